@@ -58,10 +58,13 @@ cbuffer BufferFrame : register(b0)
     float2 g_taa_jitter_offset;
 };
 
-// Low frequency - Updates once per frame
-static const int g_max_materials = 1024;
+// Low frequency - Updates when a material changes, indexed by the material id of a draw
+static const int g_max_materials = 512;
 cbuffer BufferMaterial : register(b1)
 {
+    float4 mat_color[g_max_materials];
+    float4 mat_tiling_offset[g_max_materials];
+    float4 mat_roughness_metallic_normal_height[g_max_materials];
     float4 mat_clearcoat_clearcoatRough_aniso_anisoRot[g_max_materials];
     float4 mat_sheen_sheenTint_pad[g_max_materials];
 }
@@ -83,14 +86,6 @@ cbuffer BufferUber : register(b2)
 
     float2 g_mat_tiling;
     float2 g_mat_offset;
-
-    float g_mat_roughness;
-    float g_mat_metallic;
-    float g_mat_normal;
-    float g_mat_height;
-
-    float g_mat_id;
-    float3 g_padding2;
 };
 
 // High frequency - Updates per object
@@ -99,12 +94,52 @@ cbuffer BufferObject : register(b3)
     matrix g_object_transform;
     matrix g_object_wvp_current;
     matrix g_object_wvp_previous;
+
+    uint g_object_material_id;
+    float3 g_object_padding;
+};
+
+// High frequency - Updates per instanced draw, an instance has the same data as BufferObject
+static const uint g_max_instances = 64;
+struct Instance
+{
+    matrix transform;
+    matrix wvp_current;
+    matrix wvp_previous;
+
+    uint material_id;
+    float3 padding;
+};
+
+cbuffer BufferInstances : register(b5)
+{
+    Instance g_instances[g_max_instances];
+};
+
+// Low frequency - Updates once per frame, the point and spot lights without shadows and the clusters (froxels) they are binned into
+static const uint g_max_clustered_lights        = 256;
+static const uint g_cluster_count_x             = 16;
+static const uint g_cluster_count_y             = 9;
+static const uint g_cluster_count_z             = 24;
+static const uint g_cluster_count               = g_cluster_count_x * g_cluster_count_y * g_cluster_count_z;
+static const uint g_cluster_light_indices_max   = 32768;
+cbuffer BufferLightClusters : register(b6)
+{
+    float4 clustered_light_position_range[g_max_clustered_lights];
+    float4 clustered_light_color_intensity[g_max_clustered_lights];
+    float4 clustered_light_direction_angle[g_max_clustered_lights]; // the direction is zero for point lights
+    uint4 clusters[g_cluster_count / 4];                            // offset of the first light index (24 bits) and light count (8 bits)
+    uint4 cluster_light_indices[g_cluster_light_indices_max / 16];  // 8 bits per index
+    float cluster_slice_scale;
+    float cluster_slice_bias;
+    float2 cluster_padding;
 };
 
 // High frequency - Updates per light
 cbuffer LightBuffer : register(b4)
 {
     matrix light_view_projection[6];
+    float4 light_atlas_rects[6]; // offset (xy) and scale (zw) of the tile of every view, point and spot lights only
     float4 intensity_range_angle_bias;
     float3 color;
     float normal_bias;
@@ -44,6 +44,15 @@ struct Vertex_PosUvNorTan
     float3 tangent      : TANGENT0;
 };
 
+// Imported models, see RHI_Vertex_PosTexNorTanQuantized. The position is in the model's bounds and the
+// transforms dequantize it, the normal (xy) and the tangent (zw) are octahedral.
+struct Vertex_PosUvNorTanQuantized
+{
+    float4 position         : POSITION0;
+    float2 uv               : TEXCOORD0;
+    float4 normal_tangent   : NORMAL0;
+};
+
 struct Vertex_Pos2dUvColor
 {
     float2 position     : POSITION0;
@@ -66,4 +75,34 @@ struct Pixel_PosColor
 {
     float4 position : SV_POSITION;
     float4 color    : COLOR;
-};
\ No newline at end of file
+};
+
+inline float3 octahedral_decode(float2 encoded)
+{
+    float3 direction = float3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-direction.z);
+    direction.xy += t * (1.0f - 2.0f * step(0.0f, direction.xy)); // -t where positive, t where negative
+    return normalize(direction);
+}
+
+// The vertex input of shaders which draw models, the QUANTIZED variations read the compact layout
+#if QUANTIZED
+#define Vertex_Model Vertex_PosUvNorTanQuantized
+#else
+#define Vertex_Model Vertex_PosUvNorTan
+#endif
+
+inline Vertex_PosUvNorTan vertex_model_decode(Vertex_PosUvNorTanQuantized input)
+{
+    Vertex_PosUvNorTan output;
+    output.position = float4(input.position.xyz, 1.0f);
+    output.uv       = input.uv;
+    output.normal   = octahedral_decode(input.normal_tangent.xy);
+    output.tangent  = octahedral_decode(input.normal_tangent.zw);
+    return output;
+}
+
+inline Vertex_PosUvNorTan vertex_model_decode(Vertex_PosUvNorTan input)
+{
+    return input;
+}
@@ -23,12 +23,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Common.hlsl"
 //====================
 
-Pixel_PosUv mainVS(Vertex_PosUv input)
+Pixel_PosUv mainVS(Vertex_PosUv input, uint instance_id : SV_InstanceID)
 {
     Pixel_PosUv output;
 
+    #if INSTANCED
+    matrix transform    = g_instances[instance_id].transform;
+    #else
+    matrix transform    = g_object_transform;
+    #endif
+
     input.position.w    = 1.0f; 
-    output.position     = mul(input.position, g_object_transform);
+    output.position     = mul(input.position, transform);
     output.uv           = input.uv;
 
     return output;
@@ -31,9 +31,10 @@ struct PixelInputType
     float3 positionWS   : POSITIONT_WS;
 };
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+PixelInputType mainVS(Vertex_Model input_model)
 {
     PixelInputType output;
+    Vertex_PosUvNorTan input = vertex_model_decode(input_model);
 
     input.position.w = 1.0f;
     output.positionWS = mul(input.position, g_transform).xyz;
@@ -32,6 +32,7 @@ struct PixelInputType
     float3 tangent              : TANGENT;
     float4 position_ss_current  : SCREEN_POS;
     float4 position_ss_previous : SCREEN_POS_PREVIOUS;
+    nointerpolation uint material_id : MATERIAL;
 };
 
 struct PixelOutputType
@@ -42,17 +43,28 @@ struct PixelOutputType
     float2 velocity : SV_Target3;
 };
 
-PixelInputType mainVS(Vertex_PosUvNorTan input)
+PixelInputType mainVS(Vertex_Model input_model, uint instance_id : SV_InstanceID)
 {
     PixelInputType output;
+    Vertex_PosUvNorTan input = vertex_model_decode(input_model);
+
+    #if INSTANCED
+    matrix transform            = g_instances[instance_id].transform;
+    matrix wvp_previous         = g_instances[instance_id].wvp_previous;
+    output.material_id          = g_instances[instance_id].material_id;
+    #else
+    matrix transform            = g_object_transform;
+    matrix wvp_previous         = g_object_wvp_previous;
+    output.material_id          = g_object_material_id;
+    #endif
     
     input.position.w            = 1.0f;     
-    output.position_ss_previous = mul(input.position, g_object_wvp_previous);
-    output.position             = mul(input.position, g_object_transform);
+    output.position_ss_previous = mul(input.position, wvp_previous);
+    output.position             = mul(input.position, transform);
     output.position             = mul(output.position, g_viewProjection);
     output.position_ss_current  = output.position;
-    output.normal               = normalize(mul(input.normal, (float3x3)g_object_transform)).xyz;   
-    output.tangent              = normalize(mul(input.tangent, (float3x3)g_object_transform)).xyz;
+    output.normal               = normalize(mul(input.normal, (float3x3)transform)).xyz;   
+    output.tangent              = normalize(mul(input.tangent, (float3x3)transform)).xyz;
     output.uv                   = input.uv;
     
     return output;
@@ -62,14 +74,17 @@ PixelOutputType mainPS(PixelInputType input)
 {
     PixelOutputType g_buffer;
 
-    float2 texCoords    = float2(input.uv.x * g_mat_tiling.x + g_mat_offset.x, input.uv.y * g_mat_tiling.y + g_mat_offset.y);
-    float4 albedo       = g_mat_color;
-    float roughness     = g_mat_roughness;
-    float metallic      = g_mat_metallic;
+    uint id             = input.material_id;
+    float4 uv_transform = mat_tiling_offset[id];
+    float4 properties   = mat_roughness_metallic_normal_height[id];
+    float2 texCoords    = float2(input.uv.x * uv_transform.x + uv_transform.z, input.uv.y * uv_transform.y + uv_transform.w);
+    float4 albedo       = mat_color[id];
+    float roughness     = properties.x;
+    float metallic      = properties.y;
     float3 normal       = input.normal.xyz;
     float emission      = 0.0f;
     float occlusion     = 1.0f;
-    float material_id   = g_mat_id / float(65535);
+    float material_id   = id / float(65535);
     
     //= VELOCITY ================================================================================
     float2 position_current     = (input.position_ss_current.xy / input.position_ss_current.w);
@@ -85,7 +100,7 @@ PixelOutputType mainPS(PixelInputType input)
 
     #if HEIGHT_MAP
         // Parallax Mapping
-        float height_scale      = g_mat_height * 0.04f;
+        float height_scale      = properties.w * 0.04f;
         float3 camera_to_pixel  = normalize(g_camera_position - input.position.xyz);
         texCoords               = ParallaxMapping(tex_material_height, sampler_anisotropic_wrap, texCoords, camera_to_pixel, TBN, height_scale);
     #endif
@@ -116,9 +131,10 @@ PixelOutputType mainPS(PixelInputType input)
     #endif
     
     #if NORMAL_MAP
-        // Get tangent space normal and apply intensity
-        float3 tangent_normal   = normalize(unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rgb));
-        float normal_intensity  = clamp(g_mat_normal, 0.012f, g_mat_normal);
+        // Get tangent space normal and apply intensity, z is reconstructed as normal maps can be compressed to two channels (BC5)
+        float2 tangent_xy       = unpack(tex_material_normal.Sample(sampler_anisotropic_wrap, texCoords).rg);
+        float3 tangent_normal   = float3(tangent_xy, sqrt(saturate(1.0f - dot(tangent_xy, tangent_xy))));
+        float normal_intensity  = clamp(properties.z, 0.012f, properties.z);
         tangent_normal.xy       *= saturate(normal_intensity);
         normal                  = normalize(mul(tangent_normal, TBN).xyz); // Transform to world space
     #endif
@@ -39,15 +39,118 @@ float attunation_distance(const Light light)
     return attenuation * attenuation;
 }
 
-float attunation_angle(const Light light)
+float attunation_angle(const Light light, const float3 spot_direction)
 {
     float cutoffAngle       = 1.0f - light.angle;
-    float light_dot_pixel   = dot(direction.xyz, light.direction);
+    float light_dot_pixel   = dot(spot_direction, light.direction);
     float epsilon           = cutoffAngle - cutoffAngle * 0.9f;
     float attenuation       = saturate((light_dot_pixel - cutoffAngle) / epsilon); // attenuate when approaching the outer cone
     return attenuation * attenuation;
 }
 
+// The light which a surface reflects towards the camera, the reflective energy is what's left for screen space reflections
+void reflectance(Surface surface, Material material, Light light, out float3 diffuse_out, out float3 specular_out, out float3 reflective_energy)
+{
+    // Compute some vectors and dot products
+    float3 l        = -light.direction;
+    float3 v        = -surface.camera_to_pixel;
+    float3 h        = normalize(v + l);
+    float l_dot_h   = saturate(dot(l, h));
+    float v_dot_h   = saturate(dot(v, h));
+    float n_dot_v   = saturate(dot(surface.normal, v));
+    float n_dot_l   = saturate(dot(surface.normal, l));
+    float n_dot_h   = saturate(dot(surface.normal, h));
+
+    float3 diffuse_energy   = 1.0f;
+    reflective_energy       = 1.0f;
+    
+    // Specular
+    float3 specular = 0.0f;
+    if (material.anisotropic == 0.0f)
+    {
+        specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+    else
+    {
+        specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Specular clearcoat
+    float3 specular_clearcoat = 0.0f;
+    if (material.clearcoat != 0.0f)
+    {
+        specular_clearcoat = BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
+    }
+
+    // Sheen
+    float3 specular_sheen = 0.0f;
+    if (material.sheen != 0.0f)
+    {
+        specular_sheen = BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
+    }
+    
+    // Diffuse
+    float3 diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
+
+    // Tone down diffuse such as that only non metals have it
+    diffuse *= diffuse_energy;
+
+    float3 radiance = light.color * n_dot_l;
+    diffuse_out     = diffuse * radiance;
+    specular_out    = (specular + specular_clearcoat + specular_sheen) * radiance;
+}
+
+#if CLUSTERED
+// The light count (lower 8 bits) and the offset of the first light index (upper 24 bits) of the cluster a position falls in
+uint get_cluster(float3 position)
+{
+    // The lights are binned with the unjittered projection
+    float4 position_clip    = mul(float4(position, 1.0f), g_viewProjectionUnjittered);
+    float2 uv               = saturate(position_clip.xy / position_clip.w * float2(0.5f, -0.5f) + 0.5f);
+    float depth             = mul(float4(position, 1.0f), g_view).z;
+
+    uint x      = min(uint(uv.x * g_cluster_count_x), g_cluster_count_x - 1);
+    uint y      = min(uint(uv.y * g_cluster_count_y), g_cluster_count_y - 1);
+    uint z      = uint(clamp(floor(log(depth) * cluster_slice_scale + cluster_slice_bias), 0.0f, g_cluster_count_z - 1));
+    uint index  = (z * g_cluster_count_y + y) * g_cluster_count_x + x;
+    
+    return clusters[index / 4][index % 4];
+}
+
+uint get_cluster_light_index(uint i)
+{
+    return (cluster_light_indices[i / 16][(i / 4) % 4] >> ((i % 4) * 8)) & 0xFF;
+}
+
+Light get_clustered_light(uint index, Surface surface)
+{
+    float4 position_range   = clustered_light_position_range[index];
+    float4 color_intensity  = clustered_light_color_intensity[index];
+    float4 direction_angle  = clustered_light_direction_angle[index];
+
+    Light light;
+    light.color             = color_intensity.rgb * color_intensity.a;
+    light.position          = position_range.xyz;
+    light.range             = position_range.w;
+    light.angle             = direction_angle.w;
+    light.bias              = 0.0f;
+    light.normal_bias       = 0.0f;
+    light.array_size        = 1;
+    light.distance_to_pixel = length(surface.position - light.position);
+    light.direction         = normalize(surface.position - light.position);
+    light.color             *= attunation_distance(light);
+
+    // Spot lights
+    [branch]
+    if (any(direction_angle.xyz))
+    {
+        light.color *= attunation_angle(light, direction_angle.xyz);
+    }
+
+    return light;
+}
+#endif
+
 PixelOutputType mainPS(Pixel_PosUv input)
 {
     PixelOutputType light_out;
@@ -93,6 +196,35 @@ PixelOutputType mainPS(Pixel_PosUv input)
         material.is_sky                 = mat_id == 0;
     }
 
+    #if CLUSTERED
+    // The point and spot lights without shadows, only the ones of the pixel's cluster
+    [branch]
+    if (!material.is_sky)
+    {
+        float3 multi_bounce_ao  = MultiBounceAO(material.occlusion, sample_albedo.rgb);
+        uint cluster            = get_cluster(surface.position);
+        uint offset             = cluster >> 8;
+        uint count              = cluster & 0xFF;
+
+        for (uint i = 0; i < count; i++)
+        {
+            Light light = get_clustered_light(get_cluster_light_index(offset + i), surface);
+            light.color *= multi_bounce_ao;
+
+            [branch]
+            if (any(light.color))
+            {
+                float3 diffuse, specular, reflective_energy;
+                reflectance(surface, material, light, diffuse, specular, reflective_energy);
+                light_out.diffuse   += diffuse;
+                light_out.specular  += specular;
+            }
+        }
+
+        light_out.diffuse   = saturate_16(light_out.diffuse);
+        light_out.specular  = saturate_16(light_out.specular);
+    }
+    #else
     // Fill light struct
     Light light;
     light.color             = color.xyz;
@@ -115,7 +247,7 @@ PixelOutputType mainPS(Pixel_PosUv input)
     light.array_size    = 1;
     light.direction     = normalize(surface.position - light.position);
     light.color         *= intensity_range_angle_bias.x;
-    light.color         *= attunation_distance(light) * attunation_angle(light); // attenuate
+    light.color         *= attunation_distance(light) * attunation_angle(light, direction.xyz); // attenuate
     #endif
     
     // Compute shadows and volumetric fog/light
@@ -154,49 +286,8 @@ PixelOutputType mainPS(Pixel_PosUv input)
     [branch]
     if (any(light.color) && !material.is_sky)
     {
-        // Compute some vectors and dot products
-        float3 l        = -light.direction;
-        float3 v        = -surface.camera_to_pixel;
-        float3 h        = normalize(v + l);
-        float l_dot_h   = saturate(dot(l, h));
-        float v_dot_h   = saturate(dot(v, h));
-        float n_dot_v   = saturate(dot(surface.normal, v));
-        float n_dot_l   = saturate(dot(surface.normal, l));
-        float n_dot_h   = saturate(dot(surface.normal, h));
-
-        float3 diffuse_energy       = 1.0f;
-        float3 reflective_energy    = 1.0f;
-        
-        // Specular
-        float3 specular = 0.0f;
-        if (material.anisotropic == 0.0f)
-        {
-            specular = BRDF_Specular_Isotropic(material, n_dot_v, n_dot_l, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-        else
-        {
-            specular = BRDF_Specular_Anisotropic(material, surface, v, l, h, n_dot_v, n_dot_l, n_dot_h, l_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Specular clearcoat
-        float3 specular_clearcoat = 0.0f;
-        if (material.clearcoat != 0.0f)
-        {
-            specular_clearcoat = BRDF_Specular_Clearcoat(material, n_dot_h, v_dot_h, diffuse_energy, reflective_energy);
-        }
-
-        // Sheen
-        float3 specular_sheen = 0.0f;
-        if (material.sheen != 0.0f)
-        {
-            specular_sheen = BRDF_Specular_Sheen(material, n_dot_v, n_dot_l, n_dot_h, diffuse_energy, reflective_energy);
-        }
-        
-        // Diffuse
-        float3 diffuse = BRDF_Diffuse(material, n_dot_v, n_dot_l, v_dot_h);
-
-        // Tone down diffuse such as that only non metals have it
-        diffuse *= diffuse_energy;
+        float3 diffuse, specular, reflective_energy;
+        reflectance(surface, material, light, diffuse, specular, reflective_energy);
 
         // SSR
         float3 light_reflection = 0.0f;
@@ -211,15 +302,13 @@ PixelOutputType mainPS(Pixel_PosUv input)
             light_reflection *= 1.0f - material.roughness; // fade with roughness as we don't have blurry screen space reflections yet
         }
         #endif
-
-        float3 radiance = light.color * n_dot_l;
-        
-        light_out.diffuse.rgb  = saturate_16(diffuse * radiance);
-        light_out.specular.rgb = saturate_16((specular + specular_clearcoat + specular_sheen) * radiance + light_reflection);
         
+        light_out.diffuse.rgb  = saturate_16(diffuse);
+        light_out.specular.rgb = saturate_16(specular + light_reflection);
     }
 
     light_out.volumetric.rgb = saturate_16(volumetric);
+    #endif
 
     return light_out;
 }
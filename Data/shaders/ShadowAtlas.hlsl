@@ -0,0 +1,38 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========
+#include "Common.hlsl"
+//====================
+
+// Drawn over a tile of the shadow atlas. It either clears the tile's depth to the value in g_color.x (CLEAR), or copies
+// the tile's static depth (tex), which is at the same texels in the static atlas. The color (transparent shadows) is cleared to white.
+float4 mainPS(Pixel_PosUv input, out float depth : SV_Depth) : SV_TARGET
+{
+    #if CLEAR
+    depth = g_color.x;
+    #else
+    depth = tex.Load(int3(input.position.xy, 0)).r;
+    #endif
+
+    return 1.0f;
+}
@@ -54,17 +54,28 @@ static const float g_pcf_filter_size = (sqrt((float)g_shadow_samples) - 1.0f) /
 /*------------------------------------------------------------------------------
     DEPTH SAMPLING
 ------------------------------------------------------------------------------*/
+#if POINT || SPOT
+// float3 -> uv, view to the uv of the view's tile in the atlas.
+// The uv is kept half a texel inside the tile, so that filtering doesn't reach into a neighbouring tile.
+float2 atlas_uv(float3 uv)
+{
+    float2 atlas_size;
+    light_atlas_depth.GetDimensions(atlas_size.x, atlas_size.y);
+
+    float4 rect         = light_atlas_rects[uint(uv.z)];
+    float2 texel_half   = 0.5f / atlas_size;
+    return clamp(uv.xy * rect.zw + rect.xy, rect.xy + texel_half, rect.xy + rect.zw - texel_half);
+}
+#endif
+
 float compare_depth(float3 uv, float compare)
 {
     #if DIRECTIONAL
     // float3 -> uv, slice
     return light_directional_depth.SampleCmpLevelZero(sampler_compare_depth, uv, compare).r;
-    #elif POINT
-    // float3 -> direction
-    return light_point_depth.SampleCmpLevelZero(sampler_compare_depth, uv, compare).r;
-    #elif SPOT
-    // float3 -> uv, 0
-    return light_spot_depth.SampleCmpLevelZero(sampler_compare_depth, uv.xy, compare).r;
+    #elif POINT || SPOT
+    // float3 -> uv, view
+    return light_atlas_depth.SampleCmpLevelZero(sampler_compare_depth, atlas_uv(uv), compare).r;
     #endif
 
     return 0.0f;
@@ -75,12 +86,9 @@ float sample_depth(float3 uv)
     #if DIRECTIONAL
     // float3 -> uv, slice
     return light_directional_depth.SampleLevel(sampler_point_clamp, uv, 0).r;
-    #elif POINT
-    // float3 -> direction
-    return light_point_depth.SampleLevel(sampler_point_clamp, uv, 0).r;
-    #elif SPOT
-    // float3 -> uv, 0
-    return light_spot_depth.SampleLevel(sampler_point_clamp, uv.xy, 0).r;
+    #elif POINT || SPOT
+    // float3 -> uv, view
+    return light_atlas_depth.SampleLevel(sampler_point_clamp, atlas_uv(uv), 0).r;
     #endif
 
     return 0.0f;
@@ -91,12 +99,9 @@ float4 sample_color(float3 uv)
     #if DIRECTIONAL
     // float3 -> uv, slice
     return light_directional_color.SampleLevel(sampler_point_clamp, uv, 0);
-    #elif POINT
-    // float3 -> direction
-    return light_point_color.SampleLevel(sampler_point_clamp, uv, 0);
-    #elif SPOT
-    // float3 -> uv, 0
-    return light_spot_color.SampleLevel(sampler_point_clamp, uv.xy, 0);
+    #elif POINT || SPOT
+    // float3 -> uv, view
+    return light_atlas_color.SampleLevel(sampler_point_clamp, atlas_uv(uv), 0);
     #endif
 
     return 0.0f;
@@ -380,19 +385,21 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
     }
     #elif POINT
     {
+        uint projection_index = direction_to_cube_face_index(light.direction);
+
+        // Lights which didn't fit in the atlas have no tiles
         [branch]
-        if (light.distance_to_pixel < light.range)
+        if (light.distance_to_pixel < light.range && light_atlas_rects[projection_index].z > 0.0f)
         {
-            uint projection_index   = direction_to_cube_face_index(light.direction);
-            float pos_z             = project_depth(position_world, light_view_projection[projection_index]);   
-            float compare_depth     = bias_sloped_scaled(pos_z, light.bias);
-            shadow.a                = SampleShadowMap(light.direction, compare_depth);
+            float3 pos_clip         = project(position_world, light_view_projection[projection_index]);
+            float compare_depth     = bias_sloped_scaled(pos_clip.z, light.bias);
+            shadow.a                = SampleShadowMap(float3(pos_clip.xy, projection_index), compare_depth);
             
             #if SHADOWS_TRANSPARENT
             [branch]
             if (shadow.a > 0.0f && !transparent_pixel)
             {
-                shadow *= sample_color(light.direction);
+                shadow *= sample_color(float3(pos_clip.xy, projection_index));
             }
             #endif
         }
@@ -400,7 +407,7 @@ float4 Shadow_Map(Surface surface, Light light, bool transparent_pixel)
     #elif SPOT
     {
         [branch]
-        if (light.distance_to_pixel < light.range)
+        if (light.distance_to_pixel < light.range && light_atlas_rects[0].z > 0.0f)
         {
             float3 pos_clip     = project(position_world, light_view_projection[0]);
             float compare_depth = bias_sloped_scaled(pos_clip.z, light.bias);
@@ -39,15 +39,16 @@ float vl_raymarch(Light light, float3 ray_pos, float3 ray_step, float ray_dot_li
     
     for (uint i = 0; i < g_vl_steps; i++)
     {
+        // The ray can cross into another face of a point light
+        #if POINT
+        array_index = direction_to_cube_face_index(normalize(ray_pos - light.position));
+        #endif
+
         // Compute position in clip space
         float3 pos = project(ray_pos, light_view_projection[array_index]);
         
         // Compare depth
-        #if POINT
-        float depth_delta = compare_depth(normalize(ray_pos - light.position), pos.z);
-        #else // directional & spot
         float depth_delta = compare_depth(float3(pos.xy, array_index), pos.z);
-        #endif
        
         // Depth test
         if (abs(g_vl_tolerance - depth_delta) > g_vl_tolerance)
@@ -114,11 +115,12 @@ float3 VolumetricLighting(Surface surface, Light light)
         {
             uint projection_index = direction_to_cube_face_index(light.direction);
             
-            // Compute position in clip space
-            float3 pos = project(ray_pos, light_view_projection[projection_index]);
-            
-            // Ray-march
-            fog = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, projection_index);
+            // Ray-march, if the light has tiles in the atlas
+            [branch]
+            if (light_atlas_rects[projection_index].z > 0.0f)
+            {
+                fog = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, projection_index);
+            }
         }
     }
     #elif SPOT
@@ -129,9 +131,9 @@ float3 VolumetricLighting(Surface surface, Light light)
             // Compute position in clip space
             float3 pos = project(ray_pos, light_view_projection[0]);
             
-            // Ray-march
+            // Ray-march, if the light has a tile in the atlas
             [branch]
-            if (is_saturated(pos))
+            if (is_saturated(pos) && light_atlas_rects[0].z > 0.0f)
             {
                 fog = vl_raymarch(light, ray_pos, ray_step, ray_dot_light, 0);
             }
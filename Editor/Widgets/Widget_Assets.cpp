@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Widget_Assets.h"
 #include "Widget_Properties.h"
 #include "Rendering/Model.h"
+#include "Resource/Import/ImageImporter.h"
 #include "../WidgetsDeferred/FileDialog.h"
 //========================================
 
@@ -56,6 +57,15 @@ void Widget_Assets::Tick()
 		Widget_Assets_Statics::g_show_file_dialog_load = true;
 	}
 
+	// Applies to the textures of the models imported from now on
+	ImGui::SameLine();
+	ImageImporter* image_importer		= m_context->GetSubsystem<ResourceCache>()->GetImageImporter();
+	bool color_compression_high			= image_importer->GetColorCompressionHigh();
+	if (ImGui::Checkbox("BC7 color", &color_compression_high))
+	{
+		image_importer->SetColorCompressionHigh(color_compression_high);
+	}
+
 	ImGui::SameLine();
 	
 	// VIEW
@@ -813,7 +813,11 @@ void Widget_Properties::ShowMaterial(Material* material) const
                         else
                         {
                             ImGui::PushID(static_cast<int>(ImGui::GetCursorPosX() + ImGui::GetCursorPosY()));
-                            ImGui::DragFloat("", &material->GetProperty(type), 0.004f, 0.0f, 1.0f);
+                            float value = material->GetProperty(type);
+                            if (ImGui::DragFloat("", &value, 0.004f, 0.0f, 1.0f))
+                            {
+                                material->SetProperty(type, value);
+                            }
                             ImGui::PopID();
                         }
                     }
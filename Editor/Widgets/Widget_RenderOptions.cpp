@@ -237,6 +237,9 @@ void Widget_RenderOptions::Tick()
 
             // Shadow resolution
             ImGui::InputInt("Shadow Resolution", &resolution_shadow, 1);
+
+            // Texture streaming
+            render_option_float("##texture_streaming_option", "Texture Streaming Budget (MB)", Option_Value_TextureStreamingBudget, "How much memory the mips of the streamed textures can take, the least recently used and then the largest are reduced to fit", 64.0f);
         }
 
         // Map back to engine
@@ -317,8 +320,10 @@ void Widget_RenderOptions::Tick()
     if (ImGui::CollapsingHeader("Debug", ImGuiTreeNodeFlags_None))
     {
         // Reflect from engine
-        auto do_depth_prepass   = m_renderer->GetOption(Render_DepthPrepass);
-        auto do_reverse_z       = m_renderer->GetOption(Render_ReverseZ);
+        auto do_depth_prepass       = m_renderer->GetOption(Render_DepthPrepass);
+        auto do_reverse_z           = m_renderer->GetOption(Render_ReverseZ);
+        auto do_occlusion_culling   = m_renderer->GetOption(Render_OcclusionCulling);
+        auto do_cluster_culling     = m_renderer->GetOption(Render_ClusterCulling);
 
         {
             // Buffer
@@ -379,10 +384,18 @@ void Widget_RenderOptions::Tick()
 
             // Reverse-Z
             ImGui::Checkbox("Reverse-Z", &do_reverse_z);
+
+            // Occlusion culling
+            ImGui::Checkbox("Occlusion Culling", &do_occlusion_culling);
+
+            // Cluster culling
+            ImGui::Checkbox("Cluster Culling", &do_cluster_culling);
         }
 
         // Map back to engine
         m_renderer->SetOption(Render_DepthPrepass, do_depth_prepass);
         m_renderer->SetOption(Render_ReverseZ, do_reverse_z);
+        m_renderer->SetOption(Render_OcclusionCulling, do_occlusion_culling);
+        m_renderer->SetOption(Render_ClusterCulling, do_cluster_culling);
     }
 }
@@ -37,13 +37,15 @@ namespace Spartan
 {
     Audio::Audio(Context* context) : ISubsystem(context)
     {
+        // Reads a copy of the listener's pose (not the transform), records time blocks
+        SetTickDependencies(Tick_Dependency_Profiling, Tick_Dependency_Audio, false);
 
     }
 
 	Audio::~Audio()
 	{
 		// Unsubscribe from events
-		UNSUBSCRIBE_FROM_EVENT(EventType::WorldUnload, [this](Variant) { m_listener = nullptr; });
+		UNSUBSCRIBE_FROM_EVENT(EventType::WorldUnload, [this](Variant) { lock_guard<mutex> lock(m_listener_mutex); m_listener = false; });
 
 		if (!m_system_fmod)
 			return;
@@ -128,7 +130,7 @@ namespace Spartan
         m_profiler = m_context->GetSubsystem<Profiler>();
 
         // Subscribe to events
-        SUBSCRIBE_TO_EVENT(EventType::WorldUnload, [this](Variant) { m_listener = nullptr; });
+        SUBSCRIBE_TO_EVENT(EventType::WorldUnload, [this](Variant) { lock_guard<mutex> lock(m_listener_mutex); m_listener = false; });
    
         return true;
     }
@@ -152,12 +154,21 @@ namespace Spartan
 			return;
 		}
 
-		if (m_listener)
+		Math::Vector3 position;
+		Math::Vector3 forward;
+		Math::Vector3 up;
+		bool listener = false;
+		{
+			lock_guard<mutex> lock(m_listener_mutex);
+			listener	= m_listener;
+			position	= m_listener_position;
+			forward		= m_listener_forward;
+			up			= m_listener_up;
+		}
+
+		if (listener)
 		{
-			auto position = m_listener->GetPosition();
 			auto velocity = Math::Vector3::Zero;
-			auto forward = m_listener->GetForward();
-			auto up = m_listener->GetUp();
 
 			// Set 3D attributes
 			m_result_fmod = m_system_fmod->set3DListenerAttributes(
@@ -177,7 +188,14 @@ namespace Spartan
 
     void Audio::SetListenerTransform(Transform* transform)
 	{
-		m_listener = transform;
+		lock_guard<mutex> lock(m_listener_mutex);
+		m_listener = transform != nullptr;
+		if (!m_listener)
+			return;
+
+		m_listener_position	= transform->GetPosition();
+		m_listener_forward	= transform->GetForward();
+		m_listener_up		= transform->GetUp();
 	}
 
 	void Audio::LogErrorFmod(int error) const
@@ -22,7 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <mutex>
 #include "../Core/ISubsystem.h"
+#include "../Math/Vector3.h"
 //=============================
 
 //= FORWARD DECLARATIONS =
@@ -49,7 +51,7 @@ namespace Spartan
         //===================================
 
 		auto GetSystemFMOD() const { return m_system_fmod; }
-		void SetListenerTransform(Transform* transform);
+		void SetListenerTransform(Transform* transform); // copies the pose, the audio ticks alongside the world
 
 	private:
 		void LogErrorFmod(int error) const;
@@ -58,7 +60,11 @@ namespace Spartan
 		uint32_t m_max_channels		= 32;
 		float m_distance_entity		= 1.0f;
 		bool m_initialized			= false;
-		Transform* m_listener		= nullptr;
+		bool m_listener				= false;
+		Math::Vector3 m_listener_position;
+		Math::Vector3 m_listener_forward;
+		Math::Vector3 m_listener_up;
+		std::mutex m_listener_mutex;
 		Profiler* m_profiler		= nullptr;
 		FMOD::System* m_system_fmod = nullptr;
 	};
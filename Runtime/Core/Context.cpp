@@ -0,0 +1,154 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ========================
+#include "Spartan.h"
+#include "Context.h"
+#include "../Threading/Threading.h"
+//===================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    void Context::Tick(const function<float(TickType)>& get_delta_time)
+    {
+        m_threading = GetSubsystem<Threading>();
+        if (!m_threading || m_threading->GetThreadCount() == 0)
+        {
+            Tick(TickType::Variable, get_delta_time(TickType::Variable));
+            Tick(TickType::Smoothed, get_delta_time(TickType::Smoothed));
+            return;
+        }
+
+        if (m_tick_graph.empty())
+        {
+            BuildTickGraph();
+        }
+
+        TaskCounter counter;
+        m_tick_counter          = &counter;
+        m_get_delta_time        = get_delta_time;
+        m_tick_nodes_remaining  = static_cast<uint32_t>(m_tick_graph.size());
+
+        // Reset dependency counters
+        for (_tick_node& node : m_tick_graph)
+        {
+            node.dependencies_remaining = node.dependency_count;
+            node.ready                  = false;
+        }
+
+        // Kick off the nodes which don't depend on anything
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_tick_graph.size()); i++)
+        {
+            if (m_tick_graph[i].dependency_count == 0)
+            {
+                TickNodeLaunch(i);
+            }
+        }
+
+        // The main thread ticks the subsystems which require it and helps out with the rest
+        while (m_tick_nodes_remaining != 0)
+        {
+            bool ticked = false;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(m_tick_graph.size()); i++)
+            {
+                if (m_tick_graph[i].ready.exchange(false))
+                {
+                    TickNode(i);
+                    ticked = true;
+                }
+            }
+
+            // Only the subsystem ticks are helped with, tasks submitted by the editor (e.g. loading a world) may wait on the main thread
+            if (!ticked && !m_threading->TryExecuteTask(counter))
+            {
+                this_thread::yield();
+            }
+        }
+
+        m_threading->Wait(counter);
+        m_tick_counter = nullptr;
+    }
+
+    void Context::BuildTickGraph()
+    {
+        m_tick_graph = vector<_tick_node>(m_subsystems.size());
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_subsystems.size()); i++)
+        {
+            _tick_node& node    = m_tick_graph[i];
+            ISubsystem* current = m_subsystems[i].ptr.get();
+            node.subsystem      = current;
+            node.tick_group     = m_subsystems[i].tick_group;
+            node.main_thread    = current->GetTickMainThread();
+
+            // Registration order is the tick order, so a subsystem has to wait for any
+            // previously registered subsystem which writes what it reads or writes, or reads what it writes.
+            for (uint32_t j = 0; j < i; j++)
+            {
+                ISubsystem* previous = m_subsystems[j].ptr.get();
+
+                const bool conflict =
+                    (previous->GetTickWrites() & (current->GetTickReads() | current->GetTickWrites())) != 0 ||
+                    (previous->GetTickReads() & current->GetTickWrites()) != 0;
+
+                if (conflict)
+                {
+                    m_tick_graph[j].dependents.emplace_back(i);
+                    node.dependency_count++;
+                }
+            }
+        }
+    }
+
+    void Context::TickNodeLaunch(const uint32_t index)
+    {
+        if (m_tick_graph[index].main_thread)
+        {
+            m_tick_graph[index].ready = true;
+        }
+        else
+        {
+            m_threading->AddTask([this, index]() { TickNode(index); }, m_tick_counter);
+        }
+    }
+
+    void Context::TickNode(const uint32_t index)
+    {
+        _tick_node& node = m_tick_graph[index];
+        node.subsystem->Tick(m_get_delta_time(node.tick_group));
+
+        // Launch any dependents whose last dependency was this node
+        for (const uint32_t dependent : node.dependents)
+        {
+            if (--m_tick_graph[dependent].dependencies_remaining == 0)
+            {
+                TickNodeLaunch(dependent);
+            }
+        }
+
+        m_tick_nodes_remaining--;
+    }
+}
@@ -22,6 +22,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ===================
+#include <vector>
+#include <atomic>
+#include <functional>
 #include "ISubsystem.h"
 #include "../Logging/Log.h"
 #include "Spartan_Definitions.h"
@@ -30,6 +33,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
     class Engine;
+    class Threading;
+    class TaskCounter;
 
     enum class TickType
     {
@@ -49,6 +54,18 @@ namespace Spartan
         TickType tick_group;
     };
 
+    // A node of the per-frame tick graph
+    struct _tick_node
+    {
+        ISubsystem* subsystem = nullptr;
+        TickType tick_group   = TickType::Variable;
+        bool main_thread      = true;
+        std::vector<uint32_t> dependents;
+        uint32_t dependency_count = 0;
+        std::atomic<uint32_t> dependencies_remaining = 0;
+        std::atomic<bool> ready = false;
+    };
+
 	class SPARTAN_CLASS Context
 	{
 	public:
@@ -70,8 +87,8 @@ namespace Spartan
 		void RegisterSubsystem(TickType tick_group = TickType::Variable)
 		{
             validate_subsystem_type<T>();
-
             m_subsystems.emplace_back(std::make_shared<T>(this), tick_group);
+            m_tick_graph.clear();
 		}
 
 		// Initialize subsystems
@@ -90,7 +107,7 @@ namespace Spartan
 			return result;
 		}
 
-        // Tick
+        // Tick a single group, in registration order
 		void Tick(TickType tick_group, float delta_time = 0.0f)
 		{
             for (const auto& subsystem : m_subsystems)
@@ -102,6 +119,10 @@ namespace Spartan
             }
 		}
 
+        // Tick all the subsystems, subsystems with no conflicting dependencies tick in parallel.
+        // The delta time for a tick group is requested right before a subsystem of that group ticks.
+        void Tick(const std::function<float(TickType)>& get_delta_time);
+
 		// Get a subsystem
 		template <class T> 
         T* GetSubsystem() const
@@ -120,6 +141,15 @@ namespace Spartan
         Engine* m_engine = nullptr;
 
 	private:
+        void BuildTickGraph();
+        void TickNodeLaunch(uint32_t index);
+        void TickNode(uint32_t index);
+
 		std::vector<_subystem> m_subsystems;
+        std::vector<_tick_node> m_tick_graph;
+        std::function<float(TickType)> m_get_delta_time;
+        std::atomic<uint32_t> m_tick_nodes_remaining    = 0;
+        TaskCounter* m_tick_counter                     = nullptr;
+        Threading* m_threading                          = nullptr;
 	};
 }
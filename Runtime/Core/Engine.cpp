@@ -61,14 +61,15 @@ namespace Spartan
         m_context->RegisterSubsystem<Input>(TickType::Smoothed);
 		m_context->RegisterSubsystem<Scripting>(TickType::Smoothed);
 		m_context->RegisterSubsystem<World>(TickType::Smoothed);
-        m_context->RegisterSubsystem<Profiler>(TickType::Variable);
         m_context->RegisterSubsystem<Renderer>(TickType::Smoothed);
+        m_context->RegisterSubsystem<Profiler>(TickType::Variable);      // after the renderer, so the frame ends once the render thread is done
         m_context->RegisterSubsystem<Settings>(TickType::Variable);
              	
 		// Initialize above subsystems
 		m_context->Initialize();
 
-        m_timer = m_context->GetSubsystem<Timer>();
+        m_timer     = m_context->GetSubsystem<Timer>();
+        m_renderer  = m_context->GetSubsystem<Renderer>();
 	}
 
 	Engine::~Engine()
@@ -78,8 +79,14 @@ namespace Spartan
 
 	void Engine::Tick() const
     {
-        m_context->Tick(TickType::Variable, static_cast<float>(m_timer->GetDeltaTimeSec()));
-        m_context->Tick(TickType::Smoothed, static_cast<float>(m_timer->GetDeltaTimeSmoothedSec()));
+        // The render thread records the previous frame while the subsystems tick this one
+        m_renderer->Render();
+
+        // Subsystems tick as a task graph, the timer doesn't declare its dependencies so it ticks first (and alone)
+        m_context->Tick([this](TickType tick_group)
+        {
+            return static_cast<float>(tick_group == TickType::Variable ? m_timer->GetDeltaTimeSec() : m_timer->GetDeltaTimeSmoothedSec());
+        });
 	}
 
     void Engine::SetWindowData(WindowData& window_data)
@@ -30,6 +30,7 @@ namespace Spartan
 {
 	class Context;
     class Timer;
+    class Renderer;
 
     struct WindowData
     {
@@ -82,6 +83,7 @@ namespace Spartan
         WindowData m_window_data;
         uint32_t m_flags        = 0;
         Timer* m_timer          = nullptr;
+        Renderer* m_renderer    = nullptr;
 		std::shared_ptr<Context> m_context;
 	};
 }
@@ -31,6 +31,24 @@ namespace Spartan
 {
 	class Context;
 
+    // Shared state that subsystems read or write while ticking.
+    // The Context uses these to work out which subsystems can tick in parallel.
+    enum Tick_Dependency : uint32_t
+    {
+        Tick_Dependency_None        = 0,
+        Tick_Dependency_Time        = 1 << 0,
+        Tick_Dependency_Resources   = 1 << 1,
+        Tick_Dependency_Audio       = 1 << 2,
+        Tick_Dependency_Physics     = 1 << 3,
+        Tick_Dependency_Input       = 1 << 4,
+        Tick_Dependency_Scripts     = 1 << 5,
+        Tick_Dependency_Entities    = 1 << 6,  // entities, components and transforms
+        Tick_Dependency_Profiling   = 1 << 7,  // time blocks and metrics
+        Tick_Dependency_Rendering   = 1 << 8,  // renderer state (entity lists, debug lines, options)
+        Tick_Dependency_Rhi         = 1 << 9,  // immediate context/queues
+        Tick_Dependency_All         = 0xFFFFFFFF
+    };
+
 	class SPARTAN_CLASS ISubsystem : public std::enable_shared_from_this<ISubsystem>
 	{		
 	public:
@@ -42,8 +60,26 @@ namespace Spartan
         template <typename T>
         std::shared_ptr<T> GetPtrShared() { return dynamic_pointer_cast<T>(shared_from_this()); }
 
+        // Tick dependencies
+        uint32_t GetTickReads()     const { return m_tick_reads; }
+        uint32_t GetTickWrites()    const { return m_tick_writes; }
+        bool GetTickMainThread()    const { return m_tick_main_thread; }
+
 	protected:
+        // Subsystems which don't declare their dependencies, tick alone and on the main thread
+        void SetTickDependencies(const uint32_t reads, const uint32_t writes, const bool main_thread)
+        {
+            m_tick_reads        = reads;
+            m_tick_writes       = writes;
+            m_tick_main_thread  = main_thread;
+        }
+
 		Context* m_context;
+
+    private:
+        uint32_t m_tick_reads   = Tick_Dependency_All;
+        uint32_t m_tick_writes  = Tick_Dependency_All;
+        bool m_tick_main_thread = true;
 	};
 
     template<typename T>
@@ -64,6 +64,9 @@ namespace Spartan
 {
     Settings::Settings(Context* context) : ISubsystem(context)
     {
+        // Doesn't tick
+        SetTickDependencies(Tick_Dependency_None, Tick_Dependency_None, false);
+
         m_context = context;
 
         // Register pugixml
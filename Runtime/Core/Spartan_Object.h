@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===================
 #include <string>
+#include <atomic>
 #include "Spartan_Definitions.h"
 //==============================
 
@@ -32,8 +33,8 @@ namespace Spartan
     class Context;
     //========================
 
-    // Globals
-	static uint32_t g_id = 0;
+    // Globals, one counter for the whole program (resources are created on worker threads too)
+	inline std::atomic<uint32_t> g_id = 0;
 
 	class SPARTAN_CLASS Spartan_Object
 	{
@@ -43,14 +44,21 @@ namespace Spartan
             m_context   = context;
             m_id        = GenerateId();
         }
+        virtual ~Spartan_Object() = default;
 
         // Name
         const std::string& GetName()    const { return m_name; }
 
         // Id
 		const uint32_t GetId()          const { return m_id; }
-		void SetId(const uint32_t id)	      { m_id = id; }
-        static uint32_t GenerateId()          { return ++g_id; }
+        // Ids which are set (e.g. when loading) are never generated afterwards
+		virtual void SetId(const uint32_t id)
+        {
+            m_id = id;
+            uint32_t id_generated = g_id;
+            while (id_generated < id && !g_id.compare_exchange_weak(id_generated, id)) {}
+        }
+        static uint32_t GenerateId() { return ++g_id; }
 
         // CPU & GPU sizes
         const uint64_t GetSizeCpu()     const { return m_size_cpu; }
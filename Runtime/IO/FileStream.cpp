@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "FileStream.h"
 #include "../RHI/RHI_Vertex.h"
+#include <windows.h>
 //============================
 
 //= NAMESPACES =====
@@ -31,13 +32,15 @@ using namespace std;
 
 namespace Spartan
 {
+	// Big enough to make small writes cheap, small enough to not matter when many streams are open
+	static const uint64_t buffer_size = 64 * 1024;
+
 	FileStream::FileStream(const string& path, uint32_t flags)
 	{
 		m_is_open	= false;
 		m_flags		= flags;
 
 		int ios_flags	= ios::binary;
-		ios_flags		|= (flags & FileStream_Read)	? ios::in	: 0;
 		ios_flags		|= (flags & FileStream_Write)	? ios::out	: 0;
 		ios_flags		|= (flags & FileStream_Append)	? ios::app	: 0;
 
@@ -49,11 +52,12 @@ namespace Spartan
 				LOG_ERROR("Failed to open \"%s\" for writing", path.c_str());
 				return;
 			}
+
+			m_buffer.resize(buffer_size);
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.open(path, ios_flags);
-			if(in.fail())
+			if (!Map(path))
 			{
 				LOG_ERROR("Failed to open \"%s\" for reading", path.c_str());
 				return;
@@ -63,6 +67,20 @@ namespace Spartan
 		m_is_open = true;
 	}
 
+	FileStream::FileStream(const FileStream& source, const uint64_t position)
+	{
+		m_flags		= FileStream_Read;
+		m_is_open	= source.m_is_open && (source.m_flags & FileStream_Read);
+
+		// The mapping is only borrowed, so Unmap() just forgets it
+		if (m_is_open)
+		{
+			m_data		= source.m_data;
+			m_size		= source.m_size;
+			m_position	= position < m_size ? position : m_size;
+		}
+	}
+
 	FileStream::~FileStream()
 	{
 		Close();
@@ -72,22 +90,100 @@ namespace Spartan
 	{
 		if (m_flags & FileStream_Write)
 		{
+			Flush();
 			out.flush();
 			out.close();
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.clear();
-			in.close();
+			Unmap();
 		}
 	}
 
+	bool FileStream::Map(const string& path)
+	{
+		HANDLE file = CreateFileW(FileSystem::StringToWstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_file = file;
+		m_size = static_cast<uint64_t>(size.QuadPart);
+
+		// Empty files can't be mapped, there is nothing to read anyway
+		if (m_size == 0)
+			return true;
+
+		if (HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+		{
+			if (void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+			{
+				m_mapping	= mapping;
+				m_data		= static_cast<const std::byte*>(view);
+				return true;
+			}
+
+			CloseHandle(mapping);
+		}
+
+		// Mapping can fail (e.g. a 32-bit address space is too fragmented), fall back to loading the whole file
+		LOG_WARNING("Failed to map \"%s\", loading it instead", path.c_str());
+		m_data_loaded.resize(m_size);
+		ifstream in(path, ios::binary);
+		in.read(reinterpret_cast<char*>(m_data_loaded.data()), m_size);
+		if (in.fail())
+		{
+			Unmap();
+			return false;
+		}
+		m_data = m_data_loaded.data();
+
+		return true;
+	}
+
+	void FileStream::Unmap()
+	{
+		if (m_mapping)
+		{
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+			m_mapping = nullptr;
+		}
+
+		if (m_file)
+		{
+			CloseHandle(m_file);
+			m_file = nullptr;
+		}
+
+		m_data_loaded.clear();
+		m_data_loaded.shrink_to_fit();
+		m_data		= nullptr;
+		m_size		= 0;
+		m_position	= 0;
+	}
+
+	void FileStream::Flush()
+	{
+		if (m_buffer_size == 0)
+			return;
+
+		out.write(m_buffer.data(), m_buffer_size);
+		m_buffer_size = 0;
+	}
+
 	void FileStream::Write(const string& value)
 	{
 		const auto length = static_cast<uint32_t>(value.length());
 		Write(length);
 
-		out.write(const_cast<char*>(value.c_str()), length);
+		WriteBytes(value.data(), length);
 	}
 
 	void FileStream::Write(const vector<string>& value)
@@ -105,28 +201,35 @@ namespace Spartan
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		WriteBytes(value.data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
+	}
+
+	void FileStream::Write(const vector<RHI_Vertex_PosTexNorTanQuantized>& value)
+	{
+		const auto length = static_cast<uint32_t>(value.size());
+		Write(length);
+		WriteBytes(value.data(), sizeof(RHI_Vertex_PosTexNorTanQuantized) * length);
 	}
 
 	void FileStream::Write(const vector<uint32_t>& value)
 	{
 		const auto length = static_cast<uint32_t>(value.size());
 		Write(length);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(uint32_t) * length);
+		WriteBytes(value.data(), sizeof(uint32_t) * length);
 	}
 
 	void FileStream::Write(const vector<unsigned char>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(unsigned char) * size);
+		WriteBytes(value.data(), sizeof(unsigned char) * size);
 	}
 
 	void FileStream::Write(const vector<std::byte>& value)
 	{
 		const auto size = static_cast<uint32_t>(value.size());
 		Write(size);
-		out.write(reinterpret_cast<const char*>(&value[0]), sizeof(std::byte) * size);
+		WriteBytes(value.data(), sizeof(std::byte) * size);
 	}
 
 	void FileStream::Skip(uint32_t n)
@@ -134,21 +237,79 @@ namespace Spartan
 		// Set the seek cursor to offset n from the current position
 		if (m_flags & FileStream_Write)
 		{
+			Flush();
 			out.seekp(n, ios::cur);
 		}
 		else if (m_flags & FileStream_Read)
 		{
-			in.ignore(n, ios::cur);
+			Seek(m_position + n);
 		}
 	}
 
-	void FileStream::Read(string* value)
+	uint64_t FileStream::GetPosition()
 	{
-		uint32_t length = 0;
-		Read(&length);
+		if (m_flags & FileStream_Write)
+		{
+			return static_cast<uint64_t>(out.tellp()) + m_buffer_size;
+		}
+		else if (m_flags & FileStream_Read)
+		{
+			return m_position;
+		}
+
+		return 0;
+	}
 
+	void FileStream::Seek(const uint64_t position)
+	{
+		if (m_flags & FileStream_Write)
+		{
+			Flush();
+			out.seekp(static_cast<streamoff>(position), ios::beg);
+		}
+		else if (m_flags & FileStream_Read)
+		{
+			m_position = position < m_size ? position : m_size;
+		}
+	}
+
+	uint32_t FileStream::ReadCount(const uint64_t element_size)
+	{
+		const uint64_t count		= ReadAs<uint32_t>();
+		const uint64_t available	= m_position < m_size ? m_size - m_position : 0;
+		return static_cast<uint32_t>(count < available / element_size ? count : available / element_size);
+	}
+
+	const std::byte* FileStream::ReadView(const uint64_t size)
+	{
+		if (m_size - m_position < size)
+		{
+			m_position = m_size;
+			return nullptr;
+		}
+
+		const std::byte* view = m_data + m_position;
+		m_position += size;
+		return view;
+	}
+
+	void FileStream::Prefetch(const uint64_t offset, const uint64_t size)
+	{
+		// Loaded files are already in memory
+		if (!m_mapping || offset >= m_size)
+			return;
+
+		WIN32_MEMORY_RANGE_ENTRY range;
+		range.VirtualAddress	= const_cast<std::byte*>(m_data + offset);
+		range.NumberOfBytes		= static_cast<SIZE_T>(size < m_size - offset ? size : m_size - offset);
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+
+	void FileStream::Read(string* value)
+	{
+		const uint32_t length = ReadCount(sizeof(char));
 		value->resize(length);
-		in.read(const_cast<char*>(value->c_str()), length);
+		ReadBytes(value->data(), length);
 	}
 
 	void FileStream::Read(vector<string>* vec)
@@ -156,17 +317,11 @@ namespace Spartan
 		if (!vec)
 			return;
 
-		vec->clear();
-		vec->shrink_to_fit();
-
-		uint32_t size = 0;
-		Read(&size);
-
-		string str;
-		for (uint32_t i = 0; i < size; i++)
+		// Every string takes at least its length
+		vec->resize(ReadCount(sizeof(uint32_t)));
+		for (string& str : *vec)
 		{
 			Read(&str);
-			vec->emplace_back(str);
 		}
 	}
 
@@ -175,15 +330,10 @@ namespace Spartan
 		if (!vec)
 			return;
 
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
+		const uint32_t length = ReadCount(sizeof(RHI_Vertex_PosTexNorTan));
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(RHI_Vertex_PosTexNorTan) * length);
+		ReadBytes(vec->data(), sizeof(RHI_Vertex_PosTexNorTan) * length);
 	}
 
 	void FileStream::Read(vector<uint32_t>* vec)
@@ -191,15 +341,10 @@ namespace Spartan
 		if (!vec)
 			return;
 
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
+		const uint32_t length = ReadCount(sizeof(uint32_t));
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(uint32_t) * length);
+		ReadBytes(vec->data(), sizeof(uint32_t) * length);
 	}
 
 	void FileStream::Read(vector<unsigned char>* vec)
@@ -207,15 +352,10 @@ namespace Spartan
 		if (!vec)
 			return;
 
-		vec->clear();
-		vec->shrink_to_fit();
-
-        const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
+		const uint32_t length = ReadCount(sizeof(unsigned char));
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(unsigned char) * length);
+		ReadBytes(vec->data(), sizeof(unsigned char) * length);
 	}
 
 	void FileStream::Read(vector<std::byte>* vec)
@@ -223,14 +363,9 @@ namespace Spartan
 		if (!vec)
 			return;
 
-		vec->clear();
-		vec->shrink_to_fit();
-
-		const auto length = ReadAs<uint32_t>();
-
-		vec->reserve(length);
+		const uint32_t length = ReadCount(sizeof(std::byte));
 		vec->resize(length);
 
-		in.read(reinterpret_cast<char*>(vec->data()), sizeof(std::byte) * length);
+		ReadBytes(vec->data(), sizeof(std::byte) * length);
 	}
 }
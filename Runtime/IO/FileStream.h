@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===================
 #include <vector>
 #include <fstream>
+#include <cstring>
 #include "../Math/Vector2.h"
 #include "../Math/Vector3.h"
 #include "../Math/Vector4.h"
@@ -34,6 +35,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace Spartan
 {
 	class Entity;
+	struct RHI_Vertex_PosTexNorTanQuantized;
 
 	enum FileStream_Mode : uint32_t
 	{
@@ -46,6 +48,9 @@ namespace Spartan
 	{
 	public:
 		FileStream(const std::string& path, uint32_t flags);
+		// Reads the file of another read stream (e.g. from several threads, each at its own offset) without opening or mapping it again.
+		// It's valid for as long as the other stream is open.
+		FileStream(const FileStream& source, uint64_t position);
 		~FileStream();
 
 		auto IsOpen() const { return m_is_open; }
@@ -76,17 +81,48 @@ namespace Spartan
 		>::type>
 		void Write(T value)
 		{
-			out.write(reinterpret_cast<char*>(&value), sizeof(value));
+			WriteBytes(&value, sizeof(value));
 		}
 
 		void Write(const std::string& value);
 		void Write(const std::vector<std::string>& value);
 		void Write(const std::vector<RHI_Vertex_PosTexNorTan>& value);
+		void Write(const std::vector<RHI_Vertex_PosTexNorTanQuantized>& value);
 		void Write(const std::vector<uint32_t>& value);
 		void Write(const std::vector<unsigned char>& value);
 		void Write(const std::vector<std::byte>& value);
 		void Skip(uint32_t n);
+
+		// Writes go through a user space buffer, so that small fields don't each become a stream call
+		void WriteBytes(const void* source, uint64_t size)
+		{
+			if (m_buffer_size + size > m_buffer.size())
+			{
+				Flush();
+
+				// Large blocks are written directly, there is nothing to gain from copying them first
+				if (size >= m_buffer.size())
+				{
+					out.write(reinterpret_cast<const char*>(source), size);
+					return;
+				}
+			}
+
+			std::memcpy(m_buffer.data() + m_buffer_size, source, size);
+			m_buffer_size += size;
+		}
+
+		// Writes out any buffered bytes
+		void Flush();
 		//===========================================================
+
+		//= POSITION ===========================================================
+		// The read or write cursor, as a byte offset from the start of the file
+		uint64_t GetPosition();
+		void Seek(uint64_t position);
+		// The size of the file, in read mode
+		uint64_t GetSize() const { return m_size; }
+		//======================================================================
 		
 		//= READING ===========================================
 		template <class T, class = typename std::enable_if
@@ -114,7 +150,7 @@ namespace Spartan
 		>::type>
 		void Read(T* value)
 		{
-			in.read(reinterpret_cast<char*>(value), sizeof(T));
+			ReadBytes(value, sizeof(T));
 		}
 		void Read(std::string* value);
 		void Read(std::vector<std::string>* vec);
@@ -123,6 +159,34 @@ namespace Spartan
 		void Read(std::vector<unsigned char>* vec);
 		void Read(std::vector<std::byte>* vec);
 
+		// Reads are copies out of the mapped file, reading past the end copies what's left
+		void ReadBytes(void* destination, uint64_t size)
+		{
+			const uint64_t available = m_position < m_size ? m_size - m_position : 0;
+			size = size < available ? size : available;
+
+			if (size != 0)
+			{
+				std::memcpy(destination, m_data + m_position, size);
+				m_position += size;
+			}
+		}
+
+		// Returns the next size bytes of the mapped file and moves past them, without copying anything.
+		// The pointer is valid until the stream is closed, it's null if the file doesn't have size more bytes.
+		const std::byte* ReadView(uint64_t size);
+
+		// Same as above, for arrays which were written with their element count (e.g. Write(const std::vector<uint32_t>&))
+		template <class T>
+		const T* ReadView(uint32_t* count)
+		{
+			*count = ReadAs<uint32_t>();
+			return reinterpret_cast<const T*>(ReadView(sizeof(T) * static_cast<uint64_t>(*count)));
+		}
+
+		// Asks the OS to start paging in a range of the mapped file in the background, ahead of reading it
+		void Prefetch(uint64_t offset, uint64_t size);
+
 		// Reading with explicit type definition
 		template <class T, class = typename std::enable_if
 		<
@@ -152,9 +216,26 @@ namespace Spartan
 		//=====================================================
 
 	private:
-		std::ofstream out;
-		std::ifstream in;
+		bool Map(const std::string& path);
+		void Unmap();
+
+		// Reads the element count of an array, clamped to the elements the rest of the file can hold (so that a corrupt count can't allocate gigabytes)
+		uint32_t ReadCount(uint64_t element_size);
+
 		uint32_t m_flags;
 		bool m_is_open;
+
+		// Writing
+		std::ofstream out;
+		std::vector<char> m_buffer;
+		uint64_t m_buffer_size = 0;
+
+		// Reading, the whole file is mapped (or loaded, if mapping fails) and read from memory
+		const std::byte* m_data	= nullptr;
+		uint64_t m_size			= 0;
+		uint64_t m_position		= 0;
+		void* m_file			= nullptr;
+		void* m_mapping			= nullptr;
+		std::vector<std::byte> m_data_loaded;
 	};
 }
@@ -42,6 +42,9 @@ namespace Spartan
 
 	Input::Input(Context* context) : ISubsystem(context)
 	{
+        // Window messages are pumped by the main thread
+        SetTickDependencies(Tick_Dependency_None, Tick_Dependency_Input, true);
+
         const WindowData& window_data   = context->m_engine->GetWindowData();
 		const auto window_handle	    = static_cast<HWND>(window_data.handle);
 
@@ -0,0 +1,336 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES =======
+#include "Spartan.h"
+#include "AabbTree.h"
+//==================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::Math
+{
+    namespace
+    {
+        // How much larger than their box leaves are, so that small movements don't require a re-insertion
+        constexpr float fat_margin = 0.1f;
+
+        BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box = a;
+            box.Merge(b);
+            return box;
+        }
+
+        float surface_area(const BoundingBox& box)
+        {
+            const Vector3 size = box.GetSize();
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool contains(const BoundingBox& outer, const BoundingBox& inner)
+        {
+            return outer.IsInside(inner) == Inside;
+        }
+    }
+
+    int32_t AabbTree::Insert(const BoundingBox& aabb, void* user_data)
+    {
+        const int32_t proxy         = AllocateNode();
+        Node& node                  = m_nodes[proxy];
+        node.aabb                   = BoundingBox(aabb.GetMin() - fat_margin, aabb.GetMax() + fat_margin);
+        node.aabb_tight             = aabb;
+        node.user_data              = user_data;
+        node.height                 = 0;
+
+        InsertLeaf(proxy);
+        m_proxy_count++;
+
+        return proxy;
+    }
+
+    void AabbTree::Remove(const int32_t proxy)
+    {
+        SPARTAN_ASSERT(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()) && m_nodes[proxy].IsLeaf());
+
+        RemoveLeaf(proxy);
+        FreeNode(proxy);
+        m_proxy_count--;
+    }
+
+    bool AabbTree::Update(const int32_t proxy, const BoundingBox& aabb)
+    {
+        SPARTAN_ASSERT(proxy >= 0 && proxy < static_cast<int32_t>(m_nodes.size()) && m_nodes[proxy].IsLeaf());
+
+        Node& node      = m_nodes[proxy];
+        node.aabb_tight = aabb;
+
+        // Still inside the fat box, nothing else to do
+        if (contains(node.aabb, aabb))
+            return false;
+
+        RemoveLeaf(proxy);
+        m_nodes[proxy].aabb = BoundingBox(aabb.GetMin() - fat_margin, aabb.GetMax() + fat_margin);
+        InsertLeaf(proxy);
+
+        return true;
+    }
+
+    void AabbTree::Clear()
+    {
+        m_nodes.clear();
+        m_root          = null_node;
+        m_free_list     = null_node;
+        m_proxy_count   = 0;
+    }
+
+    int32_t AabbTree::AllocateNode()
+    {
+        // Grow
+        if (m_free_list == null_node)
+        {
+            m_nodes.emplace_back();
+            return static_cast<int32_t>(m_nodes.size() - 1);
+        }
+
+        // Re-use a free node
+        const int32_t index = m_free_list;
+        m_free_list         = m_nodes[index].parent;
+        m_nodes[index]      = Node();
+        return index;
+    }
+
+    void AabbTree::FreeNode(const int32_t index)
+    {
+        Node& node      = m_nodes[index];
+        node.user_data  = nullptr;
+        node.height     = -1;
+        node.parent     = m_free_list;
+        m_free_list     = index;
+    }
+
+    void AabbTree::InsertLeaf(const int32_t leaf)
+    {
+        if (m_root == null_node)
+        {
+            m_root                  = leaf;
+            m_nodes[leaf].parent    = null_node;
+            return;
+        }
+
+        // Find the best sibling, descending towards the child which would grow the least (surface area heuristic)
+        const BoundingBox leaf_aabb = m_nodes[leaf].aabb;
+        int32_t index = m_root;
+        while (!m_nodes[index].IsLeaf())
+        {
+            const Node& node            = m_nodes[index];
+            const float area            = surface_area(node.aabb);
+            const float area_combined   = surface_area(merged(node.aabb, leaf_aabb));
+
+            // Cost of creating a new parent for this node and the new leaf
+            const float cost = 2.0f * area_combined;
+
+            // Minimum cost of pushing the leaf further down the tree
+            const float cost_inheritance = 2.0f * (area_combined - area);
+
+            auto cost_descend = [this, &leaf_aabb, cost_inheritance](const int32_t child)
+            {
+                const Node& node_child  = m_nodes[child];
+                const float area_new    = surface_area(merged(leaf_aabb, node_child.aabb));
+                return cost_inheritance + (node_child.IsLeaf() ? area_new : area_new - surface_area(node_child.aabb));
+            };
+
+            const float cost_left   = cost_descend(node.child_left);
+            const float cost_right  = cost_descend(node.child_right);
+
+            if (cost < cost_left && cost < cost_right)
+                break;
+
+            index = cost_left < cost_right ? node.child_left : node.child_right;
+        }
+
+        // Create a new parent for the sibling and the leaf
+        const int32_t sibling       = index;
+        const int32_t parent_old    = m_nodes[sibling].parent;
+        const int32_t parent_new    = AllocateNode();
+        m_nodes[parent_new].parent      = parent_old;
+        m_nodes[parent_new].aabb        = merged(leaf_aabb, m_nodes[sibling].aabb);
+        m_nodes[parent_new].height      = m_nodes[sibling].height + 1;
+        m_nodes[parent_new].child_left  = sibling;
+        m_nodes[parent_new].child_right = leaf;
+        m_nodes[sibling].parent         = parent_new;
+        m_nodes[leaf].parent            = parent_new;
+
+        if (parent_old != null_node)
+        {
+            if (m_nodes[parent_old].child_left == sibling)
+            {
+                m_nodes[parent_old].child_left = parent_new;
+            }
+            else
+            {
+                m_nodes[parent_old].child_right = parent_new;
+            }
+        }
+        else
+        {
+            m_root = parent_new;
+        }
+
+        // Walk back up, re-balancing and fixing the boxes and heights
+        Refit(m_nodes[leaf].parent);
+    }
+
+    void AabbTree::RemoveLeaf(const int32_t leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = null_node;
+            return;
+        }
+
+        const int32_t parent        = m_nodes[leaf].parent;
+        const int32_t grand_parent  = m_nodes[parent].parent;
+        const int32_t sibling       = m_nodes[parent].child_left == leaf ? m_nodes[parent].child_right : m_nodes[parent].child_left;
+
+        // The sibling takes the parent's place
+        if (grand_parent != null_node)
+        {
+            if (m_nodes[grand_parent].child_left == parent)
+            {
+                m_nodes[grand_parent].child_left = sibling;
+            }
+            else
+            {
+                m_nodes[grand_parent].child_right = sibling;
+            }
+
+            m_nodes[sibling].parent = grand_parent;
+            FreeNode(parent);
+
+            Refit(grand_parent);
+        }
+        else
+        {
+            m_root                  = sibling;
+            m_nodes[sibling].parent = null_node;
+            FreeNode(parent);
+        }
+    }
+
+    void AabbTree::Refit(int32_t index)
+    {
+        while (index != null_node)
+        {
+            index = Balance(index);
+
+            Node& node          = m_nodes[index];
+            const Node& left    = m_nodes[node.child_left];
+            const Node& right   = m_nodes[node.child_right];
+            node.height         = 1 + Helper::Max(left.height, right.height);
+            node.aabb           = merged(left.aabb, right.aabb);
+
+            index = node.parent;
+        }
+    }
+
+    // If one child of a is taller than the other by more than one level, it's promoted to a's place (a rotation).
+    // Returns the index of the node which is now at a's place.
+    int32_t AabbTree::Balance(const int32_t a)
+    {
+        Node& node_a = m_nodes[a];
+        if (node_a.IsLeaf() || node_a.height < 2)
+            return a;
+
+        const int32_t b     = node_a.child_left;
+        const int32_t c     = node_a.child_right;
+        const int32_t delta = m_nodes[c].height - m_nodes[b].height;
+
+        // The child to promote, and the one which stays
+        int32_t promote = null_node;
+        int32_t stay    = null_node;
+        if (delta > 1)
+        {
+            promote = c;
+            stay    = b;
+        }
+        else if (delta < -1)
+        {
+            promote = b;
+            stay    = c;
+        }
+        else
+        {
+            return a;
+        }
+
+        Node& node_promote      = m_nodes[promote];
+        const int32_t f         = node_promote.child_left;
+        const int32_t g         = node_promote.child_right;
+
+        // a's parent now points to the promoted node
+        node_promote.parent = node_a.parent;
+        if (node_promote.parent != null_node)
+        {
+            if (m_nodes[node_promote.parent].child_left == a)
+            {
+                m_nodes[node_promote.parent].child_left = promote;
+            }
+            else
+            {
+                m_nodes[node_promote.parent].child_right = promote;
+            }
+        }
+        else
+        {
+            m_root = promote;
+        }
+
+        // a becomes a child of the promoted node, next to its taller grand child,
+        // while the shorter grand child takes the promoted node's place under a.
+        const bool f_taller     = m_nodes[f].height > m_nodes[g].height;
+        const int32_t taller    = f_taller ? f : g;
+        const int32_t shorter   = f_taller ? g : f;
+
+        node_promote.child_left     = a;
+        node_promote.child_right    = taller;
+        node_a.parent               = promote;
+        m_nodes[shorter].parent     = a;
+
+        if (promote == c)
+        {
+            node_a.child_right = shorter;
+        }
+        else
+        {
+            node_a.child_left = shorter;
+        }
+
+        node_a.aabb         = merged(m_nodes[stay].aabb, m_nodes[shorter].aabb);
+        node_a.height       = 1 + Helper::Max(m_nodes[stay].height, m_nodes[shorter].height);
+        node_promote.aabb   = merged(node_a.aabb, m_nodes[taller].aabb);
+        node_promote.height = 1 + Helper::Max(node_a.height, m_nodes[taller].height);
+
+        return promote;
+    }
+}
@@ -0,0 +1,164 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <type_traits>
+#include "BoundingBox.h"
+#include "Frustum.h"
+#include "Ray.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan::Math
+{
+    // A dynamic bounding volume hierarchy. Leaves hold a box which is slightly larger (fat) than the
+    // one they were inserted with, so small movements don't have to touch the tree at all.
+    // Insertion picks the sibling with the smallest surface area cost, and rotations keep the tree balanced.
+    class SPARTAN_CLASS AabbTree
+    {
+    public:
+        static const int32_t null_node = -1;
+
+        AabbTree() = default;
+        ~AabbTree() = default;
+
+        // Returns a proxy id which identifies the box from then on
+        int32_t Insert(const BoundingBox& aabb, void* user_data);
+        void Remove(int32_t proxy);
+        // Returns true if the proxy was re-inserted (it moved outside of its fat box)
+        bool Update(int32_t proxy, const BoundingBox& aabb);
+        void Clear();
+
+        void* GetUserData(const int32_t proxy)              const { return m_nodes[proxy].user_data; }
+        const BoundingBox& GetAabb(const int32_t proxy)     const { return m_nodes[proxy].aabb_tight; }
+        uint32_t GetProxyCount()                            const { return m_proxy_count; }
+        uint32_t GetHeight()                                const { return m_root != null_node ? m_nodes[m_root].height : 0; }
+
+        // Invokes callback(user_data) for every box which overlaps
+        template <typename Callback>
+        void QueryBox(const BoundingBox& box, Callback&& callback) const
+        {
+            Query([&box](const BoundingBox& aabb) { return box.IsInside(aabb) != Outside; }, callback);
+        }
+
+        // Invokes callback(user_data) for every box which overlaps
+        template <typename Callback>
+        void QuerySphere(const Vector3& center, const float radius, Callback&& callback) const
+        {
+            const float radius_squared = radius * radius;
+            Query([&center, radius_squared](const BoundingBox& aabb)
+            {
+                // Distance from the closest point of the box
+                const Vector3 closest = Vector3
+                (
+                    Helper::Clamp(center.x, aabb.GetMin().x, aabb.GetMax().x),
+                    Helper::Clamp(center.y, aabb.GetMin().y, aabb.GetMax().y),
+                    Helper::Clamp(center.z, aabb.GetMin().z, aabb.GetMax().z)
+                );
+                return Vector3::DistanceSquared(center, closest) <= radius_squared;
+            }, callback);
+        }
+
+        // Invokes callback(user_data) for every box which is inside of the frustum (or intersects it)
+        template <typename Callback>
+        void QueryFrustum(const Frustum& frustum, Callback&& callback, const bool ignore_near_plane = false) const
+        {
+            Query([&frustum, ignore_near_plane](const BoundingBox& aabb) { return frustum.IsVisible(aabb.GetCenter(), aabb.GetExtents(), ignore_near_plane); }, callback);
+        }
+
+        // Invokes callback(user_data, distance) for every box which the ray hits
+        template <typename Callback>
+        void QueryRay(const Ray& ray, Callback&& callback) const
+        {
+            Query([&ray](const BoundingBox& aabb) { return ray.HitDistance(aabb) != INFINITY; }, [&ray, &callback](void* user_data, const BoundingBox& aabb)
+            {
+                callback(user_data, ray.HitDistance(aabb));
+            });
+        }
+
+    private:
+        struct Node
+        {
+            bool IsLeaf() const { return child_left == null_node; }
+
+            BoundingBox aabb;           // fat for leaves
+            BoundingBox aabb_tight;     // leaves only, what was inserted
+            void* user_data     = nullptr;
+            int32_t parent      = null_node; // or the next free node, if this node is free
+            int32_t child_left  = null_node;
+            int32_t child_right = null_node;
+            int32_t height      = -1; // 0 for leaves, -1 for free nodes
+        };
+
+        // Traverses the nodes which overlaps() accepts, leaves are tested with their tight box
+        template <typename Overlaps, typename Callback>
+        void Query(Overlaps&& overlaps, Callback&& callback) const
+        {
+            if (m_root == null_node)
+                return;
+
+            std::vector<int32_t> stack;
+            stack.reserve(64);
+            stack.emplace_back(m_root);
+
+            while (!stack.empty())
+            {
+                const Node& node = m_nodes[stack.back()];
+                stack.pop_back();
+
+                if (node.IsLeaf())
+                {
+                    if (overlaps(node.aabb_tight))
+                    {
+                        if constexpr (std::is_invocable_v<Callback, void*, const BoundingBox&>)
+                        {
+                            callback(node.user_data, node.aabb_tight);
+                        }
+                        else
+                        {
+                            callback(node.user_data);
+                        }
+                    }
+                }
+                else if (overlaps(node.aabb))
+                {
+                    stack.emplace_back(node.child_left);
+                    stack.emplace_back(node.child_right);
+                }
+            }
+        }
+
+        int32_t AllocateNode();
+        void FreeNode(int32_t index);
+        void InsertLeaf(int32_t leaf);
+        void RemoveLeaf(int32_t leaf);
+        int32_t Balance(int32_t index);
+        void Refit(int32_t index);
+
+        std::vector<Node> m_nodes;
+        int32_t m_root          = null_node;
+        int32_t m_free_list     = null_node;
+        uint32_t m_proxy_count  = 0;
+    };
+}
@@ -113,12 +113,26 @@ namespace Spartan::Math
 	{
         const Vector3 center_new = transform * GetCenter();
         const Vector3 extent_old = GetExtents();
+#if defined(SPARTAN_MATH_SSE)
+        // |row0| * x + |row1| * y + |row2| * z, the rows are the transposed columns
+        __m128 r0 = transform.LoadColumn(0), r1 = transform.LoadColumn(1), r2 = transform.LoadColumn(2), r3 = transform.LoadColumn(3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        const __m128 abs_mask   = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128 extent           = _mm_mul_ps(_mm_and_ps(r0, abs_mask), _mm_set1_ps(extent_old.x));
+        extent                  = _mm_add_ps(extent, _mm_mul_ps(_mm_and_ps(r1, abs_mask), _mm_set1_ps(extent_old.y)));
+        extent                  = _mm_add_ps(extent, _mm_mul_ps(_mm_and_ps(r2, abs_mask), _mm_set1_ps(extent_old.z)));
+
+        float e[4];
+        _mm_storeu_ps(e, extent);
+        const Vector3 extend_new = Vector3(e[0], e[1], e[2]);
+#else
         const Vector3 extend_new = Vector3
 		(
 			Helper::Abs(transform.m00) * extent_old.x + Helper::Abs(transform.m10) * extent_old.y + Helper::Abs(transform.m20) * extent_old.z,
 			Helper::Abs(transform.m01) * extent_old.x + Helper::Abs(transform.m11) * extent_old.y + Helper::Abs(transform.m21) * extent_old.z,
 			Helper::Abs(transform.m02) * extent_old.x + Helper::Abs(transform.m12) * extent_old.y + Helper::Abs(transform.m22) * extent_old.z
 		);
+#endif
 
 		return BoundingBox(center_new - extend_new, center_new + extend_new);
 	}
@@ -129,7 +143,7 @@ namespace Spartan::Math
         m_min.y = Helper::Min(m_min.y, box.m_min.y);
         m_min.z = Helper::Min(m_min.z, box.m_min.z);
         m_max.x = Helper::Max(m_max.x, box.m_max.x);
-        m_max.y = Helper::Max(m_max.x, box.m_max.x);
-        m_max.z = Helper::Max(m_max.x, box.m_max.x);
+        m_max.y = Helper::Max(m_max.y, box.m_max.y);
+        m_max.z = Helper::Max(m_max.z, box.m_max.z);
     }
 }
@@ -0,0 +1,82 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===========
+#include <vector>
+#include "BoundingBox.h"
+//======================
+
+namespace Spartan::Math
+{
+    // Bounding boxes (as centers and extents) stored as a structure of arrays, so that they can be tested 4 at a time.
+    // The arrays are padded to a multiple of 4 elements, the padding is never reported as visible.
+    class BoundingBoxArray
+    {
+    public:
+        BoundingBoxArray() = default;
+        ~BoundingBoxArray() = default;
+
+        void Clear()
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                m_center[i].clear();
+                m_extent[i].clear();
+            }
+
+            m_count = 0;
+        }
+
+        void Add(const BoundingBox& box)
+        {
+            // Grow by 4, so that the last elements can always be loaded as a whole
+            if (m_count % 4 == 0)
+            {
+                for (uint32_t i = 0; i < 3; i++)
+                {
+                    m_center[i].resize(m_count + 4, 0.0f);
+                    m_extent[i].resize(m_count + 4, 0.0f);
+                }
+            }
+
+            const Vector3 center    = box.GetCenter();
+            const Vector3 extent    = box.GetExtents();
+            m_center[0][m_count]    = center.x;
+            m_center[1][m_count]    = center.y;
+            m_center[2][m_count]    = center.z;
+            m_extent[0][m_count]    = extent.x;
+            m_extent[1][m_count]    = extent.y;
+            m_extent[2][m_count]    = extent.z;
+            m_count++;
+        }
+
+        uint32_t Size() const                           { return m_count; }
+        const float* GetCenter(uint32_t axis) const     { return m_center[axis].data(); }
+        const float* GetExtent(uint32_t axis) const     { return m_extent[axis].data(); }
+
+    private:
+        std::vector<float> m_center[3];
+        std::vector<float> m_extent[3];
+        uint32_t m_count = 0;
+    };
+}
@@ -19,9 +19,11 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-//= INCLUDES =======
+//= INCLUDES ================
 #include "Spartan.h"
-//==================
+#include "BoundingBoxArray.h"
+#include <xmmintrin.h>
+//===========================
 
 //= NAMESPACES =====
 using namespace std;
@@ -86,79 +88,91 @@ namespace Spartan::Math
 
     bool Frustum::IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane /*= false*/) const
     {
-        float radius = 0.0f;
-
-        if (!ignore_near_plane)
+        // Same test as CullBoxes(), for a single box
+        for (uint32_t i = ignore_near_plane ? 2 : 0; i < 6; i++)
         {
-            radius = Helper::Max3(extent.x, extent.y, extent.z);
+            const Plane& plane  = m_planes[i];
+            const float d       = Vector3::Dot(plane.normal, center) + plane.d;
+            const float r       = extent.x * Helper::Abs(plane.normal.x) + extent.y * Helper::Abs(plane.normal.y) + extent.z * Helper::Abs(plane.normal.z);
+
+            if (d + r < 0.0f)
+                return false;
         }
-        else
+
+        return true;
+    }
+
+    bool Frustum::IsVisible(const Vector3& center, const float radius, bool ignore_near_plane /*= false*/) const
+    {
+        // Same test, for a sphere
+        for (uint32_t i = ignore_near_plane ? 2 : 0; i < 6; i++)
         {
-            constexpr float z = numeric_limits<float>::infinity(); // reverse-z only (but I must read form Renderer)
-            radius = Helper::Max3(extent.x, extent.y, z);
+            const Plane& plane = m_planes[i];
+            if (Vector3::Dot(plane.normal, center) + plane.d + radius < 0.0f)
+                return false;
         }
 
-        // Check sphere first as it's cheaper
-        if (CheckSphere(center, radius) != Outside)
-            return true;
+        return true;
+    }
 
-        if (CheckCube(center, radius) != Outside)
-            return true;
+    uint32_t Frustum::CullBoxes(const BoundingBoxArray& boxes, uint32_t* indices, bool ignore_near_plane /*= false*/) const
+    {
+        // Broadcast the planes (and their absolute normals) once
+        __m128 normal[6][3];
+        __m128 normal_abs[6][3];
+        __m128 distance[6];
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            const Plane& plane = m_planes[i];
+            normal[i][0]        = _mm_set1_ps(plane.normal.x);
+            normal[i][1]        = _mm_set1_ps(plane.normal.y);
+            normal[i][2]        = _mm_set1_ps(plane.normal.z);
+            normal_abs[i][0]    = _mm_set1_ps(Helper::Abs(plane.normal.x));
+            normal_abs[i][1]    = _mm_set1_ps(Helper::Abs(plane.normal.y));
+            normal_abs[i][2]    = _mm_set1_ps(Helper::Abs(plane.normal.z));
+            distance[i]         = _mm_set1_ps(plane.d);
+        }
 
-        return false;
-    }
+        // The first two planes are the depth planes
+        const uint32_t plane_first  = ignore_near_plane ? 2 : 0;
+        const __m128 zero           = _mm_setzero_ps();
+        const uint32_t box_count    = boxes.Size();
+        uint32_t visible_count      = 0;
 
-	Intersection Frustum::CheckCube(const Vector3& center, const Vector3& extent) const
-	{
-        Intersection result = Inside;
-        Plane plane_abs;
-
-		// Check if any one point of the cube is in the view frustum.
-		
-		for (const Plane& plane : m_planes)
-		{
-            plane_abs.normal    = plane.normal.Abs();
-            plane_abs.d         = plane.d;
-
-            const float d   = center.x * plane.normal.x + center.y * plane.normal.y + center.z * plane.normal.z;
-            const float r   = extent.x * plane_abs.normal.x + extent.y * plane_abs.normal.y + extent.z * plane_abs.normal.z;
-
-            const float d_p_r = d + r;
-            const float d_m_r = d - r;
-
-			if (d_p_r < -plane.d)
-			{
-				result = Outside;
-				break;
-			}
-
-			if (d_m_r < -plane.d)
-			{
-				result = Intersects;
-			}
-		}
-
-		return result;
-	}
+        for (uint32_t i = 0; i < box_count; i += 4)
+        {
+            const __m128 center_x = _mm_loadu_ps(boxes.GetCenter(0) + i);
+            const __m128 center_y = _mm_loadu_ps(boxes.GetCenter(1) + i);
+            const __m128 center_z = _mm_loadu_ps(boxes.GetCenter(2) + i);
+            const __m128 extent_x = _mm_loadu_ps(boxes.GetExtent(0) + i);
+            const __m128 extent_y = _mm_loadu_ps(boxes.GetExtent(1) + i);
+            const __m128 extent_z = _mm_loadu_ps(boxes.GetExtent(2) + i);
+
+            // A box is outside if it's entirely behind any one plane, that is, if the signed distance
+            // of its center plus its extents projected on the plane's normal is negative.
+            __m128 outside = zero;
+            for (uint32_t p = plane_first; p < 6; p++)
+            {
+                __m128 d = _mm_add_ps(_mm_mul_ps(center_x, normal[p][0]), distance[p]);
+                d        = _mm_add_ps(d, _mm_mul_ps(center_y, normal[p][1]));
+                d        = _mm_add_ps(d, _mm_mul_ps(center_z, normal[p][2]));
+                __m128 r = _mm_mul_ps(extent_x, normal_abs[p][0]);
+                r        = _mm_add_ps(r, _mm_mul_ps(extent_y, normal_abs[p][1]));
+                r        = _mm_add_ps(r, _mm_mul_ps(extent_z, normal_abs[p][2]));
+                outside  = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+            }
+
+            // Write the indices of the visible boxes (skipping the padding)
+            const int visible = ~_mm_movemask_ps(outside);
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                if ((visible & (1 << j)) && (i + j) < box_count)
+                {
+                    indices[visible_count++] = i + j;
+                }
+            }
+        }
 
-	Intersection Frustum::CheckSphere(const Vector3& center, float radius) const
-	{
-		// calculate our distances to each of the planes
-		for (const auto& plane : m_planes)
-		{
-			// find the distance to this plane
-            const float distance = Vector3::Dot(plane.normal, center) + plane.d;
-
-			// if this distance is < -sphere.radius, we are outside
-			if (distance < -radius)
-				return Outside;
-
-			// else if the distance is between +- radius, then we intersect
-			if (static_cast<float>(Helper::Abs(distance)) < radius)
-				return Intersects;
-		}
-
-		// otherwise we are fully in view
-		return Inside;
-	}
+        return visible_count;
+    }
 }
@@ -29,6 +29,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan::Math
 {
+    class BoundingBoxArray;
+
 	class Frustum
 	{
 	public:
@@ -37,11 +39,13 @@ namespace Spartan::Math
 		~Frustum() = default;
 
         bool IsVisible(const Vector3& center, const Vector3& extent, bool ignore_near_plane = false) const;
+        bool IsVisible(const Vector3& center, float radius, bool ignore_near_plane = false) const;
 
-	private:
-        Intersection CheckCube(const Vector3& center, const Vector3& extent) const;
-        Intersection CheckSphere(const Vector3& center, float radius) const;
+        // Tests all the boxes (4 at a time) and writes the indices of the visible ones, returns how many were written.
+        // The indices must have room for boxes.Size() elements. Ignoring the near plane ignores both depth planes (reverse-z flips them).
+        uint32_t CullBoxes(const BoundingBoxArray& boxes, uint32_t* indices, bool ignore_near_plane = false) const;
 
+	private:
 		Plane m_planes[6];
 	};
 }
@@ -27,6 +27,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <random>
 //===============
 
+// SSE2 is part of x64, so it's always there. The math classes fall back to scalar code on any other target.
+// The SSE paths perform the same operations in the same order as the scalar ones, so their results are bit-exact.
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define SPARTAN_MATH_SSE
+#include <emmintrin.h>
+#endif
+
 namespace Spartan::Math
 {
     enum Intersection
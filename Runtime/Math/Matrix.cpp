@@ -43,4 +43,71 @@ namespace Spartan::Math
 		sprintf_s(tempBuffer, "%f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f, %f", m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33);
 		return string(tempBuffer);
 	}
+
+#if defined(SPARTAN_MATH_SSE)
+    // The 2x2 determinants (v0 to v5) of two rows, laid out as (v0, v1, v2, v3) and (v4, v5, -, -)
+    static inline void determinants_2x2(const __m128 p, const __m128 q, __m128& v0123, __m128& v45)
+    {
+        v0123 = _mm_sub_ps
+        (
+            _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 0, 0, 0)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 2, 1))),
+            _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 2, 1)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 0, 0, 0)))
+        );
+
+        v45 = _mm_sub_ps
+        (
+            _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 1, 2, 1)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3))),
+            _mm_mul_ps(_mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 1, 2, 1)))
+        );
+    }
+
+    // One column of the (unscaled) adjugate, the lanes are (v5 * r.y - v4 * r.z + v3 * r.w, v5 * r.x - v2 * r.z + v1 * r.w, ...)
+    static inline __m128 cofactors(const __m128 v0123, const __m128 v45, const __m128 row, const __m128 sign)
+    {
+        const __m128 v4433 = _mm_shuffle_ps(v45, v0123, _MM_SHUFFLE(3, 3, 0, 0));
+        const __m128 v4421 = _mm_shuffle_ps(v45, v0123, _MM_SHUFFLE(1, 2, 0, 0));
+        const __m128 a     = _mm_shuffle_ps(v45, v4433, _MM_SHUFFLE(2, 0, 1, 1));           // v5, v5, v4, v3
+        const __m128 c     = _mm_shuffle_ps(v4421, v4421, _MM_SHUFFLE(3, 2, 2, 0));       // v4, v2, v2, v1
+        const __m128 e     = _mm_shuffle_ps(v0123, v0123, _MM_SHUFFLE(0, 0, 1, 3));       // v3, v1, v0, v0
+        const __m128 b     = _mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 1));           // y, x, x, x
+        const __m128 d     = _mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 2, 2));           // z, z, y, y
+        const __m128 f     = _mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 3, 3, 3));           // w, w, w, z
+
+        const __m128 result = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(a, b), _mm_mul_ps(c, d)), _mm_mul_ps(e, f));
+        return _mm_xor_ps(result, sign);
+    }
+
+    Matrix Matrix::InvertSse(const Matrix& matrix)
+    {
+        // Rows
+        __m128 r0 = matrix.LoadColumn(0), r1 = matrix.LoadColumn(1), r2 = matrix.LoadColumn(2), r3 = matrix.LoadColumn(3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        const __m128 sign_even = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+        const __m128 sign_odd  = _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f);
+
+        __m128 v0123, v45;
+        determinants_2x2(r2, r3, v0123, v45);
+        __m128 c0 = cofactors(v0123, v45, r1, sign_even);
+        __m128 c1 = cofactors(v0123, v45, r0, sign_odd);
+
+        determinants_2x2(r1, r3, v0123, v45);
+        __m128 c2 = cofactors(v0123, v45, r0, sign_even);
+
+        determinants_2x2(r1, r2, v0123, v45);
+        __m128 c3 = cofactors(v0123, v45, r0, sign_odd);
+
+        // The determinant is the first column of the adjugate against the first row
+        float i[4];
+        _mm_storeu_ps(i, c0);
+        const __m128 inv_det = _mm_set1_ps(1.0f / (i[0] * matrix.m00 + i[1] * matrix.m01 + i[2] * matrix.m02 + i[3] * matrix.m03));
+
+        Matrix result;
+        _mm_storeu_ps(result.Column(0), _mm_mul_ps(c0, inv_det));
+        _mm_storeu_ps(result.Column(1), _mm_mul_ps(c1, inv_det));
+        _mm_storeu_ps(result.Column(2), _mm_mul_ps(c2, inv_det));
+        _mm_storeu_ps(result.Column(3), _mm_mul_ps(c3, inv_det));
+        return result;
+    }
+#endif
 }
@@ -125,10 +125,21 @@ namespace Spartan::Math
 
 			// Extract rotation and remove scaling
 			Matrix normalized;
+#if defined(SPARTAN_MATH_SSE)
+            // Every column divided by the scale of each row, the last row and column are the identity's
+            const __m128 divisor = _mm_setr_ps(scale.x, scale.y, scale.z, 1.0f);
+            const __m128 mask    = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                _mm_storeu_ps(normalized.Column(i), _mm_and_ps(_mm_div_ps(LoadColumn(i), divisor), mask));
+            }
+            _mm_storeu_ps(normalized.Column(3), _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+#else
 			normalized.m00 = m00 / scale.x; normalized.m01 = m01 / scale.x; normalized.m02 = m02 / scale.x; normalized.m03 = 0.0f;
 			normalized.m10 = m10 / scale.y; normalized.m11 = m11 / scale.y; normalized.m12 = m12 / scale.y; normalized.m13 = 0.0f;
 			normalized.m20 = m20 / scale.z; normalized.m21 = m21 / scale.z; normalized.m22 = m22 / scale.z; normalized.m23 = 0.0f;
 			normalized.m30 = 0; normalized.m31 = 0; normalized.m32 = 0; normalized.m33 = 1.0f;
+#endif
 
 			return RotationMatrixToQuaternion(normalized);
 		}
@@ -191,6 +202,20 @@ namespace Spartan::Math
 		//= SCALE ========================================================================================
         [[nodiscard]] Vector3 GetScale() const
 		{
+#if defined(SPARTAN_MATH_SSE)
+            // The rows are across the columns, so every lane computes the scale of one row
+            const __m128 c0         = LoadColumn(0);
+            const __m128 c1         = LoadColumn(1);
+            const __m128 c2         = LoadColumn(2);
+            const __m128 c3         = LoadColumn(3);
+            const __m128 product    = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(c0, c1), c2), c3);
+            const __m128 sign       = _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(product, _mm_setzero_ps()), _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f));
+            const __m128 length     = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, c0), _mm_mul_ps(c1, c1)), _mm_mul_ps(c2, c2)));
+
+            float result[4];
+            _mm_storeu_ps(result, _mm_mul_ps(sign, length));
+            return Vector3(result[0], result[1], result[2]);
+#else
             const int xs = (Helper::Sign(m00 * m01 * m02 * m03) < 0) ? -1 : 1;
             const int ys = (Helper::Sign(m10 * m11 * m12 * m13) < 0) ? -1 : 1;
             const int zs = (Helper::Sign(m20 * m21 * m22 * m23) < 0) ? -1 : 1;
@@ -200,6 +225,7 @@ namespace Spartan::Math
 				static_cast<float>(ys) * Helper::Sqrt(m10 * m10 + m11 * m11 + m12 * m12),
 				static_cast<float>(zs) * Helper::Sqrt(m20 * m20 + m21 * m21 + m22 * m22)
 			);
+#endif
 		}
 
 		static inline Matrix CreateScale(float scale) { return CreateScale(scale, scale, scale); }
@@ -273,12 +299,24 @@ namespace Spartan::Math
 		void Transpose() { *this = Transpose(*this); }
 		static inline Matrix Transpose(const Matrix& matrix)
 		{
+#if defined(SPARTAN_MATH_SSE)
+            __m128 c0 = matrix.LoadColumn(0), c1 = matrix.LoadColumn(1), c2 = matrix.LoadColumn(2), c3 = matrix.LoadColumn(3);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            Matrix result;
+            _mm_storeu_ps(result.Column(0), c0);
+            _mm_storeu_ps(result.Column(1), c1);
+            _mm_storeu_ps(result.Column(2), c2);
+            _mm_storeu_ps(result.Column(3), c3);
+            return result;
+#else
 			return Matrix(
 				matrix.m00, matrix.m10, matrix.m20, matrix.m30,
 				matrix.m01, matrix.m11, matrix.m21, matrix.m31,
 				matrix.m02, matrix.m12, matrix.m22, matrix.m32,
 				matrix.m03, matrix.m13, matrix.m23, matrix.m33
 			);
+#endif
 		}
 		//================================================================================================
 
@@ -286,6 +324,9 @@ namespace Spartan::Math
         [[nodiscard]] Matrix Inverted() const { return Invert(*this); }
 		static inline Matrix Invert(const Matrix& matrix)
 		{
+#if defined(SPARTAN_MATH_SSE)
+            return InvertSse(matrix);
+#else
 			float v0 = matrix.m20 * matrix.m31 - matrix.m21 * matrix.m30;
 			float v1 = matrix.m20 * matrix.m32 - matrix.m22 * matrix.m30;
 			float v2 = matrix.m20 * matrix.m33 - matrix.m23 *matrix.m30;
@@ -339,6 +380,7 @@ namespace Spartan::Math
 				i10, i11, i12, i13,
 				i20, i21, i22, i23,
 				i30, i31, i32, i33);
+#endif
 		}
 		//================================================================================================
 
@@ -360,6 +402,25 @@ namespace Spartan::Math
 		//= MULTIPLICATION ================================================================================================================
 		Matrix operator*(const Matrix& rhs) const
 		{
+#if defined(SPARTAN_MATH_SSE)
+            // Every column of the result is a combination of the columns of this matrix, weighted by a column of rhs
+            const __m128 c0 = LoadColumn(0);
+            const __m128 c1 = LoadColumn(1);
+            const __m128 c2 = LoadColumn(2);
+            const __m128 c3 = LoadColumn(3);
+
+            Matrix result;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                const __m128 weights = rhs.LoadColumn(i);
+                __m128 column        = _mm_mul_ps(c0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+                column               = _mm_add_ps(column, _mm_mul_ps(c1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+                column               = _mm_add_ps(column, _mm_mul_ps(c2, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+                column               = _mm_add_ps(column, _mm_mul_ps(c3, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm_storeu_ps(result.Column(i), column);
+            }
+            return result;
+#else
 			return Matrix(
 				m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
 				m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
@@ -378,12 +439,19 @@ namespace Spartan::Math
 				m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + m33 * rhs.m32,
 				m30 * rhs.m03 + m31 * rhs.m13 + m32 * rhs.m23 + m33 * rhs.m33
 			);
+#endif
 		}
 
 		void operator*=(const Matrix& rhs) { (*this) = (*this) * rhs; }
 
 		Vector3 operator*(const Vector3& rhs) const
 		{
+#if defined(SPARTAN_MATH_SSE)
+            float result[4];
+            _mm_storeu_ps(result, TransformSse(rhs.x, rhs.y, rhs.z, 1.0f));
+            const float w = 1 / result[3];
+            return Vector3(result[0] * w, result[1] * w, result[2] * w);
+#else
 			Vector4 vWorking;
 
 			vWorking.x = (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + m30;
@@ -392,10 +460,16 @@ namespace Spartan::Math
 			vWorking.w = 1 / ((rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + m33);
 
 			return Vector3(vWorking.x * vWorking.w, vWorking.y * vWorking.w, vWorking.z * vWorking.w);
+#endif
 		}
 
         Vector4 operator*(const Vector4& rhs) const
         {
+#if defined(SPARTAN_MATH_SSE)
+            Vector4 result;
+            _mm_storeu_ps(&result.x, TransformSse(rhs.x, rhs.y, rhs.z, rhs.w));
+            return result;
+#else
             return Vector4
             (
                 (rhs.x * m00) + (rhs.y * m10) + (rhs.z * m20) + (rhs.w * m30),
@@ -403,6 +477,7 @@ namespace Spartan::Math
                 (rhs.x * m02) + (rhs.y * m12) + (rhs.z * m22) + (rhs.w * m32),
                 (rhs.x * m03) + (rhs.y * m13) + (rhs.z * m23) + (rhs.w * m33)
             );
+#endif
         }
 		//=================================================================================================================================
 
@@ -442,6 +517,25 @@ namespace Spartan::Math
         [[nodiscard]] const float* Data() const { return &m00; }
         [[nodiscard]] std::string ToString() const;
 
+#if defined(SPARTAN_MATH_SSE)
+        [[nodiscard]] __m128 LoadColumn(const uint32_t index) const { return _mm_loadu_ps(&m00 + index * 4); }
+        [[nodiscard]] float* Column(const uint32_t index)           { return &m00 + index * 4; }
+
+        // x * row0 + y * row1 + z * row2 + w * row3, which is the scalar order of operations for a vector times this matrix
+        [[nodiscard]] __m128 TransformSse(const float x, const float y, const float z, const float w) const
+        {
+            __m128 r0 = LoadColumn(0), r1 = LoadColumn(1), r2 = LoadColumn(2), r3 = LoadColumn(3);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            __m128 result = _mm_mul_ps(_mm_set1_ps(x), r0);
+            result        = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), r1));
+            result        = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), r2));
+            return _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(w), r3));
+        }
+
+        static Matrix InvertSse(const Matrix& matrix);
+#endif
+
 		// Column-major memory representation 
         float m00 = 0.0f, m10 = 0.0f, m20 = 0.0f, m30 = 0.0f;
         float m01 = 0.0f, m11 = 0.0f, m21 = 0.0f, m31 = 0.0f;
@@ -232,6 +232,21 @@ namespace Spartan::Math
 
         static inline Quaternion Multiply(const Quaternion& Qa, const Quaternion& Qb)
         {
+#if defined(SPARTAN_MATH_SSE)
+            const __m128 a      = _mm_loadu_ps(&Qa.x);
+            const __m128 b      = _mm_loadu_ps(&Qb.x);
+            const __m128 a_yzx  = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+            const __m128 a_zxy  = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+            const __m128 b_yzx  = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+            const __m128 b_zxy  = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+            const __m128 cross  = _mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy), _mm_mul_ps(a_zxy, b_yzx));
+            const __m128 xyz    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(Qb.w)), _mm_mul_ps(b, _mm_set1_ps(Qa.w))), cross);
+
+            Quaternion result;
+            _mm_storeu_ps(&result.x, xyz);
+            result.w = (Qa.w * Qb.w) - (((Qa.x * Qb.x) + (Qa.y * Qb.y)) + (Qa.z * Qb.z));
+            return result;
+#else
             const float x = Qa.x;
             const float y = Qa.y;
             const float z = Qa.z;
@@ -251,6 +266,7 @@ namespace Spartan::Math
                 ((z * num) + (num2 * w)) + num10,
                 (w * num) - num9
             );
+#endif
         }
 
 		Quaternion operator*(const Quaternion& rhs) const
@@ -265,11 +281,23 @@ namespace Spartan::Math
 
 		Vector3 operator*(const Vector3& rhs) const
 		{
+#if defined(SPARTAN_MATH_SSE)
+            const __m128 q      = _mm_setr_ps(x, y, z, 0.0f);
+            const __m128 v      = _mm_setr_ps(rhs.x, rhs.y, rhs.z, 0.0f);
+            const __m128 cross1 = Cross(q, v);
+            const __m128 cross2 = Cross(q, cross1);
+            const __m128 result = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(2.0f), _mm_add_ps(_mm_mul_ps(cross1, _mm_set1_ps(w)), cross2)));
+
+            float xyz[4];
+            _mm_storeu_ps(xyz, result);
+            return Vector3(xyz[0], xyz[1], xyz[2]);
+#else
             const Vector3 qVec(x, y, z);
             const Vector3 cross1(qVec.Cross(rhs));
             const Vector3 cross2(qVec.Cross(cross1));
 
 			return rhs + 2.0f * (cross1 * w + cross2);
+#endif
 		}
 
 		Quaternion& operator *=(float rhs)
@@ -301,7 +329,22 @@ namespace Spartan::Math
 
 		std::string ToString() const;
 		float x, y, z, w;
+
 		static const Quaternion Identity;
+
+#if defined(SPARTAN_MATH_SSE)
+    private:
+        // Same as Vector3::Cross, including the negated y
+        static inline __m128 Cross(const __m128 a, const __m128 b)
+        {
+            const __m128 a_yxx  = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 0, 1));
+            const __m128 a_zzy  = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 2, 2));
+            const __m128 b_yxx  = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 0, 1));
+            const __m128 b_zzy  = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 2, 2));
+            const __m128 result = _mm_sub_ps(_mm_mul_ps(a_yxx, b_zzy), _mm_mul_ps(b_yxx, a_zzy));
+            return _mm_xor_ps(result, _mm_setr_ps(0.0f, -0.0f, 0.0f, 0.0f));
+        }
+#endif
 	};
 
 	// Reverse order operators
@@ -24,7 +24,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../World/World.h"
 #include "../World/Entity.h"
 #include "../World/Components/Environment.h"
-#include "../World/Components/Renderable.h"
 //==========================================
 
 //= NAMESPACES =====
@@ -44,32 +43,17 @@ namespace Spartan::Math
 
 	vector<RayHit> Ray::Trace(Context* context) const
 	{
-		// Find all the entities that the ray hits
+		// Find all the entities that the ray hits, only visiting the boxes of the world's spatial index which the ray crosses
 		vector<RayHit> hits;
-		const auto& entities = context->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
+		context->GetSubsystem<World>()->GetSpatialIndex().QueryRay(*this, [this, &hits](void* user_data, const float distance)
 		{
-			// Make sure there entity has a renderable
-			if (!entity->HasComponent<Renderable>())
-				continue;
-
-			// Get object oriented bounding box
-			const auto& aabb = entity->GetComponent<Renderable>()->GetAabb();
-
-			// Compute hit distance
-			auto distance = HitDistance(aabb);
-
-			// Don't store hit data if there was no hit
-			if (distance == INFINITY)
-				continue;
-
 			hits.emplace_back(
-                entity,                             // Entity
-                m_start + distance * m_direction,   // Position
-                distance,                           // Distance
-                distance == 0.0f                    // Inside
+                static_cast<Entity*>(user_data)->GetPtrShared(),    // Entity
+                m_start + distance * m_direction,                   // Position
+                distance,                                           // Distance
+                distance == 0.0f                                    // Inside
             );
-		}
+		});
 
 		// Sort by distance (ascending)
 		sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
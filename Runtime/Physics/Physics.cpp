@@ -39,6 +39,10 @@ namespace Spartan
 
 	Physics::Physics(Context* context) : ISubsystem(context)
 	{
+        // Motion states keep the poses (the rigid bodies exchange them with the transforms when the world ticks), so the simulation runs alongside the world.
+        // The debug draw adds lines to the renderer (which guards them), and the renderer options are read.
+        SetTickDependencies(Tick_Dependency_Profiling | Tick_Dependency_Rendering, Tick_Dependency_Physics, false);
+
         m_broadphase        = new btDbvtBroadphase();
         m_constraint_solver = new btSequentialImpulseConstraintSolver();
 
@@ -116,6 +120,8 @@ namespace Spartan
 	{
 		if (!m_world)
 			return;
+
+        lock_guard<mutex> lock(m_mutex);
 		
 		// Debug draw
 		if (m_renderer->GetOptions() & Render_Debug_Physics)
@@ -22,6 +22,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ==================
+#include <mutex>
 #include "../Core/ISubsystem.h"
 #include "../Math/Vector3.h"
 //=============================
@@ -75,6 +76,9 @@ namespace Spartan
         auto GetPhysicsDebugDraw()  const { return m_debug_draw; }
 		bool IsSimulating()         const { return m_simulating; }
 
+        // Held while the simulation steps, the world holds it while its entities tick (their components are what touches the bodies)
+        std::mutex& GetMutex() { return m_mutex; }
+
 	private:
         btBroadphaseInterface* m_broadphase                         = nullptr;
         btCollisionDispatcher* m_collision_dispatcher               = nullptr;
@@ -87,6 +91,7 @@ namespace Spartan
         // Misc
         Renderer* m_renderer = nullptr;
         Profiler* m_profiler = nullptr;
+        std::mutex m_mutex;
 
 		//= PROPERTIES =================================================
         int m_max_sub_steps         = 1;
@@ -37,6 +37,10 @@ namespace Spartan
 {
 	Profiler::Profiler(Context* context) : ISubsystem(context)
 	{
+        // Resolves the time blocks of the frame, so it has to tick after everything that records them.
+        // It reads the GPU's timestamps and memory through the immediate context, which belongs to the main thread.
+        SetTickDependencies(Tick_Dependency_Rendering, Tick_Dependency_Profiling | Tick_Dependency_Rhi, true);
+
         m_time_blocks_read.reserve(m_time_block_capacity);
         m_time_blocks_read.resize(m_time_block_capacity);
 		m_time_blocks_write.reserve(m_time_block_capacity);
@@ -211,7 +215,9 @@ namespace Spartan
 		if (!can_profile_cpu && !can_profile_gpu)
 			return;
 
-        // Last incomplete block of the same type, is the parent
+        lock_guard<mutex> lock(m_mutex_time_blocks);
+
+        // Last incomplete block of the same type (and thread), is the parent
         TimeBlock* time_block_parent = GetLastIncompleteTimeBlock(type);
 
 		if (TimeBlock* time_block = GetNewTimeBlock())
@@ -226,6 +232,8 @@ namespace Spartan
         if (m_increase_capacity)
             return;
 
+        lock_guard<mutex> lock(m_mutex_time_blocks);
+
 		if (TimeBlock* time_block = GetLastIncompleteTimeBlock())
 		{
 			time_block->End();
@@ -263,10 +271,15 @@ namespace Spartan
 
 	TimeBlock* Profiler::GetLastIncompleteTimeBlock(TimeBlock_Type type /*= TimeBlock_Undefined*/)
 	{
+        const thread::id thread_id = this_thread::get_id();
+
 		for (int i = m_time_block_count - 1; i >= 0; i--)
 		{
 			TimeBlock& time_block = m_time_blocks_write[i];
 
+            if (time_block.GetThreadId() != thread_id)
+                continue;
+
             if (type == time_block.GetType() || type == TimeBlock_Undefined)
             {
                 if (!time_block.IsComplete())
@@ -329,6 +342,8 @@ namespace Spartan
             // Renderer
             "Resolution:\t\t%dx%d\n"
             "Meshes rendered:\t%d\n"
+            "Binds saved:\t\t%d pipeline, %d material, %d buffer\n"
+            "Triangles culled:\t%d\n"
             "Textures:\t\t\t%d\n"
             "Materials:\t\t%d\n"
             "\n"
@@ -369,6 +384,8 @@ namespace Spartan
 			// Renderer
 			static_cast<int>(m_renderer->GetResolution().x), static_cast<int>(m_renderer->GetResolution().y),
 			m_renderer_meshes_rendered,
+            m_renderer_binds_saved_pipeline, m_renderer_binds_saved_material, m_renderer_binds_saved_buffer,
+            m_renderer_triangles_culled,
 			texture_count,
 			material_count,
 
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ===========================
 #include <string>
 #include <vector>
+#include <mutex>
 #include "TimeBlock.h"
 #include "../Core/ISubsystem.h"
 #include "../Core/Stopwatch.h"
@@ -94,7 +95,11 @@ namespace Spartan
         uint32_t m_rhi_pipeline_barriers                = 0;
 
 		// Metrics - Renderer
-		uint32_t m_renderer_meshes_rendered = 0;
+		uint32_t m_renderer_meshes_rendered         = 0;
+        int32_t m_renderer_binds_saved_pipeline     = 0;
+        int32_t m_renderer_binds_saved_material     = 0;
+        int32_t m_renderer_binds_saved_buffer       = 0;
+        uint32_t m_renderer_triangles_culled        = 0; // by cluster culling
 
 		// Metrics - Time
 		float m_time_frame_avg  = 0.0f;
@@ -116,6 +121,10 @@ namespace Spartan
             m_rhi_draw                          = 0;
             m_rhi_dispatch                      = 0;
             m_renderer_meshes_rendered          = 0;
+            m_renderer_binds_saved_pipeline     = 0;
+            m_renderer_binds_saved_material     = 0;
+            m_renderer_binds_saved_buffer       = 0;
+            m_renderer_triangles_culled         = 0;
             m_rhi_bindings_buffer_index         = 0;
             m_rhi_bindings_buffer_vertex        = 0;
             m_rhi_bindings_buffer_constant      = 0;
@@ -148,6 +157,7 @@ namespace Spartan
 		uint32_t m_time_block_count		= 0;
 		std::vector<TimeBlock> m_time_blocks_write;
         std::vector<TimeBlock> m_time_blocks_read;
+        std::mutex m_mutex_time_blocks; // subsystems can tick (and record time blocks) from different threads
 
 		// FPS
         float m_delta_time      = 0.0f;
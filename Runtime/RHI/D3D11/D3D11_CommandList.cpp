@@ -390,14 +390,28 @@ namespace Spartan
         return true;
 	}
 
-    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset)
-    {
-        m_rhi_device->GetContextRhi()->device_context->DrawIndexed
-        (
-            static_cast<UINT>(index_count),
-            static_cast<UINT>(index_offset),
-            static_cast<INT>(vertex_offset)
-        );
+    bool RHI_CommandList::DrawIndexed(const uint32_t index_count, const uint32_t index_offset, const uint32_t vertex_offset, const uint32_t instance_count)
+    {
+        if (instance_count == 1)
+        {
+            m_rhi_device->GetContextRhi()->device_context->DrawIndexed
+            (
+                static_cast<UINT>(index_count),
+                static_cast<UINT>(index_offset),
+                static_cast<INT>(vertex_offset)
+            );
+        }
+        else
+        {
+            m_rhi_device->GetContextRhi()->device_context->DrawIndexedInstanced
+            (
+                static_cast<UINT>(index_count),
+                static_cast<UINT>(instance_count),
+                static_cast<UINT>(index_offset),
+                static_cast<INT>(vertex_offset),
+                0
+            );
+        }
 
         m_profiler->m_rhi_draw++;
 
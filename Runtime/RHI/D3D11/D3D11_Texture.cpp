@@ -92,22 +92,22 @@ namespace Spartan
 
 	inline bool CreateTexture2d(
 		void*& texture,
+		const RHI_Texture* texture_rhi,
 		const uint32_t width,
 		const uint32_t height,
-		const uint32_t channels,
-		const uint32_t bits_per_channel,
 		const uint32_t array_size,
 		const DXGI_FORMAT format,
 		const UINT bind_flags,
-		vector<vector<std::byte>>& data,
 		const shared_ptr<RHI_Device>& rhi_device
 	)
 	{
+        const uint32_t mip_count = texture_rhi->GetDataMipCount();
+
         // Describe
 		D3D11_TEXTURE2D_DESC texture_desc	= {};
 		texture_desc.Width					= static_cast<UINT>(width);
 		texture_desc.Height					= static_cast<UINT>(height);
-		texture_desc.MipLevels				= data.empty() ? 1 : static_cast<UINT>(data.size());
+		texture_desc.MipLevels				= mip_count == 0 ? 1 : static_cast<UINT>(mip_count);
 		texture_desc.ArraySize				= static_cast<UINT>(array_size);
 		texture_desc.Format					= format;
 		texture_desc.SampleDesc.Count		= 1;
@@ -119,17 +119,17 @@ namespace Spartan
 
 		// Fill subresource data
 		vector<D3D11_SUBRESOURCE_DATA> vec_subresource_data;
-		for (uint32_t mip_level = 0; mip_level < static_cast<uint32_t>(data.size()); mip_level++)
+		for (uint32_t mip_level = 0; mip_level < mip_count; mip_level++)
 		{
-			if (data[mip_level].empty())
+			if (!texture_rhi->GetDataMip(mip_level))
 			{
 				LOG_ERROR("Mipmap %d has invalid data.", mip_level);
 				return false;
 			}
 
 			auto& subresource_data				= vec_subresource_data.emplace_back(D3D11_SUBRESOURCE_DATA{});
-			subresource_data.pSysMem			= data[mip_level].data();					                // Data pointer		
-			subresource_data.SysMemPitch		= (width >> mip_level) * channels * (bits_per_channel / 8);	// Line width in bytes
+			subresource_data.pSysMem			= texture_rhi->GetDataMip(mip_level);		                // Data pointer (into the mapped file, when there is one)
+			subresource_data.SysMemPitch		= texture_rhi->GetMipRowPitch(texture_rhi->GetMipResident() + mip_level); // Line width in bytes (a line of blocks when compressed)
 			subresource_data.SysMemSlicePitch	= 0;								                        // This is only used for 3D textures
 		}
 
@@ -195,7 +195,7 @@ namespace Spartan
 		return true;
 	}
 
-	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, vector<vector<std::byte>>& data, const shared_ptr<RHI_Device>& rhi_device)
+	inline bool CreateShaderResourceView2d(void* texture, void*& view, DXGI_FORMAT format, uint32_t array_size, uint32_t mip_count, const shared_ptr<RHI_Device>& rhi_device)
 	{
 		// Describe
 		D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc	= {};
@@ -203,7 +203,7 @@ namespace Spartan
 		shader_resource_view_desc.ViewDimension						= (array_size == 1) ? D3D11_SRV_DIMENSION_TEXTURE2D : D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
 		shader_resource_view_desc.Texture2DArray.FirstArraySlice	= 0;
 		shader_resource_view_desc.Texture2DArray.MostDetailedMip	= 0;
-		shader_resource_view_desc.Texture2DArray.MipLevels			= data.empty() ? 1 : static_cast<UINT>(data.size());
+		shader_resource_view_desc.Texture2DArray.MipLevels			= mip_count == 0 ? 1 : static_cast<UINT>(mip_count);
 		shader_resource_view_desc.Texture2DArray.ArraySize			= array_size;
 
 		// Create
@@ -236,6 +236,11 @@ namespace Spartan
 	}
 
     RHI_Texture2D::~RHI_Texture2D()
+    {
+        RHI_Texture2D::DestroyResourceGpu();
+    }
+
+    void RHI_Texture2D::DestroyResourceGpu()
     {
         d3d11_utility::release(*reinterpret_cast<ID3D11ShaderResourceView**>(&m_resource_view[0]));
         d3d11_utility::release(*reinterpret_cast<ID3D11UnorderedAccessView**>(&m_resource_view_unorderedAccess));
@@ -285,14 +290,12 @@ namespace Spartan
 		result_tex = CreateTexture2d
 		(
             m_resource,
-			m_width,
-			m_height,
-			m_channel_count,
-			m_bits_per_channel,
+            this,
+			GetWidthResident(),
+			GetHeightResident(),
 			m_array_size,
 			format,
 			flags,
-			m_data,
 			m_rhi_device
 		);
 
@@ -304,7 +307,7 @@ namespace Spartan
                 m_resource_view[0],
                 format_srv,
                 m_array_size,
-                m_data,
+                GetDataMipCount(),
                 m_rhi_device
             );
         }
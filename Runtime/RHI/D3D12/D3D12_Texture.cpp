@@ -49,6 +49,11 @@ namespace Spartan
         return true;
 	}
 
+    void RHI_Texture2D::DestroyResourceGpu()
+    {
+
+    }
+
 	// TEXTURE CUBE
 
     RHI_TextureCube::~RHI_TextureCube()
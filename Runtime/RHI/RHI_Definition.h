@@ -56,6 +56,7 @@ namespace Spartan
 	struct RHI_Vertex_PosCol;
 	struct RHI_Vertex_PosUvCol;
 	struct RHI_Vertex_PosTexNorTan;
+	struct RHI_Vertex_PosTexNorTanQuantized;
 
     enum RHI_PhysicalDevice_Type
     {
@@ -195,10 +196,27 @@ namespace Spartan
         // DEPTH
         RHI_Format_D32_Float,
         RHI_Format_D32_Float_S8X24_Uint,
+        // BLOCK COMPRESSED
+        RHI_Format_BC1_Unorm,
+        RHI_Format_BC3_Unorm,
+        RHI_Format_BC4_Unorm,
+        RHI_Format_BC5_Unorm,
+        RHI_Format_BC7_Unorm,
 
         RHI_Format_Undefined
 	};
 
+    // What a texture is used for, so that it can be block compressed when it's imported
+    enum RHI_Texture_Compression : uint8_t
+    {
+        RHI_Texture_Compression_None,
+        RHI_Texture_Compression_Color,      // BC1, or BC3 if the image has alpha
+        RHI_Texture_Compression_Color_High, // BC7
+        RHI_Texture_Compression_Normal,     // BC5 (x and y, z is reconstructed), or BC4 if the image is grayscale (a height map)
+        RHI_Texture_Compression_Grayscale,  // BC4
+        RHI_Texture_Compression_Mask        // BC4, with linear mips (the color channels are folded into one)
+    };
+
 	enum RHI_Blend
 	{
 		RHI_Blend_Zero,
@@ -297,12 +315,29 @@ namespace Spartan
             case RHI_Format_R32G32B32A32_Float:	    return "RHI_Format_R32G32B32A32_Float";
             case RHI_Format_D32_Float:	            return "RHI_Format_D32_Float";
             case RHI_Format_D32_Float_S8X24_Uint:	return "RHI_Format_D32_Float_S8X24_Uint";
+            case RHI_Format_BC1_Unorm:              return "RHI_Format_BC1_Unorm";
+            case RHI_Format_BC3_Unorm:              return "RHI_Format_BC3_Unorm";
+            case RHI_Format_BC4_Unorm:              return "RHI_Format_BC4_Unorm";
+            case RHI_Format_BC5_Unorm:              return "RHI_Format_BC5_Unorm";
+            case RHI_Format_BC7_Unorm:              return "RHI_Format_BC7_Unorm";
             case RHI_Format_Undefined:              return "RHI_Format_Undefined";
         }
 
         return "Unknown format";
     }
 
+    // Block compressed formats store 4x4 pixel blocks
+    inline bool rhi_format_is_block_compressed(const RHI_Format format)
+    {
+        return format >= RHI_Format_BC1_Unorm && format <= RHI_Format_BC7_Unorm;
+    }
+
+    // The size of a 4x4 block, in bytes
+    inline uint32_t rhi_format_block_byte_count(const RHI_Format format)
+    {
+        return (format == RHI_Format_BC1_Unorm || format == RHI_Format_BC4_Unorm) ? 8 : 16;
+    }
+
     // Engine constants 
     static const Math::Vector4  state_color_dont_care           = Math::Vector4(-std::numeric_limits<float>::infinity(), 0.0f, 0.0f, 0.0f);
     static const Math::Vector4  state_color_load                = Math::Vector4(std::numeric_limits<float>::infinity(), 0.0f, 0.0f, 0.0f);
@@ -261,6 +261,20 @@ namespace Spartan
                     }
                 }
             }
+
+            if (pipeline_state.dynamic_constant_buffer_slot_3 != -1)
+            {
+                for (RHI_Descriptor& descriptor : descriptors)
+                {
+                    if (descriptor.type == RHI_Descriptor_ConstantBuffer)
+                    {
+                        if (descriptor.slot == pipeline_state.dynamic_constant_buffer_slot_3 + m_rhi_device->GetContextRhi()->shader_shift_buffer)
+                        {
+                            descriptor.type = RHI_Descriptor_ConstantBufferDynamic;
+                        }
+                    }
+                }
+            }
         }
 
         return descriptors;
@@ -77,6 +77,12 @@ static const DXGI_FORMAT d3d11_format[] =
     // Depth
     DXGI_FORMAT_D32_FLOAT,
     DXGI_FORMAT_D32_FLOAT_S8X24_UINT,
+    // Block compressed
+    DXGI_FORMAT_BC1_UNORM,
+    DXGI_FORMAT_BC3_UNORM,
+    DXGI_FORMAT_BC4_UNORM,
+    DXGI_FORMAT_BC5_UNORM,
+    DXGI_FORMAT_BC7_UNORM,
 
     DXGI_FORMAT_UNKNOWN
 };
@@ -208,6 +214,12 @@ static const VkFormat vulkan_format[] =
     // DEPTH
     VK_FORMAT_D32_SFLOAT,
     VK_FORMAT_D32_SFLOAT_S8_UINT,
+    // BLOCK COMPRESSED
+    VK_FORMAT_BC1_RGBA_UNORM_BLOCK,
+    VK_FORMAT_BC3_UNORM_BLOCK,
+    VK_FORMAT_BC4_UNORM_BLOCK,
+    VK_FORMAT_BC5_UNORM_BLOCK,
+    VK_FORMAT_BC7_UNORM_BLOCK,
 
     VK_FORMAT_MAX_ENUM
 };
@@ -317,6 +329,7 @@ static const VkImageLayout vulkan_image_layout[] =
     #include "Vulkan/vk_mem_alloc.h"
     #include <vector>
     #include <unordered_map>
+    #include <mutex>
 #endif
 
 // RHI_Context
@@ -348,6 +361,7 @@ namespace Spartan
             VkColorSpaceKHR surface_color_space             = VK_COLOR_SPACE_MAX_ENUM_KHR;
             VmaAllocator allocator                          = nullptr;
             std::unordered_map<uint64_t, VmaAllocation> allocations;
+            std::mutex allocations_mutex; // images and buffers are created by the loading threads and the render thread (streaming)
 
             // Extensions
             #ifdef DEBUG
@@ -107,6 +107,7 @@ namespace Spartan
         // such a hack, must fix. Update: Came back to byte me in the ass
         int dynamic_constant_buffer_slot    = 2;
         int dynamic_constant_buffer_slot_2  = 3;
+        int dynamic_constant_buffer_slot_3  = 5;
 
         // Clear values
         
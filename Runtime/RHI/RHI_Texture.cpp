@@ -22,9 +22,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES ================================
 #include "Spartan.h"
 #include "RHI_Texture.h"
+#include "RHI_Texture2D.h"
 #include "RHI_Device.h"
 #include "../IO/FileStream.h"
 #include "../Rendering/Renderer.h"
+#include "../Rendering/TextureStreamer.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/Import/ImageImporter.h"
 //===========================================
@@ -33,11 +35,33 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 using namespace std;
 //==================
 
+namespace Spartan::texture_file
+{
+    // Points at every mip of a native texture file (which is mapped), without copying them
+    inline bool read_mips(FileStream* file, vector<pair<const std::byte*, uint32_t>>& mips)
+    {
+        file->ReadAs<uint32_t>(); // byte count
+        mips.resize(file->ReadAs<uint32_t>());
+        for (auto& mip : mips)
+        {
+            mip.first = file->ReadView<std::byte>(&mip.second);
+            if (!mip.first)
+                return false;
+        }
+
+        return true;
+    }
+}
+
 namespace Spartan
 {
 	RHI_Texture::RHI_Texture(Context* context) : IResource(context, ResourceType::Texture)
 	{
-		m_rhi_device = context->GetSubsystem<Renderer>()->GetRhiDevice();
+		// Textures can be imported without a renderer (e.g. by the tests), they just can't be uploaded
+		if (Renderer* renderer = context->GetSubsystem<Renderer>())
+		{
+			m_rhi_device = renderer->GetRhiDevice();
+		}
 	}
 
 	RHI_Texture::~RHI_Texture()
@@ -66,6 +90,8 @@ namespace Spartan
 		if (!file->IsOpen())
 			return false;
 
+		lock_guard<mutex> lock(m_mutex);
+
 		// If the existing file has a byte count but we 
 		// hold no data, don't overwrite the file's bytes.
 		if (byte_count != 0 && m_data.empty())
@@ -120,7 +146,9 @@ namespace Spartan
 
 		m_data.clear();
 		m_data.shrink_to_fit();
-		m_load_state = Started;
+		m_load_state    = Started;
+        m_mip_resident  = 0;
+        m_is_streamed   = false;
 
 		// Load from disk
 		auto texture_data_loaded = false;		
@@ -141,10 +169,13 @@ namespace Spartan
 			return false;
 		}
 
-        m_mip_levels = static_cast<uint32_t>(m_data.size());
+        m_mip_levels = GetDataMipCount();
 
 		// Create GPU resource
-        if (!m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() || !CreateResourceGpu())
+        const bool result = m_context->GetSubsystem<Renderer>()->GetRhiDevice()->IsInitialized() && CreateResourceGpu();
+        m_data_mapped.clear();
+        m_data_file.reset();
+        if (!result)
         {
             LOG_ERROR("Failed to create shader resource for \"%s\".", GetResourceFilePathNative().c_str());
             m_load_state = Failed;
@@ -159,22 +190,88 @@ namespace Spartan
 		}
 		m_load_state = Completed;
 
-        // Compute memory usage
+        ComputeMemoryUsage();
+
+		return true;
+	}
+
+    shared_ptr<RHI_Texture> RHI_Texture::CreateMipResident(const uint32_t mip)
+    {
+        const uint32_t mip_count = GetMipCount();
+        if (!IsStreamed() || mip >= mip_count)
         {
-            m_size_cpu = 0;
-            m_size_gpu = 0;
-            for (uint8_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
-            {
-                const uint32_t mip_width  = m_width >> mip_index;
-                const uint32_t mip_height = m_height >> mip_index;
+            LOG_ERROR_INVALID_PARAMETER();
+            return nullptr;
+        }
 
-                m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
-                m_size_gpu += mip_width * mip_height * (m_bits_per_channel / 8);
+        auto texture                = make_shared<RHI_Texture2D>(m_context, false);
+        texture->m_bits_per_channel = m_bits_per_channel;
+        texture->m_width            = m_width;
+        texture->m_height           = m_height;
+        texture->m_channel_count    = m_channel_count;
+        texture->m_format           = m_format;
+        texture->m_flags            = m_flags;
+        texture->m_viewport         = m_viewport;
+        texture->m_mip_resident     = mip;
+        texture->m_mip_levels       = mip_count - mip;
+        texture->m_name             = GetResourceName();
+
+        // Point at the chain in the file, it's mapped so the mips which become resident are uploaded from it without a copy
+        {
+            // If the file can't provide the mips, the texture stops being streamed and keeps what it has
+            auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
+            vector<pair<const std::byte*, uint32_t>> mips;
+            if (!file->IsOpen() || !texture_file::read_mips(file.get(), mips) || mips.size() != mip_count)
+            {
+                LOG_ERROR("\"%s\" doesn't match the texture", GetResourceFilePathNative().c_str());
+                m_is_streamed = false;
+                return nullptr;
             }
+
+            texture->m_data_mapped.assign(mips.begin() + mip, mips.end());
+            texture->m_data_file = move(file);
         }
 
-		return true;
-	}
+        const bool result = texture->CreateResourceGpu();
+        texture->m_data_mapped.clear();
+        texture->m_data_file.reset();
+
+        if (!result)
+        {
+            LOG_ERROR("Failed to stream \"%s\"", GetResourceFilePathNative().c_str());
+            m_is_streamed = false;
+            return nullptr;
+        }
+
+        return texture;
+    }
+
+    void RHI_Texture::SetMipResident(RHI_Texture* texture)
+    {
+        if (!texture)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // Take the new chain, the other texture ends up with the previous one
+        lock_guard<mutex> lock(m_mutex);
+        swap(m_mip_resident, texture->m_mip_resident);
+        swap(m_mip_levels, texture->m_mip_levels);
+        SwapResourceGpu(texture);
+        ComputeMemoryUsage();
+    }
+
+    void RHI_Texture::SwapResourceGpu(RHI_Texture* texture)
+    {
+        swap(m_resource, texture->m_resource);
+        swap(m_resource_view, texture->m_resource_view);
+        swap(m_resource_view_unorderedAccess, texture->m_resource_view_unorderedAccess);
+        swap(m_resource_view_renderTarget, texture->m_resource_view_renderTarget);
+        swap(m_resource_view_depthStencil, texture->m_resource_view_depthStencil);
+        swap(m_resource_view_depthStencilReadOnly, texture->m_resource_view_depthStencilReadOnly);
+        swap(m_layout, texture->m_layout);
+    }
 
 	vector<std::byte>* RHI_Texture::GetData(const uint32_t index)
 	{
@@ -192,13 +289,15 @@ namespace Spartan
         vector<std::byte> data;
 
         // Use existing data, if it's there
-        if (index < m_data.size())
+        unique_lock<mutex> lock(m_mutex);
+        if (index >= m_mip_resident && index - m_mip_resident < m_data.size())
         {
-            data = m_data[index];
+            data = m_data[index - m_mip_resident];
         }
         // Else attempt to load the data
         else
         {
+            lock.unlock();
             auto file = make_unique<FileStream>(GetResourceFilePathNative(), FileStream_Read);
             if (file->IsOpen())
             {
@@ -207,9 +306,17 @@ namespace Spartan
 
                 if (index < mip_count)
                 {
+                    // Skip the preceding mips without copying them
+                    uint32_t mip_byte_count = 0;
+                    const std::byte* mip    = nullptr;
                     for (uint32_t i = 0; i <= index; i++)
                     {
-                        file->Read(&data);
+                        mip = file->ReadView<std::byte>(&mip_byte_count);
+                    }
+
+                    if (mip)
+                    {
+                        data.assign(mip, mip + mip_byte_count);
                     }
                 }
                 else
@@ -227,6 +334,24 @@ namespace Spartan
         return data;
     }
 
+    uint32_t RHI_Texture::GetMipRowPitch(const uint32_t mip_index) const
+    {
+        const uint32_t mip_width = Math::Helper::Max(m_width >> mip_index, 1u);
+
+        if (IsBlockCompressed())
+            return ((mip_width + 3) / 4) * rhi_format_block_byte_count(m_format);
+
+        return mip_width * GetBytesPerPixel();
+    }
+
+    uint32_t RHI_Texture::GetMipByteCount(const uint32_t mip_index) const
+    {
+        const uint32_t mip_height   = Math::Helper::Max(m_height >> mip_index, 1u);
+        const uint32_t row_count    = IsBlockCompressed() ? (mip_height + 3) / 4 : mip_height;
+
+        return GetMipRowPitch(mip_index) * row_count;
+    }
+
     bool RHI_Texture::LoadFromFile_ForeignFormat(const string& file_path, const bool generate_mipmaps)
 	{
 		// Load texture
@@ -249,16 +374,10 @@ namespace Spartan
 		m_data.clear();
 		m_data.shrink_to_fit();
 
-		// Read byte and mipmap count
-		auto byte_count = file->ReadAs<uint32_t>();
-        const auto mip_count  = file->ReadAs<uint32_t>();
-
-		// Read bytes
-		m_data.resize(mip_count);
-		for (auto& mip : m_data)
-		{
-			file->Read(&mip);
-		}
+		// The bytes come first, get a view of every mip
+		vector<pair<const std::byte*, uint32_t>> mips;
+		if (!texture_file::read_mips(file.get(), mips))
+			return false;
 
 		// Read properties
 		file->Read(&m_bits_per_channel);
@@ -270,6 +389,15 @@ namespace Spartan
 		SetId(file->ReadAs<uint32_t>());
 		SetResourceFilePath(file->ReadAs<string>());
 
+        // Sampled textures with a chain of mips are streamed, they start with the tail and the renderer streams in the rest as needed
+        const uint32_t mip_count    = static_cast<uint32_t>(mips.size());
+        m_is_streamed               = m_resource_type == ResourceType::Texture2d && IsSampled() && mip_count > 1;
+        m_mip_resident              = m_is_streamed ? TextureStreamer::GetMipTail(m_width, m_height, mip_count) : 0;
+
+		// Keep the file mapped, the GPU resource is created straight from the resident mips
+		m_data_mapped.assign(mips.begin() + m_mip_resident, mips.end());
+		m_data_file = move(file);
+
 		return true;
 	}
 
@@ -291,10 +419,26 @@ namespace Spartan
 			case RHI_Format_R32G32B32A32_Float:	    return 4;
             case RHI_Format_D32_Float:			    return 1;
             case RHI_Format_D32_Float_S8X24_Uint:   return 2;
+            case RHI_Format_BC1_Unorm:              return 4;
+            case RHI_Format_BC3_Unorm:              return 4;
+            case RHI_Format_BC4_Unorm:              return 1;
+            case RHI_Format_BC5_Unorm:              return 2;
+            case RHI_Format_BC7_Unorm:              return 4;
 			default:						        return 0;
 		}
 	}
 
+    void RHI_Texture::ComputeMemoryUsage()
+    {
+        m_size_cpu = 0;
+        m_size_gpu = 0;
+        for (uint32_t mip_index = 0; mip_index < m_mip_levels; mip_index++)
+        {
+            m_size_cpu += mip_index < m_data.size() ? m_data[mip_index].size() * sizeof(std::byte) : 0;
+            m_size_gpu += GetMipByteCount(m_mip_resident + mip_index);
+        }
+    }
+
 	uint32_t RHI_Texture::GetByteCount()
 	{
 		uint32_t byte_count = 0;
@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 //= INCLUDES =====================
 #include <memory>
 #include <array>
+#include <atomic>
+#include <mutex>
 #include "RHI_Viewport.h"
 #include "RHI_Definition.h"
 #include "../Resource/IResource.h"
@@ -31,6 +33,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
+    class FileStream;
+
 	enum RHI_Texture_Flags : uint16_t
 	{
 		RHI_Texture_Sampled			        = 1 << 0,
@@ -84,15 +88,38 @@ namespace Spartan
 		auto GetFormat() const											{ return m_format; }
 		void SetFormat(const RHI_Format format)							{ m_format = format; }
 
+        // What the texture is used for, set before importing it so that it gets block compressed
+        auto GetCompression() const                                     { return m_compression; }
+        void SetCompression(const RHI_Texture_Compression compression)  { m_compression = compression; }
+
 		// Data
-        bool HasData() const                                            { return !m_data.empty(); }
+        bool HasData() const                                            { return !m_data.empty() || !m_data_mapped.empty(); }
 		const auto& GetData() const										{ return m_data; }		
+        auto& GetData()                                                 { return m_data; }
         void SetData(const std::vector<std::vector<std::byte>>& data)   { m_data = data; }
         auto AddMipmap()                                                { return &m_data.emplace_back(std::vector<std::byte>()); }
         bool HasMipmaps() const                                         { return !m_data.empty();  }
-        uint32_t GetMiplevels() const                                   { return m_mip_levels; }
+        uint32_t GetMiplevels() const                                   { std::lock_guard<std::mutex> lock(m_mutex); return m_mip_levels; }
         std::vector<std::byte>* GetData(uint32_t mipmap_index);
         std::vector<std::byte> GetMipmap(uint32_t index);
+        // The mips the GPU resource is created from, views into the file when it was loaded from one (which stays mapped until then), else the data
+        uint32_t GetDataMipCount() const                                { return static_cast<uint32_t>(m_data_mapped.empty() ? m_data.size() : m_data_mapped.size()); }
+        const std::byte* GetDataMip(uint32_t index) const               { return m_data_mapped.empty() ? m_data[index].data() : m_data_mapped[index].first; }
+        // The size of a row of a mip, a row of 4x4 blocks for block compressed formats
+        uint32_t GetMipRowPitch(uint32_t mip_index) const;
+        uint32_t GetMipByteCount(uint32_t mip_index) const;
+
+        // Streaming, the GPU (and the data, when there is any) holds the mips from the resident one to the end of the chain
+        bool IsStreamed() const                                         { return m_is_streamed.load(std::memory_order_relaxed); }
+        uint32_t GetMipResident() const                                 { std::lock_guard<std::mutex> lock(m_mutex); return m_mip_resident; }
+        uint32_t GetMipCount() const                                    { std::lock_guard<std::mutex> lock(m_mutex); return m_mip_resident + m_mip_levels; }
+        uint32_t GetWidthResident() const                               { std::lock_guard<std::mutex> lock(m_mutex); return Math::Helper::Max(m_width >> m_mip_resident, 1u); }
+        uint32_t GetHeightResident() const                              { std::lock_guard<std::mutex> lock(m_mutex); return Math::Helper::Max(m_height >> m_mip_resident, 1u); }
+        // Streaming takes two steps, so that the texture stays usable throughout. The new chain is created in a texture of its own, on any thread,
+        // and then it's swapped in on the render thread. After the swap, that texture holds the previous GPU resource, which has to be kept alive
+        // until the GPU is done with it. If the chain can't be created, nothing is returned and the texture stops being streamed.
+        std::shared_ptr<RHI_Texture> CreateMipResident(uint32_t mip);
+        void SetMipResident(RHI_Texture* texture);
 
         // Binding type
         bool IsSampled()        const { return m_flags & RHI_Texture_Sampled; }
@@ -105,6 +132,7 @@ namespace Spartan
         bool IsStencilFormat()          const { return m_format == RHI_Format_D32_Float_S8X24_Uint; }
         bool IsDepthStencilFormat()     const { return IsDepthFormat() || IsStencilFormat(); }
         bool IsColorFormat()            const { return !IsDepthStencilFormat(); }
+        bool IsBlockCompressed()        const { return rhi_format_is_block_compressed(m_format); }
         
         // Layout
         void SetLayout(const RHI_Image_Layout layout, RHI_CommandList* command_list = nullptr);
@@ -115,10 +143,10 @@ namespace Spartan
         const auto& GetViewport()   const { return m_viewport; }
         uint16_t GetFlags()         const { return m_flags; }
 
-        // GPU resources
-        void* Get_Resource()                                                const { return m_resource; }
+        // GPU resources, streaming swaps the resource and its shader views (a texture which is streamed is only sampled)
+        void* Get_Resource()                                                const { std::lock_guard<std::mutex> lock(m_mutex); return m_resource; }
         void  Set_Resource(void* resource)                                        { m_resource = resource; }
-        void* Get_Resource_View(const uint32_t i = 0)                       const { return m_resource_view[i]; }
+        void* Get_Resource_View(const uint32_t i = 0)                       const { std::lock_guard<std::mutex> lock(m_mutex); return m_resource_view[i]; }
         void* Get_Resource_View_UnorderedAccess()	                        const { return m_resource_view_unorderedAccess; }
         void* Get_Resource_View_DepthStencil(const uint32_t i = 0)          const { return i < m_resource_view_depthStencil.size() ? m_resource_view_depthStencil[i] : nullptr; }
         void* Get_Resource_View_DepthStencilReadOnly(const uint32_t i = 0)  const { return i < m_resource_view_depthStencilReadOnly.size() ? m_resource_view_depthStencilReadOnly[i] : nullptr; }
@@ -129,6 +157,7 @@ namespace Spartan
 		bool LoadFromFile_ForeignFormat(const std::string& file_path, bool generate_mipmaps);
 		static uint32_t GetChannelCountFromFormat(RHI_Format format);
         virtual bool CreateResourceGpu() { LOG_ERROR("Function not implemented by API"); return false; }
+        virtual void DestroyResourceGpu() { LOG_ERROR("Function not implemented by API"); }
 
 		uint32_t m_bits_per_channel = 8;
 		uint32_t m_width		    = 0;
@@ -136,11 +165,16 @@ namespace Spartan
 		uint32_t m_channel_count	= 4;
         uint32_t m_array_size       = 1;
         uint32_t m_mip_levels       = 1;
+        uint32_t m_mip_resident     = 0;
+        std::atomic<bool> m_is_streamed = false;
 		RHI_Format m_format		    = RHI_Format_Undefined;
         RHI_Image_Layout m_layout   = RHI_Image_Undefined;
         uint16_t m_flags	        = 0;
+        RHI_Texture_Compression m_compression = RHI_Texture_Compression_None;
 		RHI_Viewport m_viewport;
 		std::vector<std::vector<std::byte>> m_data;
+        std::unique_ptr<FileStream> m_data_file;
+        std::vector<std::pair<const std::byte*, uint32_t>> m_data_mapped;
 		std::shared_ptr<RHI_Device> m_rhi_device;
 
         // API
@@ -150,7 +184,12 @@ namespace Spartan
         std::array<void*, state_max_render_target_count> m_resource_view_renderTarget           = { nullptr };
         std::array<void*, state_max_render_target_count> m_resource_view_depthStencil           = { nullptr };
         std::array<void*, state_max_render_target_count> m_resource_view_depthStencilReadOnly   = { nullptr };
+        // Guards what streaming changes (the resident mips and the GPU resource), against the threads which read it
+        mutable std::mutex m_mutex;
+
 	private:
 		uint32_t GetByteCount();
+        void ComputeMemoryUsage();
+        void SwapResourceGpu(RHI_Texture* texture);
 	};
 }
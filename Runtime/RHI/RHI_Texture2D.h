@@ -95,5 +95,6 @@ namespace Spartan
 
 		// RHI_Texture
 		bool CreateResourceGpu() override;
+        void DestroyResourceGpu() override;
 	};
 }
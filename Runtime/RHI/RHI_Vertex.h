@@ -127,11 +127,21 @@ namespace Spartan
 		float tan[3] = { 0 };
 	};
 
+	// The compact form of RHI_Vertex_PosTexNorTan which imported models keep on the GPU (see VertexQuantizer), 20 bytes instead of 44.
+	// The position is 16-bit within the model's bounds, the uv is half precision and the normal and the tangent are octahedral.
+	struct RHI_Vertex_PosTexNorTanQuantized
+	{
+		int16_t pos[4]		= { 0 }; // snorm, w is always 1
+		uint16_t tex[2]		= { 0 }; // half
+		int16_t nor_tan[4]	= { 0 }; // snorm, the normal in xy and the tangent in zw
+	};
+
 	static_assert(std::is_trivially_copyable<RHI_Vertex_Pos>::value,			"RHI_Vertex_Pos is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTex>::value,			"RHI_Vertex_PosTex is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosCol>::value,			"RHI_Vertex_PosCol is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_Pos2dTexCol8>::value,	"RHI_Vertex_Pos2dTexCol8 is not trivially copyable");
 	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTan>::value,	"RHI_Vertex_PosTexNorTan is not trivially copyable");
+	static_assert(std::is_trivially_copyable<RHI_Vertex_PosTexNorTanQuantized>::value,	"RHI_Vertex_PosTexNorTanQuantized is not trivially copyable");
 
 	enum RHI_Vertex_Type
 	{
@@ -140,6 +150,7 @@ namespace Spartan
 		RHI_Vertex_Type_PositionColor,
 		RHI_Vertex_Type_PositionTexture,
 		RHI_Vertex_Type_PositionTextureNormalTangent,
+		RHI_Vertex_Type_PositionTextureNormalTangentQuantized,
 		RHI_Vertex_Type_Position2dTextureColor8
 	};
 
@@ -151,4 +162,5 @@ namespace Spartan
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosCol>()			{ return RHI_Vertex_Type_PositionColor; }
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_Pos2dTexCol8>()	{ return RHI_Vertex_Type_Position2dTextureColor8; }
 	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTan>()	{ return RHI_Vertex_Type_PositionTextureNormalTangent; }
+	template<> inline RHI_Vertex_Type RHI_Vertex_Type_To_Enum<RHI_Vertex_PosTexNorTanQuantized>()	{ return RHI_Vertex_Type_PositionTextureNormalTangentQuantized; }
 }
@@ -76,11 +76,11 @@ namespace Spartan
             return true;
         }
 
-        const uint32_t width            = texture->GetWidth();
-        const uint32_t height           = texture->GetHeight();
+        const uint32_t width            = texture->GetWidthResident();
+        const uint32_t height           = texture->GetHeightResident();
         const uint32_t array_size       = texture->GetArraySize();
         const uint32_t mip_levels       = texture->GetMiplevels();
-        const uint32_t bytes_per_pixel  = texture->GetBytesPerPixel();
+        const uint32_t mip_resident     = texture->GetMipResident();
 
         // Fill out VkBufferImageCopy structs describing the array and the mip levels   
         VkDeviceSize buffer_offset = 0;
@@ -88,8 +88,8 @@ namespace Spartan
         {
             for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
             {
-                uint32_t mip_width  = width >> mip_index;
-                uint32_t mip_height = height >> mip_index;
+                uint32_t mip_width  = Math::Helper::Max(width >> mip_index, 1u);
+                uint32_t mip_height = Math::Helper::Max(height >> mip_index, 1u);
 
                 VkBufferImageCopy region				= {};
                 region.bufferOffset						= buffer_offset;
@@ -104,8 +104,8 @@ namespace Spartan
 
                 buffer_image_copies[mip_index] = region;
 
-                // Update staging buffer memory requirement (in bytes)
-                buffer_offset += mip_width * mip_height * bytes_per_pixel;
+                // Update staging buffer memory requirement (in bytes, block compressed mips are made of 4x4 blocks)
+                buffer_offset += texture->GetMipByteCount(mip_resident + mip_index);
             }
         }
 
@@ -121,8 +121,8 @@ namespace Spartan
             {
                 for (uint32_t mip_index = 0; mip_index < mip_levels; mip_index++)
                 {
-                    uint64_t buffer_size = (width >> mip_index) * (height >> mip_index) * bytes_per_pixel;
-                    memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetData(array_index + mip_index)->data(), buffer_size);
+                    uint64_t buffer_size = texture->GetMipByteCount(mip_resident + mip_index);
+                    memcpy(static_cast<std::byte*>(data) + buffer_offset, texture->GetDataMip(array_index + mip_index), buffer_size);
                     buffer_offset += buffer_size;
                 }
             }
@@ -196,12 +196,17 @@ namespace Spartan
 
     RHI_Texture2D::~RHI_Texture2D()
     {
-        if (!m_rhi_device->IsInitialized())
+        if (!m_rhi_device || !m_rhi_device->IsInitialized())
             return;
 
         m_rhi_device->Queue_WaitAll();
         m_data.clear();
 
+        RHI_Texture2D::DestroyResourceGpu();
+	}
+
+    void RHI_Texture2D::DestroyResourceGpu()
+    {
         vulkan_utility::image::view::destroy(m_resource_view[0]);
         vulkan_utility::image::view::destroy(m_resource_view[1]);
         for (uint32_t i = 0; i < state_max_render_target_count; i++)
@@ -326,7 +331,7 @@ namespace Spartan
 
 	RHI_TextureCube::~RHI_TextureCube()
 	{
-        if (!m_rhi_device->IsInitialized())
+        if (!m_rhi_device || !m_rhi_device->IsInitialized())
             return;
 
         m_rhi_device->Queue_WaitAll();
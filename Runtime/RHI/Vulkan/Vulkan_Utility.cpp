@@ -73,8 +73,8 @@ namespace Spartan::vulkan_utility
         create_info.sType               = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         create_info.imageType           = VK_IMAGE_TYPE_2D;
         create_info.flags               = (texture->GetResourceType() == ResourceType::TextureCube) ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
-        create_info.extent.width        = texture->GetWidth();
-        create_info.extent.height       = texture->GetHeight();
+        create_info.extent.width        = texture->GetWidthResident();
+        create_info.extent.height       = texture->GetHeightResident();
         create_info.extent.depth        = 1;
         create_info.mipLevels           = texture->GetMiplevels();
         create_info.arrayLayers         = texture->GetArraySize();
@@ -96,8 +96,9 @@ namespace Spartan::vulkan_utility
 
         texture->Set_Resource(resource);
 
-        // Keep allocation reference
-        globals::rhi_context->allocations[texture->GetId()] = allocation;
+        // Keep allocation reference, by image (like buffers), as a streamed texture's previous image outlives the swap to its new one
+        lock_guard<mutex> lock(globals::rhi_context->allocations_mutex);
+        globals::rhi_context->allocations[reinterpret_cast<uint64_t>(resource)] = allocation;
 
         return true;
 	}
@@ -105,8 +106,9 @@ namespace Spartan::vulkan_utility
     void image::destroy(RHI_Texture* texture)
     {
         void* resource          = texture->Get_Resource();
-        uint64_t allocation_id  = texture->GetId();
+        uint64_t allocation_id  = reinterpret_cast<uint64_t>(resource);
 
+        lock_guard<mutex> lock(globals::rhi_context->allocations_mutex);
         auto it = globals::rhi_context->allocations.find(allocation_id);
         if (it != globals::rhi_context->allocations.end())
         {
@@ -140,7 +142,10 @@ namespace Spartan::vulkan_utility
             return false;
 
         // Keep allocation reference
-        globals::rhi_context->allocations[reinterpret_cast<uint64_t>(_buffer)] = allocation;
+        {
+            lock_guard<mutex> lock(globals::rhi_context->allocations_mutex);
+            globals::rhi_context->allocations[reinterpret_cast<uint64_t>(_buffer)] = allocation;
+        }
 
         // If a pointer to the buffer data has been passed, map the buffer and copy over the data
         if (data != nullptr)
@@ -193,6 +198,7 @@ namespace Spartan::vulkan_utility
             return;
 
         uint64_t allocation_id = reinterpret_cast<uint64_t>(_buffer);
+        lock_guard<mutex> lock(globals::rhi_context->allocations_mutex);
         auto it = globals::rhi_context->allocations.find(allocation_id);
         if (it != globals::rhi_context->allocations.end())
         {
@@ -0,0 +1,303 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "LightClusters.h"
+#include "../Threading/Threading.h"
+#include <xmmintrin.h>
+//=============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        // Indices are 16 bits
+        const uint32_t light_count_max = 65536;
+
+        // The sphere which bounds the light, for spot lights it's the one of the cone if that is tighter than the one of the range
+        void bounding_sphere(const ClusteredLight& light, Vector3& center, float& radius)
+        {
+            center = light.position;
+            radius = light.range;
+
+            if (light.angle <= 0.0f || light.angle >= Helper::PI_DIV_2)
+                return;
+
+            const Vector3 direction = light.direction.Normalized();
+            if (light.angle > Helper::PI_DIV_4)
+            {
+                // Wide cones, the sphere of the cap
+                center = light.position + direction * (cos(light.angle) * light.range);
+                radius = sin(light.angle) * light.range;
+            }
+            else
+            {
+                // Narrow cones, the sphere which passes through the apex and the rim of the cap
+                radius = light.range / (2.0f * cos(light.angle));
+                center = light.position + direction * radius;
+            }
+        }
+
+        float horizontal_min(__m128 v)
+        {
+            v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+            return _mm_cvtss_f32(v);
+        }
+
+        float horizontal_max(__m128 v)
+        {
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+            return _mm_cvtss_f32(v);
+        }
+
+        uint32_t uv_to_tile(const float uv, const uint32_t count)
+        {
+            return static_cast<uint32_t>(Helper::Clamp(uv * static_cast<float>(count), 0.0f, static_cast<float>(count - 1)));
+        }
+    }
+
+    void LightClusters::Build(const vector<ClusteredLight>& lights, const Matrix& view, const Matrix& projection, const float near_plane, const float far_plane, Threading* threading /*= nullptr*/)
+    {
+        const float log_depth_range = log(far_plane / near_plane);
+        m_slice_scale               = static_cast<float>(m_cluster_count_z) / log_depth_range;
+        m_slice_bias                = -static_cast<float>(m_cluster_count_z) * log(near_plane) / log_depth_range;
+
+        uint32_t light_count = static_cast<uint32_t>(lights.size());
+        if (light_count > light_count_max)
+        {
+            LOG_WARNING("Only %d of the %d lights will be binned", light_count_max, light_count);
+            light_count = light_count_max;
+        }
+
+        // Bound the lights
+        m_bounds.resize(light_count);
+        const auto compute_bounds = [this, &lights, &view, near_plane, far_plane](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                m_bounds[i] = ComputeBounds(lights[i], view, near_plane, far_plane);
+            }
+        };
+
+        // Bin every slice, each one only writes to its own clusters
+        const auto bin_slices = [this, &projection, near_plane](uint32_t start, uint32_t end)
+        {
+            for (uint32_t z = start; z < end; z++)
+            {
+                BinSlice(z, projection, near_plane);
+            }
+        };
+
+        if (threading)
+        {
+            threading->ParallelFor(light_count, 64, compute_bounds);
+            threading->ParallelFor(m_cluster_count_z, 1, bin_slices);
+        }
+        else
+        {
+            compute_bounds(0, light_count);
+            bin_slices(0, m_cluster_count_z);
+        }
+
+        // Compact the slices into a single list of indices
+        m_clusters.resize(m_cluster_count);
+        m_indices.clear();
+        m_overflow_count = 0;
+        for (uint32_t z = 0; z < m_cluster_count_z; z++)
+        {
+            const vector<uint16_t>& slice_indices   = m_slice_indices[z];
+            uint32_t slice_offset                   = 0;
+            m_overflow_count                        += m_slice_overflow[z];
+
+            for (uint32_t cluster = GetClusterIndex(0, 0, z); cluster < GetClusterIndex(0, 0, z + 1); cluster++)
+            {
+                const uint32_t count    = m_cluster_counts[cluster];
+                const uint32_t offset   = static_cast<uint32_t>(m_indices.size());
+                const uint32_t fit      = Helper::Min(count, m_cluster_light_indices_max - offset);
+
+                m_indices.insert(m_indices.end(), slice_indices.begin() + slice_offset, slice_indices.begin() + slice_offset + fit);
+                m_clusters[cluster] = (offset << 8) | fit;
+                m_overflow_count    += count - fit;
+                slice_offset        += count;
+            }
+        }
+    }
+
+    uint32_t LightClusters::GetSlice(const float depth) const
+    {
+        const float slice = floor(log(depth) * m_slice_scale + m_slice_bias);
+        return static_cast<uint32_t>(Helper::Clamp(slice, 0.0f, static_cast<float>(m_cluster_count_z - 1)));
+    }
+
+    LightClusters::Bounds LightClusters::ComputeBounds(const ClusteredLight& light, const Matrix& view, const float near_plane, const float far_plane) const
+    {
+        Bounds bounds;
+        bounding_sphere(light, bounds.center, bounds.radius);
+        bounds.center       = bounds.center * view;
+        bounds.slice_min    = 1;
+        bounds.slice_max    = 0;
+
+        const float depth_min = bounds.center.z - bounds.radius;
+        const float depth_max = bounds.center.z + bounds.radius;
+        if (bounds.radius > 0.0f && depth_max >= near_plane && depth_min <= far_plane)
+        {
+            bounds.slice_min = GetSlice(Helper::Max(depth_min, near_plane));
+            bounds.slice_max = GetSlice(Helper::Min(depth_max, far_plane));
+        }
+
+        return bounds;
+    }
+
+    bool LightClusters::ComputeTileRect(const Bounds& bounds, float depth_min, float depth_max, const Matrix& projection, TileRect& rect) const
+    {
+        // The part of the sphere which is within the depth range
+        const Vector3& center   = bounds.center;
+        depth_min               = Helper::Max(depth_min, center.z - bounds.radius);
+        depth_max               = Helper::Min(depth_max, center.z + bounds.radius);
+        if (depth_min > depth_max)
+            return false;
+
+        // It's widest at the depth closest to the center
+        const float depth_closest   = Helper::Clamp(center.z, depth_min, depth_max) - center.z;
+        const float radius          = sqrt(Helper::Max(bounds.radius * bounds.radius - depth_closest * depth_closest, 0.0f));
+
+        // Project the corners of the box around it, the four of each face at once. They are all
+        // in front of the near plane (which is where the first slice starts), so the projected
+        // rectangle contains the one of the sphere.
+        const __m128 x      = _mm_add_ps(_mm_set1_ps(center.x), _mm_setr_ps(-radius, radius, -radius, radius));
+        const __m128 y      = _mm_add_ps(_mm_set1_ps(center.y), _mm_setr_ps(-radius, -radius, radius, radius));
+        __m128 ndc_x_min    = _mm_set1_ps(numeric_limits<float>::infinity());
+        __m128 ndc_y_min    = ndc_x_min;
+        __m128 ndc_x_max    = _mm_set1_ps(-numeric_limits<float>::infinity());
+        __m128 ndc_y_max    = ndc_x_max;
+        for (const float z : { depth_min, depth_max })
+        {
+            const __m128 clip_x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(projection.m00)), _mm_mul_ps(y, _mm_set1_ps(projection.m10))), _mm_set1_ps(z * projection.m20 + projection.m30));
+            const __m128 clip_y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(projection.m01)), _mm_mul_ps(y, _mm_set1_ps(projection.m11))), _mm_set1_ps(z * projection.m21 + projection.m31));
+            const __m128 clip_w = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(projection.m03)), _mm_mul_ps(y, _mm_set1_ps(projection.m13))), _mm_set1_ps(z * projection.m23 + projection.m33));
+            const __m128 ndc_x  = _mm_div_ps(clip_x, clip_w);
+            const __m128 ndc_y  = _mm_div_ps(clip_y, clip_w);
+            ndc_x_min           = _mm_min_ps(ndc_x_min, ndc_x);
+            ndc_x_max           = _mm_max_ps(ndc_x_max, ndc_x);
+            ndc_y_min           = _mm_min_ps(ndc_y_min, ndc_y);
+            ndc_y_max           = _mm_max_ps(ndc_y_max, ndc_y);
+        }
+
+        // To texture space, where y points down
+        const float u_min = horizontal_min(ndc_x_min) * 0.5f + 0.5f;
+        const float u_max = horizontal_max(ndc_x_max) * 0.5f + 0.5f;
+        const float v_min = 0.5f - horizontal_max(ndc_y_max) * 0.5f;
+        const float v_max = 0.5f - horizontal_min(ndc_y_min) * 0.5f;
+        if (u_max < 0.0f || u_min > 1.0f || v_max < 0.0f || v_min > 1.0f)
+            return false;
+
+        rect.x_min = static_cast<uint8_t>(uv_to_tile(u_min, m_cluster_count_x));
+        rect.x_max = static_cast<uint8_t>(uv_to_tile(u_max, m_cluster_count_x));
+        rect.y_min = static_cast<uint8_t>(uv_to_tile(v_min, m_cluster_count_y));
+        rect.y_max = static_cast<uint8_t>(uv_to_tile(v_max, m_cluster_count_y));
+
+        return true;
+    }
+
+    void LightClusters::BinSlice(const uint32_t z, const Matrix& projection, const float near_plane)
+    {
+        const uint32_t tile_count   = m_cluster_count_x * m_cluster_count_y;
+        uint32_t* counts            = &m_cluster_counts[GetClusterIndex(0, 0, z)];
+        uint32_t& overflow          = m_slice_overflow[z];
+        vector<uint16_t>& indices   = m_slice_indices[z];
+        vector<TileRect>& rects     = m_slice_rects[z];
+        const uint32_t light_count  = static_cast<uint32_t>(m_bounds.size());
+        fill(counts, counts + tile_count, 0);
+        overflow = 0;
+        rects.clear();
+
+        // The depth range of the slice, the first one starts at the near plane
+        const float depth_min = z == 0 ? near_plane : exp((static_cast<float>(z) - m_slice_bias) / m_slice_scale);
+        const float depth_max = exp((static_cast<float>(z + 1) - m_slice_bias) / m_slice_scale);
+
+        // Find the tiles of every light in the slice, and count the lights of every cluster
+        uint32_t index_count = 0;
+        for (uint32_t i = 0; i < light_count; i++)
+        {
+            const Bounds& bounds = m_bounds[i];
+            if (z < bounds.slice_min || z > bounds.slice_max)
+                continue;
+
+            TileRect rect;
+            rect.light = static_cast<uint16_t>(i);
+            if (!ComputeTileRect(bounds, depth_min, depth_max, projection, rect))
+                continue;
+
+            rects.emplace_back(rect);
+            for (uint32_t y = rect.y_min; y <= rect.y_max; y++)
+            {
+                for (uint32_t x = rect.x_min; x <= rect.x_max; x++)
+                {
+                    uint32_t& count = counts[y * m_cluster_count_x + x];
+                    if (count < m_cluster_lights_max)
+                    {
+                        count++;
+                        index_count++;
+                    }
+                    else
+                    {
+                        overflow++;
+                    }
+                }
+            }
+        }
+
+        // Where the lights of every cluster start, within the slice
+        array<uint32_t, m_cluster_count_x * m_cluster_count_y> offsets;
+        array<uint32_t, m_cluster_count_x * m_cluster_count_y> ends;
+        for (uint32_t tile = 0, offset = 0; tile < tile_count; tile++)
+        {
+            offsets[tile]   = offset;
+            offset          += counts[tile];
+            ends[tile]      = offset;
+        }
+
+        // Fill in the indices, in the same order they were counted
+        indices.resize(index_count);
+        for (const TileRect& rect : rects)
+        {
+            for (uint32_t y = rect.y_min; y <= rect.y_max; y++)
+            {
+                for (uint32_t x = rect.x_min; x <= rect.x_max; x++)
+                {
+                    const uint32_t tile = y * m_cluster_count_x + x;
+                    if (offsets[tile] < ends[tile])
+                    {
+                        indices[offsets[tile]++] = rect.light;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,116 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <array>
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Math/Matrix.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    class Threading;
+
+    // The grid of clusters (froxels), tiles in screen space and exponential slices in view space depth
+    static const uint32_t m_cluster_count_x             = 16;
+    static const uint32_t m_cluster_count_y             = 9;
+    static const uint32_t m_cluster_count_z             = 24;
+    static const uint32_t m_cluster_count               = m_cluster_count_x * m_cluster_count_y * m_cluster_count_z;
+    static const uint32_t m_cluster_lights_max          = 255;      // per cluster, the count is packed in 8 bits
+    static const uint32_t m_cluster_light_indices_max   = 32768;    // across all clusters
+
+    // A point light (angle of 0) or a spot light, as the clusters see it
+    struct ClusteredLight
+    {
+        Math::Vector3 position  = Math::Vector3::Zero;
+        float range             = 0.0f;
+        Math::Vector3 direction = Math::Vector3::Zero; // spot lights only
+        float angle             = 0.0f;                // spot lights only, the half angle of the cone in radians
+    };
+
+    // Bins lights into the clusters of a view, so that shading only has to go through the lights which can reach a pixel.
+    // Every light is bounded by a sphere (the cone's for spot lights). Within every slice it covers, the part of the sphere
+    // which falls in the slice is projected to a rectangle of tiles. Slices are binned in parallel, then compacted into
+    // one list of light indices. It doesn't depend on the RHI.
+    class SPARTAN_CLASS LightClusters
+    {
+    public:
+        LightClusters() = default;
+        ~LightClusters() = default;
+
+        // The threading subsystem is optional, without it the slices are binned on the calling thread
+        void Build(const std::vector<ClusteredLight>& lights, const Math::Matrix& view, const Math::Matrix& projection, float near_plane, float far_plane, Threading* threading = nullptr);
+
+        // The slice of a view space depth, slices are spaced exponentially between the near and the far plane
+        uint32_t GetSlice(float depth) const;
+        uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * m_cluster_count_y + y) * m_cluster_count_x + x; }
+
+        // Per cluster, the offset of its first light index (upper 24 bits) and its light count (lower 8 bits)
+        const std::vector<uint32_t>& GetClusters()  const { return m_clusters; }
+        const std::vector<uint16_t>& GetIndices()   const { return m_indices; }
+
+        // Slice = log(depth) * scale + bias
+        float GetSliceScale()       const { return m_slice_scale; }
+        float GetSliceBias()        const { return m_slice_bias; }
+
+        // Light indices which were dropped because a cluster or the index list ran out of space
+        uint32_t GetOverflowCount() const { return m_overflow_count; }
+
+    private:
+        // A light's bounding sphere in view space, and the slices it covers (none when min > max)
+        struct Bounds
+        {
+            Math::Vector3 center;
+            float radius;
+            uint32_t slice_min;
+            uint32_t slice_max;
+        };
+
+        // The tiles which a light covers within a slice
+        struct TileRect
+        {
+            uint16_t light;
+            uint8_t x_min;
+            uint8_t x_max;
+            uint8_t y_min;
+            uint8_t y_max;
+        };
+
+        Bounds ComputeBounds(const ClusteredLight& light, const Math::Matrix& view, float near_plane, float far_plane) const;
+        bool ComputeTileRect(const Bounds& bounds, float depth_min, float depth_max, const Math::Matrix& projection, TileRect& rect) const;
+        void BinSlice(uint32_t z, const Math::Matrix& projection, float near_plane);
+
+        std::vector<uint32_t> m_clusters;
+        std::vector<uint16_t> m_indices;
+        std::vector<Bounds> m_bounds;
+        std::array<std::vector<uint16_t>, m_cluster_count_z> m_slice_indices;   // scratch, the light indices of every slice in cluster order
+        std::array<std::vector<TileRect>, m_cluster_count_z> m_slice_rects;     // scratch, the lights of every slice
+        std::array<uint32_t, m_cluster_count> m_cluster_counts;                 // scratch, before compaction
+        std::array<uint32_t, m_cluster_count_z> m_slice_overflow;               // scratch, so that slices don't share a counter
+        float m_slice_scale         = 0.0f;
+        float m_slice_bias          = 0.0f;
+        uint32_t m_overflow_count   = 0;
+    };
+}
@@ -28,7 +28,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../IO/XmlDocument.h"
 #include "../RHI/RHI_Texture2D.h"
 #include "../RHI/RHI_TextureCube.h"
-#include "../World/World.h"
 //====================================
 
 //= NAMESPACES ===============
@@ -66,17 +65,25 @@ namespace Spartan
 
 		SetResourceFilePath(file_path);
 
+        // Properties live in an array, so they are read into a local and set (which also bumps the version)
+        const auto load_property = [&xml, this](const char* name, const Material_Property type)
+        {
+            float value = GetProperty(type);
+            xml->GetAttribute("Material", name, &value);
+            SetProperty(type, value);
+        };
+
         xml->GetAttribute("Material", "Color",                          &m_color_albedo);
-		xml->GetAttribute("Material", "Roughness_Multiplier",	        &GetProperty(Material_Roughness));
-		xml->GetAttribute("Material", "Metallic_Multiplier",	        &GetProperty(Material_Metallic));
-		xml->GetAttribute("Material", "Normal_Multiplier",		        &GetProperty(Material_Normal));
-		xml->GetAttribute("Material", "Height_Multiplier",		        &GetProperty(Material_Height));
-        xml->GetAttribute("Material", "Clearcoat_Multiplier",           &GetProperty(Material_Clearcoat));
-        xml->GetAttribute("Material", "Clearcoat_Roughness_Multiplier", &GetProperty(Material_Clearcoat_Roughness));
-        xml->GetAttribute("Material", "Anisotropi_Multiplier",          &GetProperty(Material_Anisotropic));
-        xml->GetAttribute("Material", "Anisotropic_Rotatio_Multiplier", &GetProperty(Material_Anisotropic_Rotation));
-        xml->GetAttribute("Material", "Sheen_Multiplier",               &GetProperty(Material_Sheen));
-        xml->GetAttribute("Material", "Sheen_Tint_Multiplier",          &GetProperty(Material_Sheen_Tint));
+		load_property("Roughness_Multiplier",	        Material_Roughness);
+		load_property("Metallic_Multiplier",	        Material_Metallic);
+		load_property("Normal_Multiplier",		        Material_Normal);
+		load_property("Height_Multiplier",		        Material_Height);
+        load_property("Clearcoat_Multiplier",           Material_Clearcoat);
+        load_property("Clearcoat_Roughness_Multiplier", Material_Clearcoat_Roughness);
+        load_property("Anisotropi_Multiplier",          Material_Anisotropic);
+        load_property("Anisotropic_Rotatio_Multiplier", Material_Anisotropic_Rotation);
+        load_property("Sheen_Multiplier",               Material_Sheen);
+        load_property("Sheen_Tint_Multiplier",          Material_Sheen_Tint);
 		xml->GetAttribute("Material", "IsEditable",				        &m_is_editable);
 		xml->GetAttribute("Material", "UV_Tiling",				        &m_uv_tiling);
 		xml->GetAttribute("Material", "UV_Offset",				        &m_uv_offset);
@@ -129,15 +136,19 @@ namespace Spartan
 		xml->AddAttribute("Material", "IsEditable",				        m_is_editable);
 
 		xml->AddChildNode("Material", "Textures");
-		xml->AddAttribute("Textures", "Count", static_cast<uint32_t>(m_textures.size()));
+		xml->AddAttribute("Textures", "Count", static_cast<uint32_t>(GetTexturePaths().size()));
 		auto i = 0;
-		for (const auto& texture : m_textures)
+		for (uint32_t slot = 0; slot < m_material_property_count; slot++)
 		{
+            const shared_ptr<RHI_Texture>& texture = m_textures[slot];
+            if (!texture)
+                continue;
+
 			auto tex_node = "Texture_" + to_string(i);
 			xml->AddChildNode("Textures", tex_node);
-			xml->AddAttribute(tex_node, "Texture_Type", static_cast<uint32_t>(texture.first));
-			xml->AddAttribute(tex_node, "Texture_Name", texture.second ? texture.second->GetResourceName() : "");
-			xml->AddAttribute(tex_node, "Texture_Path", texture.second ? texture.second->GetResourceFilePathNative() : "");
+			xml->AddAttribute(tex_node, "Texture_Type", static_cast<uint32_t>(1 << slot));
+			xml->AddAttribute(tex_node, "Texture_Name", texture->GetResourceName());
+			xml->AddAttribute(tex_node, "Texture_Path", texture->GetResourceFilePathNative());
 			i++;
 		}
 
@@ -150,17 +161,19 @@ namespace Spartan
 		{
             // In order for the material to guarantee serialization/deserialization we cache the texture
             const shared_ptr<RHI_Texture> texture_cached = m_context->GetSubsystem<ResourceCache>()->Cache(texture);
-			m_textures[type] = texture_cached != nullptr ? texture_cached : texture;
+			m_textures[material_property_index(type)] = texture_cached != nullptr ? texture_cached : texture;
             m_flags |= type;
 
             SetProperty(type, multiplier);
 		}
 		else
 		{
-			m_textures.erase(type);
+			m_textures[material_property_index(type)] = nullptr;
             m_flags &= ~type;
 		}
 
+        m_version++;
+
         // Ensure an a suitable shader exists
         ShaderGBuffer::GenerateVariation(m_context, m_flags);
 	}
@@ -179,10 +192,10 @@ namespace Spartan
 	{
 		for (const auto& texture : m_textures)
 		{
-			if (!texture.second)
+			if (!texture)
 				continue;
 
-			if (texture.second->GetResourceFilePathNative() == path)
+			if (texture->GetResourceFilePathNative() == path)
 				return true;
 		}
 
@@ -194,7 +207,7 @@ namespace Spartan
 		if (!HasTexture(type))
 			return "";
 
-		return m_textures.at(type)->GetResourceFilePathNative();
+		return m_textures[material_property_index(type)]->GetResourceFilePathNative();
 	}
 
 	vector<string> Material::GetTexturePaths()
@@ -202,10 +215,10 @@ namespace Spartan
 		vector<string> paths;
 		for (const auto& texture : m_textures)
 		{
-			if (!texture.second)
+			if (!texture)
 				continue;
 
-			paths.emplace_back(texture.second->GetResourceFilePathNative());
+			paths.emplace_back(texture->GetResourceFilePathNative());
 		}
 
 		return paths;
@@ -214,18 +227,14 @@ namespace Spartan
     shared_ptr<Spartan::RHI_Texture>& Material::GetTexture_PtrShared(const Material_Property type)
     {
         static shared_ptr<RHI_Texture> texture_empty;
-        return HasTexture(type) ? m_textures.at(type) : texture_empty;
+        return HasTexture(type) ? m_textures[material_property_index(type)] : texture_empty;
     }
 
     void Material::SetColorAlbedo(const Math::Vector4& color)
     {
-        // If an object switches from opaque to transparent or vice versa, make the world update so that the renderer
-        // goes through the entities and makes the ones that use this material, render in the correct mode.
-        if ((m_color_albedo.w != 1.0f && color.w == 1.0f) || (m_color_albedo.w == 1.0f && color.w != 1.0f))
-        {
-            m_context->GetSubsystem<World>()->MakeDirty();
-        }
-
+        // Switching between opaque and transparent doesn't need the world to resolve, the renderer checks the
+        // materials when it captures a frame and moves the entities which use this one to the right pass.
         m_color_albedo = color;
+        m_version++;
     }
 }
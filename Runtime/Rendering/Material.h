@@ -22,8 +22,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 //= INCLUDES ======================
+#include <array>
 #include <memory>
-#include <unordered_map>
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/Vector2.h"
@@ -53,6 +53,20 @@ namespace Spartan
 		Material_Mask                   = 1 << 13   // Discards pixels
 	};
 
+    // Textures and properties are stored in fixed arrays, indexed by the bit of their Material_Property
+    static const uint32_t m_material_property_count = 14;
+
+    inline uint32_t material_property_index(const Material_Property type)
+    {
+        uint32_t index = 0;
+        while ((static_cast<uint32_t>(type) >> (index + 1)) != 0)
+        {
+            index++;
+        }
+
+        return index;
+    }
+
 	class SPARTAN_CLASS Material : public IResource
 	{
 	public:
@@ -72,7 +86,7 @@ namespace Spartan
         bool HasTexture(const Material_Property type) const { return m_flags & type; }
 		std::string GetTexturePathByType(Material_Property type);
 		std::vector<std::string> GetTexturePaths();
-		RHI_Texture* GetTexture_Ptr(const Material_Property type) { return HasTexture(type) ? m_textures[type].get() : nullptr; }
+		RHI_Texture* GetTexture_Ptr(const Material_Property type) { return HasTexture(type) ? m_textures[material_property_index(type)].get() : nullptr; }
         std::shared_ptr<RHI_Texture>& GetTexture_PtrShared(const Material_Property type);
 		//=======================================================================================================================
         
@@ -81,28 +95,34 @@ namespace Spartan
         void SetColorAlbedo(const Math::Vector4& color);
 
         const Math::Vector2& GetTiling()                                    const { return m_uv_tiling; }
-        void SetTiling(const Math::Vector2& tiling)                         { m_uv_tiling = tiling; }
+        void SetTiling(const Math::Vector2& tiling)                         { m_uv_tiling = tiling; m_version++; }
 
         const Math::Vector2& GetOffset()                                    const { return m_uv_offset; }
-        void SetOffset(const Math::Vector2& offset)                         { m_uv_offset = offset; }
+        void SetOffset(const Math::Vector2& offset)                         { m_uv_offset = offset; m_version++; }
 
         auto IsEditable()                                                   const { return m_is_editable; }
         void SetIsEditable(const bool is_editable)                          { m_is_editable = is_editable; }
 
-        auto& GetProperty(const Material_Property type)                     { return m_properties[type]; }
-        void SetProperty(const Material_Property type, const float value)   { m_properties[type] = value; }
+        float GetProperty(const Material_Property type)                     const { return m_properties[material_property_index(type)]; }
+        void SetProperty(const Material_Property type, const float value)   { m_properties[material_property_index(type)] = value; m_version++; }
 
         uint16_t GetFlags()                                                 const { return m_flags; }
         //==================================================================================================
 
+        //= RENDERER =======================================================================================
+        // Incremented whenever anything the GPU material table holds changes, so the renderer only re-uploads what did
+        uint32_t GetVersion()                                               const { return m_version; }
+        //==================================================================================================
+
 	private:
 		Math::Vector4 m_color_albedo	= Math::Vector4(1.0f, 1.0f, 1.0f, 1.0f);
 		Math::Vector2 m_uv_tiling		= Math::Vector2(1.0f, 1.0f);
 		Math::Vector2 m_uv_offset		= Math::Vector2(0.0f, 0.0f);
 		bool m_is_editable				= true;
         uint16_t m_flags                = 0;
-		std::unordered_map<Material_Property, std::shared_ptr<RHI_Texture>> m_textures;
-		std::unordered_map<Material_Property, float> m_properties;
+        uint32_t m_version              = 1; // table rows start at 0, so that a new material is always uploaded
+		std::array<std::shared_ptr<RHI_Texture>, m_material_property_count> m_textures;
+		std::array<float, m_material_property_count> m_properties = {};
 		std::shared_ptr<RHI_Device> m_rhi_device;
 	};
 }
@@ -0,0 +1,169 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "Meshlet.h"
+#include "../RHI/RHI_Vertex.h"
+//=============================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    static Vector3 vertex_position(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t index)
+    {
+        const float* pos = vertices[index].pos;
+        return Vector3(pos[0], pos[1], pos[2]);
+    }
+
+    void MeshletBuilder::Build(const uint32_t* indices, const uint32_t index_count, const uint32_t index_offset, const RHI_Vertex_PosTexNorTan* vertices, const float radius_padding, vector<Meshlet>* meshlets)
+    {
+        if (!indices || !vertices || !meshlets)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        // The unique vertices of the meshlet that's being filled
+        uint32_t meshlet_vertices[m_meshlet_vertices_max];
+        uint32_t meshlet_vertex_count   = 0;
+        uint32_t meshlet_first          = 0; // first index
+
+        const auto contains = [&meshlet_vertices, &meshlet_vertex_count](const uint32_t index)
+        {
+            for (uint32_t i = 0; i < meshlet_vertex_count; i++)
+            {
+                if (meshlet_vertices[i] == index)
+                    return true;
+            }
+
+            return false;
+        };
+
+        const auto flush = [&](const uint32_t last)
+        {
+            if (last > meshlet_first)
+            {
+                Meshlet meshlet         = ComputeBounds(indices + meshlet_first, last - meshlet_first, vertices);
+                meshlet.radius         += radius_padding;
+                meshlet.index_offset    = index_offset + meshlet_first;
+                meshlet.index_count     = last - meshlet_first;
+                meshlets->emplace_back(meshlet);
+            }
+
+            meshlet_vertex_count    = 0;
+            meshlet_first           = last;
+        };
+
+        const uint32_t triangle_index_count = index_count - index_count % 3;
+        for (uint32_t i = 0; i < triangle_index_count; i += 3)
+        {
+            // Count the vertices the triangle adds
+            const uint32_t* triangle = indices + i;
+            uint32_t vertices_new = 0;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                const bool repeated = (j > 0 && triangle[j] == triangle[0]) || (j > 1 && triangle[j] == triangle[1]);
+                vertices_new += (!repeated && !contains(triangle[j])) ? 1 : 0;
+            }
+
+            // Start a new meshlet if it doesn't fit
+            if (meshlet_vertex_count + vertices_new > m_meshlet_vertices_max || (i - meshlet_first) / 3 == m_meshlet_triangles_max)
+            {
+                flush(i);
+            }
+
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                if (!contains(triangle[j]))
+                {
+                    meshlet_vertices[meshlet_vertex_count++] = triangle[j];
+                }
+            }
+        }
+
+        flush(triangle_index_count);
+    }
+
+    Meshlet MeshletBuilder::ComputeBounds(const uint32_t* indices, const uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices)
+    {
+        Meshlet meshlet;
+
+        // Bounding sphere, around the center of the bounding box
+        Vector3 min = Vector3::Infinity;
+        Vector3 max = Vector3::InfinityNeg;
+        for (uint32_t i = 0; i < index_count; i++)
+        {
+            const Vector3 position = vertex_position(vertices, indices[i]);
+            min = Vector3(Helper::Min(min.x, position.x), Helper::Min(min.y, position.y), Helper::Min(min.z, position.z));
+            max = Vector3(Helper::Max(max.x, position.x), Helper::Max(max.y, position.y), Helper::Max(max.z, position.z));
+        }
+
+        meshlet.center = (min + max) * 0.5f;
+        float radius_squared = 0.0f;
+        for (uint32_t i = 0; i < index_count; i++)
+        {
+            radius_squared = Helper::Max(radius_squared, Vector3::DistanceSquared(meshlet.center, vertex_position(vertices, indices[i])));
+        }
+        meshlet.radius = Helper::Sqrt(radius_squared);
+
+        // Normal cone, around the average of the triangle normals (degenerate triangles face nowhere, so they are skipped)
+        Vector3 normals[m_meshlet_triangles_max];
+        uint32_t normal_count = 0;
+        Vector3 normal_sum = Vector3::Zero;
+        for (uint32_t i = 0; i + 2 < index_count; i += 3)
+        {
+            const Vector3 a = vertex_position(vertices, indices[i]);
+            const Vector3 b = vertex_position(vertices, indices[i + 1]);
+            const Vector3 c = vertex_position(vertices, indices[i + 2]);
+            const Vector3 normal = Vector3::Cross(b - a, c - a);
+            const float length = normal.Length();
+            if (length <= Helper::M_EPSILON)
+                continue;
+
+            normals[normal_count] = normal / length;
+            normal_sum += normals[normal_count];
+            normal_count++;
+        }
+
+        const float axis_length = normal_sum.Length();
+        if (normal_count == 0 || axis_length <= Helper::M_EPSILON)
+            return meshlet;
+
+        meshlet.cone_axis = normal_sum / axis_length;
+
+        // The cone has to contain every normal, if one is 90 degrees or more from the axis there is no viewer all of them face away from
+        float dot_min = 1.0f;
+        for (uint32_t i = 0; i < normal_count; i++)
+        {
+            dot_min = Helper::Min(dot_min, Vector3::Dot(normals[i], meshlet.cone_axis));
+        }
+
+        meshlet.cone_cutoff = dot_min <= 0.0f ? 1.0f : Helper::Sqrt(1.0f - dot_min * dot_min);
+
+        return meshlet;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    struct RHI_Vertex_PosTexNorTan;
+
+    // The most a meshlet can hold, the limits of mesh shader hardware so that the clusters can be reused by it
+    static const uint32_t m_meshlet_vertices_max    = 64;
+    static const uint32_t m_meshlet_triangles_max   = 124;
+
+    // A cluster of consecutive triangles of a mesh, with the bounds to reject it before it's drawn. Everything is in model space.
+    struct Meshlet
+    {
+        // True if every triangle faces away from a viewer at the given position (conservative, it works with the bounding sphere)
+        bool IsBackFacing(const Math::Vector3& position) const
+        {
+            const Math::Vector3 direction = center - position;
+            return Math::Vector3::Dot(direction, cone_axis) >= cone_cutoff * direction.Length() + radius;
+        }
+
+        Math::Vector3 center    = Math::Vector3::Zero;
+        float radius            = 0.0f;
+        Math::Vector3 cone_axis = Math::Vector3::Zero;  // the average triangle normal
+        float cone_cutoff       = 1.0f;                 // sine of the cone's half angle, 1 means that the triangles face too many ways to ever be rejected
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+    };
+
+    class SPARTAN_CLASS MeshletBuilder
+    {
+    public:
+        // Splits the triangles of a mesh into meshlets, in index order, and appends them. The indices are relative to the vertices,
+        // the index offset is where the indices are in the model's index buffer. The radius padding is how far the positions the GPU
+        // draws can be from the given ones (see VertexQuantizer::GetPositionError()).
+        static void Build(const uint32_t* indices, uint32_t index_count, uint32_t index_offset, const RHI_Vertex_PosTexNorTan* vertices, float radius_padding, std::vector<Meshlet>* meshlets);
+
+    private:
+        static Meshlet ComputeBounds(const uint32_t* indices, uint32_t index_count, const RHI_Vertex_PosTexNorTan* vertices);
+    };
+}
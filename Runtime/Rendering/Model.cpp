@@ -62,7 +62,11 @@ namespace Spartan
         m_vertex_buffer.reset();
         m_index_buffer.reset();
         m_mesh->Geometry_Clear();
+        m_meshlets.clear();
+        m_geometry_appended.clear();
         m_aabb.Undefine();
+        m_vertex_dequantization = Matrix::Identity;
+        m_vertices_quantized = false;
         m_normalized_scale = 1.0f;
         m_is_animated = false;
     }
@@ -90,7 +94,52 @@ namespace Spartan
             file->Read(&m_mesh->Indices_Get());
             file->Read(&m_mesh->Vertices_Get());
 
-            UpdateGeometry();
+            // Quantized models store their vertices quantized, after an empty array of full precision ones (older files end there)
+            m_vertices_quantized = file->GetPosition() < file->GetSize() && file->ReadAs<bool>();
+            if (m_vertices_quantized)
+            {
+                Vector3 center  = Vector3::Zero;
+                float extent    = 1.0f;
+                file->Read(&center);
+                file->Read(&extent);
+                m_vertex_quantizer = VertexQuantizer(center, extent);
+
+                // They go to the GPU straight from the file, and are dequantized for the CPU
+                uint32_t vertex_count = 0;
+                const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized = file->ReadView<RHI_Vertex_PosTexNorTanQuantized>(&vertex_count);
+                if (!vertices_quantized)
+                {
+                    LOG_ERROR("\"%s\" is truncated", file_path.c_str());
+                    return false;
+                }
+
+                m_mesh->Vertices_Get().resize(vertex_count);
+                m_vertex_quantizer.Dequantize(vertices_quantized, vertex_count, m_mesh->Vertices_Get().data());
+                m_vertex_quantization = true;
+
+                GeometryCreateBuffers(vertices_quantized);
+                m_normalized_scale  = GeometryComputeNormalizedScale();
+                m_aabb              = BoundingBox(m_mesh->Vertices_Get().data(), static_cast<uint32_t>(m_mesh->Vertices_Get().size()));
+            }
+            else
+            {
+                UpdateGeometry();
+            }
+
+            // Followed by the meshlets (older files end before them, so the model is culled as a whole)
+            if (file->GetPosition() < file->GetSize())
+            {
+                // Copied, a view into the mapped file wouldn't be aligned for Meshlet
+                const uint64_t meshlet_count = file->ReadAs<uint32_t>();
+                if (sizeof(Meshlet) * meshlet_count > file->GetSize() - file->GetPosition())
+                {
+                    LOG_ERROR("\"%s\" is truncated", file_path.c_str());
+                    return false;
+                }
+
+                m_meshlets.resize(meshlet_count);
+                file->ReadBytes(m_meshlets.data(), sizeof(Meshlet) * meshlet_count);
+            }
         }
         // Load foreign format
         else
@@ -137,14 +186,35 @@ namespace Spartan
 		file->Write(GetResourceFilePath());
 		file->Write(m_normalized_scale);
 		file->Write(m_mesh->Indices_Get());
-		file->Write(m_mesh->Vertices_Get());
+
+		// Quantized models store their vertices quantized, older versions of the engine see a model without vertices
+		if (m_vertices_quantized)
+		{
+			const vector<RHI_Vertex_PosTexNorTan>& vertices = m_mesh->Vertices_Get();
+			vector<RHI_Vertex_PosTexNorTanQuantized> vertices_quantized(vertices.size());
+			m_vertex_quantizer.Quantize(vertices.data(), static_cast<uint32_t>(vertices.size()), vertices_quantized.data());
+
+			file->Write(vector<RHI_Vertex_PosTexNorTan>());
+			file->Write(true);
+			file->Write(m_vertex_quantizer.GetCenter());
+			file->Write(m_vertex_quantizer.GetExtent());
+			file->Write(vertices_quantized);
+		}
+		else
+		{
+			file->Write(m_mesh->Vertices_Get());
+			file->Write(false);
+		}
+
+		file->Write(static_cast<uint32_t>(m_meshlets.size()));
+		file->WriteBytes(m_meshlets.data(), sizeof(Meshlet) * m_meshlets.size());
 
         file->Close();
 
 		return true;
 	}
 
-	void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset) const
+	void Model::AppendGeometry(const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, uint32_t* index_offset, uint32_t* vertex_offset)
 	{
 		if (indices.empty() || vertices.empty())
 		{
@@ -152,11 +222,25 @@ namespace Spartan
 			return;
 		}
 
+		// Remember where it goes, UpdateGeometry() splits it into meshlets (the indices are relative to the appended vertices)
+		m_geometry_appended.emplace_back(m_mesh->Indices_Count(), m_mesh->Vertices_Count());
+
 		// Append indices and vertices to the main mesh
 		m_mesh->Indices_Append(indices, index_offset);
 		m_mesh->Vertices_Append(vertices, vertex_offset);
 	}
 
+	pair<const Meshlet*, const Meshlet*> Model::GetMeshlets(const uint32_t index_offset, const uint32_t index_count) const
+	{
+		const auto first = lower_bound(m_meshlets.begin(), m_meshlets.end(), index_offset, [](const Meshlet& meshlet, const uint32_t offset) { return meshlet.index_offset < offset; });
+		const auto last  = lower_bound(first, m_meshlets.end(), index_offset + index_count, [](const Meshlet& meshlet, const uint32_t offset) { return meshlet.index_offset < offset; });
+
+		if (first == last)
+			return { nullptr, nullptr };
+
+		return { &*first, &*first + (last - first) };
+	}
+
 	void Model::GetGeometry(const uint32_t index_offset, const uint32_t index_count, const uint32_t vertex_offset, const uint32_t vertex_count, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices) const
 	{
 		m_mesh->Geometry_Get(index_offset, index_count, vertex_offset, vertex_count, indices, vertices);
@@ -170,6 +254,26 @@ namespace Spartan
 			return;
 		}
 
+		// Quantize if the model allows it and the geometry can be reconstructed within the error bounds
+		m_vertices_quantized = m_vertex_quantization && m_vertex_quantizer.Fit(m_mesh->Vertices_Get(), m_mesh->Indices_Get());
+
+		// Split the appended geometry into meshlets, their bounds have to contain the quantized positions too
+		if (!m_geometry_appended.empty())
+		{
+			const vector<uint32_t>& indices					= m_mesh->Indices_Get();
+			const vector<RHI_Vertex_PosTexNorTan>& vertices	= m_mesh->Vertices_Get();
+			const float radius_padding						= m_vertices_quantized ? m_vertex_quantizer.GetPositionError() : 0.0f;
+
+			m_meshlets.clear();
+			for (size_t i = 0; i < m_geometry_appended.size(); i++)
+			{
+				const uint32_t index_offset		= m_geometry_appended[i].first;
+				const uint32_t vertex_offset	= m_geometry_appended[i].second;
+				const uint32_t index_end		= i + 1 < m_geometry_appended.size() ? m_geometry_appended[i + 1].first : static_cast<uint32_t>(indices.size());
+				MeshletBuilder::Build(indices.data() + index_offset, index_end - index_offset, index_offset, vertices.data() + vertex_offset, radius_padding, &m_meshlets);
+			}
+		}
+
 		GeometryCreateBuffers();
 		m_normalized_scale	= GeometryComputeNormalizedScale();
 		m_aabb				= BoundingBox(m_mesh->Vertices_Get().data(), static_cast<uint32_t>(m_mesh->Vertices_Get().size()));
@@ -191,6 +295,26 @@ namespace Spartan
         entity->AddComponent<Renderable>()->SetMaterial(material);
 	}
 
+	RHI_Texture_Compression Model::GetTextureCompression(const Material_Property texture_type)
+	{
+		switch (texture_type)
+		{
+			// Sampled as color
+			case Material_Color:        return RHI_Texture_Compression_Color;
+			case Material_Emission:     return RHI_Texture_Compression_Color;
+			// Normal and height maps get mixed up by some models, so both are compressed based on whether the image is grayscale
+			case Material_Normal:       return RHI_Texture_Compression_Normal;
+			case Material_Height:       return RHI_Texture_Compression_Normal;
+			// Sampled as a single channel
+			case Material_Roughness:    return RHI_Texture_Compression_Grayscale;
+			case Material_Metallic:     return RHI_Texture_Compression_Grayscale;
+			case Material_Occlusion:    return RHI_Texture_Compression_Grayscale;
+			// Compared against a threshold, so it's data rather than color
+			case Material_Mask:         return RHI_Texture_Compression_Mask;
+			default:                    return RHI_Texture_Compression_None;
+		}
+	}
+
 	void Model::AddTexture(shared_ptr<Material>& material, const Material_Property texture_type, const string& file_path)
 	{
 		if (!material || file_path.empty())
@@ -208,9 +332,10 @@ namespace Spartan
 		// If we didn't get a texture, it's not cached, hence we have to load it and cache it now
 		else
 		{
-			// Load texture
+			// Load texture, block compressed according to what the material uses it for
 			auto generate_mipmaps = true;
             texture = make_shared<RHI_Texture2D>(m_context, generate_mipmaps);
+            texture->SetCompression(GetTextureCompression(texture_type));
 			texture->LoadFromFile(file_path);
 
 			// Set the texture to the provided material
@@ -218,13 +343,13 @@ namespace Spartan
 		}
 	}
 
-	bool Model::GeometryCreateBuffers()
+	bool Model::GeometryCreateBuffers(const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized)
 	{
 		auto success = true;
 
 		// Get geometry
-		const auto indices	= m_mesh->Indices_Get();
-		const auto vertices	= m_mesh->Vertices_Get();
+		const auto& indices		= m_mesh->Indices_Get();
+		const auto& vertices	= m_mesh->Vertices_Get();
 
 		if (!indices.empty())
 		{
@@ -244,7 +369,25 @@ namespace Spartan
 		if (!vertices.empty())
 		{
 			m_vertex_buffer = make_shared<RHI_VertexBuffer>(m_rhi_device);
-			if (!m_vertex_buffer->Create(vertices))
+			m_vertex_dequantization = m_vertices_quantized ? m_vertex_quantizer.GetDequantization() : Matrix::Identity;
+
+			bool created = false;
+			if (m_vertices_quantized && vertices_quantized)
+			{
+				created = m_vertex_buffer->Create(vertices_quantized, static_cast<uint32_t>(vertices.size()));
+			}
+			else if (m_vertices_quantized)
+			{
+				vector<RHI_Vertex_PosTexNorTanQuantized> quantized(vertices.size());
+				m_vertex_quantizer.Quantize(vertices.data(), static_cast<uint32_t>(vertices.size()), quantized.data());
+				created = m_vertex_buffer->Create(quantized);
+			}
+			else
+			{
+				created = m_vertex_buffer->Create(vertices);
+			}
+
+			if (!created)
 			{
 				LOG_ERROR("Failed to create vertex buffer for \"%s\".", GetResourceName().c_str());
 				success = false;
@@ -25,6 +25,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <memory>
 #include <vector>
 #include "Material.h"
+#include "VertexQuantizer.h"
+#include "Meshlet.h"
 #include "../RHI/RHI_Definition.h"
 #include "../Resource/IResource.h"
 #include "../Math/BoundingBox.h"
@@ -56,7 +58,7 @@ namespace Spartan
             const std::vector<RHI_Vertex_PosTexNorTan>& vertices,
             uint32_t* index_offset  = nullptr,
             uint32_t* vertex_offset = nullptr
-        ) const;
+        );
         void GetGeometry(
             uint32_t index_offset,
             uint32_t index_count,
@@ -67,6 +69,14 @@ namespace Spartan
         ) const;
         void UpdateGeometry();
         const auto& GetAabb() const { return m_aabb; }
+
+        // Imported models keep the GPU copy of their vertices quantized, if that's within the error bounds (see VertexQuantizer)
+        void SetVertexQuantization(const bool vertex_quantization)  { m_vertex_quantization = vertex_quantization; }
+        bool IsQuantized()                                    const { return m_vertices_quantized; }
+        const Math::Matrix& GetVertexDequantization()         const { return m_vertex_dequantization; } // goes in front of the world matrix
+
+        // The meshlets of the index range of a mesh, as [first, last), built from the appended geometry when it's updated
+        std::pair<const Meshlet*, const Meshlet*> GetMeshlets(uint32_t index_offset, uint32_t index_count) const;
         const auto& GetMesh() const { return m_mesh; }
 
 		// Add resources to the model
@@ -79,19 +89,30 @@ namespace Spartan
 		void SetAnimated(const bool is_animated)	      { m_is_animated = is_animated; }
 		const RHI_IndexBuffer* GetIndexBuffer()     const { return m_index_buffer.get(); }
 		const RHI_VertexBuffer* GetVertexBuffer()   const { return m_vertex_buffer.get(); }
+		const auto& GetIndexBuffer_PtrShared()      const { return m_index_buffer; }
+		const auto& GetVertexBuffer_PtrShared()     const { return m_vertex_buffer; }
 		auto GetSharedPtr()							      { return shared_from_this(); }
 
 	private:
 		// Geometry
-		bool GeometryCreateBuffers();
+		bool GeometryCreateBuffers(const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized = nullptr);
 		float GeometryComputeNormalizedScale() const;
 
+		// What the texture of a material slot gets block compressed to
+		static RHI_Texture_Compression GetTextureCompression(Material_Property texture_type);
+
 		// Misc
 		std::weak_ptr<Entity> m_root_entity;
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer;
 		std::shared_ptr<RHI_IndexBuffer> m_index_buffer;
 		std::shared_ptr<Mesh> m_mesh;
 		Math::BoundingBox m_aabb;
+		VertexQuantizer m_vertex_quantizer;
+		std::vector<Meshlet> m_meshlets; // sorted by index offset
+		std::vector<std::pair<uint32_t, uint32_t>> m_geometry_appended; // the index and vertex offset of every AppendGeometry()
+		Math::Matrix m_vertex_dequantization	= Math::Matrix::Identity;
+		bool m_vertex_quantization				= false;
+		bool m_vertices_quantized				= false;
 		float m_normalized_scale	= 1.0f;
 		bool m_is_animated			= false;
 
@@ -0,0 +1,375 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==============
+#include "Spartan.h"
+#include "OcclusionBuffer.h"
+#include "../RHI/RHI_Vertex.h"
+#include <xmmintrin.h>
+//=========================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    namespace
+    {
+        void load_rows(const Matrix& matrix, __m128 rows[4])
+        {
+            rows[0] = _mm_setr_ps(matrix.m00, matrix.m01, matrix.m02, matrix.m03);
+            rows[1] = _mm_setr_ps(matrix.m10, matrix.m11, matrix.m12, matrix.m13);
+            rows[2] = _mm_setr_ps(matrix.m20, matrix.m21, matrix.m22, matrix.m23);
+            rows[3] = _mm_setr_ps(matrix.m30, matrix.m31, matrix.m32, matrix.m33);
+        }
+
+        // A point (w = 1) times a matrix, as a row vector
+        __m128 transform_point(const float x, const float y, const float z, const __m128 rows[4])
+        {
+            __m128 result = _mm_mul_ps(_mm_set1_ps(x), rows[0]);
+            result        = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(y), rows[1]));
+            result        = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(z), rows[2]));
+            return _mm_add_ps(result, rows[3]);
+        }
+
+        // Signed distance from the near plane in clip space, positive in front of it
+        float near_plane_distance(const Vector4& clip, const bool reverse_z)
+        {
+            return reverse_z ? clip.w - clip.z : clip.z;
+        }
+    }
+
+    void OcclusionBuffer::Clear(const uint32_t width, const uint32_t height, const bool reverse_z)
+    {
+        m_width     = (width + 3) & ~3u;
+        m_height    = height;
+        m_reverse_z = reverse_z;
+        m_depth.assign(m_width * m_height, 0.0f);
+    }
+
+    void OcclusionBuffer::RasterizeOccluder(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count, const uint32_t* indices, const uint32_t index_count, const Matrix& world_view_projection)
+    {
+        if (m_depth.empty())
+            return;
+
+        // Transform to clip space
+        __m128 rows[4];
+        load_rows(world_view_projection, rows);
+        m_clip.resize(vertex_count);
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            const float* position = vertices[i].pos;
+            _mm_storeu_ps(&m_clip[i].x, transform_point(position[0], position[1], position[2], rows));
+        }
+
+        // Project to the screen, triangles which cross the near plane are clipped (into one or two triangles)
+        m_triangles.clear();
+        const float width   = static_cast<float>(m_width);
+        const float height  = static_cast<float>(m_height);
+        auto emit_vertex = [this, width, height](const Vector4& clip)
+        {
+            const float w_inverse   = 1.0f / clip.w;
+            const float z           = clip.z * w_inverse;
+            m_triangles.emplace_back((clip.x * w_inverse * 0.5f + 0.5f) * width);
+            m_triangles.emplace_back((0.5f - clip.y * w_inverse * 0.5f) * height);
+            m_triangles.emplace_back(m_reverse_z ? z : 1.0f - z);
+        };
+
+        for (uint32_t i = 0; i + 2 < index_count; i += 3)
+        {
+            const Vector4* triangle[3]  = { &m_clip[indices[i]], &m_clip[indices[i + 1]], &m_clip[indices[i + 2]] };
+            const float distance[3]     = { near_plane_distance(*triangle[0], m_reverse_z), near_plane_distance(*triangle[1], m_reverse_z), near_plane_distance(*triangle[2], m_reverse_z) };
+            const uint32_t inside_count = (distance[0] >= 0.0f) + (distance[1] >= 0.0f) + (distance[2] >= 0.0f);
+
+            if (inside_count == 0)
+                continue;
+
+            if (inside_count == 3)
+            {
+                emit_vertex(*triangle[0]);
+                emit_vertex(*triangle[1]);
+                emit_vertex(*triangle[2]);
+                continue;
+            }
+
+            Vector4 polygon[4];
+            uint32_t polygon_count = 0;
+            for (uint32_t a = 0; a < 3; a++)
+            {
+                const uint32_t b = (a + 1) % 3;
+
+                if (distance[a] >= 0.0f)
+                {
+                    polygon[polygon_count++] = *triangle[a];
+                }
+
+                // Always interpolate from the inside vertex, so that an edge which is shared with another triangle is clipped at exactly the same point
+                if ((distance[a] >= 0.0f) != (distance[b] >= 0.0f))
+                {
+                    const uint32_t in       = distance[a] >= 0.0f ? a : b;
+                    const uint32_t out      = distance[a] >= 0.0f ? b : a;
+                    const float t           = distance[in] / (distance[in] - distance[out]);
+                    polygon[polygon_count++] = Vector4
+                    (
+                        triangle[in]->x + (triangle[out]->x - triangle[in]->x) * t,
+                        triangle[in]->y + (triangle[out]->y - triangle[in]->y) * t,
+                        triangle[in]->z + (triangle[out]->z - triangle[in]->z) * t,
+                        triangle[in]->w + (triangle[out]->w - triangle[in]->w) * t
+                    );
+                }
+            }
+
+            emit_vertex(polygon[0]);
+            emit_vertex(polygon[1]);
+            emit_vertex(polygon[2]);
+
+            if (polygon_count == 4)
+            {
+                emit_vertex(polygon[0]);
+                emit_vertex(polygon[2]);
+                emit_vertex(polygon[3]);
+            }
+        }
+
+        RasterizeTriangles();
+    }
+
+    void OcclusionBuffer::RasterizeTriangles()
+    {
+        const uint32_t triangle_count   = static_cast<uint32_t>(m_triangles.size() / 9);
+        const __m128 zero               = _mm_setzero_ps();
+        const __m128 pixel_centers      = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const int32_t pixel_max_x       = static_cast<int32_t>(m_width) - 1;
+        const int32_t pixel_max_y       = static_cast<int32_t>(m_height) - 1;
+
+        for (uint32_t t = 0; t < triangle_count; t += 4)
+        {
+            const uint32_t lane_count = Helper::Min(4u, triangle_count - t);
+
+            // Gather 4 triangles as a structure of arrays
+            alignas(16) float soa[9][4] = {};
+            for (uint32_t lane = 0; lane < lane_count; lane++)
+            {
+                const float* triangle = &m_triangles[(t + lane) * 9];
+                for (uint32_t k = 0; k < 9; k++)
+                {
+                    soa[k][lane] = triangle[k];
+                }
+            }
+
+            const __m128 x0 = _mm_load_ps(soa[0]), y0 = _mm_load_ps(soa[1]), n0 = _mm_load_ps(soa[2]);
+            const __m128 x1 = _mm_load_ps(soa[3]), y1 = _mm_load_ps(soa[4]), n1 = _mm_load_ps(soa[5]);
+            const __m128 x2 = _mm_load_ps(soa[6]), y2 = _mm_load_ps(soa[7]), n2 = _mm_load_ps(soa[8]);
+
+            // Twice the signed area
+            const __m128 e10_x  = _mm_sub_ps(x1, x0);
+            const __m128 e10_y  = _mm_sub_ps(y1, y0);
+            const __m128 e20_x  = _mm_sub_ps(x2, x0);
+            const __m128 e20_y  = _mm_sub_ps(y2, y0);
+            const __m128 area   = _mm_sub_ps(_mm_mul_ps(e10_x, e20_y), _mm_mul_ps(e20_x, e10_y));
+
+            // Nearness as a plane, n = dndx * x + dndy * y + dnc
+            const __m128 area_inverse   = _mm_div_ps(_mm_set1_ps(1.0f), area);
+            const __m128 dn10           = _mm_sub_ps(n1, n0);
+            const __m128 dn20           = _mm_sub_ps(n2, n0);
+            const __m128 dndx           = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dn10, e20_y), _mm_mul_ps(dn20, e10_y)), area_inverse);
+            const __m128 dndy           = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dn20, e10_x), _mm_mul_ps(dn10, e20_x)), area_inverse);
+            const __m128 dnc            = _mm_sub_ps(_mm_sub_ps(n0, _mm_mul_ps(dndx, x0)), _mm_mul_ps(dndy, y0));
+
+            // Edge functions, e = a * x + b * y + c, which are positive inside of the triangle. Each edge is set up from its
+            // vertices in a fixed order (so a shared edge has exactly the negated function in both triangles, without cracks),
+            // and the sign is flipped as needed, for the edge's direction and for clockwise triangles (both windings are rasterized).
+            const __m128 sign_bit       = _mm_set1_ps(-0.0f);
+            const __m128 clockwise      = _mm_and_ps(_mm_cmplt_ps(area, zero), sign_bit);
+            const __m128 vertex_x[3]    = { x0, x1, x2 };
+            const __m128 vertex_y[3]    = { y0, y1, y2 };
+            alignas(16) float edge[3][3][4];
+            for (uint32_t e = 0; e < 3; e++)
+            {
+                const uint32_t b    = (e + 1) % 3;
+                const __m128 swap   = _mm_or_ps(_mm_cmpgt_ps(vertex_x[e], vertex_x[b]), _mm_and_ps(_mm_cmpeq_ps(vertex_x[e], vertex_x[b]), _mm_cmpgt_ps(vertex_y[e], vertex_y[b])));
+                const __m128 p_x    = _mm_or_ps(_mm_and_ps(swap, vertex_x[b]), _mm_andnot_ps(swap, vertex_x[e]));
+                const __m128 p_y    = _mm_or_ps(_mm_and_ps(swap, vertex_y[b]), _mm_andnot_ps(swap, vertex_y[e]));
+                const __m128 q_x    = _mm_or_ps(_mm_and_ps(swap, vertex_x[e]), _mm_andnot_ps(swap, vertex_x[b]));
+                const __m128 q_y    = _mm_or_ps(_mm_and_ps(swap, vertex_y[e]), _mm_andnot_ps(swap, vertex_y[b]));
+                const __m128 sign   = _mm_xor_ps(clockwise, _mm_and_ps(swap, sign_bit));
+                const __m128 a_     = _mm_sub_ps(p_y, q_y);
+                const __m128 b_     = _mm_sub_ps(q_x, p_x);
+                const __m128 c_     = _mm_sub_ps(zero, _mm_add_ps(_mm_mul_ps(a_, p_x), _mm_mul_ps(b_, p_y)));
+                _mm_store_ps(edge[e][0], _mm_xor_ps(a_, sign));
+                _mm_store_ps(edge[e][1], _mm_xor_ps(b_, sign));
+                _mm_store_ps(edge[e][2], _mm_xor_ps(c_, sign));
+            }
+
+            // Bounds
+            alignas(16) float bounds[4][4];
+            _mm_store_ps(bounds[0], _mm_min_ps(x0, _mm_min_ps(x1, x2)));
+            _mm_store_ps(bounds[1], _mm_max_ps(x0, _mm_max_ps(x1, x2)));
+            _mm_store_ps(bounds[2], _mm_min_ps(y0, _mm_min_ps(y1, y2)));
+            _mm_store_ps(bounds[3], _mm_max_ps(y0, _mm_max_ps(y1, y2)));
+
+            alignas(16) float plane[3][4];
+            alignas(16) float areas[4];
+            _mm_store_ps(plane[0], dndx);
+            _mm_store_ps(plane[1], dndy);
+            _mm_store_ps(plane[2], dnc);
+            _mm_store_ps(areas, area);
+
+            // Rasterize, 4 pixels at a time
+            for (uint32_t lane = 0; lane < lane_count; lane++)
+            {
+                // Skip degenerate triangles
+                if (!(Helper::Abs(areas[lane]) > Helper::M_EPSILON))
+                    continue;
+
+                const int32_t x_min = Helper::Max(0, static_cast<int32_t>(Helper::Floor(bounds[0][lane]))) & ~3;
+                const int32_t x_max = Helper::Min(pixel_max_x, static_cast<int32_t>(Helper::Floor(bounds[1][lane])));
+                const int32_t y_min = Helper::Max(0, static_cast<int32_t>(Helper::Floor(bounds[2][lane])));
+                const int32_t y_max = Helper::Min(pixel_max_y, static_cast<int32_t>(Helper::Floor(bounds[3][lane])));
+
+                const __m128 a0 = _mm_set1_ps(edge[0][0][lane]), a1 = _mm_set1_ps(edge[1][0][lane]), a2 = _mm_set1_ps(edge[2][0][lane]);
+                const __m128 dx = _mm_set1_ps(plane[0][lane]);
+
+                for (int32_t y = y_min; y <= y_max; y++)
+                {
+                    const float center_y    = static_cast<float>(y) + 0.5f;
+                    const __m128 row_e0     = _mm_set1_ps(edge[0][1][lane] * center_y + edge[0][2][lane]);
+                    const __m128 row_e1     = _mm_set1_ps(edge[1][1][lane] * center_y + edge[1][2][lane]);
+                    const __m128 row_e2     = _mm_set1_ps(edge[2][1][lane] * center_y + edge[2][2][lane]);
+                    const __m128 row_n      = _mm_set1_ps(plane[1][lane] * center_y + plane[2][lane]);
+                    float* row              = &m_depth[y * m_width];
+
+                    for (int32_t x = x_min; x <= x_max; x += 4)
+                    {
+                        const __m128 center_x   = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixel_centers);
+                        __m128 inside           = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, center_x), row_e0), zero);
+                        inside                  = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, center_x), row_e1), zero));
+                        inside                  = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, center_x), row_e2), zero));
+                        if (_mm_movemask_ps(inside) == 0)
+                            continue;
+
+                        // Keep the nearest
+                        const __m128 nearness   = _mm_add_ps(_mm_mul_ps(dx, center_x), row_n);
+                        const __m128 previous   = _mm_loadu_ps(row + x);
+                        const __m128 nearest    = _mm_max_ps(previous, nearness);
+                        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+                    }
+                }
+            }
+        }
+    }
+
+    OcclusionBuffer::ScreenRect OcclusionBuffer::ProjectBox(const BoundingBox& box, const Matrix& view_projection) const
+    {
+        ScreenRect rect     = { FLT_MAX, -FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, false };
+        const Vector3& min  = box.GetMin();
+        const Vector3& max  = box.GetMax();
+
+        __m128 rows[4];
+        load_rows(view_projection, rows);
+
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            Vector4 clip;
+            _mm_storeu_ps(&clip.x, transform_point((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, rows));
+
+            if (near_plane_distance(clip, m_reverse_z) < 0.0f || clip.w <= 0.0f)
+            {
+                rect.crosses_near_plane = true;
+                return rect;
+            }
+
+            const float w_inverse   = 1.0f / clip.w;
+            const float x           = (clip.x * w_inverse * 0.5f + 0.5f) * static_cast<float>(m_width);
+            const float y           = (0.5f - clip.y * w_inverse * 0.5f) * static_cast<float>(m_height);
+            const float z           = clip.z * w_inverse;
+            rect.x_min              = Helper::Min(rect.x_min, x);
+            rect.x_max              = Helper::Max(rect.x_max, x);
+            rect.y_min              = Helper::Min(rect.y_min, y);
+            rect.y_max              = Helper::Max(rect.y_max, y);
+            rect.nearness           = Helper::Max(rect.nearness, m_reverse_z ? z : 1.0f - z);
+        }
+
+        return rect;
+    }
+
+    bool OcclusionBuffer::IsVisible(const BoundingBox& box, const Matrix& view_projection) const
+    {
+        if (m_depth.empty())
+            return true;
+
+        const ScreenRect rect = ProjectBox(box, view_projection);
+        if (rect.crosses_near_plane)
+            return true;
+
+        // The pixels which the box's screen rectangle touches
+        const int32_t x_min = Helper::Max(0, static_cast<int32_t>(Helper::Floor(rect.x_min)));
+        const int32_t x_max = Helper::Min(static_cast<int32_t>(m_width) - 1, static_cast<int32_t>(Helper::Floor(rect.x_max)));
+        const int32_t y_min = Helper::Max(0, static_cast<int32_t>(Helper::Floor(rect.y_min)));
+        const int32_t y_max = Helper::Min(static_cast<int32_t>(m_height) - 1, static_cast<int32_t>(Helper::Floor(rect.y_max)));
+
+        // Off-screen, that's for frustum culling to decide
+        if (x_min > x_max || y_min > y_max)
+            return true;
+
+        const __m128 box_nearness   = _mm_set1_ps(rect.nearness);
+        const __m128 column_min     = _mm_set1_ps(static_cast<float>(x_min));
+        const __m128 column_max     = _mm_set1_ps(static_cast<float>(x_max));
+        const __m128 column_offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+        for (int32_t y = y_min; y <= y_max; y++)
+        {
+            const float* row = &m_depth[y * m_width];
+
+            for (int32_t x = x_min & ~3; x <= x_max; x += 4)
+            {
+                const __m128 column     = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), column_offsets);
+                const __m128 in_rect    = _mm_and_ps(_mm_cmpge_ps(column, column_min), _mm_cmple_ps(column, column_max));
+
+                // Visible if the occluders are not nearer than the box's nearest point in any of the pixels
+                const __m128 visible = _mm_and_ps(in_rect, _mm_cmple_ps(_mm_loadu_ps(row + x), box_nearness));
+                if (_mm_movemask_ps(visible) != 0)
+                    return true;
+            }
+        }
+
+        return false;
+    }
+
+    float OcclusionBuffer::GetScreenCoverage(const BoundingBox& box, const Matrix& view_projection) const
+    {
+        if (m_depth.empty())
+            return 0.0f;
+
+        const ScreenRect rect = ProjectBox(box, view_projection);
+        if (rect.crosses_near_plane)
+            return 1.0f;
+
+        const float width   = static_cast<float>(m_width);
+        const float height  = static_cast<float>(m_height);
+        const float x       = Helper::Clamp(rect.x_max, 0.0f, width) - Helper::Clamp(rect.x_min, 0.0f, width);
+        const float y       = Helper::Clamp(rect.y_max, 0.0f, height) - Helper::Clamp(rect.y_min, 0.0f, height);
+
+        return (x * y) / (width * height);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../Math/Vector4.h"
+#include "../Math/Matrix.h"
+#include "../Math/BoundingBox.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    struct RHI_Vertex_PosTexNorTan;
+
+    // A low resolution depth buffer which is rasterized on the CPU from a few large occluders, so that renderables
+    // which are hidden behind them can be rejected before any draw is recorded. It doesn't depend on the RHI.
+    // Depth is stored as nearness (1 at the near plane, 0 at the far plane) regardless of the projection being reverse-z or not.
+    class SPARTAN_CLASS OcclusionBuffer
+    {
+    public:
+        OcclusionBuffer() = default;
+        ~OcclusionBuffer() = default;
+
+        // Resizes (the width is rounded up to a multiple of 4) and clears to the far plane
+        void Clear(uint32_t width, uint32_t height, bool reverse_z);
+
+        // Rasterizes the triangles of an occluder, the indices are relative to vertices
+        void RasterizeOccluder(const RHI_Vertex_PosTexNorTan* vertices, uint32_t vertex_count, const uint32_t* indices, uint32_t index_count, const Math::Matrix& world_view_projection);
+
+        // Returns false if the box is entirely behind what has been rasterized, conservatively
+        bool IsVisible(const Math::BoundingBox& box, const Math::Matrix& view_projection) const;
+
+        // Returns the fraction of the buffer covered by the screen rectangle of a box, 1 if the box crosses the near plane
+        float GetScreenCoverage(const Math::BoundingBox& box, const Math::Matrix& view_projection) const;
+
+        uint32_t GetWidth()     const { return m_width; }
+        uint32_t GetHeight()    const { return m_height; }
+        const float* GetData()  const { return m_depth.data(); }
+
+    private:
+        struct ScreenRect
+        {
+            float x_min;
+            float x_max;
+            float y_min;
+            float y_max;
+            float nearness; // of the nearest corner
+            bool crosses_near_plane;
+        };
+
+        ScreenRect ProjectBox(const Math::BoundingBox& box, const Math::Matrix& view_projection) const;
+        void RasterizeTriangles();
+
+        std::vector<float> m_depth;
+        std::vector<Math::Vector4> m_clip;  // scratch, the occluder's vertices in clip space
+        std::vector<float> m_triangles;     // scratch, screen space triangles (x, y, nearness for each vertex) after near plane clipping
+        uint32_t m_width    = 0;
+        uint32_t m_height   = 0;
+        bool m_reverse_z    = false;
+    };
+}
@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Spartan.h"
 #include "Renderer.h"
 #include "Model.h"
+#include "Mesh.h"
+#include "OcclusionBuffer.h"
 #include "ShaderGBuffer.h"
 #include "Font/Font.h"
 #include "Gizmos/Grid.h"
@@ -30,6 +32,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../Utilities/Sampling.h"
 #include "../Profiling/Profiler.h"
 #include "../Resource/ResourceCache.h"
+#include "../Threading/Threading.h"
+#include "../World/World.h"
 #include "../World/Entity.h"
 #include "../World/Components/Transform.h"
 #include "../World/Components/Renderable.h"
@@ -55,6 +59,9 @@ namespace Spartan
 {
     Renderer::Renderer(Context* context) : ISubsystem(context)
     {
+        // Captures the world for the render thread and updates the transform gizmo (which moves entities), on the main thread
+        SetTickDependencies(Tick_Dependency_Entities | Tick_Dependency_Time | Tick_Dependency_Profiling, Tick_Dependency_Entities | Tick_Dependency_Rendering | Tick_Dependency_Rhi, true);
+
         // Options
         m_options |= Render_ReverseZ;
         m_options |= Render_Debug_Transform;
@@ -72,6 +79,8 @@ namespace Spartan
         m_options |= Render_Sharpening_LumaSharpen;
         m_options |= Render_FilmGrain;
         m_options |= Render_ChromaticAberration;
+        m_options |= Render_OcclusionCulling;
+        m_options |= Render_ClusterCulling;
 
         // Option values
         m_option_values[Option_Value_Anisotropy]        = 16.0f;
@@ -80,6 +89,7 @@ namespace Spartan
         m_option_values[Option_Value_Gamma]             = 2.2f;
         m_option_values[Option_Value_Sharpen_Strength]  = 1.0f;
         m_option_values[Option_Value_Bloom_Intensity]   = 0.2f;
+        m_option_values[Option_Value_TextureStreamingBudget] = 1024.0f;
 
 		// Subscribe to events
 		SUBSCRIBE_TO_EVENT(EventType::WorldResolved,    EVENT_HANDLER_VARIANT(RenderablesAcquire));
@@ -88,12 +98,35 @@ namespace Spartan
 
 	Renderer::~Renderer()
 	{
+        // Stop the render thread
+        RenderWait();
+        {
+            lock_guard<mutex> lock(m_render_mutex);
+            m_render_stopping = true;
+        }
+        m_render_condition.notify_all();
+        if (m_render_thread.joinable())
+        {
+            m_render_thread.join();
+        }
+
 		// Unsubscribe from events
 		UNSUBSCRIBE_FROM_EVENT(EventType::WorldResolved, EVENT_HANDLER_VARIANT(RenderablesAcquire));
 
-		m_entities.clear();
+        m_frames[0].Clear();
+        m_frames[1].Clear();
+		ClearEntities();
+        m_entities_retired.clear();
+        m_entity_states_retired.clear();
 		m_camera = nullptr;
 
+        // The textures which streaming retired have to go before the device
+        if (m_rhi_device)
+        {
+            m_rhi_device->Queue_WaitAll();
+        }
+        m_texture_store.Clear();
+
 		// Log to file as the renderer is no more
 		LOG_TO_FILE(true);
 	}
@@ -103,6 +136,8 @@ namespace Spartan
         // Get required systems		
         m_resource_cache    = m_context->GetSubsystem<ResourceCache>();
         m_profiler          = m_context->GetSubsystem<Profiler>();
+        m_threading         = m_context->GetSubsystem<Threading>();
+        m_texture_store.SetThreading(m_threading);
 
         // Resolution, viewport and swapchain default to whatever the window size is
         const WindowData& window_data = m_context->m_engine->GetWindowData();
@@ -147,6 +182,9 @@ namespace Spartan
                 LOG_ERROR("Failed to create swap chain");
                 return false;
             }
+
+            // Every buffer has its own command list, so that's how many frames the GPU can be behind
+            m_texture_store.SetFramesInFlight(m_swap_chain->GetBufferCount());
         }
 
         // Full-screen quad
@@ -166,10 +204,14 @@ namespace Spartan
 		CreateRasterizerStates();
 		CreateBlendStates();
 		CreateRenderTextures();
+        CreateShadowAtlas();
 		CreateFonts();	
 		CreateSamplers();
 		CreateTextures();
 
+        // Start the render thread
+        m_render_thread = thread(&Renderer::RenderThreadLoop, this);
+
 		if (!m_initialized)
 		{
 			// Log on-screen as the renderer is ready
@@ -190,77 +232,1074 @@ namespace Spartan
 		if (!m_rhi_device || !m_rhi_device->IsInitialized())
 			return;
 
-        // Don't do any work if the swapchain is not presenting
-        if (m_swap_chain && !m_swap_chain->IsPresenting())
+        // Capture the world, the render thread might still be recording the previous capture
+        FrameSnapshot& frame    = m_frames[m_frame_index_capture];
+        const bool captured     = FrameCapture(frame);
+
+        // Whoever presents is about to use the command list, so the render thread has to be done with it
+        RenderWait();
+
+        if (!captured)
+            return;
+
+        // The transform gizmo moves the selected entity and its handles are read while recording, so it can only update now
+        frame.gizmo_transform_visible = GetOption(Render_Debug_Transform) && m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed);
+
+        // Hand the capture over to the render thread, it will record it while the next frame simulates
+        swap(m_frame_index_capture, m_frame_index_render);
+        m_frame_captured = true;
+	}
+
+    void Renderer::Render()
+    {
+        if (!m_frame_captured)
             return;
 
-		// If there is no camera, clear
-		if (!m_camera)
+        m_frame_captured = false;
+
+        {
+            lock_guard<mutex> lock(m_render_mutex);
+            m_render_requested = true;
+        }
+
+        m_render_condition.notify_all();
+    }
+
+    void Renderer::RenderWait()
+    {
+        unique_lock<mutex> lock(m_render_mutex);
+        m_render_condition.wait(lock, [this] { return !m_render_requested; });
+    }
+
+    void Renderer::RenderThreadLoop()
+    {
+        while (true)
+        {
+            {
+                unique_lock<mutex> lock(m_render_mutex);
+                m_render_condition.wait(lock, [this] { return m_render_requested || m_render_stopping; });
+
+                if (m_render_stopping)
+                    return;
+            }
+
+            RenderFrame(m_swap_chain->GetCmdList());
+
+            {
+                lock_guard<mutex> lock(m_render_mutex);
+                m_render_requested = false;
+            }
+
+            m_render_condition.notify_all();
+        }
+    }
+
+    void Renderer::RenderFrame(RHI_CommandList* cmd_list)
+    {
+        const FrameCamera& camera = m_frames[m_frame_index_render].camera;
+
+        // Reset dynamic buffer indices when the swapchain resets to first buffer/command list
+        if (m_swap_chain->GetCmdIndex() == 0)
+        {
+            m_buffer_uber_offset_index      = 0;
+            m_buffer_object_offset_index    = 0;
+            m_buffer_instances_offset_index = 0;
+        }
+
+		// Get camera matrices
 		{
-            //cmd_list->Clear(m_render_targets[RenderTarget_Composition_Ldr].get(), Vector4(0.0f, 0.0f, 0.0f, 1.0f));
-			return;
+            if (m_update_ortho_proj || m_near_plane != camera.near_plane || m_far_plane != camera.far_plane)
+            {
+                m_buffer_frame_cpu.projection_ortho         = Matrix::CreateOrthographicLH(m_viewport.width, m_viewport.height, m_near_plane, m_far_plane);
+                m_buffer_frame_cpu.view_projection_ortho    = Matrix::CreateLookAtLH(Vector3(0, 0, -m_near_plane), Vector3::Forward, Vector3::Up) * m_buffer_frame_cpu.projection_ortho;
+                m_update_ortho_proj                         = false;
+            }
+
+            m_near_plane	                = camera.near_plane;
+            m_far_plane		                = camera.far_plane;
+            m_buffer_frame_cpu.view		    = camera.view;
+            m_buffer_frame_cpu.projection   = camera.projection;
+
+			// TAA - Generate jitter
+			if (GetOption(Render_AntiAliasing_Taa))
+			{
+				m_taa_jitter_previous = m_taa_jitter;
+
+                const float scale               = 1.0f;
+				const uint64_t samples	        = 16;
+				const uint64_t index	        = m_frame_num % samples;
+				m_taa_jitter			        = (Utility::Sampling::Halton2D(index, 2, 3) * 2.0f - 1.0f);
+				m_taa_jitter.x			        = (m_taa_jitter.x / m_resolution.x) * scale;
+				m_taa_jitter.y			        = (m_taa_jitter.y / m_resolution.y) * scale;
+                m_buffer_frame_cpu.projection   *= Matrix::CreateTranslation(Vector3(m_taa_jitter.x, m_taa_jitter.y, 0.0f));
+			}
+			else
+			{
+				m_taa_jitter			= Vector2::Zero;
+				m_taa_jitter_previous   = Vector2::Zero;		
+			}
+
+            // Compute some TAA affected matrices
+            m_buffer_frame_cpu.view_projection              = m_buffer_frame_cpu.view * m_buffer_frame_cpu.projection;
+            m_buffer_frame_cpu.view_projection_inv          = Matrix::Invert(m_buffer_frame_cpu.view_projection);   
+            m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * camera.projection;
 		}
 
-		// If there are no entities, clear to the camera's clear color
-		if (m_entities.empty())
-		{
-            //cmd_list->Clear(m_render_targets[RenderTarget_Composition_Ldr].get(), m_camera->GetClearColor());
-			return;
-		}
+        m_is_rendering = true;
+        Pass_Main(cmd_list);
+        m_is_rendering = false;
+
+        m_frame_num++;
+        m_is_odd_frame = (m_frame_num % 2) == 1;
+    }
+
+    bool Renderer::FrameCapture(FrameSnapshot& frame)
+    {
+        // The render thread recorded this capture two frames ago, so it's safe to release
+        frame.Clear();
+
+        // Don't do any work if the swapchain is not presenting
+        if (m_swap_chain && !m_swap_chain->IsPresenting())
+            return false;
+
+        lock_guard<mutex> lock(m_entities_mutex);
+
+        // The frames captured before this one can still reference the entities which were erased since
+        frame.entities_retired.swap(m_entities_retired);
+        frame.entity_states_retired.swap(m_entity_states_retired);
+
+        // If there is no camera or entities, there is nothing to render
+        if (!m_camera || m_entity_proxies.empty())
+            return false;
+
+        SCOPED_TIME_BLOCK(m_profiler);
+
+        // Time
+        Timer* timer        = m_context->GetSubsystem<Timer>();
+        frame.delta_time    = static_cast<float>(timer->GetDeltaTimeSmoothedSec());
+        frame.time          = static_cast<float>(timer->GetTimeSec());
+
+        // Camera
+        {
+            Transform* transform        = m_camera->GetTransform();
+            frame.camera.camera         = m_camera;
+            frame.camera.view           = m_camera->GetViewMatrix();
+            frame.camera.projection     = m_camera->GetProjectionMatrix();
+            frame.camera.frustum        = m_camera->GetFrustum();
+            frame.camera.position       = transform->GetPosition();
+            frame.camera.forward        = transform->GetForward();
+            frame.camera.near_plane     = m_camera->GetNearPlane();
+            frame.camera.far_plane      = m_camera->GetFarPlane();
+            frame.camera.aperture       = m_camera->GetAperture();
+            frame.camera.shutter_speed  = m_camera->GetShutterSpeed();
+            frame.camera.iso            = m_camera->GetIso();
+            frame.camera.exposure       = m_camera->GetExposure();
+        }
+
+        // Materials, captured once however many renderables share them. There can't be more than one
+        // per renderable (and the outline), so reserving that many keeps the renderables' pointers valid.
+        m_frame_materials.clear();
+        frame.materials.reserve(m_entities[Renderer_Object_Opaque].size() + m_entities[Renderer_Object_Transparent].size() + 1);
+        const auto capture_material = [this, &frame](Material* material) -> const FrameMaterial*
+        {
+            if (!material)
+                return nullptr;
+
+            const auto [it, inserted] = m_frame_materials.try_emplace(material->GetId(), static_cast<uint32_t>(frame.materials.size()));
+            if (!inserted)
+                return &frame.materials[it->second];
+
+            FrameMaterial& frame_material   = frame.materials.emplace_back();
+            frame_material.id               = material->GetId();
+            frame_material.version          = material->GetVersion();
+            frame_material.flags            = material->GetFlags();
+            frame_material.color            = material->GetColorAlbedo();
+            frame_material.tiling           = material->GetTiling();
+            frame_material.offset           = material->GetOffset();
+            for (uint32_t i = 0; i < m_material_property_count; i++)
+            {
+                const Material_Property type    = static_cast<Material_Property>(1 << i);
+                frame_material.properties[i]    = material->GetProperty(type);
+                frame_material.textures[i]      = material->GetTexture_PtrShared(type);
+            }
+
+            return &frame_material;
+        };
+
+        // Geometry, the GPU buffers are captured since they are bound long after the model could have re-created them
+        const auto capture_model = [](FrameRenderable& frame_renderable, shared_ptr<const Model> model)
+        {
+            frame_renderable.matrix_vertex  = model ? model->GetVertexDequantization() * frame_renderable.matrix : frame_renderable.matrix;
+            if (model)
+            {
+                frame_renderable.vertex_buffer  = model->GetVertexBuffer_PtrShared();
+                frame_renderable.index_buffer   = model->GetIndexBuffer_PtrShared();
+                frame_renderable.geometry_id    = model->GetId();
+                frame_renderable.quantized      = model->IsQuantized();
+            }
+            frame_renderable.model = move(model);
+        };
+
+        // Renderables
+        m_frame_captures++;
+        vector<Entity*> renderables_switched; // materials which became transparent, or opaque, since the entities were classified
+        for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            vector<FrameRenderable>& renderables = frame.renderables[object_type];
+
+            for (Entity* entity : m_entities[object_type])
+            {
+                Renderable* renderable = entity->GetRenderable();
+                if (!renderable)
+                    continue;
+
+                const Material* material = renderable->GetMaterial();
+                if ((material && material->GetColorAlbedo().w < 1.0f) != (object_type == Renderer_Object_Transparent))
+                {
+                    renderables_switched.emplace_back(entity);
+                }
+
+                EntityProxy& proxy                  = m_entity_proxies[entity];
+                proxy.frame_capture                 = m_frame_captures;
+                proxy.frame_object_type             = object_type;
+                proxy.frame_index                   = static_cast<uint32_t>(renderables.size());
+
+                FrameRenderable& frame_renderable   = renderables.emplace_back();
+                frame_renderable.entity             = entity;
+                frame_renderable.state              = proxy.state.get();
+                frame_renderable.material           = capture_material(renderable->GetMaterial());
+                frame_renderable.matrix             = entity->GetTransform()->GetMatrix();
+                capture_model(frame_renderable, renderable->GeometryModel_PtrShared());
+                frame_renderable.aabb               = renderable->GetAabb();
+                frame_renderable.index_offset       = renderable->GeometryIndexOffset();
+                frame_renderable.index_count        = renderable->GeometryIndexCount();
+                frame_renderable.vertex_offset      = renderable->GeometryVertexOffset();
+                frame_renderable.vertex_count       = renderable->GeometryVertexCount();
+                frame_renderable.cast_shadows       = renderable->GetCastShadows();
+                frame_renderable.occluder           = object_type == Renderer_Object_Opaque && frame_renderable.model && frame_renderable.material && !frame_renderable.material->HasTexture(Material_Mask) && frame_renderable.index_count / 3 <= m_occluder_triangles_max;
+            }
+        }
+
+        // They are drawn as they were classified for this frame, and move for the next one
+        if (!renderables_switched.empty())
+        {
+            for (Entity* entity : renderables_switched)
+            {
+                const bool to_transparent = m_entity_proxies[entity].index[Renderer_Object_Opaque] != m_entity_index_none;
+                EntityProxyErase(entity, to_transparent ? Renderer_Object_Opaque : Renderer_Object_Transparent);
+                EntityProxyInsert(entity, to_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque);
+            }
+
+            RenderablesSort(Renderer_Object_Opaque);
+            RenderablesSort(Renderer_Object_Transparent);
+        }
+
+        // Lights, straight from the world's pool. The shadow maps are re-created here, after the shadow resolution changed.
+        const bool shadow_maps_dirty = m_shadow_maps_dirty.exchange(false);
+        m_context->GetSubsystem<World>()->ComponentForEach<Light, Transform>([this, &frame, shadow_maps_dirty](Light* light, Transform* transform)
+        {
+            Entity* entity = light->GetEntity();
+            if (!entity->IsActive() || entity->IsPendingDestruction())
+                return;
+
+            if (shadow_maps_dirty && light->GetShadowsEnabled())
+            {
+                light->CreateShadowMap();
+            }
+
+            FrameLight& frame_light         = frame.lights.emplace_back();
+            frame_light.entity              = entity;
+            frame_light.id                  = light->GetId();
+            frame_light.type                = light->GetLightType();
+            frame_light.shadow_map          = light->GetShadowMap();
+            frame_light.shadow_array_size   = Helper::Min(light->GetShadowArraySize(), static_cast<uint32_t>(frame_light.shadow_map.slices.size()));
+            frame_light.shadow_array_size   = Helper::Min(frame_light.shadow_array_size, static_cast<uint32_t>(frame_light.view_projection.size()));
+            frame_light.position            = transform->GetPosition();
+            frame_light.direction           = light->GetDirection();
+            frame_light.forward             = transform->GetForward();
+            frame_light.color               = light->GetColor();
+            frame_light.intensity           = light->GetIntensity();
+            frame_light.range               = light->GetRange();
+            frame_light.angle               = light->GetAngle();
+            frame_light.bias                = light->GetBias();
+            frame_light.normal_bias         = light->GetNormalBias();
+            frame_light.shadows_enabled                 = light->GetShadowsEnabled();
+            frame_light.shadows_transparent_enabled     = light->GetShadowsTransparentEnabled();
+            frame_light.shadows_screen_space_enabled    = light->GetShadowsScreenSpaceEnabled();
+            frame_light.volumetric_enabled              = light->GetVolumetricEnabled();
+
+            for (uint32_t i = 0; i < frame_light.shadow_array_size; i++)
+            {
+                frame_light.view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+            }
+
+            // Icon
+            if (GetOption(Render_Debug_Lights))
+            {
+                const Vector3 direction_camera_to_light = (frame_light.position - frame.camera.position).Normalized();
+                frame_light.icon_visible                = Vector3::Dot(frame.camera.forward, direction_camera_to_light) > 0.5f;
+                frame_light.position_screen             = m_camera->Project(frame_light.position);
+            }
+        });
+
+        // What every view can see, while the world's spatial index matches the renderables
+        FrameCaptureViews(frame);
+
+        // Debug
+        {
+            // Picking ray
+            if (GetOption(Render_Debug_PickingRay))
+            {
+                const auto& ray = m_camera->GetPickingRay();
+                DrawLine(ray.GetStart(), ray.GetStart() + ray.GetDirection() * m_camera->GetFarPlane(), Vector4(0, 1, 0, 1));
+            }
+
+            // Lights
+            if (GetOption(Render_Debug_Lights))
+            {
+                for (const FrameLight& frame_light : frame.lights)
+                {
+                    if (frame_light.type == LightType::Spot)
+                    {
+                        DrawLine(frame_light.position, frame_light.position + frame_light.forward * frame_light.range, Vector4(0, 1, 0, 1));
+                    }
+                }
+            }
+
+            // AABBs
+            if (GetOption(Render_Debug_Aabb))
+            {
+                for (const vector<FrameRenderable>& renderables : frame.renderables)
+                {
+                    for (const FrameRenderable& frame_renderable : renderables)
+                    {
+                        DrawBox(frame_renderable.aabb, Vector4(0.41f, 0.86f, 1.0f, 1.0f));
+                    }
+                }
+            }
+
+            // Lines (from the above and from anything that ticked this frame, e.g. physics)
+            {
+                lock_guard<mutex> lock(m_lines_mutex);
+                frame.lines_depth_enabled.swap(m_lines_list_depth_enabled);
+                frame.lines_depth_disabled.swap(m_lines_list_depth_disabled);
+            }
+
+            // Grid
+            if (GetOption(Render_Debug_Grid))
+            {
+                frame.grid_transform = m_gizmo_grid->ComputeWorldMatrix(m_camera->GetTransform());
+            }
+
+            // Selection outline
+            if (GetOption(Render_Debug_SelectionOutline))
+            {
+                if (const Entity* entity = m_gizmo_transform->GetSelectedEntity())
+                {
+                    if (const Renderable* renderable = entity->GetRenderable())
+                    {
+                        frame.outline.material      = capture_material(renderable->GetMaterial());
+                        frame.outline.matrix        = entity->GetTransform()->GetMatrix();
+                        capture_model(frame.outline, renderable->GeometryModel_PtrShared());
+                        frame.outline.index_offset  = renderable->GeometryIndexOffset();
+                        frame.outline.index_count   = renderable->GeometryIndexCount();
+                        frame.outline.vertex_offset = renderable->GeometryVertexOffset();
+                        frame.outline_visible       = true;
+                    }
+                }
+            }
+
+            // Performance metrics
+            if (GetOption(Render_Debug_PerformanceMetrics))
+            {
+                frame.metrics = m_profiler->GetMetrics();
+            }
+        }
+
+        return true;
+    }
+
+    // Queries the world's spatial index for the renderables in every view, so culling only visits the parts of the world which
+    // overlap the view. Point and spot lights query the sphere of their range once and test what's in it against each of their views.
+    void Renderer::FrameCaptureViews(FrameSnapshot& frame)
+    {
+        const AabbTree& spatial_index = m_context->GetSubsystem<World>()->GetSpatialIndex();
+
+        const uint32_t light_count = static_cast<uint32_t>(frame.lights.size());
+        frame.views.resize(1 + light_count * m_max_shadow_views);
+
+        // The index is shared by everything in the world, and the renderer only draws what it captured this frame
+        const auto add = [this](FrameView& view, const void* user_data)
+        {
+            const auto it = m_entity_proxies.find(static_cast<const Entity*>(user_data));
+            if (it != m_entity_proxies.end() && it->second.frame_capture == m_frame_captures)
+            {
+                view.visible[it->second.frame_object_type].emplace_back(it->second.frame_index);
+            }
+        };
+
+        // One task for the camera, and one per light
+        m_threading->ParallelFor(1 + light_count, 1, [this, &frame, &spatial_index, &add](const uint32_t start, const uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                // Camera
+                if (i == 0)
+                {
+                    FrameView& view = frame.views[0];
+                    spatial_index.QueryFrustum(frame.camera.frustum, [&view, &add](void* user_data) { add(view, user_data); });
+                    continue;
+                }
+
+                // Light
+                const FrameLight& frame_light   = frame.lights[i - 1];
+                FrameView* views                = &frame.views[1 + (i - 1) * m_max_shadow_views];
+                if (!frame_light.shadows_enabled)
+                    continue;
+
+                // Ensure that potential shadow casters from behind the near plane are not rejected
+                if (frame_light.type == LightType::Directional)
+                {
+                    for (uint32_t array_index = 0; array_index < frame_light.shadow_array_size; array_index++)
+                    {
+                        FrameView& view = views[array_index];
+                        spatial_index.QueryFrustum(frame_light.shadow_map.slices[array_index].frustum, [&view, &add](void* user_data) { add(view, user_data); }, true);
+                    }
+                    continue;
+                }
+
+                static thread_local vector<pair<void*, BoundingBox>> casters;
+                casters.clear();
+                spatial_index.QuerySphere(frame_light.position, frame_light.range, [](void* user_data, const BoundingBox& aabb) { casters.emplace_back(user_data, aabb); });
+                for (uint32_t array_index = 0; array_index < frame_light.shadow_array_size; array_index++)
+                {
+                    const Frustum& frustum = frame_light.shadow_map.slices[array_index].frustum;
+                    for (const auto& [user_data, aabb] : casters)
+                    {
+                        if (frustum.IsVisible(aabb.GetCenter(), aabb.GetExtents()))
+                        {
+                            add(views[array_index], user_data);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    // Rasterizes the biggest of the nearest visible renderables into an occlusion buffer, and removes
+    // the visible renderables which are entirely behind them. The occluders themselves are always kept.
+    static void draw_list_occlusion_cull(FrameDrawList& draw_list, const Matrix& view_projection, const vector<FrameRenderable>& renderables, const bool shadow_casters_only, const bool reverse_z)
+    {
+        // One buffer per worker thread
+        static thread_local OcclusionBuffer occlusion_buffer;
+        occlusion_buffer.Clear(m_occlusion_buffer_width, m_occlusion_buffer_height, reverse_z);
+
+        // Occluders, the renderables are sorted front to back so the nearest come first
+        array<uint32_t, m_occluders_max> occluders;
+        uint32_t occluder_count = 0;
+        for (const uint32_t index : draw_list.visible)
+        {
+            if (occluder_count == m_occluders_max)
+                break;
+
+            const FrameRenderable& renderable = renderables[index];
+            if (!renderable.occluder || (shadow_casters_only && !renderable.cast_shadows) || occlusion_buffer.GetScreenCoverage(renderable.aabb, view_projection) < m_occluder_screen_coverage_min)
+                continue;
+
+            Mesh* mesh = renderable.model->GetMesh().get();
+            if (!mesh || renderable.vertex_offset + renderable.vertex_count > mesh->Vertices_Count() || renderable.index_offset + renderable.index_count > mesh->Indices_Count())
+                continue;
+
+            occlusion_buffer.RasterizeOccluder
+            (
+                mesh->Vertices_Get().data() + renderable.vertex_offset,
+                renderable.vertex_count,
+                mesh->Indices_Get().data() + renderable.index_offset,
+                renderable.index_count,
+                renderable.matrix * view_projection
+            );
+            occluders[occluder_count++] = index;
+        }
+
+        if (occluder_count == 0)
+            return;
+
+        // Occludees
+        const auto occluders_end = occluders.begin() + occluder_count;
+        draw_list.visible.erase(remove_if(draw_list.visible.begin(), draw_list.visible.end(), [&](const uint32_t index)
+        {
+            return find(occluders.begin(), occluders_end, index) == occluders_end && !occlusion_buffer.IsVisible(renderables[index].aabb, view_projection);
+        }), draw_list.visible.end());
+    }
+
+    // Rejects the meshlets of a visible renderable which are outside the frustum or face away from the view, and adds the index ranges
+    // of the rest to the draw list, merged where they are next to each other. Returns false if none of them survived.
+    static bool draw_list_cluster_cull(FrameDrawList& draw_list, FrameDrawCall& draw_call, const Frustum& frustum, const Vector3& view_position)
+    {
+        const FrameRenderable& renderable = *draw_call.renderable;
+        if (!renderable.model)
+            return true;
+
+        // Nothing to gain without at least two meshlets, which cover the renderable's index range exactly (older model files have none)
+        const auto [meshlets_begin, meshlets_end] = renderable.model->GetMeshlets(renderable.index_offset, renderable.index_count);
+        if (meshlets_end - meshlets_begin < 2 || meshlets_begin->index_offset != renderable.index_offset || (meshlets_end - 1)->index_offset + (meshlets_end - 1)->index_count != renderable.index_offset + renderable.index_count)
+            return true;
+
+        // Bounding spheres grow with the largest scale of the transform
+        const Matrix& matrix    = renderable.matrix;
+        const float scale_x     = matrix.m00 * matrix.m00 + matrix.m01 * matrix.m01 + matrix.m02 * matrix.m02;
+        const float scale_y     = matrix.m10 * matrix.m10 + matrix.m11 * matrix.m11 + matrix.m12 * matrix.m12;
+        const float scale_z     = matrix.m20 * matrix.m20 + matrix.m21 * matrix.m21 + matrix.m22 * matrix.m22;
+        const float radius_scale = Helper::Sqrt(Helper::Max(scale_x, Helper::Max(scale_y, scale_z)));
+
+        // Facing is tested in model space. A mirroring transform flips the winding and the rasterizer culls the other side, so those are only frustum culled.
+        const float determinant =
+            matrix.m00 * (matrix.m11 * matrix.m22 - matrix.m12 * matrix.m21) -
+            matrix.m01 * (matrix.m10 * matrix.m22 - matrix.m12 * matrix.m20) +
+            matrix.m02 * (matrix.m10 * matrix.m21 - matrix.m11 * matrix.m20);
+        const bool cone_cull                = determinant > 0.0f;
+        const Vector3 view_position_model   = cone_cull ? view_position * matrix.Inverted() : Vector3::Zero;
+
+        const uint32_t range_first  = static_cast<uint32_t>(draw_list.ranges.size());
+        uint32_t index_count        = 0;
+        for (const Meshlet* meshlet = meshlets_begin; meshlet != meshlets_end; meshlet++)
+        {
+            if (cone_cull && meshlet->IsBackFacing(view_position_model))
+                continue;
+
+            if (!frustum.IsVisible(meshlet->center * matrix, meshlet->radius * radius_scale))
+                continue;
+
+            index_count += meshlet->index_count;
+
+            if (draw_list.ranges.size() > range_first && draw_list.ranges.back().index_offset + draw_list.ranges.back().index_count == meshlet->index_offset)
+            {
+                draw_list.ranges.back().index_count += meshlet->index_count;
+                continue;
+            }
+
+            FrameDrawRange& range   = draw_list.ranges.emplace_back();
+            range.index_offset      = meshlet->index_offset;
+            range.index_count       = meshlet->index_count;
+        }
+
+        draw_list.triangles_culled += (renderable.index_count - index_count) / 3;
+
+        // Everything survived, draw the whole range (so that it can still be instanced)
+        if (index_count == renderable.index_count)
+        {
+            draw_list.ranges.resize(range_first);
+            return true;
+        }
+
+        draw_call.range_first = range_first;
+        draw_call.range_count = static_cast<uint32_t>(draw_list.ranges.size()) - range_first;
+
+        return draw_call.range_count != 0;
+    }
+
+    static uint64_t draw_key(const FrameRenderable& renderable, const uint32_t index, const uint32_t count, const bool sort_by_material)
+    {
+        uint64_t key = (static_cast<uint64_t>(index) * 256) / count;
+
+        if (renderable.model)
+        {
+            key |= (renderable.geometry_id & m_draw_key_mask_field) << m_draw_key_shift_geometry;
+            key |= static_cast<uint64_t>((renderable.index_offset * 2654435761u) >> 24) << m_draw_key_shift_mesh;
+
+            // Quantized geometry has its own vertex shaders, so it's grouped even when materials aren't
+            key |= static_cast<uint64_t>(renderable.quantized ? 1 : 0) << m_draw_key_shift_quantized;
+        }
+
+        if (sort_by_material && renderable.material)
+        {
+            key |= (static_cast<uint64_t>(renderable.material->flags) << m_draw_key_shift_variation);
+            key |= static_cast<uint64_t>(renderable.material_index) << m_draw_key_shift_material;
+        }
+
+        return key;
+    }
+
+    // Sorts the draw calls by their keys, with an LSD radix sort over 8-bit digits. The keys are sorted along with
+    // the index of their draw call, which is then moved once. Digits which are the same for every key are skipped.
+    static void draw_list_sort(FrameDrawList& draw_list, vector<pair<uint64_t, uint32_t>>& keys)
+    {
+        const uint32_t count = static_cast<uint32_t>(keys.size());
+        if (count < 2)
+            return;
+
+        // The histograms of all the digits, in one pass
+        array<array<uint32_t, 256>, 8> histograms = {};
+        for (const auto& key : keys)
+        {
+            for (uint32_t digit = 0; digit < 8; digit++)
+            {
+                histograms[digit][(key.first >> (digit * 8)) & 0xFF]++;
+            }
+        }
+
+        static thread_local vector<pair<uint64_t, uint32_t>> keys_scratch;
+        keys_scratch.resize(count);
+        for (uint32_t digit = 0; digit < 8; digit++)
+        {
+            const uint32_t shift    = digit * 8;
+            auto& histogram         = histograms[digit];
+            if (histogram[(keys[0].first >> shift) & 0xFF] == count)
+                continue;
+
+            // Counts to offsets
+            uint32_t offset = 0;
+            for (uint32_t& bucket : histogram)
+            {
+                const uint32_t bucket_count = bucket;
+                bucket = offset;
+                offset += bucket_count;
+            }
+
+            for (const auto& key : keys)
+            {
+                keys_scratch[histogram[(key.first >> shift) & 0xFF]++] = key;
+            }
+            keys.swap(keys_scratch);
+        }
+
+        // Move the draw calls into the sorted order
+        static thread_local vector<FrameDrawCall> draw_calls_unsorted;
+        draw_calls_unsorted.swap(draw_list.draw_calls);
+        draw_list.draw_calls.resize(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            draw_list.draw_calls[i] = draw_calls_unsorted[keys[i].second];
+        }
+    }
+
+    // Counts how many times the shader variation, the material and the geometry change, over a stream of keys
+    static void draw_list_count_binds(const vector<pair<uint64_t, uint32_t>>& keys, uint32_t& pipeline, uint32_t& material, uint32_t& buffer)
+    {
+        pipeline = material = buffer = 0;
+        uint64_t key_previous = ~0ull;
+        for (const auto& key : keys)
+        {
+            const auto changed = [&key, &key_previous](const uint32_t shift) { return ((key.first >> shift) & m_draw_key_mask_field) != ((key_previous >> shift) & m_draw_key_mask_field); };
+            pipeline    += changed(m_draw_key_shift_variation) ? 1 : 0;
+            material    += changed(m_draw_key_shift_material) ? 1 : 0;
+            buffer      += changed(m_draw_key_shift_geometry) ? 1 : 0;
+            key_previous = key.first;
+        }
+    }
+
+    static void draw_list_build(FrameDrawList& draw_list, const Frustum& frustum, const Matrix& view_projection, const vector<uint32_t>& visible, const vector<FrameRenderable>& renderables, const bool shadow_casters_only, const bool occlusion_cull, const bool reverse_z, const bool sort_by_material, const bool cluster_cull, const Vector3& view_position)
+    {
+        // Culled through the spatial index when the frame was captured
+        draw_list.visible = visible;
+
+        if (occlusion_cull)
+        {
+            draw_list_occlusion_cull(draw_list, view_projection, renderables, shadow_casters_only, reverse_z);
+        }
+
+        // Transform, and cull the clusters of the visible renderables
+        static thread_local vector<pair<uint64_t, uint32_t>> keys;
+        keys.clear();
+        draw_list.draw_calls.clear();
+        draw_list.ranges.clear();
+        draw_list.triangles_culled = 0;
+        for (const uint32_t index : draw_list.visible)
+        {
+            const FrameRenderable& renderable = renderables[index];
+
+            if (shadow_casters_only && !renderable.cast_shadows)
+                continue;
+
+            FrameDrawCall& draw_call    = draw_list.draw_calls.emplace_back();
+            draw_call.renderable        = &renderable;
+            draw_call.transform         = renderable.matrix_vertex * view_projection;
+
+            if (cluster_cull && !draw_list_cluster_cull(draw_list, draw_call, frustum, view_position))
+            {
+                draw_list.draw_calls.pop_back();
+                continue;
+            }
+
+            keys.emplace_back(draw_key(renderable, index, static_cast<uint32_t>(renderables.size()), sort_by_material), static_cast<uint32_t>(draw_list.draw_calls.size() - 1));
+        }
+
+        // Sort
+        uint32_t unsorted_pipeline, unsorted_material, unsorted_buffer;
+        draw_list_count_binds(keys, unsorted_pipeline, unsorted_material, unsorted_buffer);
+        draw_list_sort(draw_list, keys);
+        uint32_t sorted_pipeline, sorted_material, sorted_buffer;
+        draw_list_count_binds(keys, sorted_pipeline, sorted_material, sorted_buffer);
+        draw_list.binds_saved_pipeline  = static_cast<int32_t>(unsorted_pipeline) - static_cast<int32_t>(sorted_pipeline);
+        draw_list.binds_saved_material  = static_cast<int32_t>(unsorted_material) - static_cast<int32_t>(sorted_material);
+        draw_list.binds_saved_buffer    = static_cast<int32_t>(unsorted_buffer) - static_cast<int32_t>(sorted_buffer);
+
+        // Batch, the draw calls of the same mesh and material are next to each other now
+        draw_list.batches.clear();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(draw_list.draw_calls.size()); i++)
+        {
+            if (!draw_list.batches.empty())
+            {
+                FrameDrawBatch& batch       = draw_list.batches.back();
+                const FrameRenderable& a    = *draw_list.draw_calls[batch.first].renderable;
+                const FrameRenderable& b    = *draw_list.draw_calls[i].renderable;
+
+                const bool same_ranges      = draw_list.draw_calls[batch.first].range_count == 0 && draw_list.draw_calls[i].range_count == 0;
+                const bool same_mesh        = same_ranges && a.model == b.model && a.index_offset == b.index_offset && a.index_count == b.index_count && a.vertex_offset == b.vertex_offset;
+                const bool same_material    = !sort_by_material || a.material == b.material;
+                if (same_mesh && same_material && batch.count < m_max_instances)
+                {
+                    batch.count++;
+                    continue;
+                }
+            }
+
+            FrameDrawBatch& batch   = draw_list.batches.emplace_back();
+            batch.first             = i;
+            batch.count             = 1;
+        }
+
+        // Single and instanced draws use different vertex shaders, group them so that a pass switches once per shader variation
+        stable_sort(draw_list.batches.begin(), draw_list.batches.end(), [](const FrameDrawBatch& a, const FrameDrawBatch& b)
+        {
+            const uint64_t variation_a = keys[a.first].first >> m_draw_key_shift_variation;
+            const uint64_t variation_b = keys[b.first].first >> m_draw_key_shift_variation;
+            return variation_a != variation_b ? variation_a < variation_b : (a.count == 1 && b.count > 1);
+        });
+    }
+
+    void Renderer::DrawCallsPrepare()
+    {
+        const FrameSnapshot* frame      = &m_frames[m_frame_index_render];
+        const Matrix view_projection    = m_buffer_frame_cpu.view_projection;
+        const bool occlusion_culling    = GetOption(Render_OcclusionCulling);
+        const bool cluster_culling      = GetOption(Render_ClusterCulling);
+        const bool reverse_z            = GetOption(Render_ReverseZ);
+
+        // One task per view, the camera's two (opaque and transparent) and one per shadow view (cascade or cube face) of each light and object type
+        const uint32_t camera_view_count    = 2;
+        const uint32_t light_view_count     = static_cast<uint32_t>(frame->lights.size()) * m_max_shadow_views;
+        m_draw_lists_light[Renderer_Object_Opaque].resize(light_view_count);
+        m_draw_lists_light[Renderer_Object_Transparent].resize(light_view_count);
+
+        m_threading->ParallelFor(camera_view_count + light_view_count * 2, 1, [this, frame, view_projection, occlusion_culling, cluster_culling, reverse_z, camera_view_count, light_view_count](uint32_t start, uint32_t end)
+        {
+            for (uint32_t i = start; i < end; i++)
+            {
+                // Camera
+                if (i < camera_view_count)
+                {
+                    const Renderer_Object_Type object_type  = static_cast<Renderer_Object_Type>(i);
+                    const bool occlusion_cull               = occlusion_culling && object_type == Renderer_Object_Opaque;
+
+                    draw_list_build(m_draw_lists_camera[object_type], frame->camera.frustum, view_projection, frame->views[0].visible[object_type], frame->renderables[object_type], false, occlusion_cull, reverse_z, true, cluster_culling, frame->camera.position);
+                    continue;
+                }
+
+                // Light
+                const uint32_t light_view_index         = i - camera_view_count;
+                const Renderer_Object_Type object_type  = light_view_index < light_view_count ? Renderer_Object_Opaque : Renderer_Object_Transparent;
+                const uint32_t view_index               = light_view_index % light_view_count;
+                const uint32_t array_index              = view_index % m_max_shadow_views;
+                const FrameLight& frame_light           = frame->lights[view_index / m_max_shadow_views];
+                FrameDrawList& draw_list                = m_draw_lists_light[object_type][view_index];
+                draw_list.visible.clear();
+                draw_list.draw_calls.clear();
+                draw_list.ranges.clear();
+                draw_list.triangles_culled      = 0;
+                draw_list.binds_saved_pipeline  = 0;
+                draw_list.binds_saved_material  = 0;
+                draw_list.binds_saved_buffer    = 0;
+
+                // Skip views which won't be rendered
+                if (!frame_light.shadows_enabled || array_index >= frame_light.shadow_array_size)
+                    continue;
+
+                // Skip lights that don't cast transparent shadows
+                if (object_type == Renderer_Object_Transparent && !frame_light.shadows_transparent_enabled)
+                    continue;
+
+                // Hidden casters don't change a shadow map either, as long as the occluders are opaque
+                const bool occlusion_cull = occlusion_culling && object_type == Renderer_Object_Opaque;
+
+                // Only the transparent shadows bind materials
+                const bool sort_by_material = object_type == Renderer_Object_Transparent;
+
+                draw_list_build(draw_list, frame_light.shadow_map.slices[array_index].frustum, frame_light.view_projection[array_index], frame->views[1 + view_index].visible[object_type], frame->renderables[object_type], true, occlusion_cull, reverse_z, sort_by_material, false, Vector3::Zero);
+            }
+        }, &m_draw_calls_counter);
+    }
+
+    void Renderer::LightClustersPrepare()
+    {
+        // Last frame's binning may not have been waited on, if its shader was still compiling
+        DrawCallsWait(m_light_clusters_counter);
+
+        FrameSnapshot& frame = m_frames[m_frame_index_render];
+
+        // Point and spot lights without any kind of shadows are shaded together, in a single pass, the rest get a pass each
+        m_clustered_lights.clear();
+        m_clustered_frame_lights.clear();
+        const bool screen_space_shadows = GetOption(Render_ScreenSpaceShadows);
+        for (FrameLight& frame_light : frame.lights)
+        {
+            frame_light.clustered =
+                frame_light.type != LightType::Directional                              &&
+                frame_light.intensity != 0.0f                                           &&
+                !frame_light.shadows_enabled                                            &&
+                !(frame_light.shadows_screen_space_enabled && screen_space_shadows)     &&
+                m_clustered_lights.size() < m_max_clustered_lights;
+
+            if (!frame_light.clustered)
+                continue;
+
+            ClusteredLight& clustered_light = m_clustered_lights.emplace_back();
+            clustered_light.position        = frame_light.position;
+            clustered_light.range           = frame_light.range;
+            if (frame_light.type == LightType::Spot)
+            {
+                // The shader's cone ends where the cosine of the angle to the light's direction is 1 - angle
+                clustered_light.direction   = frame_light.direction;
+                clustered_light.angle       = acos(Helper::Clamp(1.0f - frame_light.angle, -1.0f, 1.0f));
+            }
+
+            m_clustered_frame_lights.emplace_back(&frame_light);
+        }
+
+        m_light_clusters_dirty = !m_clustered_lights.empty();
+        if (!m_light_clusters_dirty)
+            return;
+
+        // Bin them on the job system, the light pass waits for it
+        const FrameCamera* camera = &frame.camera;
+        m_threading->AddTask([this, camera]()
+        {
+            m_light_clusters.Build(m_clustered_lights, camera->view, camera->projection, camera->near_plane, camera->far_plane, m_threading);
+        }, &m_light_clusters_counter);
+    }
+
+    void Renderer::ShadowAtlasPrepare()
+    {
+        RHI_Texture* tex_atlas = m_render_targets[RenderTarget_Shadow_Atlas_Depth].get();
+        if (!tex_atlas)
+            return;
+
+        // The textures were (re)created, start over
+        if (m_shadow_atlas_dirty.exchange(false))
+        {
+            m_shadow_atlas.SetResolution(tex_atlas->GetWidth(), GetOptionValue<uint32_t>(Option_Value_ShadowResolution));
+        }
+
+        const FrameSnapshot& frame  = m_frames[m_frame_index_render];
+        const FrameCamera& camera   = frame.camera;
+
+        // Point and spot lights ask for tiles as large as they appear on the screen
+        m_shadow_atlas_requests.clear();
+        for (const FrameLight& frame_light : frame.lights)
+        {
+            if (frame_light.type == LightType::Directional || frame_light.shadow_array_size == 0)
+                continue;
+
+            // The diameter of the light's sphere on the screen, in pixels, or as much as there is if the camera is inside of it
+            const float range       = frame_light.range;
+            const float distance    = Vector3::Distance(camera.position, frame_light.position);
+            float size              = numeric_limits<float>::max();
+            if (distance > range)
+            {
+                size = range / sqrt(distance * distance - range * range) * camera.projection.m11 * m_resolution.y;
+            }
+
+            ShadowAtlasRequest& request = m_shadow_atlas_requests.emplace_back();
+            request.light_id            = frame_light.id;
+            request.view_count          = frame_light.shadow_array_size;
+            request.size                = size;
+        }
+
+        m_shadow_atlas.Allocate(m_shadow_atlas_requests, m_frame_num);
+
+        // Only opaque casters are cached, transparent ones are drawn every frame
+        m_shadow_atlas.UpdateCasters(frame.renderables[Renderer_Object_Opaque], m_frame_num);
+    }
+
+    void Renderer::TextureStreamingPrepare()
+    {
+        const FrameSnapshot& frame  = m_frames[m_frame_index_render];
+        const FrameCamera& camera   = frame.camera;
+
+        // Visible renderables ask for the textures of their material to be as sharp as they appear on the screen
+        for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+        {
+            for (const uint32_t index : frame.views[0].visible[object_type])
+            {
+                const FrameRenderable& renderable   = frame.renderables[object_type][index];
+                const FrameMaterial* material       = renderable.material;
+                if (!material)
+                    continue;
+
+                // The diameter of the bounding sphere on the screen, in pixels, times how many times the textures repeat across it
+                const float radius      = renderable.aabb.GetExtents().Length();
+                const float distance    = Vector3::Distance(camera.position, renderable.aabb.GetCenter());
+                float size              = numeric_limits<float>::max();
+                if (distance > radius)
+                {
+                    size = radius / sqrt(distance * distance - radius * radius) * camera.projection.m11 * m_resolution.y;
+                    size *= Helper::Max(material->tiling.x, material->tiling.y);
+                }
+
+                for (uint32_t i = 0; i < m_material_property_count; i++)
+                {
+                    const shared_ptr<RHI_Texture>& texture = material->textures[i]; // the snapshot's copy, alive for as long as the frame is
+                    if (!texture || !texture->IsStreamed() || texture->GetLoadState() != Completed)
+                        continue;
+
+                    // Textures are tracked from the first time they are seen
+                    if (!m_texture_streamer.Contains(texture->GetId()))
+                    {
+                        vector<uint64_t> byte_counts(texture->GetMipCount());
+                        for (uint32_t mip = 0; mip < texture->GetMipCount(); mip++)
+                        {
+                            byte_counts[mip] = texture->GetMipByteCount(mip);
+                        }
+
+                        m_texture_store.Add(texture);
+                        m_texture_streamer.Add(texture->GetId(), texture->GetWidth(), texture->GetHeight(), byte_counts, texture->GetMipResident());
+                    }
+
+                    m_texture_streamer.Request(texture->GetId(), size, m_frame_num);
+                }
+            }
+        }
+
+        // Stream in and out, before anything is recorded with the textures
+        m_texture_store.BeginFrame(m_frame_num);
+        m_texture_streamer.SetBudget(static_cast<uint64_t>(GetOptionValue<float>(Option_Value_TextureStreamingBudget) * 1024.0f * 1024.0f));
+        m_texture_streamer.Update(m_texture_store, m_frame_num);
+    }
+
+    void TextureStoreGpu::Add(const shared_ptr<RHI_Texture>& texture)
+    {
+        m_textures[texture->GetId()] = texture;
+    }
+
+    void TextureStoreGpu::BeginFrame(const uint64_t frame)
+    {
+        m_frame = frame;
+
+        // The GPU is done with the frames which were recorded before the frames in flight
+        m_textures_retired.erase(remove_if(m_textures_retired.begin(), m_textures_retired.end(), [this](const auto& retired)
+        {
+            return m_frame > retired.first + m_frames_in_flight;
+        }), m_textures_retired.end());
+
+        // Swap in the chains which are ready, before anything is recorded with the textures
+        for (auto it = m_streams.begin(); it != m_streams.end();)
+        {
+            Stream& stream = it->second;
+            if (!stream.counter.IsDone())
+            {
+                it++;
+                continue;
+            }
+
+            // The texture keeps what it has if the chain couldn't be created (it's no longer streamed then)
+            if (stream.texture_staged)
+            {
+                stream.texture->SetMipResident(stream.texture_staged.get());
+                m_textures_retired.emplace_back(m_frame, move(stream.texture_staged));
+            }
+
+            // Something else was asked for in the meantime
+            if (stream.texture->IsStreamed() && stream.mip_next != stream.texture->GetMipResident())
+            {
+                stream.mip = stream.mip_next;
+                StreamStart(stream);
+                it++;
+                continue;
+            }
+
+            it = m_streams.erase(it);
+        }
+    }
+
+    void TextureStoreGpu::Clear()
+    {
+        for (auto& it : m_streams)
+        {
+            m_threading->Wait(it.second.counter);
+        }
+
+        m_streams.clear();
+        m_textures.clear();
+        m_textures_retired.clear();
+    }
+
+    bool TextureStoreGpu::IsValid(const uint32_t texture_id) const
+    {
+        auto it = m_textures.find(texture_id);
+        if (it == m_textures.end())
+            return false;
 
-        // Reset dynamic buffer indices when the swapchain resets to first buffer/command list
-        if (m_swap_chain->GetCmdIndex() == 0)
+        if (it->second.expired())
         {
-            m_buffer_uber_offset_index      = 0;
-            m_buffer_object_offset_index    = 0;
+            m_textures.erase(it);
+            return false;
         }
 
-		// Get camera matrices
-		{
-            if (m_update_ortho_proj || m_near_plane != m_camera->GetNearPlane() || m_far_plane != m_camera->GetFarPlane())
+        return true;
+    }
+
+    bool TextureStoreGpu::SetMipResident(const uint32_t texture_id, const uint32_t mip)
+    {
+        auto it = m_textures.find(texture_id);
+        shared_ptr<RHI_Texture> texture = it != m_textures.end() ? it->second.lock() : nullptr;
+        if (!texture)
+        {
+            if (it != m_textures.end())
             {
-                m_buffer_frame_cpu.projection_ortho         = Matrix::CreateOrthographicLH(m_viewport.width, m_viewport.height, m_near_plane, m_far_plane);
-                m_buffer_frame_cpu.view_projection_ortho    = Matrix::CreateLookAtLH(Vector3(0, 0, -m_near_plane), Vector3::Forward, Vector3::Up) * m_buffer_frame_cpu.projection_ortho;
-                m_update_ortho_proj                         = false;
+                m_textures.erase(it);
             }
+            return false;
+        }
 
-            m_near_plane	                = m_camera->GetNearPlane();
-            m_far_plane		                = m_camera->GetFarPlane();
-            m_buffer_frame_cpu.view		    = m_camera->GetViewMatrix();
-            m_buffer_frame_cpu.projection   = m_camera->GetProjectionMatrix();
+        // A chain which failed to be created stops the streaming
+        if (!texture->IsStreamed() || mip >= texture->GetMipCount())
+            return false;
 
-			// TAA - Generate jitter
-			if (GetOption(Render_AntiAliasing_Taa))
-			{
-				m_taa_jitter_previous = m_taa_jitter;
+        // A texture streams one chain at a time, the latest request follows once the running one is swapped in
+        auto it_stream = m_streams.find(texture_id);
+        if (it_stream != m_streams.end())
+        {
+            it_stream->second.mip_next = mip;
+            return true;
+        }
 
-                const float scale               = 1.0f;
-				const uint64_t samples	        = 16;
-				const uint64_t index	        = m_frame_num % samples;
-				m_taa_jitter			        = (Utility::Sampling::Halton2D(index, 2, 3) * 2.0f - 1.0f);
-				m_taa_jitter.x			        = (m_taa_jitter.x / m_resolution.x) * scale;
-				m_taa_jitter.y			        = (m_taa_jitter.y / m_resolution.y) * scale;
-                m_buffer_frame_cpu.projection   *= Matrix::CreateTranslation(Vector3(m_taa_jitter.x, m_taa_jitter.y, 0.0f));
-			}
-			else
-			{
-				m_taa_jitter			= Vector2::Zero;
-				m_taa_jitter_previous   = Vector2::Zero;		
-			}
+        if (mip == texture->GetMipResident())
+            return true;
 
-            // Compute some TAA affected matrices
-            m_buffer_frame_cpu.view_projection              = m_buffer_frame_cpu.view * m_buffer_frame_cpu.projection;
-            m_buffer_frame_cpu.view_projection_inv          = Matrix::Invert(m_buffer_frame_cpu.view_projection);   
-            m_buffer_frame_cpu.view_projection_unjittered   = m_buffer_frame_cpu.view * m_camera->GetProjectionMatrix();
-		}
+        Stream& stream  = m_streams[texture_id];
+        stream.texture  = move(texture);
+        stream.mip      = mip;
+        stream.mip_next = mip;
+        StreamStart(stream);
 
-        m_is_rendering = true;
-        Pass_Main(m_swap_chain->GetCmdList());
-        m_is_rendering = false;
+        return true;
+    }
 
-        m_frame_num++;
-        m_is_odd_frame = (m_frame_num % 2) == 1;
-	}
+    void TextureStoreGpu::StreamStart(Stream& stream)
+    {
+        m_threading->AddTask([&stream]()
+        {
+            stream.texture_staged = stream.texture->CreateMipResident(stream.mip);
+        }, &stream.counter);
+    }
+
+    void Renderer::DrawCallsWait(const TaskCounter& counter) const
+    {
+        if (!counter.IsDone())
+        {
+            m_threading->Wait(counter);
+        }
+    }
 
     void Renderer::SetViewport(float width, float height, float offset_x /*= 0*/, float offset_y /*= 0*/)
     {
@@ -321,6 +1360,8 @@ namespace Spartan
 
 	void Renderer::DrawLine(const Vector3& from, const Vector3& to, const Vector4& color_from, const Vector4& color_to, const bool depth /*= true*/)
 	{
+        lock_guard<mutex> lock(m_lines_mutex);
+
 		if (depth)
 		{
 			m_lines_list_depth_enabled.emplace_back(from, color_from);
@@ -372,20 +1413,22 @@ namespace Spartan
             return false;
         }
 
+        const FrameSnapshot& frame = m_frames[m_frame_index_render];
+
         // Struct is updated automatically here as per frame data are (by definition) known ahead of time
-        m_buffer_frame_cpu.camera_aperture              = m_camera->GetAperture();
-        m_buffer_frame_cpu.camera_shutter_speed         = m_camera->GetShutterSpeed();
-        m_buffer_frame_cpu.camera_iso                   = m_camera->GetIso();
-        m_buffer_frame_cpu.camera_near                  = m_camera->GetNearPlane();
-        m_buffer_frame_cpu.camera_far                   = m_camera->GetFarPlane();
-        m_buffer_frame_cpu.camera_position              = m_camera->GetTransform()->GetPosition();
-        m_buffer_frame_cpu.camera_direction             = m_camera->GetTransform()->GetForward();
+        m_buffer_frame_cpu.camera_aperture              = frame.camera.aperture;
+        m_buffer_frame_cpu.camera_shutter_speed         = frame.camera.shutter_speed;
+        m_buffer_frame_cpu.camera_iso                   = frame.camera.iso;
+        m_buffer_frame_cpu.camera_near                  = frame.camera.near_plane;
+        m_buffer_frame_cpu.camera_far                   = frame.camera.far_plane;
+        m_buffer_frame_cpu.camera_position              = frame.camera.position;
+        m_buffer_frame_cpu.camera_direction             = frame.camera.forward;
         m_buffer_frame_cpu.bloom_intensity              = m_option_values[Option_Value_Bloom_Intensity];
         m_buffer_frame_cpu.sharpen_strength             = m_option_values[Option_Value_Sharpen_Strength];
         m_buffer_frame_cpu.taa_jitter_offset_previous   = m_buffer_frame_cpu.taa_jitter_offset;
         m_buffer_frame_cpu.taa_jitter_offset            = m_taa_jitter - m_taa_jitter_previous;
-        m_buffer_frame_cpu.delta_time                   = static_cast<float>(m_context->GetSubsystem<Timer>()->GetDeltaTimeSmoothedSec());
-        m_buffer_frame_cpu.time                         = static_cast<float>(m_context->GetSubsystem<Timer>()->GetTimeSec());
+        m_buffer_frame_cpu.delta_time                   = frame.delta_time;
+        m_buffer_frame_cpu.time                         = frame.time;
         m_buffer_frame_cpu.tonemapping                  = m_option_values[Option_Value_Tonemapping];
         m_buffer_frame_cpu.gamma                        = m_option_values[Option_Value_Gamma];
         m_buffer_frame_cpu.ssr_enabled                  = GetOption(Render_ScreenSpaceReflections) ? 1.0f : 0.0f;
@@ -393,14 +1436,13 @@ namespace Spartan
         m_buffer_frame_cpu.frame                        = static_cast<uint32_t>(m_frame_num);
 
         // Update directional light intensity, just grab the first one
-        for (const auto& entity : m_entities[Renderer_Object_Light])
-            if (Light* light = entity->GetComponent<Light>())
+        for (const FrameLight& frame_light : frame.lights)
+        {
+            if (frame_light.type == LightType::Directional)
             {
-                if (light->GetLightType() == LightType::Directional)
-                {
-                    m_buffer_frame_cpu.directional_light_intensity = light->GetIntensity();
-                }
+                m_buffer_frame_cpu.directional_light_intensity = frame_light.intensity;
             }
+        }
 
         // Update
         *buffer = m_buffer_frame_cpu;
@@ -411,6 +1453,51 @@ namespace Spartan
 
     bool Renderer::UpdateMaterialBuffer()
     {
+        FrameSnapshot& frame = m_frames[m_frame_index_render];
+
+        // Give every material of the frame a row, and refresh the rows of the materials which changed since they were uploaded
+        bool dirty = false;
+        for (FrameMaterial& material : frame.materials)
+        {
+            const uint32_t index    = MaterialTableIndex(material.id);
+            material.table_index    = index;
+            if (index == 0)
+                continue;
+
+            MaterialTableRow& row   = m_material_table[index];
+            row.frame_used          = m_frame_num;
+            if (row.version == material.version)
+                continue;
+
+            row.version = material.version;
+            dirty       = true;
+
+            m_buffer_material_cpu.mat_color[index]                                   = material.color;
+            m_buffer_material_cpu.mat_tiling_offset[index]                           = Vector4(material.tiling.x, material.tiling.y, material.offset.x, material.offset.y);
+            m_buffer_material_cpu.mat_roughness_metallic_normal_height[index].x      = material.GetProperty(Material_Roughness);
+            m_buffer_material_cpu.mat_roughness_metallic_normal_height[index].y      = material.GetProperty(Material_Metallic);
+            m_buffer_material_cpu.mat_roughness_metallic_normal_height[index].z      = material.GetProperty(Material_Normal);
+            m_buffer_material_cpu.mat_roughness_metallic_normal_height[index].w      = material.GetProperty(Material_Height);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[index].x = material.GetProperty(Material_Clearcoat);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[index].y = material.GetProperty(Material_Clearcoat_Roughness);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[index].z = material.GetProperty(Material_Anisotropic);
+            m_buffer_material_cpu.mat_clearcoat_clearcoatRough_anis_anisRot[index].w = material.GetProperty(Material_Anisotropic_Rotation);
+            m_buffer_material_cpu.mat_sheen_sheenTint_pad[index].x                   = material.GetProperty(Material_Sheen);
+            m_buffer_material_cpu.mat_sheen_sheenTint_pad[index].y                   = material.GetProperty(Material_Sheen_Tint);
+        }
+
+        for (vector<FrameRenderable>& renderables : frame.renderables)
+        {
+            for (FrameRenderable& renderable : renderables)
+            {
+                renderable.material_index = renderable.material ? renderable.material->table_index : 0;
+            }
+        }
+
+        // The GPU table is still up to date
+        if (!dirty)
+            return true;
+
         // Map
         BufferMaterial* buffer = static_cast<BufferMaterial*>(m_buffer_material_gpu->Map());
         if (!buffer)
@@ -419,36 +1506,50 @@ namespace Spartan
             return false;
         }
 
-        // Update
-        for (uint32_t i = 0; i < m_max_material_instances; i++)
+        // Update, all of it since mapping can discard the previous contents
+        *buffer = m_buffer_material_cpu;
+
+        // Unmap
+        return m_buffer_material_gpu->Unmap();
+    }
+
+    uint32_t Renderer::MaterialTableIndex(const uint32_t material_id)
+    {
+        // The row the material was given before, if another material hasn't taken it over since
+        const auto it = m_material_table_rows.find(material_id);
+        if (it != m_material_table_rows.end())
+            return it->second;
+
+        // Take the next row which is free or not drawn this frame (row 0 is reserved for the sky)
+        for (uint32_t i = 1; i < m_max_material_instances; i++)
         {
-            Material* material = m_material_instances[i];
-            if (!material)
+            const uint32_t candidate    = m_material_table_cursor;
+            m_material_table_cursor     = (m_material_table_cursor + 1 < m_max_material_instances) ? m_material_table_cursor + 1 : 1;
+
+            MaterialTableRow& row = m_material_table[candidate];
+            if (row.material_id != 0 && row.frame_used == m_frame_num)
                 continue;
 
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].x = material->GetProperty(Material_Clearcoat);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].y = material->GetProperty(Material_Clearcoat_Roughness);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].z = material->GetProperty(Material_Anisotropic);
-            buffer->mat_clearcoat_clearcoatRough_anis_anisRot[i].w = material->GetProperty(Material_Anisotropic_Rotation);
-            buffer->mat_sheen_sheenTint_pad[i].x                   = material->GetProperty(Material_Sheen);
-            buffer->mat_sheen_sheenTint_pad[i].y                   = material->GetProperty(Material_Sheen_Tint);
+            if (row.material_id != 0)
+            {
+                m_material_table_rows.erase(row.material_id);
+            }
+
+            row.material_id = material_id;
+            row.version     = 0; // materials start at version 1, so the row will be uploaded
+            row.frame_used  = m_frame_num;
+            m_material_table_rows[material_id] = candidate;
+
+            return candidate;
         }
 
-        // Unmap
-        return m_buffer_material_gpu->Unmap();
+        LOG_ERROR("Material table has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
+        return 0;
     }
 
     template<typename T>
-    inline bool update_dynamic_buffer(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_gpu, T& buffer_cpu, T& buffer_cpu_previous, uint32_t& offset_index)
+    inline bool grow_dynamic_buffer(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_gpu, const uint32_t offset_index)
     {
-        offset_index++;
-
-        // Only update if needed
-        bool update = buffer_gpu->GetOffsetIndexDynamic() != offset_index;
-        update      = update ? true : buffer_cpu != buffer_cpu_previous;
-        if (!update)
-            return true;
-
         const uint32_t offset_count = offset_index + 1;
 
         // Re-allocate buffer with double size (if needed)
@@ -467,6 +1568,23 @@ namespace Spartan
             }
         }
 
+        return true;
+    }
+
+    template<typename T>
+    inline bool update_dynamic_buffer(RHI_CommandList* cmd_list, RHI_ConstantBuffer* buffer_gpu, T& buffer_cpu, T& buffer_cpu_previous, uint32_t& offset_index)
+    {
+        offset_index++;
+
+        // Only update if needed
+        bool update = buffer_gpu->GetOffsetIndexDynamic() != offset_index;
+        update      = update ? true : buffer_cpu != buffer_cpu_previous;
+        if (!update)
+            return true;
+
+        if (!grow_dynamic_buffer<T>(cmd_list, buffer_gpu, offset_index))
+            return false;
+
         // Set new buffer offset
         buffer_gpu->SetOffsetIndexDynamic(offset_index);
 
@@ -526,11 +1644,62 @@ namespace Spartan
         return cmd_list->SetConstantBuffer(3, RHI_Shader_Vertex, m_buffer_object_gpu);
     }
 
-    bool Renderer::UpdateLightBuffer(const Light* light)
+    bool Renderer::UpdateInstanceBuffer(RHI_CommandList* cmd_list, const uint32_t instance_count)
     {
-        if (!light)
+        if (!cmd_list)
+        {
+            LOG_ERROR("Invalid command list");
+            return false;
+        }
+
+        // Every instanced draw gets its own offset, there is no point in comparing with the previous one
+        m_buffer_instances_offset_index++;
+        if (!grow_dynamic_buffer<BufferInstances>(cmd_list, m_buffer_instances_gpu.get(), m_buffer_instances_offset_index))
+            return false;
+
+        m_buffer_instances_gpu->SetOffsetIndexDynamic(m_buffer_instances_offset_index);
+
+        // Map
+        std::byte* buffer = static_cast<std::byte*>(m_buffer_instances_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update, only the instances which are drawn
+        const uint64_t offset   = m_buffer_instances_gpu->IsDynamic() ? m_buffer_instances_offset_index * m_buffer_instances_gpu->GetStride() : 0;
+        const uint64_t size     = instance_count * sizeof(BufferObject);
+        memcpy(buffer + offset, m_buffer_instances_cpu.instances, size);
+
+        // Unmap
+        if (!m_buffer_instances_gpu->Unmap(offset, size))
             return false;
 
+        // Dynamic buffers with offsets have to be rebound whenever the offset changes
+        return cmd_list->SetConstantBuffer(5, RHI_Shader_Vertex, m_buffer_instances_gpu);
+    }
+
+    // Converts luminous power to luminous intensity
+    static float light_luminous_intensity(const FrameLight& frame_light, const float exposure)
+    {
+        float luminous_intensity = frame_light.intensity * exposure;
+        if (frame_light.type == LightType::Point)
+        {
+            luminous_intensity /= Math::Helper::PI_4; // lumens to candelas
+            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+        }
+        else if (frame_light.type == LightType::Spot)
+        {
+            luminous_intensity /= Math::Helper::PI; // lumens to candelas
+            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+        }
+
+        return luminous_intensity;
+    }
+
+    bool Renderer::UpdateLightBuffer(const FrameLight& frame_light)
+    {
         // Only update if needed
         if (m_buffer_light_cpu == m_buffer_light_cpu_previous)
             return true;
@@ -546,29 +1715,24 @@ namespace Spartan
         const bool volumetric         = static_cast<float>(m_options & Render_VolumetricLighting);
         const bool contact_shadows    = static_cast<float>(m_options & Render_ScreenSpaceShadows);
 
-        for (uint32_t i = 0; i < light->GetShadowArraySize(); i++)
+        for (uint32_t i = 0; i < frame_light.shadow_array_size; i++)
         {
-            m_buffer_light_cpu.view_projection[i] = light->GetViewMatrix(i) * light->GetProjectionMatrix(i);
+            m_buffer_light_cpu.view_projection[i] = frame_light.view_projection[i];
         }
 
-        // Convert luminous power to luminous intensity
-        float luminous_intensity = light->GetIntensity() * m_camera->GetExposure();
-        if (light->GetLightType() == LightType::Point)
+        // The tiles of point and spot lights, in the shadow atlas
+        ShadowAtlasLight* atlas_light = frame_light.type != LightType::Directional ? m_shadow_atlas.GetLight(frame_light.id) : nullptr;
+        for (uint32_t i = 0; i < m_max_shadow_views; i++)
         {
-            luminous_intensity /= Math::Helper::PI_4; // lumens to candelas
-            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
-        }
-        else if (light->GetLightType() == LightType::Spot)
-        {
-            luminous_intensity /= Math::Helper::PI; // lumens to candelas
-            luminous_intensity *= 255.0f; // this is a hack, must fix whats my color units
+            m_buffer_light_cpu.atlas_rects[i] = atlas_light && i < atlas_light->view_count ? m_shadow_atlas.GetTileRect(atlas_light->views[i].tile) : Vector4::Zero;
         }
 
-        m_buffer_light_cpu.intensity_range_angle_bias   = Vector4(luminous_intensity, light->GetRange(), light->GetAngle(), GetOption(Render_ReverseZ) ? light->GetBias() : -light->GetBias());
-        m_buffer_light_cpu.color                        = light->GetColor();
-        m_buffer_light_cpu.normal_bias                  = light->GetNormalBias();
-        m_buffer_light_cpu.position                     = light->GetTransform()->GetPosition();
-        m_buffer_light_cpu.direction                    = light->GetDirection();
+        const float luminous_intensity                  = light_luminous_intensity(frame_light, m_frames[m_frame_index_render].camera.exposure);
+        m_buffer_light_cpu.intensity_range_angle_bias   = Vector4(luminous_intensity, frame_light.range, frame_light.angle, GetOption(Render_ReverseZ) ? frame_light.bias : -frame_light.bias);
+        m_buffer_light_cpu.color                        = frame_light.color;
+        m_buffer_light_cpu.normal_bias                  = frame_light.normal_bias;
+        m_buffer_light_cpu.position                     = frame_light.position;
+        m_buffer_light_cpu.direction                    = frame_light.direction;
 
         // Update
         *buffer = m_buffer_light_cpu;
@@ -578,86 +1742,229 @@ namespace Spartan
         return m_buffer_light_gpu->Unmap();
     }
 
+    bool Renderer::UpdateLightClustersBuffer()
+    {
+        // Only once per frame, the transparent light pass uses the same clusters
+        if (!m_light_clusters_dirty)
+            return true;
+
+        DrawCallsWait(m_light_clusters_counter);
+        m_light_clusters_dirty = false;
+
+        // Lights
+        const float exposure = m_frames[m_frame_index_render].camera.exposure;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_clustered_lights.size()); i++)
+        {
+            const ClusteredLight& clustered_light               = m_clustered_lights[i];
+            const FrameLight& frame_light                       = *m_clustered_frame_lights[i];
+            const bool is_spot                                  = frame_light.type == LightType::Spot;
+            m_buffer_light_clusters_cpu.position_range[i]       = Vector4(clustered_light.position, clustered_light.range);
+            m_buffer_light_clusters_cpu.color_intensity[i]      = Vector4(frame_light.color.x, frame_light.color.y, frame_light.color.z, light_luminous_intensity(frame_light, exposure));
+            m_buffer_light_clusters_cpu.direction_angle[i]      = is_spot ? Vector4(frame_light.direction, frame_light.angle) : Vector4::Zero;
+        }
+
+        // Clusters
+        const vector<uint32_t>& clusters = m_light_clusters.GetClusters();
+        memcpy(m_buffer_light_clusters_cpu.clusters, clusters.data(), clusters.size() * sizeof(uint32_t));
+
+        // Light indices, packed to 8 bits
+        const vector<uint16_t>& indices = m_light_clusters.GetIndices();
+        memset(m_buffer_light_clusters_cpu.light_indices, 0, sizeof(m_buffer_light_clusters_cpu.light_indices));
+        for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); i++)
+        {
+            m_buffer_light_clusters_cpu.light_indices[i / 4] |= static_cast<uint32_t>(indices[i]) << ((i % 4) * 8);
+        }
+
+        m_buffer_light_clusters_cpu.slice_scale = m_light_clusters.GetSliceScale();
+        m_buffer_light_clusters_cpu.slice_bias  = m_light_clusters.GetSliceBias();
+
+        // Map
+        BufferLightClusters* buffer = static_cast<BufferLightClusters*>(m_buffer_light_clusters_gpu->Map());
+        if (!buffer)
+        {
+            LOG_ERROR("Failed to map buffer");
+            return false;
+        }
+
+        // Update
+        *buffer = m_buffer_light_clusters_cpu;
+
+        // Unmap
+        return m_buffer_light_clusters_gpu->Unmap();
+    }
+
 	void Renderer::RenderablesAcquire(const Variant& entities_variant)
 	{
         SCOPED_TIME_BLOCK(m_profiler);
 
-		// Clear previous state
-		m_entities.clear();
-		m_camera = nullptr;
+        lock_guard<mutex> lock(m_entities_mutex);
+
+        // Only the entities which were added, removed or changed since the world last resolved
+        const vector<shared_ptr<Entity>>& entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
 
-		vector<shared_ptr<Entity>> entities = entities_variant.Get<vector<shared_ptr<Entity>>>();
-		for (const auto& entity : entities)
+        array<bool, 3> sort = { false, false, false };
+		for (const shared_ptr<Entity>& entity : entities)
 		{
-			if (!entity || !entity->IsActive())
+			if (!entity)
 				continue;
 
-			// Get all the components we are interested in
-            Renderable* renderable  = entity->GetComponent<Renderable>();
-            Light* light            = entity->GetComponent<Light>();
-            Camera* camera          = entity->GetComponent<Camera>();
-
-			if (renderable)
-			{
-                bool is_transparent = false;
+			// Get all the components we are interested in (removed and inactive entities have none)
+            const bool is_tracked   = entity->IsActive() && !entity->IsPendingDestruction();
+            Renderable* renderable  = is_tracked && entity->HasComponent<Renderable>() ? entity->GetRenderable() : nullptr;
+            const bool is_camera    = is_tracked && entity->HasComponent<Camera>();
 
+            bool is_transparent = false;
+            if (renderable)
+            {
                 if (const Material* material = renderable->GetMaterial())
                 {
                     is_transparent = material->GetColorAlbedo().w < 1.0f;
                 }
+            }
 
-                m_entities[is_transparent ? Renderer_Object_Transparent : Renderer_Object_Opaque].emplace_back(entity.get());
-			}
+            array<bool, 3> wanted;
+            wanted[Renderer_Object_Opaque]      = renderable && !is_transparent;
+            wanted[Renderer_Object_Transparent] = renderable && is_transparent;
+            wanted[Renderer_Object_Camera]      = is_camera;
 
-			if (light)
-			{
-				m_entities[Renderer_Object_Light].emplace_back(entity.get());
-			}
+            // Renderables which come or go, break the order
+            auto it = m_entity_proxies.find(entity.get());
+            for (const Renderer_Object_Type object_type : { Renderer_Object_Opaque, Renderer_Object_Transparent })
+            {
+                const bool is_inserted  = it != m_entity_proxies.end() && it->second.index[object_type] != m_entity_index_none;
+                sort[object_type]       = sort[object_type] || is_inserted != wanted[object_type];
+            }
 
-			if (camera)
-			{
-				m_entities[Renderer_Object_Camera].emplace_back(entity.get());
-				m_camera = camera->GetPtrShared<Camera>();
-			}
+            // Not (or no longer) something the renderer tracks
+            if (!renderable && !is_camera)
+            {
+                if (it != m_entity_proxies.end())
+                {
+                    for (uint32_t type = 0; type < static_cast<uint32_t>(m_entities.size()); type++)
+                    {
+                        EntityProxyErase(entity.get(), static_cast<Renderer_Object_Type>(type));
+                    }
+
+                    m_entities_retired.emplace_back(move(it->second.entity));
+                    m_entity_states_retired.emplace_back(move(it->second.state));
+                    m_entity_proxies.erase(it);
+                }
+
+                continue;
+            }
+
+            if (it == m_entity_proxies.end())
+            {
+                m_entity_proxies[entity.get()].entity = entity;
+            }
+
+            for (uint32_t type = 0; type < static_cast<uint32_t>(m_entities.size()); type++)
+            {
+                const Renderer_Object_Type object_type = static_cast<Renderer_Object_Type>(type);
+                if (wanted[type])
+                {
+                    EntityProxyInsert(entity.get(), object_type);
+                }
+                else
+                {
+                    EntityProxyErase(entity.get(), object_type);
+                }
+            }
 		}
 
-		RenderablesSort(&m_entities[Renderer_Object_Opaque]);
-		RenderablesSort(&m_entities[Renderer_Object_Transparent]);
+        // The last camera wins
+        const vector<Entity*>& cameras = m_entities[Renderer_Object_Camera];
+        m_camera = cameras.empty() ? nullptr : cameras.back()->GetComponent<Camera>()->GetPtrShared<Camera>();
+
+        if (sort[Renderer_Object_Opaque])
+        {
+            RenderablesSort(Renderer_Object_Opaque);
+        }
+
+        if (sort[Renderer_Object_Transparent])
+        {
+            RenderablesSort(Renderer_Object_Transparent);
+        }
 	}
 
-	void Renderer::RenderablesSort(vector<Entity*>* renderables)
+    void Renderer::EntityProxyInsert(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        uint32_t& index = m_entity_proxies[entity].index[object_type];
+        if (index != m_entity_index_none)
+            return;
+
+        vector<Entity*>& entities = m_entities[object_type];
+        index = static_cast<uint32_t>(entities.size());
+        entities.emplace_back(entity);
+    }
+
+    void Renderer::EntityProxyErase(Entity* entity, const Renderer_Object_Type object_type)
+    {
+        uint32_t& index = m_entity_proxies[entity].index[object_type];
+        if (index == m_entity_index_none)
+            return;
+
+        // Swap with the last one, the renderables are sorted again after any changes
+        vector<Entity*>& entities = m_entities[object_type];
+        Entity* entity_last = entities.back();
+        entities[index]     = entity_last;
+        m_entity_proxies[entity_last].index[object_type] = index;
+        entities.pop_back();
+
+        index = m_entity_index_none;
+    }
+
+	void Renderer::RenderablesSort(const Renderer_Object_Type object_type)
 	{
-		if (!m_camera || renderables->size() <= 2)
-			return;
+        vector<Entity*>& renderables = m_entities[object_type];
+		if (m_camera && renderables.size() > 2)
+        {
+            // Compute the distances once, instead of on every comparison
+            const Vector3 camera_position = m_camera->GetTransform()->GetPosition();
+            vector<pair<float, Entity*>> distances;
+            distances.reserve(renderables.size());
+            for (Entity* entity : renderables)
+            {
+                Renderable* renderable = entity->GetRenderable();
+                distances.emplace_back(renderable ? (renderable->GetAabb().GetCenter() - camera_position).LengthSquared() : 0.0f, entity);
+            }
 
-		auto comparison_op = [this](Entity* entity)
-		{
-			auto renderable = entity->GetRenderable();
-			if (!renderable)
-				return 0.0f;
+		    // Sort by depth (front to back)
+		    sort(distances.begin(), distances.end(), [](const pair<float, Entity*>& a, const pair<float, Entity*>& b)
+		    {
+                return a.first < b.first;
+		    });
 
-			return (renderable->GetAabb().GetCenter() - m_camera->GetTransform()->GetPosition()).LengthSquared();
-		};
+            for (uint32_t i = 0; i < static_cast<uint32_t>(distances.size()); i++)
+            {
+                renderables[i] = distances[i].second;
+            }
+        }
 
-		// Sort by depth (front to back)
-		sort(renderables->begin(), renderables->end(), [&comparison_op](Entity* a, Entity* b)
-		{
-            return comparison_op(a) < comparison_op(b);
-		});
+        // The proxies have to know where their entities went
+        for (uint32_t i = 0; i < static_cast<uint32_t>(renderables.size()); i++)
+        {
+            m_entity_proxies[renderables[i]].index[object_type] = i;
+        }
 	}
 
     void Renderer::ClearEntities()
     {
-        m_rhi_device->Queue_WaitAll();
+        // The captured frames can still be using them, so they are handed over to the next one
+        lock_guard<mutex> lock(m_entities_mutex);
+        for (auto& it : m_entity_proxies)
+        {
+            m_entities_retired.emplace_back(move(it.second.entity));
+            m_entity_states_retired.emplace_back(move(it.second.state));
+        }
+        m_entity_proxies.clear();
 
-        // light depth buffers might be used by the command list
-        if (!m_swap_chain->GetCmdList()->Reset())
+        for (vector<Entity*>& entities : m_entities)
         {
-            LOG_ERROR("Failed to reset command pool");
-            return;
+            entities.clear();
         }
 
-        m_entities.clear();
+        m_camera = nullptr;
     }
 
     const shared_ptr<Spartan::RHI_Texture>& Renderer::GetEnvironmentTexture()
@@ -702,6 +2009,10 @@ namespace Spartan
         {
             value = Helper::Clamp(value, static_cast<float>(m_resolution_shadow_min), static_cast<float>(m_rhi_device->GetContextRhi()->max_texture_dimension_2d));
         }
+        else if (option == Option_Value_TextureStreamingBudget)
+        {
+            value = Helper::Max(value, 0.0f);
+        }
 
         if (m_option_values[option] == value)
             return;
@@ -711,15 +2022,8 @@ namespace Spartan
         // Shadow resolution handling
         if (option == Option_Value_ShadowResolution)
         {
-            const auto& light_entities = m_entities[Renderer_Object_Light];
-            for (const auto& light_entity : light_entities)
-            {
-                auto light = light_entity->GetComponent<Light>();
-                if (light->GetShadowsEnabled())
-                {
-                    light->CreateShadowMap();
-                }
-            }
+            CreateShadowAtlas();
+            m_shadow_maps_dirty = true; // the lights are walked on the next capture
         }
     }
 
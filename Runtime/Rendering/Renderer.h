@@ -25,9 +25,16 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unordered_map>
 #include <array>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "Renderer_ConstantBuffers.h"
+#include "Renderer_Frame.h"
+#include "ShadowAtlas.h"
+#include "TextureStreamer.h"
 #include "Material.h"
 #include "../Core/ISubsystem.h"
+#include "../Threading/Task.h"
 #include "../Math/Rectangle.h"
 #include "../RHI/RHI_Definition.h"
 #include "../RHI/RHI_Viewport.h"
@@ -46,6 +53,7 @@ namespace Spartan
 	class Grid;
 	class Transform_Gizmo;
 	class Profiler;
+    class Threading;
 
 	namespace Math
 	{
@@ -79,7 +87,9 @@ namespace Spartan
 		Render_ChromaticAberration	    = 1 << 21,
 		Render_Dithering			    = 1 << 22,
         Render_ReverseZ                 = 1 << 23,
-        Render_DepthPrepass             = 1 << 24
+        Render_DepthPrepass             = 1 << 24,
+        Render_OcclusionCulling         = 1 << 25,
+        Render_ClusterCulling           = 1 << 26
 	};
 
     enum Renderer_Option_Value
@@ -89,7 +99,8 @@ namespace Spartan
         Option_Value_Tonemapping,
         Option_Value_Gamma,
         Option_Value_Bloom_Intensity,
-        Option_Value_Sharpen_Strength
+        Option_Value_Sharpen_Strength,
+        Option_Value_TextureStreamingBudget // in megabytes
     };
 
     enum Renderer_ToneMapping_Type
@@ -104,16 +115,23 @@ namespace Spartan
 	{
 		Renderer_Object_Opaque,
 		Renderer_Object_Transparent,
-        Renderer_Object_Light,
 		Renderer_Object_Camera
 	};
 
 	enum Renderer_Shader_Type
 	{
 		Shader_Gbuffer_V,
+        Shader_Gbuffer_Instanced_V,
+        Shader_Gbuffer_Quantized_V,
+        Shader_Gbuffer_Instanced_Quantized_V,
         Shader_Gbuffer_P,
 		Shader_Depth_V,
+        Shader_Depth_Instanced_V,
+        Shader_Depth_Quantized_V,
+        Shader_Depth_Instanced_Quantized_V,
         Shader_Depth_P,
+        Shader_ShadowAtlas_Copy_P,
+        Shader_ShadowAtlas_Clear_P,
 		Shader_Quad_V,
 		Shader_Texture_P,
         Shader_Copy_C,
@@ -152,6 +170,7 @@ namespace Spartan
         Shader_Hbao_IndirectBounce_P,
         Shader_Ssr_P,
 		Shader_Entity_V,
+        Shader_Entity_Quantized_V,
         Shader_Entity_Transform_P,
 		Shader_BlurBox_P,
 		Shader_BlurGaussian_P,
@@ -182,6 +201,46 @@ namespace Spartan
         RenderTarget_Hbao                           = 1 << 18,
         RenderTarget_Ssr                            = 1 << 19,
         RenderTarget_TaaHistory                     = 1 << 20,
+        RenderTarget_Shadow_Atlas_Depth             = 1 << 21,
+        RenderTarget_Shadow_Atlas_Depth_Static      = 1 << 22,
+        RenderTarget_Shadow_Atlas_Color             = 1 << 23,
+    };
+
+    // The texture streamer's store for the renderer's textures, it re-creates them on the GPU with the resident mips.
+    // The file is read and the resource is created on the job system, the new one is swapped in at the start of the frame after it's ready.
+    // The resources they replace are released once the frames in flight, which can still be sampling them, are done.
+    class SPARTAN_CLASS TextureStoreGpu : public ITextureStore
+    {
+    public:
+        void Add(const std::shared_ptr<RHI_Texture>& texture);
+        void SetFramesInFlight(const uint32_t frame_count) { m_frames_in_flight = frame_count; }
+        void SetThreading(Threading* threading) { m_threading = threading; }
+        void BeginFrame(uint64_t frame);
+        void Clear();
+
+        //= ITextureStore ==================================================
+        bool IsValid(uint32_t texture_id) const override;
+        bool SetMipResident(uint32_t texture_id, uint32_t mip) override;
+        //==================================================================
+
+    private:
+        struct Stream
+        {
+            std::shared_ptr<RHI_Texture> texture;
+            std::shared_ptr<RHI_Texture> texture_staged; // written by the job, read once the counter is done
+            uint32_t mip        = 0;
+            uint32_t mip_next   = 0; // what was asked for while the job was running
+            TaskCounter counter;
+        };
+
+        void StreamStart(Stream& stream);
+
+        mutable std::unordered_map<uint32_t, std::weak_ptr<RHI_Texture>> m_textures; // expired entries are pruned when they are found
+        std::unordered_map<uint32_t, Stream> m_streams; // elements don't move, so the jobs can write to them
+        std::vector<std::pair<uint64_t, std::shared_ptr<RHI_Texture>>> m_textures_retired; // with the frame they were retired in
+        Threading* m_threading      = nullptr;
+        uint64_t m_frame            = 0;
+        uint32_t m_frames_in_flight = 3;
     };
 
 	class SPARTAN_CLASS Renderer : public ISubsystem
@@ -242,6 +301,10 @@ namespace Spartan
         bool Present();
         bool Flush();
 
+        // Render thread
+        void Render();      // Records the last captured frame on the render thread (returns immediately)
+        void RenderWait();  // Blocks until the render thread is done recording
+
         // Misc
         const std::shared_ptr<RHI_Device>& GetRhiDevice()   const { return m_rhi_device; } 
         RHI_PipelineCache* GetPipelineCache()               const { return m_pipeline_cache.get(); }
@@ -270,10 +333,23 @@ namespace Spartan
 		void CreateShaders();
 		void CreateSamplers();
 		void CreateRenderTextures();
+        void CreateShadowAtlas();
+
+        // Render thread
+        void RenderThreadLoop();
+        void RenderFrame(RHI_CommandList* cmd_list);
+        bool FrameCapture(FrameSnapshot& frame);
+        void FrameCaptureViews(FrameSnapshot& frame);
+        void DrawCallsPrepare();
+        void LightClustersPrepare();
+        void ShadowAtlasPrepare();
+        void TextureStreamingPrepare();
+        void DrawCallsWait(const TaskCounter& counter) const;
 
 		// Passes
 		void Pass_Main(RHI_CommandList* cmd_list);
 		void Pass_LightDepth(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type);
+        void Pass_ShadowAtlas(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type);
         void Pass_DepthPrePass(RHI_CommandList* cmd_list);
 		void Pass_GBuffer(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type);
 		void Pass_Hbao(RHI_CommandList* cmd_list, const bool use_stencil);
@@ -308,13 +384,24 @@ namespace Spartan
         // Constant buffers
         bool UpdateFrameBuffer();
         bool UpdateMaterialBuffer();
+        uint32_t MaterialTableIndex(uint32_t material_id);
         bool UpdateUberBuffer(RHI_CommandList* cmd_list);
         bool UpdateObjectBuffer(RHI_CommandList* cmd_list);
-        bool UpdateLightBuffer(const Light* light);
+        bool UpdateInstanceBuffer(RHI_CommandList* cmd_list, uint32_t instance_count);
+        bool UpdateLightBuffer(const FrameLight& frame_light);
+        bool UpdateLightClustersBuffer();
+
+        // The vertex shader of a pass which draws models (Shader_Gbuffer_V, Shader_Depth_V or Shader_Entity_V) for instanced and/or quantized geometry
+        RHI_Shader* GetShaderVertex(Renderer_Shader_Type type, bool instanced, bool quantized) const;
+
+        // Draws a batch of a draw list, a single draw call with index ranges draws the ones which survived cluster culling
+        void DrawBatch(RHI_CommandList* cmd_list, const FrameDrawList& draw_list, const FrameDrawBatch& batch) const;
 
         // Misc
-        void RenderablesAcquire(const Variant& renderables);
-        void RenderablesSort(std::vector<Entity*>* renderables);
+        void RenderablesAcquire(const Variant& entities_variant);
+        void RenderablesSort(const Renderer_Object_Type object_type);
+        void EntityProxyInsert(Entity* entity, const Renderer_Object_Type object_type);
+        void EntityProxyErase(Entity* entity, const Renderer_Object_Type object_type);
         void ClearEntities();
 
         // Render textures
@@ -340,6 +427,7 @@ namespace Spartan
 		std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_w;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_r;
         std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_on_w;
+        std::shared_ptr<RHI_DepthStencilState> m_depth_stencil_on_off_w_always;
 
         // Blend states 
         std::shared_ptr<RHI_BlendState> m_blend_disabled;
@@ -367,6 +455,7 @@ namespace Spartan
 		std::shared_ptr<RHI_VertexBuffer> m_vertex_buffer_lines;
 		std::vector<RHI_Vertex_PosCol> m_lines_list_depth_enabled;
 		std::vector<RHI_Vertex_PosCol> m_lines_list_depth_disabled;
+        std::mutex m_lines_mutex; // the physics debug draw adds lines off the main thread, alongside the world
 
         // Gizmos
 		std::unique_ptr<Transform_Gizmo> m_gizmo_transform;
@@ -405,6 +494,7 @@ namespace Spartan
         BufferFrame m_buffer_frame_cpu;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_frame_gpu;
 
+        BufferMaterial m_buffer_material_cpu;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_material_gpu;
 
         BufferUber m_buffer_uber_cpu;
@@ -417,14 +507,87 @@ namespace Spartan
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_object_gpu;
         uint32_t m_buffer_object_offset_index = 0;
 
+        BufferInstances m_buffer_instances_cpu;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_instances_gpu;
+        uint32_t m_buffer_instances_offset_index = 0;
+
         BufferLight m_buffer_light_cpu;
         BufferLight m_buffer_light_cpu_previous;
         std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_gpu;
+
+        BufferLightClusters m_buffer_light_clusters_cpu;
+        std::shared_ptr<RHI_ConstantBuffer> m_buffer_light_clusters_gpu;
         //========================================================
 
-        // Entities and material references
-        std::unordered_map<Renderer_Object_Type, std::vector<Entity*>> m_entities;
-        std::array<Material*, m_max_material_instances> m_material_instances;
+        // Entities, indexed by Renderer_Object_Type. They are kept across frames and only the entities which the world
+        // reports as added, removed or changed are (re)classified, each one's proxy knows where it is so removing doesn't search.
+        struct EntityProxy
+        {
+            std::shared_ptr<Entity> entity; // keeps it alive, it's handed over to a captured frame once the proxy is erased
+            std::unique_ptr<FrameEntityState> state = std::make_unique<FrameEntityState>(); // handed over along with the entity
+            std::array<uint32_t, 3> index   = { m_entity_index_none, m_entity_index_none, m_entity_index_none };
+
+            // Where the last capture put the renderable, the spatial index only knows the entity
+            uint64_t frame_capture                  = 0;
+            Renderer_Object_Type frame_object_type  = Renderer_Object_Opaque;
+            uint32_t frame_index                    = m_entity_index_none;
+        };
+        static const uint32_t m_entity_index_none = 0xFFFFFFFF;
+        std::array<std::vector<Entity*>, 3> m_entities; // lights aren't tracked, they are captured from the world's pool
+        std::unordered_map<const Entity*, EntityProxy> m_entity_proxies;
+        std::vector<std::shared_ptr<Entity>> m_entities_retired; // erased since the last frame capture
+        std::vector<std::unique_ptr<FrameEntityState>> m_entity_states_retired;
+        std::mutex m_entities_mutex;
+
+        // Material table, the rows of m_buffer_material_cpu and which material (and version of it) they hold.
+        // Row 0 is reserved for the sky. A row can be taken over by another material once it's no longer drawn.
+        // Only the render thread touches the table, materials themselves don't know their row.
+        struct MaterialTableRow
+        {
+            uint32_t material_id    = 0;
+            uint32_t version        = 0;
+            uint64_t frame_used     = 0;
+        };
+        std::array<MaterialTableRow, m_max_material_instances> m_material_table;
+        std::unordered_map<uint32_t, uint32_t> m_material_table_rows; // material id to the row it holds
+        uint32_t m_material_table_cursor = 1;
+        std::unordered_map<uint32_t, uint32_t> m_frame_materials; // material id to its index in the captured snapshot's materials
+
+        // Frame snapshots, the simulation captures one while the render thread records the other
+        std::array<FrameSnapshot, 2> m_frames;
+        uint32_t m_frame_index_capture  = 0;
+        uint32_t m_frame_index_render   = 1;
+        bool m_frame_captured           = false;
+        uint64_t m_frame_captures       = 0;
+
+        // Render thread
+        std::thread m_render_thread;
+        std::mutex m_render_mutex;
+        std::condition_variable m_render_condition;
+        bool m_render_requested = false;
+        bool m_render_stopping  = false;
+
+        // Draw lists, culled and transformed on the job system while the passes before the ones using them are recording
+        std::array<std::vector<FrameDrawList>, 2> m_draw_lists_light; // per object type, per light and shadow view
+        std::array<FrameDrawList, 2> m_draw_lists_camera;             // per object type
+        TaskCounter m_draw_calls_counter;
+
+        // Clustered lighting, the lights are binned on the job system while the passes before the light pass are recording
+        LightClusters m_light_clusters;
+        std::vector<ClusteredLight> m_clustered_lights;
+        std::vector<const FrameLight*> m_clustered_frame_lights;   // the frame lights which m_clustered_lights were made from
+        TaskCounter m_light_clusters_counter;
+        bool m_light_clusters_dirty = false;                        // the GPU buffer has to be updated
+
+        // Shadow atlas, the shadows of point and spot lights
+        ShadowAtlas m_shadow_atlas;
+        std::vector<ShadowAtlasRequest> m_shadow_atlas_requests;
+        std::atomic<bool> m_shadow_maps_dirty  = false;             // the shadow resolution changed, so the lights have to re-create their shadow maps
+        std::atomic<bool> m_shadow_atlas_dirty = true;              // the textures were (re)created, so the tiles have to be reset
+
+        // Texture streaming, the textures of the renderables' materials get as many mips as they need, within a budget
+        TextureStreamer m_texture_streamer;
+        TextureStoreGpu m_texture_store;
         
         std::shared_ptr<Camera> m_camera;
 
@@ -437,5 +600,6 @@ namespace Spartan
         // Dependencies
         Profiler* m_profiler            = nullptr;
         ResourceCache* m_resource_cache = nullptr;
+        Threading* m_threading          = nullptr;
     };
 }
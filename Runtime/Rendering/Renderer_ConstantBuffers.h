@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "..\Math\Vector2.h"
 #include "..\Math\Vector3.h"
 #include "..\Math\Matrix.h"
+#include "LightClusters.h"
 //==========================
 
 namespace Spartan
@@ -68,10 +69,13 @@ namespace Spartan
         Math::Vector2 taa_jitter_offset;
     };
     
-    // Low frequency buffer - Updates once per frame
-    static const uint32_t m_max_material_instances = 1024; // must match the shader
+    // Low frequency buffer - A persistent table which is only updated when a material changes, draws index it with the material's row
+    static const uint32_t m_max_material_instances = 512; // must match the shader
     struct BufferMaterial
     {
+        Math::Vector4 mat_color[m_max_material_instances];
+        Math::Vector4 mat_tiling_offset[m_max_material_instances];
+        Math::Vector4 mat_roughness_metallic_normal_height[m_max_material_instances];
         Math::Vector4 mat_clearcoat_clearcoatRough_anis_anisRot[m_max_material_instances];
         Math::Vector4 mat_sheen_sheenTint_pad[m_max_material_instances];
     };
@@ -94,26 +98,13 @@ namespace Spartan
         Math::Vector2 mat_tiling_uv;
         Math::Vector2 mat_offset_uv;
 
-        float mat_roughness_mul;
-        float mat_metallic_mul;
-        float mat_normal_mul;
-        float mat_height_mul;
-
-        float mat_id;
-        Math::Vector3 padding;
-
         bool operator==(const BufferUber& rhs) const
         {
             return
                 transform           == rhs.transform            &&
-                mat_id              == rhs.mat_id               &&
                 mat_albedo          == rhs.mat_albedo           &&
                 mat_tiling_uv       == rhs.mat_tiling_uv        &&
                 mat_offset_uv       == rhs.mat_offset_uv        &&
-                mat_roughness_mul   == rhs.mat_roughness_mul    &&
-                mat_metallic_mul    == rhs.mat_metallic_mul     &&
-                mat_normal_mul      == rhs.mat_normal_mul       &&
-                mat_height_mul      == rhs.mat_height_mul       &&
                 color               == rhs.color                &&
                 transform_axis      == rhs.transform_axis       &&
                 blur_sigma          == rhs.blur_sigma           &&
@@ -130,22 +121,48 @@ namespace Spartan
         Math::Matrix object;
         Math::Matrix wvp_current;
         Math::Matrix wvp_previous;
+
+        uint32_t material_index = 0; // the row of the material table
+        Math::Vector3 padding;
     
         bool operator==(const BufferObject& rhs) const
         {
             return
                 object          == rhs.object       &&
                 wvp_current     == rhs.wvp_current  &&
-                wvp_previous    == rhs.wvp_previous;
+                wvp_previous    == rhs.wvp_previous &&
+                material_index  == rhs.material_index;
         }
 
         bool operator!=(const BufferObject& rhs) const { return !(*this == rhs); }
     };
+
+    // High frequency - Updates once per instanced draw
+    static const uint32_t m_max_instances = 64; // must match the shader
+    struct BufferInstances
+    {
+        BufferObject instances[m_max_instances];
+    };
     
+    // Low frequency - Updates once per frame, the point and spot lights without shadows and the clusters they are binned into
+    static const uint32_t m_max_clustered_lights = 256; // must match the shader, light indices are 8 bits on the GPU
+    struct BufferLightClusters
+    {
+        Math::Vector4 position_range[m_max_clustered_lights];
+        Math::Vector4 color_intensity[m_max_clustered_lights];
+        Math::Vector4 direction_angle[m_max_clustered_lights];
+        uint32_t clusters[m_cluster_count];
+        uint32_t light_indices[m_cluster_light_indices_max / 4];
+        float slice_scale;
+        float slice_bias;
+        Math::Vector2 padding;
+    };
+
     // Light buffer
     struct BufferLight
     {
         Math::Matrix view_projection[6];
+        Math::Vector4 atlas_rects[6];
         Math::Vector4 intensity_range_angle_bias;
         Math::Vector3 color;
         float normal_bias;
@@ -156,6 +173,7 @@ namespace Spartan
         {
             return
                 view_projection             == rhs.view_projection              &&
+                atlas_rects                 == rhs.atlas_rects                  &&
                 intensity_range_angle_bias  == rhs.intensity_range_angle_bias   &&
                 normal_bias                 == rhs.normal_bias                  &&
                 color                       == rhs.color                        &&
@@ -0,0 +1,261 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES ===============================
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include "../Math/Matrix.h"
+#include "../Math/Vector2.h"
+#include "../Math/Vector3.h"
+#include "../Math/Frustum.h"
+#include "../Math/BoundingBox.h"
+#include "../RHI/RHI_Vertex.h"
+#include "../RHI/RHI_Definition.h"
+#include "../World/Components/Light.h"
+#include "Material.h"
+//==========================================
+
+namespace Spartan
+{
+    class Entity;
+    class Transform;
+    class Material;
+    class Model;
+    class Camera;
+
+    static const uint32_t m_max_shadow_views = 6; // cascades or cube faces, per light
+
+    // Occlusion culling, per view
+    static const uint32_t m_occlusion_buffer_width          = 256;
+    static const uint32_t m_occlusion_buffer_height         = 128;
+    static const uint32_t m_occluders_max                   = 16;
+    static const uint32_t m_occluder_triangles_max          = 4096;
+    static constexpr float m_occluder_screen_coverage_min   = 0.02f;
+
+    // The simulation captures what the renderer needs into a FrameSnapshot, at the end of every frame.
+    // The render thread records the snapshot while the simulation of the next frame is running, so the
+    // snapshot must not be read through any of the live data (transforms, aabbs, lights, materials) it was captured from.
+
+    // What the renderer needs of a material, captured once per frame for all the renderables which share it
+    struct FrameMaterial
+    {
+        float GetProperty(const Material_Property type) const   { return properties[material_property_index(type)]; }
+        bool HasTexture(const Material_Property type) const     { return flags & type; }
+        RHI_Texture* GetTexture(const Material_Property type) const { return HasTexture(type) ? textures[material_property_index(type)].get() : nullptr; }
+
+        uint32_t id                 = 0;
+        uint32_t version            = 0;
+        uint16_t flags              = 0;
+        Math::Vector4 color         = Math::Vector4::One;
+        Math::Vector2 tiling        = Math::Vector2::One;
+        Math::Vector2 offset        = Math::Vector2::Zero;
+        std::array<float, m_material_property_count> properties = {};
+        std::array<std::shared_ptr<RHI_Texture>, m_material_property_count> textures; // copies, so they stay alive if the material's slots are changed
+        uint32_t table_index        = 0; // the row in the material table, assigned by the render thread
+    };
+
+    // What the render thread keeps of an entity from one frame to the next. It lives in the renderer's entity proxy,
+    // and once the proxy is erased, in the frames captured before, so a snapshot can point to it.
+    struct FrameEntityState
+    {
+        Math::Matrix wvp_previous   = Math::Matrix::Identity; // for the velocity
+        bool wvp_previous_valid     = false;                  // it hasn't been drawn yet
+    };
+
+    struct FrameRenderable
+    {
+        Entity* entity              = nullptr; // identity only
+        FrameEntityState* state     = nullptr; // only the render thread touches it
+        std::shared_ptr<const Model> model;    // a copy, for the CPU geometry (the occluder's mesh and the meshlets)
+        const FrameMaterial* material = nullptr; // in the snapshot's materials
+        uint32_t material_index     = 0;       // the material's row in the material table, copied from the above by the render thread
+        std::shared_ptr<RHI_VertexBuffer> vertex_buffer; // copies, so they stay alive if the model re-creates them
+        std::shared_ptr<RHI_IndexBuffer> index_buffer;
+        uint32_t geometry_id        = 0;       // the model's id
+        bool quantized              = false;   // whether the model's vertices are quantized
+        Math::Matrix matrix         = Math::Matrix::Identity;
+        Math::Matrix matrix_vertex  = Math::Matrix::Identity; // what the vertex shaders get, the model's vertex dequantization followed by the world matrix
+        Math::BoundingBox aabb;
+        uint32_t index_offset       = 0;
+        uint32_t index_count        = 0;
+        uint32_t vertex_offset      = 0;
+        uint32_t vertex_count       = 0;
+        bool cast_shadows           = true;
+        bool occluder               = false; // opaque, without a mask and with few enough triangles to be rasterized on the CPU
+    };
+
+    struct FrameLight
+    {
+        Entity* entity                  = nullptr; // identity only
+        uint32_t id                     = 0;       // the light component's id
+        LightType type                  = LightType::Directional;
+        ShadowMap shadow_map;                      // a copy, so the textures stay alive if the light re-creates them
+        uint32_t shadow_array_size      = 0;
+        std::array<Math::Matrix, m_max_shadow_views> view_projection;
+        Math::Vector3 position          = Math::Vector3::Zero;
+        Math::Vector3 direction         = Math::Vector3::Zero;
+        Math::Vector3 forward           = Math::Vector3::Zero;
+        Math::Vector2 position_screen   = Math::Vector2::Zero;
+        bool icon_visible               = false;
+        bool clustered                  = false;   // shaded in the clustered pass, along with the other point and spot lights without shadows
+
+        // Properties which are edited outside of the simulation (e.g. by the editor)
+        Math::Vector4 color             = Math::Vector4::One;
+        float intensity                 = 0.0f;
+        float range                     = 0.0f;
+        float angle                     = 0.0f;
+        float bias                      = 0.0f;
+        float normal_bias               = 0.0f;
+        bool shadows_enabled            = false;
+        bool shadows_transparent_enabled    = false;
+        bool shadows_screen_space_enabled   = false;
+        bool volumetric_enabled         = false;
+    };
+
+    struct FrameCamera
+    {
+        std::shared_ptr<Camera> camera;
+        Math::Matrix view               = Math::Matrix::Identity;
+        Math::Matrix projection         = Math::Matrix::Identity;
+        Math::Frustum frustum;
+        Math::Vector3 position          = Math::Vector3::Zero;
+        Math::Vector3 forward           = Math::Vector3::Zero;
+        float near_plane                = 0.0f;
+        float far_plane                 = 0.0f;
+        float aperture                  = 0.0f;
+        float shutter_speed             = 0.0f;
+        float iso                       = 0.0f;
+        float exposure                  = 0.0f;
+    };
+
+    // A draw which has been culled and transformed ahead of recording (by the job system)
+    struct FrameDrawCall
+    {
+        const FrameRenderable* renderable   = nullptr;
+        Math::Matrix transform              = Math::Matrix::Identity;
+        uint32_t range_first                = 0; // the index ranges which survived cluster culling, in the draw list's ranges
+        uint32_t range_count                = 0; // zero means the renderable's whole index range
+    };
+
+    // Part of a renderable's index range, made of the meshlets which survived cluster culling
+    struct FrameDrawRange
+    {
+        uint32_t index_offset   = 0;
+        uint32_t index_count    = 0;
+    };
+
+    // Draw calls are sorted by a 64-bit key, so that the ones which share state end up next to each other.
+    // From the most to the least significant bits: shader variation (whether the geometry is quantized and the material's flags, 16 bits),
+    // material (16, its table row), geometry (16), mesh (8, the index range within the geometry) and depth (8). The depth is the renderable's
+    // index, scaled to 8 bits, since the snapshot's renderables are already sorted front to back.
+    static const uint32_t m_draw_key_shift_variation  = 48;
+    static const uint32_t m_draw_key_shift_quantized  = 62; // above the material's flags
+    static const uint32_t m_draw_key_shift_material   = 32;
+    static const uint32_t m_draw_key_shift_geometry   = 16;
+    static const uint32_t m_draw_key_shift_mesh       = 8;
+    static const uint64_t m_draw_key_mask_field       = 0xFFFF;
+
+    // A range of draw calls which share the same mesh and material, and are drawn as instances of one draw (draw calls with index ranges are never instanced)
+    struct FrameDrawBatch
+    {
+        uint32_t first  = 0;
+        uint32_t count  = 0;
+    };
+
+    // What a view (the camera or one of a light's shadow views) has to draw
+    struct FrameDrawList
+    {
+        std::vector<uint32_t> visible; // indices of the renderables which are inside the view's frustum
+        std::vector<FrameDrawCall> draw_calls; // sorted by state, see the draw key above
+        std::vector<FrameDrawBatch> batches; // within every shader variation, the single draws come before the instanced ones
+        std::vector<FrameDrawRange> ranges;
+
+        // State changes which the sorting saved, compared to drawing in the order of the renderables.
+        // Geometry can come out negative, when a model's meshes have different materials.
+        int32_t binds_saved_pipeline    = 0;
+        int32_t binds_saved_material    = 0;
+        int32_t binds_saved_buffer      = 0;
+
+        // Triangles of the visible renderables which were rejected by cluster culling
+        uint32_t triangles_culled       = 0;
+    };
+
+    // The renderables in a view (the camera or one of a light's shadow views), found through the world's spatial index
+    struct FrameView
+    {
+        std::array<std::vector<uint32_t>, 2> visible; // indices of the renderables, per object type
+    };
+
+    struct FrameSnapshot
+    {
+        void Clear()
+        {
+            entities_retired.clear();
+            entity_states_retired.clear();
+            renderables[0].clear();
+            renderables[1].clear();
+            for (FrameView& view : views)
+            {
+                view.visible[0].clear();
+                view.visible[1].clear();
+            }
+            materials.clear();
+            lights.clear();
+            lines_depth_enabled.clear();
+            lines_depth_disabled.clear();
+            metrics.clear();
+            camera                      = FrameCamera();
+            outline                     = FrameRenderable();
+            outline_visible             = false;
+            grid_transform              = Math::Matrix::Identity;
+            gizmo_transform_visible     = false;
+        }
+
+        // Entities which the renderer stopped tracking before this frame was captured. The frames before it can still
+        // reference them, and this one is released after them, so it keeps them (and their components) alive until then.
+        std::vector<std::shared_ptr<Entity>> entities_retired;
+        std::vector<std::unique_ptr<FrameEntityState>> entity_states_retired;
+
+        // Indexed by Renderer_Object_Opaque and Renderer_Object_Transparent, sorted front to back
+        std::array<std::vector<FrameRenderable>, 2> renderables;
+        std::vector<FrameView> views; // the camera's, followed by m_max_shadow_views for every light
+        std::vector<FrameMaterial> materials; // reserved up front, the renderables point into it
+        std::vector<FrameLight> lights;
+        FrameCamera camera;
+
+        // Time
+        float delta_time    = 0.0f;
+        float time          = 0.0f;
+
+        // Debug
+        std::vector<RHI_Vertex_PosCol> lines_depth_enabled;
+        std::vector<RHI_Vertex_PosCol> lines_depth_disabled;
+        std::string metrics;
+        FrameRenderable outline;
+        bool outline_visible            = false;
+        Math::Matrix grid_transform     = Math::Matrix::Identity;
+        bool gizmo_transform_visible    = false;
+    };
+}
@@ -48,6 +48,39 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    RHI_Shader* Renderer::GetShaderVertex(const Renderer_Shader_Type type, const bool instanced, const bool quantized) const
+    {
+        switch (type)
+        {
+            case Shader_Gbuffer_V:
+                return m_shaders.at(quantized ? (instanced ? Shader_Gbuffer_Instanced_Quantized_V : Shader_Gbuffer_Quantized_V) : (instanced ? Shader_Gbuffer_Instanced_V : Shader_Gbuffer_V)).get();
+            case Shader_Depth_V:
+                return m_shaders.at(quantized ? (instanced ? Shader_Depth_Instanced_Quantized_V : Shader_Depth_Quantized_V) : (instanced ? Shader_Depth_Instanced_V : Shader_Depth_V)).get();
+            case Shader_Entity_V:
+                return m_shaders.at(quantized ? Shader_Entity_Quantized_V : Shader_Entity_V).get();
+            default:
+                return m_shaders.at(type).get();
+        }
+    }
+
+    void Renderer::DrawBatch(RHI_CommandList* cmd_list, const FrameDrawList& draw_list, const FrameDrawBatch& batch) const
+    {
+        const FrameDrawCall& draw_call      = draw_list.draw_calls[batch.first];
+        const FrameRenderable& renderable   = *draw_call.renderable;
+
+        if (draw_call.range_count == 0)
+        {
+            cmd_list->DrawIndexed(renderable.index_count, renderable.index_offset, renderable.vertex_offset, batch.count);
+            return;
+        }
+
+        for (uint32_t i = draw_call.range_first; i < draw_call.range_first + draw_call.range_count; i++)
+        {
+            const FrameDrawRange& range = draw_list.ranges[i];
+            cmd_list->DrawIndexed(range.index_count, range.index_offset, renderable.vertex_offset);
+        }
+    }
+
     void Renderer::SetGlobalSamplersAndConstantBuffers(RHI_CommandList* cmd_list) const
     {
         // Constant buffers
@@ -56,6 +89,8 @@ namespace Spartan
         cmd_list->SetConstantBuffer(2, RHI_Shader_Vertex | RHI_Shader_Pixel | RHI_Shader_Compute, m_buffer_uber_gpu);
         cmd_list->SetConstantBuffer(3, RHI_Shader_Vertex | RHI_Shader_Compute, m_buffer_object_gpu);
         cmd_list->SetConstantBuffer(4, RHI_Shader_Pixel, m_buffer_light_gpu);
+        cmd_list->SetConstantBuffer(5, RHI_Shader_Vertex, m_buffer_instances_gpu);
+        cmd_list->SetConstantBuffer(6, RHI_Shader_Pixel, m_buffer_light_clusters_gpu);
         
         // Samplers
         cmd_list->SetSampler(0, m_sampler_compare_depth);
@@ -76,18 +111,35 @@ namespace Spartan
 
         // Updates onces, used almost everywhere
         UpdateFrameBuffer();
+
+        // Assigns the material table rows which the draw calls are keyed with, so it has to happen before they are prepared
+        UpdateMaterialBuffer();
+
+        // Cull and transform draw calls on the job system, the passes which need them wait (as late as possible)
+        DrawCallsPrepare();
+
+        // Bin the unshadowed lights into clusters on the job system, the light pass waits for them
+        LightClustersPrepare();
+
+        // Fit the shadowed point and spot lights into the shadow atlas, and find out which casters are static
+        ShadowAtlasPrepare();
+
+        // Stream the mips of the visible textures in and out, before the passes bind them
+        TextureStreamingPrepare();
         
         // Runs only once
         Pass_BrdfSpecularLut(cmd_list);
         
-        const bool draw_transparent_objects = !m_entities[Renderer_Object_Transparent].empty();
+        const bool draw_transparent_objects = !m_frames[m_frame_index_render].renderables[Renderer_Object_Transparent].empty();
         
         // Depth
         {
             Pass_LightDepth(cmd_list, Renderer_Object_Opaque);
+            Pass_ShadowAtlas(cmd_list, Renderer_Object_Opaque);
             if (draw_transparent_objects)
             {
                 Pass_LightDepth(cmd_list, Renderer_Object_Transparent);
+                Pass_ShadowAtlas(cmd_list, Renderer_Object_Transparent);
             }
         
             if (GetOption(Render_DepthPrepass))
@@ -129,51 +181,57 @@ namespace Spartan
             Pass_DebugBuffer(cmd_list, m_render_targets[RenderTarget_Ldr]);
             Pass_Text(cmd_list, m_render_targets[RenderTarget_Ldr].get());
         }
+
+        // Passes can skip waiting (e.g. a shader is still compiling), the tasks must not outlive the frame they read from
+        DrawCallsWait(m_draw_calls_counter);
 	}
 
 	void Renderer::Pass_LightDepth(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type)
 	{
-        // All opaque objects are rendered from the lights point of view.
+        // All opaque objects are rendered from the directional lights point of view (point and spot lights use the atlas, see Pass_ShadowAtlas).
         // Opaque objects write their depth information to a depth buffer, using just a vertex shader.
         // Transparent objects, read the opaque depth but don't write their own, instead, they write their color information using a pixel shader.
 
 		// Acquire shader
-		RHI_Shader* shader_v = m_shaders[Shader_Depth_V].get();
-        RHI_Shader* shader_p = m_shaders[Shader_Depth_P].get();
-		if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
+		RHI_Shader* shader_v            = m_shaders[Shader_Depth_V].get();
+        RHI_Shader* shader_v_instanced  = m_shaders[Shader_Depth_Instanced_V].get();
+        RHI_Shader* shader_p            = m_shaders[Shader_Depth_P].get();
+		if (!shader_v->IsCompiled() || !shader_v_instanced->IsCompiled() || !shader_p->IsCompiled())
 			return;
 
-        // Get entities
-        const auto& entities = m_entities[object_type];
-        if (entities.empty())
+        // Get renderables
+        const FrameSnapshot& frame  = m_frames[m_frame_index_render];
+        const auto& renderables     = frame.renderables[object_type];
+        if (renderables.empty())
             return;
 
         const bool transparent_pass = object_type == Renderer_Object_Transparent;
 
+        // Wait for the draw calls to be culled
+        DrawCallsWait(m_draw_calls_counter);
+
         // Go through all of the lights
-		const auto& entities_light = m_entities[Renderer_Object_Light];
-        for (uint32_t light_index = 0; light_index < entities_light.size(); light_index++)
+        for (uint32_t light_index = 0; light_index < static_cast<uint32_t>(frame.lights.size()); light_index++)
         {
-            const Light* light = entities_light[light_index]->GetComponent<Light>();
+            const FrameLight& frame_light = frame.lights[light_index];
 
             // Skip some obvious cases
-            if (!light || !light->GetShadowsEnabled())
+            if (!frame_light.shadows_enabled || frame_light.type != LightType::Directional)
                 continue;
 
             // Skip lights that don't cast transparent shadows (if this is a transparent pass)
-            if (transparent_pass && !light->GetShadowsTransparentEnabled())
+            if (transparent_pass && !frame_light.shadows_transparent_enabled)
                 continue;
 
             // Acquire light's shadow maps
-            RHI_Texture* tex_depth = light->GetDepthTexture();
-            RHI_Texture* tex_color = light->GetColorTexture();
+            RHI_Texture* tex_depth = frame_light.shadow_map.texture_depth.get();
+            RHI_Texture* tex_color = frame_light.shadow_map.texture_color.get();
             if (!tex_depth)
                 continue;
 
             // Set render state
             static RHI_PipelineState pipeline_state;
             pipeline_state.shader_vertex                    = shader_v;
-            pipeline_state.vertex_buffer_stride             = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
             pipeline_state.shader_pixel                     = transparent_pass ? shader_p : nullptr;
             pipeline_state.blend_state                      = transparent_pass ? m_blend_alpha.get() : m_blend_disabled.get();
             pipeline_state.depth_stencil_state              = transparent_pass ? m_depth_stencil_on_off_r.get() : m_depth_stencil_on_off_w.get();
@@ -184,7 +242,7 @@ namespace Spartan
             pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
             pipeline_state.pass_name                        = transparent_pass ? "Pass_LightDepthTransparent" : "Pass_LightDepth";
 
-            for (uint32_t array_index = 0; array_index < tex_depth->GetArraySize(); array_index++)
+            for (uint32_t array_index = 0; array_index < frame_light.shadow_array_size; array_index++)
             {
                 // Set render target texture array index
                 pipeline_state.render_target_color_texture_array_index          = array_index;
@@ -194,10 +252,8 @@ namespace Spartan
                 pipeline_state.clear_color[0] = Vector4::One;
                 pipeline_state.clear_depth    = transparent_pass ? state_depth_load : GetClearDepth();
 
-                const Matrix& view_projection = light->GetViewMatrix(array_index) * light->GetProjectionMatrix(array_index);
-
                 // Set appropriate rasterizer state
-                if (light->GetLightType() == LightType::Directional)
+                if (frame_light.type == LightType::Directional)
                 {
                     // "Pancaking" - https://www.gamedev.net/forums/topic/639036-shadow-mapping-and-high-up-objects/
                     // It's basically a way to capture the silhouettes of potential shadow casters behind the light's view point.
@@ -213,67 +269,87 @@ namespace Spartan
                 bool render_pass_active     = false;
                 uint32_t m_set_material_id  = 0;
 
-                for (uint32_t entity_index = 0; entity_index < static_cast<uint32_t>(entities.size()); entity_index++)
+                // Shadow casters which are inside the view's frustum
+                const FrameDrawList& draw_list = m_draw_lists_light[object_type][light_index * m_max_shadow_views + array_index];
+                for (const FrameDrawBatch& batch : draw_list.batches)
                 {
-                    Entity* entity = entities[entity_index];
-
-                    // Acquire renderable component
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
-
-                    // Skip meshes that don't cast shadows
-                    if (!renderable->GetCastShadows())
-                        continue;
+                    const FrameDrawCall& draw_call      = draw_list.draw_calls[batch.first];
+                    const FrameRenderable& renderable   = *draw_call.renderable;
 
                     // Acquire geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                    const RHI_VertexBuffer* vertex_buffer = renderable.vertex_buffer.get();
+                    const RHI_IndexBuffer* index_buffer   = renderable.index_buffer.get();
+                    if (!vertex_buffer || !index_buffer)
                         continue;
 
                     // Acquire material
-                    const auto& material = renderable->GetMaterial();
+                    const FrameMaterial* material = renderable.material;
                     if (!material)
                         continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!light->IsInViewFrustrum(renderable, array_index))
+                    // Batches and quantized geometry use their own vertex shaders, which are different pipelines
+                    RHI_Shader* shader_vertex = GetShaderVertex(Shader_Depth_V, batch.count > 1, renderable.quantized);
+                    if (!shader_vertex->IsCompiled())
                         continue;
 
+                    if (render_pass_active && pipeline_state.shader_vertex != shader_vertex)
+                    {
+                        cmd_list->EndRenderPass();
+                        render_pass_active = false;
+
+                        // Already cleared by the previous render pass
+                        pipeline_state.clear_color[0]   = state_color_load;
+                        pipeline_state.clear_depth      = state_depth_load;
+                    }
+                    pipeline_state.shader_vertex        = shader_vertex;
+                    pipeline_state.vertex_buffer_stride = vertex_buffer->GetStride();
+
                     if (!render_pass_active)
                     {
                         render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
                     }
 
                     // Bind material
-                    if (transparent_pass && m_set_material_id != material->GetId())
+                    if (transparent_pass && m_set_material_id != material->id)
                     {
                         // Bind material textures
-                        RHI_Texture* tex_albedo = material->GetTexture_Ptr(Material_Color);
+                        RHI_Texture* tex_albedo = material->GetTexture(Material_Color);
                         cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
 
                         // Update uber buffer with material properties
-                        m_buffer_uber_cpu.mat_albedo    = material->GetColorAlbedo();
-                        m_buffer_uber_cpu.mat_tiling_uv = material->GetTiling();
-                        m_buffer_uber_cpu.mat_offset_uv = material->GetOffset();
+                        m_buffer_uber_cpu.mat_albedo    = material->color;
+                        m_buffer_uber_cpu.mat_tiling_uv = material->tiling;
+                        m_buffer_uber_cpu.mat_offset_uv = material->offset;
 
                         // Update constant buffer
                         UpdateUberBuffer(cmd_list);
 
-                        m_set_material_id = material->GetId();
+                        m_set_material_id = material->id;
                     }
 
                     // Bind geometry
-                    cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                    cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                    cmd_list->SetBufferIndex(index_buffer);
+                    cmd_list->SetBufferVertex(vertex_buffer);
 
-                    // Update uber buffer with cascade transform
-                    m_buffer_object_cpu.object = entity->GetTransform()->GetMatrix() * view_projection;
-                    if (!UpdateObjectBuffer(cmd_list))
-                        continue;
+                    // Update object buffer with cascade transform, or the instance buffer with all of them
+                    if (batch.count == 1)
+                    {
+                        m_buffer_object_cpu.object = draw_call.transform;
+                        if (!UpdateObjectBuffer(cmd_list))
+                            continue;
+                    }
+                    else
+                    {
+                        for (uint32_t i = 0; i < batch.count; i++)
+                        {
+                            m_buffer_instances_cpu.instances[i].object = draw_list.draw_calls[batch.first + i].transform;
+                        }
 
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                        if (!UpdateInstanceBuffer(cmd_list, batch.count))
+                            continue;
+                    }
 
+                    cmd_list->DrawIndexed(renderable.index_count, renderable.index_offset, renderable.vertex_offset, batch.count);
                 }
 
                 if (render_pass_active)
@@ -284,23 +360,275 @@ namespace Spartan
         }
 	}
 
+    void Renderer::Pass_ShadowAtlas(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type)
+    {
+        // Point and spot lights render into tiles of a shared atlas (see ShadowAtlas).
+        // Opaque casters which haven't moved for a while are static, they are rendered into a static atlas, and only when the view or the casters change.
+        // The depth atlas gets a copy of the static tile and the dynamic casters on top, but only when there are dynamic (or transparent) casters to draw.
+        // Transparent objects, read that depth and write their color information into the color atlas, every frame.
+
+        // Acquire shaders
+        RHI_Shader* shader_v            = m_shaders[Shader_Depth_V].get();
+        RHI_Shader* shader_v_instanced  = m_shaders[Shader_Depth_Instanced_V].get();
+        RHI_Shader* shader_p            = m_shaders[Shader_Depth_P].get();
+        RHI_Shader* shader_quad_v       = m_shaders[Shader_Quad_V].get();
+        RHI_Shader* shader_copy_p       = m_shaders[Shader_ShadowAtlas_Copy_P].get();
+        RHI_Shader* shader_clear_p      = m_shaders[Shader_ShadowAtlas_Clear_P].get();
+        if (!shader_v->IsCompiled() || !shader_v_instanced->IsCompiled() || !shader_p->IsCompiled() || !shader_quad_v->IsCompiled() || !shader_copy_p->IsCompiled() || !shader_clear_p->IsCompiled())
+            return;
+
+        // Acquire render targets
+        RHI_Texture* tex_depth          = m_render_targets[RenderTarget_Shadow_Atlas_Depth].get();
+        RHI_Texture* tex_depth_static   = m_render_targets[RenderTarget_Shadow_Atlas_Depth_Static].get();
+        RHI_Texture* tex_color          = m_render_targets[RenderTarget_Shadow_Atlas_Color].get();
+        if (!tex_depth || !tex_depth_static || !tex_color || tex_depth->GetWidth() != m_shadow_atlas.GetResolution())
+            return;
+
+        const FrameSnapshot& frame  = m_frames[m_frame_index_render];
+        const auto& renderables     = frame.renderables[object_type];
+        const bool transparent_pass = object_type == Renderer_Object_Transparent;
+
+        // Wait for the draw calls to be culled
+        DrawCallsWait(m_draw_calls_counter);
+
+        // All tiles share the same pipelines, they are selected with a dynamic viewport and scissor
+        auto set_tile = [cmd_list](const ShadowAtlasTile& tile)
+        {
+            const float x       = static_cast<float>(tile.x);
+            const float y       = static_cast<float>(tile.y);
+            const float size    = static_cast<float>(tile.size);
+
+            cmd_list->SetViewport(RHI_Viewport(x, y, size, size));
+            cmd_list->SetScissorRectangle(Math::Rectangle(x, y, x + size, y + size));
+        };
+
+        // Clears the depth of a static tile, or copies it into the depth atlas (which also clears the color to white)
+        auto draw_quad = [&](RHI_Shader* shader_pixel, RHI_Texture* tex_depth_target, RHI_Texture* tex_color_target, const ShadowAtlasTile& tile)
+        {
+            static RHI_PipelineState pipeline_state;
+            pipeline_state.shader_vertex                    = shader_quad_v;
+            pipeline_state.shader_pixel                     = shader_pixel;
+            pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+            pipeline_state.blend_state                      = m_blend_disabled.get();
+            pipeline_state.depth_stencil_state              = m_depth_stencil_on_off_w_always.get();
+            pipeline_state.vertex_buffer_stride             = m_viewport_quad.GetVertexBuffer()->GetStride();
+            pipeline_state.render_target_color_textures[0]  = tex_color_target;
+            pipeline_state.clear_color[0]                   = state_color_load;
+            pipeline_state.render_target_depth_texture      = tex_depth_target;
+            pipeline_state.clear_depth                      = state_depth_load;
+            pipeline_state.clear_stencil                    = state_stencil_dont_care;
+            pipeline_state.viewport                         = RHI_Viewport::Undefined;
+            pipeline_state.dynamic_scissor                  = true;
+            pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+            pipeline_state.pass_name                        = shader_pixel == shader_copy_p ? "Pass_ShadowAtlas_Copy" : "Pass_ShadowAtlas_Clear";
+
+            if (cmd_list->BeginRenderPass(pipeline_state))
+            {
+                set_tile(tile);
+
+                // The clear shader outputs this depth
+                m_buffer_uber_cpu.color = Vector4(GetClearDepth(), 0.0f, 0.0f, 0.0f);
+                UpdateUberBuffer(cmd_list);
+
+                cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+                cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+                cmd_list->SetTexture(28, shader_pixel == shader_copy_p ? tex_depth_static : m_tex_white.get());
+                cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                cmd_list->EndRenderPass();
+            }
+        };
+
+        // Set render state
+        static RHI_PipelineState pipeline_state;
+        pipeline_state.shader_pixel                     = transparent_pass ? shader_p : nullptr;
+        pipeline_state.rasterizer_state                 = m_rasterizer_cull_back_solid.get();
+        pipeline_state.blend_state                      = transparent_pass ? m_blend_alpha.get() : m_blend_disabled.get();
+        pipeline_state.depth_stencil_state              = transparent_pass ? m_depth_stencil_on_off_r.get() : m_depth_stencil_on_off_w.get();
+        pipeline_state.render_target_color_textures[0]  = transparent_pass ? tex_color : nullptr;
+        pipeline_state.clear_color[0]                   = state_color_load;
+        pipeline_state.clear_depth                      = state_depth_load;
+        pipeline_state.clear_stencil                    = state_stencil_dont_care;
+        pipeline_state.viewport                         = RHI_Viewport::Undefined;
+        pipeline_state.dynamic_scissor                  = true;
+        pipeline_state.primitive_topology               = RHI_PrimitiveTopology_TriangleList;
+        pipeline_state.pass_name                        = transparent_pass ? "Pass_ShadowAtlasTransparent" : "Pass_ShadowAtlas";
+
+        // Draws the casters of a view which are static, dynamic, or both
+        auto draw_casters = [&](RHI_Texture* tex_depth_target, const FrameDrawList& draw_list, const ShadowAtlasTile& tile, const bool draw_static, const bool draw_dynamic)
+        {
+            pipeline_state.render_target_depth_texture = tex_depth_target;
+
+            // State tracking
+            bool render_pass_active     = false;
+            uint32_t m_set_material_id  = 0;
+
+            for (const FrameDrawBatch& batch : draw_list.batches)
+            {
+                const FrameDrawCall& draw_call      = draw_list.draw_calls[batch.first];
+                const FrameRenderable& renderable   = *draw_call.renderable;
+
+                // Acquire geometry
+                const RHI_VertexBuffer* vertex_buffer = renderable.vertex_buffer.get();
+                const RHI_IndexBuffer* index_buffer   = renderable.index_buffer.get();
+                if (!vertex_buffer || !index_buffer)
+                    continue;
+
+                // Acquire material
+                const FrameMaterial* material = renderable.material;
+                if (!material)
+                    continue;
+
+                // Instances of a batch can be split between the static and the dynamic casters
+                uint32_t instance_count = 0;
+                for (uint32_t i = 0; i < batch.count; i++)
+                {
+                    const FrameDrawCall& instance   = draw_list.draw_calls[batch.first + i];
+                    const bool dynamic              = m_shadow_atlas.IsCasterDynamic(instance.renderable, renderables);
+                    if (dynamic ? draw_dynamic : draw_static)
+                    {
+                        m_buffer_instances_cpu.instances[instance_count++].object = instance.transform;
+                    }
+                }
+
+                if (instance_count == 0)
+                    continue;
+
+                // Batches and quantized geometry use their own vertex shaders, which are different pipelines
+                RHI_Shader* shader_vertex = GetShaderVertex(Shader_Depth_V, instance_count > 1, renderable.quantized);
+                if (!shader_vertex->IsCompiled())
+                    continue;
+
+                if (render_pass_active && pipeline_state.shader_vertex != shader_vertex)
+                {
+                    cmd_list->EndRenderPass();
+                    render_pass_active = false;
+                }
+                pipeline_state.shader_vertex        = shader_vertex;
+                pipeline_state.vertex_buffer_stride = vertex_buffer->GetStride();
+
+                if (!render_pass_active)
+                {
+                    render_pass_active = cmd_list->BeginRenderPass(pipeline_state);
+                    if (!render_pass_active)
+                        continue;
+
+                    set_tile(tile);
+                    m_set_material_id = 0;
+                }
+
+                // Bind material
+                if (transparent_pass && m_set_material_id != material->id)
+                {
+                    // Bind material textures
+                    RHI_Texture* tex_albedo = material->GetTexture(Material_Color);
+                    cmd_list->SetTexture(28, tex_albedo ? tex_albedo : m_tex_white.get());
+
+                    // Update uber buffer with material properties
+                    m_buffer_uber_cpu.mat_albedo    = material->color;
+                    m_buffer_uber_cpu.mat_tiling_uv = material->tiling;
+                    m_buffer_uber_cpu.mat_offset_uv = material->offset;
+
+                    // Update constant buffer
+                    UpdateUberBuffer(cmd_list);
+
+                    m_set_material_id = material->id;
+                }
+
+                // Bind geometry
+                cmd_list->SetBufferIndex(index_buffer);
+                cmd_list->SetBufferVertex(vertex_buffer);
+
+                // Update object buffer with the view transform, or the instance buffer with all of them
+                if (instance_count == 1)
+                {
+                    m_buffer_object_cpu.object = m_buffer_instances_cpu.instances[0].object;
+                    if (!UpdateObjectBuffer(cmd_list))
+                        continue;
+                }
+                else if (!UpdateInstanceBuffer(cmd_list, instance_count))
+                {
+                    continue;
+                }
+
+                cmd_list->DrawIndexed(renderable.index_count, renderable.index_offset, renderable.vertex_offset, instance_count);
+            }
+
+            if (render_pass_active)
+            {
+                cmd_list->EndRenderPass();
+            }
+        };
+
+        // Go through all of the lights
+        for (uint32_t light_index = 0; light_index < static_cast<uint32_t>(frame.lights.size()); light_index++)
+        {
+            const FrameLight& frame_light = frame.lights[light_index];
+
+            // Skip some obvious cases (directional lights have their own cascades, see Pass_LightDepth)
+            if (!frame_light.shadows_enabled || frame_light.type == LightType::Directional)
+                continue;
+
+            // Skip lights that don't cast transparent shadows (if this is a transparent pass)
+            if (transparent_pass && !frame_light.shadows_transparent_enabled)
+                continue;
+
+            // Skip lights which didn't fit in the atlas
+            ShadowAtlasLight* atlas_light = m_shadow_atlas.GetLight(frame_light.id);
+            if (!atlas_light || atlas_light->tile_size == 0)
+                continue;
+
+            const uint32_t view_count = Math::Helper::Min(frame_light.shadow_array_size, atlas_light->view_count);
+            for (uint32_t view_index = 0; view_index < view_count; view_index++)
+            {
+                ShadowAtlasView& view           = atlas_light->views[view_index];
+                const uint32_t draw_list_index  = light_index * m_max_shadow_views + view_index;
+                const FrameDrawList& draw_list  = m_draw_lists_light[object_type][draw_list_index];
+
+                // Drawn on top of this frame's copy of the static depth
+                if (transparent_pass)
+                {
+                    draw_casters(tex_depth, draw_list, view.tile, true, true);
+                    continue;
+                }
+
+                // Decide what has to be drawn, transparent casters need the copy since it also clears the color
+                const bool transparent = frame_light.shadows_transparent_enabled && !m_draw_lists_light[Renderer_Object_Transparent][draw_list_index].draw_calls.empty();
+                m_shadow_atlas.UpdateView(view, frame_light.view_projection[view_index], draw_list, renderables, transparent);
+
+                if (view.render_static)
+                {
+                    draw_quad(shader_clear_p, tex_depth_static, nullptr, view.tile);
+                    draw_casters(tex_depth_static, draw_list, view.tile, true, false);
+                }
+
+                if (view.render_dynamic)
+                {
+                    draw_quad(shader_copy_p, tex_depth, tex_color, view.tile);
+                    draw_casters(tex_depth, draw_list, view.tile, false, true);
+                }
+            }
+        }
+    }
+
     void Renderer::Pass_DepthPrePass(RHI_CommandList* cmd_list)
     {
         // Description: All the opaque meshes are rendered, outputting
         // just their depth information into a depth map.
 
         // Acquire required resources/data
-        const auto& shader_depth    = m_shaders[Shader_Depth_V];
-        const auto& tex_depth       = m_render_targets[RenderTarget_Gbuffer_Depth];
-        const auto& entities        = m_entities[Renderer_Object_Opaque];
+        const auto& shader_depth            = m_shaders[Shader_Depth_V];
+        const auto& shader_depth_instanced  = m_shaders[Shader_Depth_Instanced_V];
+        const auto& tex_depth               = m_render_targets[RenderTarget_Gbuffer_Depth];
+        const FrameDrawList& draw_list      = m_draw_lists_camera[Renderer_Object_Opaque];
 
         // Ensure the shader has compiled
-        if (!shader_depth->IsCompiled())
+        if (!shader_depth->IsCompiled() || !shader_depth_instanced->IsCompiled())
             return;
 
         // Set render state
         static RHI_PipelineState pipeline_state;
         pipeline_state.shader_vertex                = shader_depth.get();
+        pipeline_state.vertex_buffer_stride         = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan));
         pipeline_state.shader_pixel                 = nullptr;
         pipeline_state.rasterizer_state             = m_rasterizer_cull_back_solid.get();
         pipeline_state.blend_state                  = m_blend_disabled.get();
@@ -314,46 +642,68 @@ namespace Spartan
         // Record commands
         if (cmd_list->BeginRenderPass(pipeline_state))
         { 
-            if (!entities.empty())
+            // Wait for the draw calls to be culled
+            DrawCallsWait(m_draw_calls_counter);
+
+            if (!draw_list.batches.empty())
             {
                 // Variables that help reduce state changes
                 uint32_t currently_bound_geometry = 0;
 
                 // Draw opaque
-                for (const auto& entity : entities)
+                for (const FrameDrawBatch& batch : draw_list.batches)
                 {
-                    // Get renderable
-                    const auto& renderable = entity->GetRenderable();
-                    if (!renderable)
-                        continue;
-
                     // Get geometry
-                    const auto& model = renderable->GeometryModel();
-                    if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+                    const FrameDrawCall& draw_call      = draw_list.draw_calls[batch.first];
+                    const FrameRenderable& renderable   = *draw_call.renderable;
+                    const RHI_VertexBuffer* vertex_buffer = renderable.vertex_buffer.get();
+                    const RHI_IndexBuffer* index_buffer   = renderable.index_buffer.get();
+                    if (!vertex_buffer || !index_buffer)
                         continue;
 
-                    // Skip objects outside of the view frustum
-                    if (!m_camera->IsInViewFrustrum(renderable))
+                    // Batches and quantized geometry use their own vertex shaders, which are different pipelines
+                    RHI_Shader* shader_vertex = GetShaderVertex(Shader_Depth_V, batch.count > 1, renderable.quantized);
+                    if (!shader_vertex->IsCompiled())
                         continue;
 
+                    if (pipeline_state.shader_vertex != shader_vertex)
+                    {
+                        cmd_list->EndRenderPass();
+                        pipeline_state.shader_vertex        = shader_vertex;
+                        pipeline_state.vertex_buffer_stride = vertex_buffer->GetStride();
+                        pipeline_state.clear_depth          = state_depth_load;
+                        cmd_list->BeginRenderPass(pipeline_state);
+                        currently_bound_geometry        = 0;
+                    }
+
                     // Bind geometry
-                    if (currently_bound_geometry != model->GetId())
+                    if (currently_bound_geometry != renderable.geometry_id)
                     {
-                        cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                        cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                        currently_bound_geometry = model->GetId();
+                        cmd_list->SetBufferIndex(index_buffer);
+                        cmd_list->SetBufferVertex(vertex_buffer);
+                        currently_bound_geometry = renderable.geometry_id;
                     }
 
-                    // Update uber buffer with entity transform
-                    if (Transform* transform = entity->GetTransform())
+                    // Update object buffer with entity transform, or the instance buffer with all of them
+                    if (batch.count == 1)
                     {
-                        // Update uber buffer with cascade transform
-                        m_buffer_uber_cpu.transform = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                        UpdateUberBuffer(cmd_list);
+                        m_buffer_object_cpu.object = draw_call.transform;
+                        if (!UpdateObjectBuffer(cmd_list))
+                            continue;
+                    }
+                    else
+                    {
+                        for (uint32_t i = 0; i < batch.count; i++)
+                        {
+                            m_buffer_instances_cpu.instances[i].object = draw_list.draw_calls[batch.first + i].transform;
+                        }
+
+                        if (!UpdateInstanceBuffer(cmd_list, batch.count))
+                            continue;
                     }
 
                     // Draw	
-                    cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                    DrawBatch(cmd_list, draw_list, batch);
                 }
             }
             cmd_list->EndRenderPass();
@@ -363,16 +713,17 @@ namespace Spartan
 	void Renderer::Pass_GBuffer(RHI_CommandList* cmd_list, const Renderer_Object_Type object_type)
 	{
         // Acquire required resources/shaders
-        RHI_Texture* tex_albedo       = m_render_targets[RenderTarget_Gbuffer_Albedo].get();
-        RHI_Texture* tex_normal       = m_render_targets[RenderTarget_Gbuffer_Normal].get();
-        RHI_Texture* tex_material     = m_render_targets[RenderTarget_Gbuffer_Material].get();
-        RHI_Texture* tex_velocity     = m_render_targets[RenderTarget_Gbuffer_Velocity].get();
-        RHI_Texture* tex_depth        = m_render_targets[RenderTarget_Gbuffer_Depth].get();
-        RHI_Shader* shader_v          = m_shaders[Shader_Gbuffer_V].get();
-        ShaderGBuffer* shader_p       = static_cast<ShaderGBuffer*>(m_shaders[Shader_Gbuffer_P].get());
+        RHI_Texture* tex_albedo        = m_render_targets[RenderTarget_Gbuffer_Albedo].get();
+        RHI_Texture* tex_normal        = m_render_targets[RenderTarget_Gbuffer_Normal].get();
+        RHI_Texture* tex_material      = m_render_targets[RenderTarget_Gbuffer_Material].get();
+        RHI_Texture* tex_velocity      = m_render_targets[RenderTarget_Gbuffer_Velocity].get();
+        RHI_Texture* tex_depth         = m_render_targets[RenderTarget_Gbuffer_Depth].get();
+        RHI_Shader* shader_v           = m_shaders[Shader_Gbuffer_V].get();
+        RHI_Shader* shader_v_instanced = m_shaders[Shader_Gbuffer_Instanced_V].get();
+        ShaderGBuffer* shader_p        = static_cast<ShaderGBuffer*>(m_shaders[Shader_Gbuffer_P].get());
 
         // Validate that the shader has compiled
-        if (!shader_v->IsCompiled())
+        if (!shader_v->IsCompiled() || !shader_v_instanced->IsCompiled())
             return;
 
         // Clear values that depend on the objects being opaque or transparent
@@ -381,7 +732,7 @@ namespace Spartan
         // Set render state
         RHI_PipelineState pso;
         pso.shader_vertex                   = shader_v;
-        pso.vertex_buffer_stride            = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan)); // assume all vertex buffers have the same stride (which they do)
+        pso.vertex_buffer_stride            = static_cast<uint32_t>(sizeof(RHI_Vertex_PosTexNorTan));
         pso.blend_state                     = m_blend_disabled.get();
         pso.rasterizer_state                = GetOption(Render_Debug_Wireframe) ? m_rasterizer_cull_back_wireframe.get() : m_rasterizer_cull_back_solid.get();
         pso.depth_stencil_state             = is_transparent ? m_depth_stencil_on_on_w.get() : m_depth_stencil_on_off_w.get(); // GetOptionValue(Render_DepthPrepass) is not accounted for anymore, have to fix
@@ -400,147 +751,166 @@ namespace Spartan
         pso.primitive_topology              = RHI_PrimitiveTopology_TriangleList;
 
         bool cleared = false;
-        uint32_t material_index = 0;
-        uint32_t material_bound_id = 0;
-        m_material_instances.fill(nullptr);
+        const FrameMaterial* material_bound = nullptr;
+
+        // Wait for the draw calls to be culled
+        DrawCallsWait(m_draw_calls_counter);
+        const FrameDrawList& draw_list = m_draw_lists_camera[object_type];
+
+        // The draw calls are sorted by shader variation, then by material and then by geometry, so every
+        // variation is a contiguous range that gets its own render pass, with each material bound once.
+        // Within a variation, the single draws come first and the instanced ones (a second render pass) after.
+        bool render_pass_active     = false;
+        bool variation_bound        = false;
+        uint16_t variation_flags    = 0;
+        ShaderGBuffer* variation    = nullptr;
 
-        // Iterate through all the G-Buffer shader variations
-        for (const auto& it : ShaderGBuffer::GetVariations())
+        // Record commands
+        for (const FrameDrawBatch& batch : draw_list.batches)
         {
-            // Skip the shader until it compiles or the users spots a compilation error
-            if (!it.second->IsCompiled())
+            // Get material
+            const FrameDrawCall& draw_call      = draw_list.draw_calls[batch.first];
+            const FrameRenderable& renderable   = *draw_call.renderable;
+            const FrameMaterial* material       = renderable.material;
+            if (!material)
                 continue;
 
-            // Set pixel shader
-            pso.shader_pixel = static_cast<RHI_Shader*>(it.second.get());
+            // Skip transparent objects that won't contribute
+            if (material->color.w == 0 && is_transparent)
+                continue;
 
-            // Set pass name
-            pso.pass_name = pso.shader_pixel->GetName().c_str();
+            // Get geometry
+            const RHI_VertexBuffer* vertex_buffer = renderable.vertex_buffer.get();
+            const RHI_IndexBuffer* index_buffer   = renderable.index_buffer.get();
+            if (!vertex_buffer || !index_buffer)
+                continue;
 
-            bool render_pass_active = false;
-            auto& entities = m_entities[object_type];
+            // Switch to the shader variation that suits the material, and to the vertex shader for batches and quantized geometry
+            RHI_Shader* shader_vertex   = GetShaderVertex(Shader_Gbuffer_V, batch.count > 1, renderable.quantized);
+            if (!shader_vertex->IsCompiled())
+                continue;
 
-            // Record commands
-            for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+            const bool variation_change = !variation_bound || variation_flags != material->flags;
+            if (variation_change || pso.shader_vertex != shader_vertex)
             {
-                Entity* entity = entities[i];
-
-                // Get renderable
-                const auto& renderable = entity->GetRenderable();
-                if (!renderable)
-                    continue;
-
-                // Get material
-                Material* material = renderable->GetMaterial();
-                if (!material)
-                    continue;
-
-                // Skip objects with different shader requirements
-                if (!static_cast<ShaderGBuffer*>(pso.shader_pixel)->IsSuitable(material->GetFlags()))
-                    continue;
-
-                // Skip transparent objects that won't contribute
-                if (material->GetColorAlbedo().w == 0 && is_transparent)
-                    continue;
-
-                // Get geometry
-                const auto& model = renderable->GeometryModel();
-                if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
-                    continue;
-
-                // Skip objects outside of the view frustum
-                if (!m_camera->IsInViewFrustrum(renderable))
-                    continue;
-
-                if (!render_pass_active)
+                if (render_pass_active)
                 {
-                    render_pass_active = cmd_list->BeginRenderPass(pso);
+                    cmd_list->EndRenderPass();
+                    render_pass_active = false;
                 }
 
-                // Set geometry (will only happen if not already set)
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
+                pso.shader_vertex           = shader_vertex;
+                pso.vertex_buffer_stride    = vertex_buffer->GetStride();
+            }
+
+            if (variation_change)
+            {
+                variation_bound = true;
+                variation_flags = material->flags;
+                const auto& variations  = ShaderGBuffer::GetVariations();
+                const auto it           = variations.find(variation_flags);
+                variation               = it != variations.end() ? it->second.get() : nullptr;
 
-                // Bind material
-                bool firs_run       = material_index == 0;
-                bool new_material   = material_bound_id != material->GetId();
-                if (firs_run || new_material)
+                if (variation && variation->IsCompiled())
                 {
-                    material_bound_id = material->GetId();
+                    pso.shader_pixel    = static_cast<RHI_Shader*>(variation);
+                    pso.pass_name       = pso.shader_pixel->GetName().c_str();
+                }
+            }
 
-                    // Keep track of used material instances (they get mapped to shaders)
-                    if (material_index + 1 < m_material_instances.size())
-                    {
-                        // Advance index (0 is reserved for the sky)
-                        material_index++;
+            // Skip the shader until it compiles or the users spots a compilation error
+            if (!variation || !variation->IsCompiled())
+                continue;
 
-                        // Keep reference
-                        m_material_instances[material_index] = material;
-                    }
-                    else
-                    {
-                        LOG_ERROR("Material instance array has reached it's maximum capacity of %d elements. Consider increasing the size.", m_max_material_instances);
-                    }
+            if (!render_pass_active)
+            {
+                render_pass_active = cmd_list->BeginRenderPass(pso);
+            }
 
-                    // Bind material textures		
-                    cmd_list->SetTexture(0, material->GetTexture_Ptr(Material_Color));
-                    cmd_list->SetTexture(1, material->GetTexture_Ptr(Material_Roughness));
-                    cmd_list->SetTexture(2, material->GetTexture_Ptr(Material_Metallic));
-                    cmd_list->SetTexture(3, material->GetTexture_Ptr(Material_Normal));
-                    cmd_list->SetTexture(4, material->GetTexture_Ptr(Material_Height));
-                    cmd_list->SetTexture(5, material->GetTexture_Ptr(Material_Occlusion));
-                    cmd_list->SetTexture(6, material->GetTexture_Ptr(Material_Emission));
-                    cmd_list->SetTexture(7, material->GetTexture_Ptr(Material_Mask));
-                
-                    // Update uber buffer with material properties
-                    m_buffer_uber_cpu.mat_id            = static_cast<float>(material_index);
-                    m_buffer_uber_cpu.mat_albedo        = material->GetColorAlbedo();
-                    m_buffer_uber_cpu.mat_tiling_uv     = material->GetTiling();
-                    m_buffer_uber_cpu.mat_offset_uv     = material->GetOffset();
-                    m_buffer_uber_cpu.mat_roughness_mul = material->GetProperty(Material_Roughness);
-                    m_buffer_uber_cpu.mat_metallic_mul  = material->GetProperty(Material_Metallic);
-                    m_buffer_uber_cpu.mat_normal_mul    = material->GetProperty(Material_Normal);
-                    m_buffer_uber_cpu.mat_height_mul    = material->GetProperty(Material_Height);
+            // Set geometry (will only happen if not already set)
+            cmd_list->SetBufferIndex(index_buffer);
+            cmd_list->SetBufferVertex(vertex_buffer);
 
-                    // Update constant buffer
-                    UpdateUberBuffer(cmd_list);
-                }
-                
-                // Update uber buffer with entity transform
-                if (Transform* transform = entity->GetTransform())
+            // Bind material textures, the rest of the material is in the material table which the draws index
+            if (material != material_bound)
+            {
+                material_bound = material;
+
+                cmd_list->SetTexture(0, material->GetTexture(Material_Color));
+                cmd_list->SetTexture(1, material->GetTexture(Material_Roughness));
+                cmd_list->SetTexture(2, material->GetTexture(Material_Metallic));
+                cmd_list->SetTexture(3, material->GetTexture(Material_Normal));
+                cmd_list->SetTexture(4, material->GetTexture(Material_Height));
+                cmd_list->SetTexture(5, material->GetTexture(Material_Occlusion));
+                cmd_list->SetTexture(6, material->GetTexture(Material_Emission));
+                cmd_list->SetTexture(7, material->GetTexture(Material_Mask));
+            }
+            
+            // Update uber buffer with entity transform
+            if (batch.count == 1)
+            {
+                if (FrameEntityState* state = renderable.state)
                 {
-                    m_buffer_object_cpu.object          = transform->GetMatrix();
-                    m_buffer_object_cpu.wvp_current     = transform->GetMatrix() * m_buffer_frame_cpu.view_projection;
-                    m_buffer_object_cpu.wvp_previous    = transform->GetWvpLastFrame();
+                    m_buffer_object_cpu.object          = renderable.matrix_vertex;
+                    m_buffer_object_cpu.wvp_current     = draw_call.transform;
+                    m_buffer_object_cpu.wvp_previous    = state->wvp_previous_valid ? state->wvp_previous : draw_call.transform;
+                    m_buffer_object_cpu.material_index  = renderable.material_index;
 
                     // Save matrix for velocity computation
-                    transform->SetWvpLastFrame(m_buffer_object_cpu.wvp_current);
+                    state->wvp_previous         = m_buffer_object_cpu.wvp_current;
+                    state->wvp_previous_valid   = true;
 
                     // Update object buffer
                     if (!UpdateObjectBuffer(cmd_list))
                         continue;
                 }
-                
-                // Render	
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
-                m_profiler->m_renderer_meshes_rendered++;
-
-                // Clear only on first pass
-                if (!cleared)
+            }
+            else
+            {
+                // Update instance buffer with the transforms of all the entities
+                for (uint32_t i = 0; i < batch.count; i++)
                 {
-                    pso.ResetClearValues();
-                    cleared = true;
+                    const FrameDrawCall& instance_draw_call = draw_list.draw_calls[batch.first + i];
+                    BufferObject& instance                  = m_buffer_instances_cpu.instances[i];
+                    FrameEntityState* state                 = instance_draw_call.renderable->state;
+                    instance.object                         = instance_draw_call.renderable->matrix_vertex;
+                    instance.wvp_current                    = instance_draw_call.transform;
+                    instance.wvp_previous                   = state && state->wvp_previous_valid ? state->wvp_previous : instance.wvp_current;
+                    instance.material_index                 = instance_draw_call.renderable->material_index;
+
+                    // Save matrix for velocity computation
+                    if (state)
+                    {
+                        state->wvp_previous         = instance.wvp_current;
+                        state->wvp_previous_valid   = true;
+                    }
                 }
+
+                if (!UpdateInstanceBuffer(cmd_list, batch.count))
+                    continue;
             }
+            
+            // Render	
+            DrawBatch(cmd_list, draw_list, batch);
+            m_profiler->m_renderer_meshes_rendered += batch.count;
 
-            if (render_pass_active)
+            // Clear only on first pass
+            if (!cleared)
             {
-                cmd_list->EndRenderPass();
+                pso.ResetClearValues();
+                cleared = true;
             }
         }
 
-        // Update constant buffer (light pass will access it using material IDs)
-        UpdateMaterialBuffer();
+        if (render_pass_active)
+        {
+            cmd_list->EndRenderPass();
+        }
+
+        m_profiler->m_renderer_binds_saved_pipeline += draw_list.binds_saved_pipeline;
+        m_profiler->m_renderer_binds_saved_material += draw_list.binds_saved_material;
+        m_profiler->m_renderer_binds_saved_buffer   += draw_list.binds_saved_buffer;
+        m_profiler->m_renderer_triangles_culled     += draw_list.triangles_culled;
 	}
 
 	void Renderer::Pass_Hbao(RHI_CommandList* cmd_list, const bool use_stencil)
@@ -663,8 +1033,8 @@ namespace Spartan
     void Renderer::Pass_Light(RHI_CommandList* cmd_list, const bool use_stencil)
     {
         // Acquire lights
-        const vector<Entity*>& entities = m_entities[Renderer_Object_Light];
-        if (entities.empty())
+        const vector<FrameLight>& lights = m_frames[m_frame_index_render].lights;
+        if (lights.empty())
             return;
 
         // Acquire shaders
@@ -705,75 +1075,99 @@ namespace Spartan
 
         bool cleared = false;
 
-        // Iterate through all the light entities
-        for (const auto& entity : entities)
+        // Everything a light pass binds, besides the light itself
+        auto begin_pass = [this, cmd_list, tex_diffuse, tex_depth]()
+        {
+            if (!cmd_list->BeginRenderPass(pipeline_state))
+                return false;
+
+            // Update uber buffer
+            m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_diffuse->GetWidth()), static_cast<float>(tex_diffuse->GetHeight()));
+            UpdateUberBuffer(cmd_list);
+
+            cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
+            cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
+            cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
+            cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
+            cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
+            cmd_list->SetTexture(12, tex_depth);
+            cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
+            cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
+            cmd_list->SetTexture(27, m_render_targets[RenderTarget_Hdr_2]); // previous frame before post-processing
+            cmd_list->SetTexture(31, m_tex_blue_noise);
+
+            return true;
+        };
+
+        auto end_pass = [cmd_list, use_stencil, &cleared]()
         {
-            if (Light* light = entity->GetComponent<Light>())
+            // Draw
+            cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+            cmd_list->EndRenderPass();
+
+            // Clear only on first pass
+            if (!cleared && !use_stencil)
             {
-                if (light->GetIntensity() != 0)
-                {
-                    // Set pixel shader
-                    pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, light, m_options));
+                pipeline_state.ResetClearValues();
+                cleared = true;
+            }
+        };
 
-                    // Skip the shader until it compiles or the users spots a compilation error
-                    if (!pipeline_state.shader_pixel->IsCompiled())
-                        continue;
+        // Unshadowed point and spot lights, all in one pass
+        if (!m_clustered_lights.empty())
+        {
+            pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariationClustered(m_context));
 
-                    if (cmd_list->BeginRenderPass(pipeline_state))
-                    {
-                        // Update uber buffer
-                        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_diffuse->GetWidth()), static_cast<float>(tex_diffuse->GetHeight()));
-                        UpdateUberBuffer(cmd_list);
+            // Skip the shader until it compiles or the users spots a compilation error
+            if (pipeline_state.shader_pixel->IsCompiled() && UpdateLightClustersBuffer() && begin_pass())
+            {
+                end_pass();
+            }
+        }
 
-                        cmd_list->SetBufferVertex(m_viewport_quad.GetVertexBuffer());
-                        cmd_list->SetBufferIndex(m_viewport_quad.GetIndexBuffer());
-                        cmd_list->SetTexture(8, m_render_targets[RenderTarget_Gbuffer_Albedo]);
-                        cmd_list->SetTexture(9, m_render_targets[RenderTarget_Gbuffer_Normal]);
-                        cmd_list->SetTexture(10, m_render_targets[RenderTarget_Gbuffer_Material]);
-                        cmd_list->SetTexture(12, tex_depth);
-                        cmd_list->SetTexture(22, (m_options & Render_Hbao) ? m_render_targets[RenderTarget_Hbao] : m_tex_black_opaque);
-                        cmd_list->SetTexture(26, (m_options & Render_ScreenSpaceReflections) ? m_render_targets[RenderTarget_Ssr] : m_tex_black_transparent);
-                        cmd_list->SetTexture(27, m_render_targets[RenderTarget_Hdr_2]); // previous frame before post-processing
-                        cmd_list->SetTexture(31, m_tex_blue_noise);
-
-                        // Update light buffer
-                        UpdateLightBuffer(light);
-
-                        // Set shadow map
-                        if (light->GetShadowsEnabled())
-                        {
-                            RHI_Texture* tex_depth = light->GetDepthTexture();
-                            RHI_Texture* tex_color = light->GetShadowsTransparentEnabled() ? light->GetColorTexture() : m_tex_white.get();
-
-                            if (light->GetLightType() == LightType::Directional)
-                            {
-                                cmd_list->SetTexture(13, tex_depth);
-                                cmd_list->SetTexture(14, tex_color);
-                            }
-                            else if (light->GetLightType() == LightType::Point)
-                            {
-                                cmd_list->SetTexture(15, tex_depth);
-                                cmd_list->SetTexture(16, tex_color);
-                            }
-                            else if (light->GetLightType() == LightType::Spot)
-                            {
-                                cmd_list->SetTexture(17, tex_depth);
-                                cmd_list->SetTexture(18, tex_color);
-                            }
-                        }
+        // Iterate through the rest of the lights
+        for (const FrameLight& frame_light : lights)
+        {
+            if (frame_light.clustered)
+                continue;
 
-                        // Draw
-                        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
-                        cmd_list->EndRenderPass();
+            if (frame_light.intensity == 0)
+                continue;
 
-                        // Clear only on first pass
-                        if (!cleared && !use_stencil)
-                        {
-                            pipeline_state.ResetClearValues();
-                            cleared = true;
-                        }
+            // Set pixel shader
+            pipeline_state.shader_pixel = static_cast<RHI_Shader*>(ShaderLight::GetVariation(m_context, frame_light, m_options));
+
+            // Skip the shader until it compiles or the users spots a compilation error
+            if (!pipeline_state.shader_pixel->IsCompiled())
+                continue;
+
+            if (begin_pass())
+            {
+                // Update light buffer
+                UpdateLightBuffer(frame_light);
+
+                // Set shadow map
+                if (frame_light.shadows_enabled)
+                {
+                    if (frame_light.type == LightType::Directional)
+                    {
+                        RHI_Texture* tex_depth = frame_light.shadow_map.texture_depth.get();
+                        RHI_Texture* tex_color = frame_light.shadows_transparent_enabled ? frame_light.shadow_map.texture_color.get() : m_tex_white.get();
+
+                        cmd_list->SetTexture(13, tex_depth);
+                        cmd_list->SetTexture(14, tex_color);
+                    }
+                    else // point and spot lights share the atlas, the light buffer holds their tiles
+                    {
+                        RHI_Texture* tex_depth = m_render_targets[RenderTarget_Shadow_Atlas_Depth].get();
+                        RHI_Texture* tex_color = frame_light.shadows_transparent_enabled ? m_render_targets[RenderTarget_Shadow_Atlas_Color].get() : m_tex_white.get();
+
+                        cmd_list->SetTexture(15, tex_depth);
+                        cmd_list->SetTexture(16, tex_color);
                     }
                 }
+
+                end_pass();
             }
         }
     }
@@ -1723,12 +2117,11 @@ namespace Spartan
 
 	void Renderer::Pass_Lines(RHI_CommandList* cmd_list, shared_ptr<RHI_Texture>& tex_out)
 	{
-		const bool draw_picking_ray = m_options & Render_Debug_PickingRay;
-		const bool draw_aabb		= m_options & Render_Debug_Aabb;
+        // The debug primitives (picking ray, lights, aabbs) are generated into the line lists when the frame is captured
+        const FrameSnapshot& frame  = m_frames[m_frame_index_render];
 		const bool draw_grid		= m_options & Render_Debug_Grid;
-        const bool draw_lights      = m_options & Render_Debug_Lights;
-		const auto draw_lines		= !m_lines_list_depth_enabled.empty() || !m_lines_list_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
-		const auto draw				= draw_picking_ray || draw_aabb || draw_grid || draw_lines || draw_lights;
+		const auto draw_lines		= !frame.lines_depth_enabled.empty() || !frame.lines_depth_disabled.empty(); // Any kind of lines, physics, user debug, etc.
+		const auto draw				= draw_grid || draw_lines;
 		if (!draw)
 			return;
 
@@ -1738,53 +2131,6 @@ namespace Spartan
         if (!shader_color_v->IsCompiled() || !shader_color_p->IsCompiled())
             return;
 
-        // Generate lines for debug primitives offered by the renderer
-        {
-            // Picking ray
-            if (draw_picking_ray)
-            {
-                const auto& ray = m_camera->GetPickingRay();
-                DrawLine(ray.GetStart(), ray.GetStart() + ray.GetDirection() * m_camera->GetFarPlane(), Vector4(0, 1, 0, 1));
-            }
-
-            // Lights
-            if (draw_lights)
-            {
-                auto& lights = m_entities[Renderer_Object_Light];
-                for (const auto& entity : lights)
-                {
-                    Light* light = entity->GetComponent<Light>();
-
-                    if (light->GetLightType() == LightType::Spot)
-                    {
-                        Vector3 start = light->GetTransform()->GetPosition();
-                        Vector3 end = light->GetTransform()->GetForward() * light->GetRange();
-                        DrawLine(start, start + end, Vector4(0, 1, 0, 1));
-                    }
-                }
-            }
-
-            // AABBs
-            if (draw_aabb)
-            {
-                for (const auto& entity : m_entities[Renderer_Object_Opaque])
-                {
-                    if (auto renderable = entity->GetRenderable())
-                    {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
-                    }
-                }
-
-                for (const auto& entity : m_entities[Renderer_Object_Transparent])
-                {
-                    if (auto renderable = entity->GetRenderable())
-                    {
-                        DrawBox(renderable->GetAabb(), Vector4(0.41f, 0.86f, 1.0f, 1.0f));
-                    }
-                }
-            }
-        }
-
         // Draw lines with depth
         {
             // Grid
@@ -1809,7 +2155,7 @@ namespace Spartan
                 {
                     // Update uber buffer
                     m_buffer_uber_cpu.resolution    = m_resolution;
-                    m_buffer_uber_cpu.transform     = m_gizmo_grid->ComputeWorldMatrix(m_camera->GetTransform()) * m_buffer_frame_cpu.view_projection_unjittered;
+                    m_buffer_uber_cpu.transform     = frame.grid_transform * m_buffer_frame_cpu.view_projection_unjittered;
                     UpdateUberBuffer(cmd_list);
 
                     cmd_list->SetBufferIndex(m_gizmo_grid->GetIndexBuffer().get());
@@ -1820,7 +2166,7 @@ namespace Spartan
             }
 
             // Lines
-            const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_enabled.size());
+            const auto line_vertex_buffer_size = static_cast<uint32_t>(frame.lines_depth_enabled.size());
             if (line_vertex_buffer_size != 0)
             {
                 // Grow vertex buffer (if needed)
@@ -1831,9 +2177,8 @@ namespace Spartan
 
                 // Update vertex buffer
                 const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-                copy(m_lines_list_depth_enabled.begin(), m_lines_list_depth_enabled.end(), buffer);
+                copy(frame.lines_depth_enabled.begin(), frame.lines_depth_enabled.end(), buffer);
                 m_vertex_buffer_lines->Unmap();
-                m_lines_list_depth_enabled.clear();
 
                 // Set render state
                 static RHI_PipelineState pipeline_state;
@@ -1860,7 +2205,7 @@ namespace Spartan
         }
 
         // Draw lines without depth
-        const auto line_vertex_buffer_size = static_cast<uint32_t>(m_lines_list_depth_disabled.size());
+        const auto line_vertex_buffer_size = static_cast<uint32_t>(frame.lines_depth_disabled.size());
         if (line_vertex_buffer_size != 0)
         {
             // Grow vertex buffer (if needed)
@@ -1871,9 +2216,8 @@ namespace Spartan
 
             // Update vertex buffer
             const auto buffer = static_cast<RHI_Vertex_PosCol*>(m_vertex_buffer_lines->Map());
-            copy(m_lines_list_depth_disabled.begin(), m_lines_list_depth_disabled.end(), buffer);
+            copy(frame.lines_depth_disabled.begin(), frame.lines_depth_disabled.end(), buffer);
             m_vertex_buffer_lines->Unmap();
-            m_lines_list_depth_disabled.clear();
 
             // Set render state
             static RHI_PipelineState pipeline_state;
@@ -1904,7 +2248,8 @@ namespace Spartan
             return;
 
         // Acquire resources
-        auto& lights                    = m_entities[Renderer_Object_Light];
+        const FrameSnapshot& frame      = m_frames[m_frame_index_render];
+        const auto& lights              = frame.lights;
 		const auto& shader_quad_v       = m_shaders[Shader_Quad_V];
         const auto& shader_texture_p    = m_shaders[Shader_Texture_P];
 		if (lights.empty() || !shader_quad_v->IsCompiled() || !shader_texture_p->IsCompiled())
@@ -1924,60 +2269,51 @@ namespace Spartan
         pipeline_state.pass_name                        = "Pass_Gizmos_Lights";
 
         // For each light
-        for (const auto& entity : lights)
+        for (const FrameLight& frame_light : lights)
         {
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
-                // Light can be null if it just got removed and our buffer doesn't update till the next frame
-                if (Light* light = entity->GetComponent<Light>())
+                // Only draw if it's inside our view (determined when the frame was captured)
+                if (frame_light.icon_visible)
                 {
-                    auto position_light_world       = entity->GetTransform()->GetPosition();
-                    auto position_camera_world      = m_camera->GetTransform()->GetPosition();
-                    auto direction_camera_to_light  = (position_light_world - position_camera_world).Normalized();
-                    const auto v_dot_l                    = Vector3::Dot(m_camera->GetTransform()->GetForward(), direction_camera_to_light);
-        
-                    // Only draw if it's inside our view
-                    if (v_dot_l > 0.5f)
+                    // Compute light scale (based on distance from the camera)
+                    const auto& position_light_screen   = frame_light.position_screen;
+                    const auto distance                 = (frame.camera.position - frame_light.position).Length() + Helper::M_EPSILON;
+                    auto scale                          = m_gizmo_size_max / distance;
+                    scale                               = Helper::Clamp(scale, m_gizmo_size_min, m_gizmo_size_max);
+    
+                    // Choose texture based on light type
+                    shared_ptr<RHI_Texture> light_tex = nullptr;
+                    const auto type = frame_light.type;
+                    if (type == LightType::Directional)	light_tex = m_gizmo_tex_light_directional;
+                    else if (type == LightType::Point)	light_tex = m_gizmo_tex_light_point;
+                    else if (type == LightType::Spot)	light_tex = m_gizmo_tex_light_spot;
+    
+                    // Construct appropriate rectangle
+                    const auto tex_width = light_tex->GetWidth() * scale;
+                    const auto tex_height = light_tex->GetHeight() * scale;
+                    auto rectangle = Math::Rectangle
+                    (
+                        position_light_screen.x - tex_width * 0.5f,
+                        position_light_screen.y - tex_height * 0.5f,
+                        position_light_screen.x + tex_width,
+                        position_light_screen.y + tex_height
+                    );
+                    if (rectangle != m_gizmo_light_rect)
                     {
-                        // Compute light screen space position and scale (based on distance from the camera)
-                        const auto position_light_screen    = m_camera->Project(position_light_world);
-                        const auto distance                 = (position_camera_world - position_light_world).Length() + Helper::M_EPSILON;
-                        auto scale                          = m_gizmo_size_max / distance;
-                        scale                               = Helper::Clamp(scale, m_gizmo_size_min, m_gizmo_size_max);
-        
-                        // Choose texture based on light type
-                        shared_ptr<RHI_Texture> light_tex = nullptr;
-                        const auto type = light->GetLightType();
-                        if (type == LightType::Directional)	light_tex = m_gizmo_tex_light_directional;
-                        else if (type == LightType::Point)	light_tex = m_gizmo_tex_light_point;
-                        else if (type == LightType::Spot)	light_tex = m_gizmo_tex_light_spot;
-        
-                        // Construct appropriate rectangle
-                        const auto tex_width = light_tex->GetWidth() * scale;
-                        const auto tex_height = light_tex->GetHeight() * scale;
-                        auto rectangle = Math::Rectangle
-                        (
-                            position_light_screen.x - tex_width * 0.5f,
-                            position_light_screen.y - tex_height * 0.5f,
-                            position_light_screen.x + tex_width,
-                            position_light_screen.y + tex_height
-                        );
-                        if (rectangle != m_gizmo_light_rect)
-                        {
-                            m_gizmo_light_rect = rectangle;
-                            m_gizmo_light_rect.CreateBuffers(this);
-                        }
-        
-                        // Update uber buffer
-                        m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_width), static_cast<float>(tex_width));
-                        m_buffer_uber_cpu.transform = m_buffer_frame_cpu.view_projection_ortho;
-                        UpdateUberBuffer(cmd_list);
-        
-                        cmd_list->SetTexture(28, light_tex);
-                        cmd_list->SetBufferIndex(m_gizmo_light_rect.GetIndexBuffer());
-                        cmd_list->SetBufferVertex(m_gizmo_light_rect.GetVertexBuffer());
-                        cmd_list->DrawIndexed(Rectangle::GetIndexCount());
+                        m_gizmo_light_rect = rectangle;
+                        m_gizmo_light_rect.CreateBuffers(this);
                     }
+    
+                    // Update uber buffer
+                    m_buffer_uber_cpu.resolution = Vector2(static_cast<float>(tex_width), static_cast<float>(tex_width));
+                    m_buffer_uber_cpu.transform = m_buffer_frame_cpu.view_projection_ortho;
+                    UpdateUberBuffer(cmd_list);
+    
+                    cmd_list->SetTexture(28, light_tex);
+                    cmd_list->SetBufferIndex(m_gizmo_light_rect.GetIndexBuffer());
+                    cmd_list->SetBufferVertex(m_gizmo_light_rect.GetVertexBuffer());
+                    cmd_list->DrawIndexed(Rectangle::GetIndexCount());
                 }
                 cmd_list->EndRenderPass();
             }
@@ -1995,8 +2331,8 @@ namespace Spartan
         if (!shader_gizmo_transform_v->IsCompiled() || !shader_gizmo_transform_p->IsCompiled())
             return;
 
-        // Transform
-        if (m_gizmo_transform->Update(m_camera.get(), m_gizmo_transform_size, m_gizmo_transform_speed))
+        // Transform (the gizmo is updated by the simulation, after the previous frame was recorded)
+        if (m_frames[m_frame_index_render].gizmo_transform_visible)
         {
             // Set render state
             static RHI_PipelineState pipeline_state;
@@ -2076,26 +2412,25 @@ namespace Spartan
         if (!GetOption(Render_Debug_SelectionOutline))
             return;
 
-        if (const Entity* entity = m_gizmo_transform->GetSelectedEntity())
+        const FrameSnapshot& frame = m_frames[m_frame_index_render];
+        if (frame.outline_visible)
         {
-            // Get renderable
-            const Renderable* renderable = entity->GetRenderable();
-            if (!renderable)
-                return;
+            const FrameRenderable& renderable = frame.outline;
 
             // Get material
-            const Material* material = renderable->GetMaterial();
+            const FrameMaterial* material = renderable.material;
             if (!material)
                 return;
 
             // Get geometry
-            const Model* model = renderable->GeometryModel();
-            if (!model || !model->GetVertexBuffer() || !model->GetIndexBuffer())
+            const RHI_VertexBuffer* vertex_buffer = renderable.vertex_buffer.get();
+            const RHI_IndexBuffer* index_buffer   = renderable.index_buffer.get();
+            if (!vertex_buffer || !index_buffer)
                 return;
 
             // Acquire shaders
-            const auto& shader_v = m_shaders[Shader_Entity_V];
-            const auto& shader_p = m_shaders[Shader_Entity_Outline_P];
+            RHI_Shader* shader_v = GetShaderVertex(Shader_Entity_V, false, renderable.quantized);
+            RHI_Shader* shader_p = m_shaders[Shader_Entity_Outline_P].get();
             if (!shader_v->IsCompiled() || !shader_p->IsCompiled())
                 return;
 
@@ -2104,12 +2439,12 @@ namespace Spartan
 
             // Set render state
             static RHI_PipelineState pipeline_state;
-            pipeline_state.shader_vertex                            = shader_v.get();
-            pipeline_state.shader_pixel                             = shader_p.get();
+            pipeline_state.shader_vertex                            = shader_v;
+            pipeline_state.shader_pixel                             = shader_p;
             pipeline_state.rasterizer_state                         = m_rasterizer_cull_back_solid.get();
             pipeline_state.blend_state                              = m_blend_alpha.get();
             pipeline_state.depth_stencil_state                      = m_depth_stencil_on_off_r.get();
-            pipeline_state.vertex_buffer_stride                     = model->GetVertexBuffer()->GetStride();
+            pipeline_state.vertex_buffer_stride                     = vertex_buffer->GetStride();
             pipeline_state.render_target_color_textures[0]          = tex_out.get();
             pipeline_state.render_target_depth_texture              = tex_depth;
             pipeline_state.render_target_depth_texture_read_only    = true;
@@ -2121,18 +2456,15 @@ namespace Spartan
             if (cmd_list->BeginRenderPass(pipeline_state))
             {
                  // Update uber buffer with entity transform
-                if (Transform* transform = entity->GetTransform())
-                {
-                    m_buffer_uber_cpu.transform     = transform->GetMatrix();
-                    m_buffer_uber_cpu.resolution    = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
-                    UpdateUberBuffer(cmd_list);
-                }
+                m_buffer_uber_cpu.transform     = renderable.matrix_vertex;
+                m_buffer_uber_cpu.resolution    = Vector2(tex_out->GetWidth(), tex_out->GetHeight());
+                UpdateUberBuffer(cmd_list);
 
                 cmd_list->SetTexture(12, tex_depth);
                 cmd_list->SetTexture(9, tex_normal);
-                cmd_list->SetBufferVertex(model->GetVertexBuffer());
-                cmd_list->SetBufferIndex(model->GetIndexBuffer());
-                cmd_list->DrawIndexed(renderable->GeometryIndexCount(), renderable->GeometryIndexOffset(), renderable->GeometryVertexOffset());
+                cmd_list->SetBufferVertex(vertex_buffer);
+                cmd_list->SetBufferIndex(index_buffer);
+                cmd_list->DrawIndexed(renderable.index_count, renderable.index_offset, renderable.vertex_offset);
                 cmd_list->EndRenderPass();
             }
         }
@@ -2142,7 +2474,8 @@ namespace Spartan
 	{
         // Early exit cases
         const bool draw         = m_options & Render_Debug_PerformanceMetrics;
-        const bool empty        = m_profiler->GetMetrics().empty();
+        const auto& metrics     = m_frames[m_frame_index_render].metrics;
+        const bool empty        = metrics.empty();
         const auto& shader_v    = m_shaders[Shader_Font_V];
         const auto& shader_p    = m_shaders[Shader_Font_P];
         if (!draw || empty || !shader_v->IsCompiled() || !shader_p->IsCompiled())
@@ -2163,7 +2496,7 @@ namespace Spartan
 
         // Update text
         const auto text_pos = Vector2(-m_viewport.width * 0.5f + 5.0f, m_viewport.height * 0.5f - m_font->GetSize() - 2.0f);
-        m_font->SetText(m_profiler->GetMetrics(), text_pos);
+        m_font->SetText(metrics, text_pos);
 
         // Draw outline
         if (m_font->GetOutline() != Font_Outline_None && m_font->GetOutlineSize() != 0)
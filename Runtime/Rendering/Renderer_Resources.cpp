@@ -60,8 +60,14 @@ namespace Spartan
         m_buffer_object_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "object", is_dynamic);
         m_buffer_object_gpu->Create<BufferObject>();
 
+        m_buffer_instances_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "instances", is_dynamic);
+        m_buffer_instances_gpu->Create<BufferInstances>();
+
         m_buffer_light_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "light");
         m_buffer_light_gpu->Create<BufferLight>();
+
+        m_buffer_light_clusters_gpu = make_shared<RHI_ConstantBuffer>(m_rhi_device, "light_clusters");
+        m_buffer_light_clusters_gpu->Create<BufferLightClusters>();
     }
 
     void Renderer::CreateDepthStencilStates()
@@ -72,6 +78,9 @@ namespace Spartan
         m_depth_stencil_on_off_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    false,  GetComparisonFunction(), false, false);                         // depth
         m_depth_stencil_off_on_r    = make_shared<RHI_DepthStencilState>(m_rhi_device, false,   false,  GetComparisonFunction(), true,  false,  RHI_Comparison_Equal);  // depth + stencil
         m_depth_stencil_on_on_w     = make_shared<RHI_DepthStencilState>(m_rhi_device, true,    true,   GetComparisonFunction(), true,  true,   RHI_Comparison_Always); // depth + stencil
+
+        // Overwrites whatever depth is there, used to clear and copy tiles of the shadow atlas
+        m_depth_stencil_on_off_w_always = make_shared<RHI_DepthStencilState>(m_rhi_device, true, true, RHI_Comparison_Always, false, false);
     }
 
     void Renderer::CreateRasterizerStates()
@@ -174,6 +183,28 @@ namespace Spartan
         }
     }
 
+    void Renderer::CreateShadowAtlas()
+    {
+        // Room for 16 tiles of the shadow resolution, as long as the GPU supports it
+        const uint32_t tile_size_max    = GetOptionValue<uint32_t>(Option_Value_ShadowResolution);
+        const uint32_t texture_size_max = GetMaxResolution();
+        uint32_t resolution             = m_resolution_shadow_min;
+        while (resolution < tile_size_max * 4 && resolution * 2 <= texture_size_max)
+        {
+            resolution *= 2;
+        }
+
+        Flush();
+
+        // The static atlas holds the depth of the casters which don't move, the atlas gets a copy of it before the rest are drawn
+        m_render_targets[RenderTarget_Shadow_Atlas_Depth]           = make_shared<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float,      1, 0, "rt_shadow_atlas_depth");
+        m_render_targets[RenderTarget_Shadow_Atlas_Depth_Static]    = make_shared<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float,      1, 0, "rt_shadow_atlas_depth_static");
+        m_render_targets[RenderTarget_Shadow_Atlas_Color]           = make_shared<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_R8G8B8A8_Unorm, 1, 0, "rt_shadow_atlas_color");
+
+        // The render thread resets the tiles. The textures don't need clearing, tiles are cleared before they are drawn to.
+        m_shadow_atlas_dirty = true;
+    }
+
     void Renderer::CreateShaders()
     {
         // Get standard shader directory
@@ -186,6 +217,16 @@ namespace Spartan
         // G-Buffer
         m_shaders[Shader_Gbuffer_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Gbuffer_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Instanced_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Quantized_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Quantized_V]->AddDefine("QUANTIZED");
+        m_shaders[Shader_Gbuffer_Quantized_V]->CompileAsync<RHI_Vertex_PosTexNorTanQuantized>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
+        m_shaders[Shader_Gbuffer_Instanced_Quantized_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Gbuffer_Instanced_Quantized_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Gbuffer_Instanced_Quantized_V]->AddDefine("QUANTIZED");
+        m_shaders[Shader_Gbuffer_Instanced_Quantized_V]->CompileAsync<RHI_Vertex_PosTexNorTanQuantized>(RHI_Shader_Vertex, dir_shaders + "GBuffer.hlsl");
 
         // Quad
         {
@@ -201,9 +242,25 @@ namespace Spartan
         // Depth Vertex
         m_shaders[Shader_Depth_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Depth_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Instanced_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Instanced_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Instanced_V]->CompileAsync<RHI_Vertex_PosTex>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        // Quantized geometry is read as it is, snorm positions and half uvs, the dequantization is part of the transform
+        m_shaders[Shader_Depth_Quantized_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Quantized_V]->CompileAsync<RHI_Vertex_PosTexNorTanQuantized>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
+        m_shaders[Shader_Depth_Instanced_Quantized_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Depth_Instanced_Quantized_V]->AddDefine("INSTANCED");
+        m_shaders[Shader_Depth_Instanced_Quantized_V]->CompileAsync<RHI_Vertex_PosTexNorTanQuantized>(RHI_Shader_Vertex, dir_shaders + "Depth.hlsl");
         m_shaders[Shader_Depth_P] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Depth_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "Depth.hlsl");
 
+        // Shadow atlas
+        m_shaders[Shader_ShadowAtlas_Copy_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ShadowAtlas_Copy_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "ShadowAtlas.hlsl");
+        m_shaders[Shader_ShadowAtlas_Clear_P] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_ShadowAtlas_Clear_P]->AddDefine("CLEAR");
+        m_shaders[Shader_ShadowAtlas_Clear_P]->CompileAsync(RHI_Shader_Pixel, dir_shaders + "ShadowAtlas.hlsl");
+
         // BRDF - Specular Lut
         m_shaders[Shader_BrdfSpecularLut_C] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_BrdfSpecularLut_C]->CompileAsync(RHI_Shader_Compute, dir_shaders + "BRDF_SpecularLut.hlsl");
@@ -334,6 +391,9 @@ namespace Spartan
         // Entity
         m_shaders[Shader_Entity_V] = make_shared<RHI_Shader>(m_context);
         m_shaders[Shader_Entity_V]->CompileAsync<RHI_Vertex_PosTexNorTan>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
+        m_shaders[Shader_Entity_Quantized_V] = make_shared<RHI_Shader>(m_context);
+        m_shaders[Shader_Entity_Quantized_V]->AddDefine("QUANTIZED");
+        m_shaders[Shader_Entity_Quantized_V]->CompileAsync<RHI_Vertex_PosTexNorTanQuantized>(RHI_Shader_Vertex, dir_shaders + "Entity.hlsl");
 
         // Entity - Transform
         m_shaders[Shader_Entity_Transform_P] = make_shared<RHI_Shader>(m_context);
@@ -40,17 +40,17 @@ namespace Spartan
         m_flags = flags;
     }
 
-    ShaderLight* ShaderLight::GetVariation(Context* context, const Light* light, const uint64_t renderer_flags)
+    ShaderLight* ShaderLight::GetVariation(Context* context, const FrameLight& light, const uint64_t renderer_flags)
     {
         // Compute flags
         uint16_t flags = 0;
-        flags |= light->GetLightType() == LightType::Directional                                            ? Shader_Light_Directional              : flags;
-        flags |= light->GetLightType() == LightType::Point                                                  ? Shader_Light_Point                    : flags;
-        flags |= light->GetLightType() == LightType::Spot                                                   ? Shader_Light_Spot                     : flags;
-        flags |= light->GetShadowsEnabled()                                                                 ? Shader_Light_Shadows                  : flags;
-        flags |= (light->GetShadowsScreenSpaceEnabled() && (renderer_flags & Render_ScreenSpaceShadows))    ? Shader_Light_ShadowsScreenSpace       : flags;
-        flags |= light->GetShadowsTransparentEnabled()                                                      ? Shader_Light_ShadowsTransparent       : flags;
-        flags |= (light->GetVolumetricEnabled() && (renderer_flags & Render_VolumetricLighting))            ? Shader_Light_Volumetric               : flags;
+        flags |= light.type == LightType::Directional                                                   ? Shader_Light_Directional              : flags;
+        flags |= light.type == LightType::Point                                                         ? Shader_Light_Point                    : flags;
+        flags |= light.type == LightType::Spot                                                          ? Shader_Light_Spot                     : flags;
+        flags |= light.shadows_enabled                                                                  ? Shader_Light_Shadows                  : flags;
+        flags |= (light.shadows_screen_space_enabled && (renderer_flags & Render_ScreenSpaceShadows))   ? Shader_Light_ShadowsScreenSpace       : flags;
+        flags |= light.shadows_transparent_enabled                                                      ? Shader_Light_ShadowsTransparent       : flags;
+        flags |= (light.volumetric_enabled && (renderer_flags & Render_VolumetricLighting))             ? Shader_Light_Volumetric               : flags;
         flags |= (renderer_flags & Render_ScreenSpaceReflections)                                           ? Shader_Light_ScreenSpaceReflections   : flags;
 
         // Return existing shader, if it's already compiled
@@ -61,6 +61,19 @@ namespace Spartan
         return Compile(context, flags);
     }
 
+    ShaderLight* ShaderLight::GetVariationClustered(Context* context)
+    {
+        // The point and spot lights without shadows, shaded together
+        const uint16_t flags = Shader_Light_Clustered;
+
+        // Return existing shader, if it's already compiled
+        if (m_variations.find(flags) != m_variations.end())
+            return m_variations.at(flags).get();
+
+        // Compile new shader
+        return Compile(context, flags);
+    }
+
     ShaderLight* ShaderLight::Compile(Context* context, const uint16_t flags)
     {
         // Shader source file path
@@ -78,6 +91,7 @@ namespace Spartan
         shader->AddDefine("SHADOWS_TRANSPARENT",        (flags & Shader_Light_ShadowsTransparent)       ? "1" : "0");
         shader->AddDefine("VOLUMETRIC",                 (flags & Shader_Light_Volumetric)               ? "1" : "0");
         shader->AddDefine("SCREEN_SPACE_REFLECTIONS",   (flags & Shader_Light_ScreenSpaceReflections)   ? "1" : "0");
+        shader->AddDefine("CLUSTERED",                  (flags & Shader_Light_Clustered)                ? "1" : "0");
 
         // Compile
         shader->CompileAsync(RHI_Shader_Pixel, file_path);
@@ -30,7 +30,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace Spartan
 {
-    class Light;
+    struct FrameLight;
 
     enum Shader_Light_Branch : uint16_t
     {
@@ -42,7 +42,8 @@ namespace Spartan
         Shader_Light_ShadowsScreenSpace     = 1 << 4,
         Shader_Light_ShadowsTransparent     = 1 << 5,
         Shader_Light_Volumetric             = 1 << 6,
-        Shader_Light_ScreenSpaceReflections = 1 << 7
+        Shader_Light_ScreenSpaceReflections = 1 << 7,
+        Shader_Light_Clustered              = 1 << 8
     };
 
     class SPARTAN_CLASS ShaderLight : public RHI_Shader
@@ -51,7 +52,8 @@ namespace Spartan
         ShaderLight(Context* context, const uint16_t flags = 0);
         ~ShaderLight() = default;
 
-        static ShaderLight* GetVariation(Context* context, const Light* light, const uint64_t renderer_flags);
+        static ShaderLight* GetVariation(Context* context, const FrameLight& light, const uint64_t renderer_flags);
+        static ShaderLight* GetVariationClustered(Context* context);
         static auto& GetVariations() { return m_variations; }
 
     private:
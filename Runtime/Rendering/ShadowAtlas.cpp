@@ -0,0 +1,330 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "ShadowAtlas.h"
+#include "../World/Entity.h"
+#include "../Utilities/Hash.h"
+//=============================
+
+//= NAMESPACES ===============
+using namespace std;
+using namespace Spartan::Math;
+//============================
+
+namespace Spartan
+{
+    void ShadowAtlas::SetResolution(const uint32_t resolution, const uint32_t tile_size_max)
+    {
+        m_resolution    = resolution;
+        m_tile_size_max = Helper::Clamp(tile_size_max, m_shadow_atlas_tile_size_min, resolution / 4);
+        m_lights.clear();
+
+        for (uint32_t level = 0; level < m_shadow_atlas_levels; level++)
+        {
+            const uint32_t dimension = 1 << level;
+            m_nodes[level].assign(dimension * dimension, Node_Absent);
+        }
+        m_nodes[0][0] = Node_Free;
+    }
+
+    void ShadowAtlas::Allocate(vector<ShadowAtlasRequest>& requests, const uint64_t frame)
+    {
+        if (m_resolution == 0)
+            return;
+
+        // Lights which were not requested give their tiles back
+        for (const ShadowAtlasRequest& request : requests)
+        {
+            m_lights[request.light_id].frame_used = frame;
+        }
+
+        for (auto it = m_lights.begin(); it != m_lights.end();)
+        {
+            if (it->second.frame_used != frame)
+            {
+                FreeLight(it->second);
+                it = m_lights.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        // The largest lights get their tiles first
+        sort(requests.begin(), requests.end(), [](const ShadowAtlasRequest& a, const ShadowAtlasRequest& b) { return a.size > b.size; });
+
+        // Lights which keep the size of their tiles, keep the tiles (and what's cached in them). Sizes only change once
+        // the size a light calls for is well past the one it has, so that a light at the threshold doesn't flip every frame.
+        vector<pair<ShadowAtlasRequest*, uint32_t>> resized;
+        for (ShadowAtlasRequest& request : requests)
+        {
+            ShadowAtlasLight& light = m_lights[request.light_id];
+            const float size        = Helper::Clamp(request.size, static_cast<float>(m_shadow_atlas_tile_size_min), static_cast<float>(m_tile_size_max));
+            const float size_now    = static_cast<float>(light.tile_size);
+
+            if (light.tile_size != 0 && light.view_count == request.view_count && size < size_now * 1.5f && size > size_now * 0.35f)
+                continue;
+
+            // The nearest power of two
+            uint32_t tile_size = m_tile_size_max;
+            while (tile_size > m_shadow_atlas_tile_size_min && static_cast<float>(tile_size) * 0.75f > size)
+            {
+                tile_size /= 2;
+            }
+
+            if (light.tile_size == tile_size && light.view_count == request.view_count)
+                continue;
+
+            FreeLight(light);
+            resized.emplace_back(&request, tile_size);
+        }
+
+        // If a light doesn't fit, try with smaller tiles, and give up on its shadows if even the smallest don't fit
+        for (const auto& [request, tile_size_requested] : resized)
+        {
+            ShadowAtlasLight& light = m_lights[request->light_id];
+            light.view_count        = Helper::Min(request->view_count, m_max_shadow_views);
+
+            for (uint32_t tile_size = tile_size_requested; tile_size >= m_shadow_atlas_tile_size_min && light.tile_size == 0; tile_size /= 2)
+            {
+                bool allocated = true;
+                for (uint32_t i = 0; i < light.view_count && allocated; i++)
+                {
+                    allocated = AllocateTile(tile_size, light.views[i].tile);
+                }
+
+                if (allocated)
+                {
+                    light.tile_size = tile_size;
+                }
+                else
+                {
+                    FreeLight(light);
+                }
+            }
+        }
+    }
+
+    ShadowAtlasLight* ShadowAtlas::GetLight(const uint32_t light_id)
+    {
+        auto it = m_lights.find(light_id);
+        return it != m_lights.end() ? &it->second : nullptr;
+    }
+
+    void ShadowAtlas::UpdateCasters(const vector<FrameRenderable>& renderables, const uint64_t frame)
+    {
+        m_casters_dynamic.resize(renderables.size());
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(renderables.size()); i++)
+        {
+            const FrameRenderable& renderable = renderables[i];
+
+            // Casters which were never seen before have just been added, so they count as moved
+            const auto [it, added] = m_casters.try_emplace(renderable.entity->GetId());
+            CasterState& caster = it->second;
+            if (added || caster.matrix != renderable.matrix)
+            {
+                caster.matrix       = renderable.matrix;
+                caster.frame_moved  = frame;
+            }
+            caster.frame_seen = frame;
+
+            m_casters_dynamic[i] = frame - caster.frame_moved < m_shadow_caster_static_frames;
+        }
+
+        // Forget the casters which are gone
+        for (auto it = m_casters.begin(); it != m_casters.end();)
+        {
+            it = it->second.frame_seen != frame ? m_casters.erase(it) : ++it;
+        }
+    }
+
+    bool ShadowAtlas::IsCasterDynamic(const FrameRenderable* renderable, const vector<FrameRenderable>& renderables) const
+    {
+        const size_t index = static_cast<size_t>(renderable - renderables.data());
+        return index < m_casters_dynamic.size() ? m_casters_dynamic[index] : true;
+    }
+
+    void ShadowAtlas::UpdateView(ShadowAtlasView& view, const Matrix& view_projection, const FrameDrawList& draw_list, const vector<FrameRenderable>& renderables, const bool transparent) const
+    {
+        // The static casters in the view, as a sum of their hashes so that the order of the draw calls doesn't matter
+        size_t static_signature = 0;
+        bool dynamic            = false;
+        for (const FrameDrawCall& draw_call : draw_list.draw_calls)
+        {
+            const FrameRenderable* renderable = draw_call.renderable;
+            if (IsCasterDynamic(renderable, renderables))
+            {
+                dynamic = true;
+                continue;
+            }
+
+            size_t hash = 0;
+            Utility::Hash::hash_combine(hash, renderable->entity->GetId());
+            Utility::Hash::hash_combine(hash, renderable->model.get());
+            Utility::Hash::hash_combine(hash, renderable->index_offset);
+            static_signature += hash;
+        }
+
+        // The copy of the static depth also erases last frame's dynamic casters, and clears the transparent ones
+        view.render_static  = !view.static_valid || view.view_projection != view_projection || view.static_signature != static_signature;
+        view.render_dynamic = view.render_static || dynamic || view.dynamic_previous || transparent || view.transparent_previous;
+
+        view.view_projection        = view_projection;
+        view.static_signature       = static_signature;
+        view.static_valid           = true;
+        view.dynamic_previous       = dynamic;
+        view.transparent_previous   = transparent;
+    }
+
+    Vector4 ShadowAtlas::GetTileRect(const ShadowAtlasTile& tile) const
+    {
+        if (!tile.IsValid() || m_resolution == 0)
+            return Vector4::Zero;
+
+        const float resolution = static_cast<float>(m_resolution);
+        return Vector4(tile.x / resolution, tile.y / resolution, tile.size / resolution, tile.size / resolution);
+    }
+
+    float ShadowAtlas::GetOccupancy() const
+    {
+        if (m_resolution == 0)
+            return 0.0f;
+
+        uint64_t texels = 0;
+        for (const auto& [id, light] : m_lights)
+        {
+            texels += static_cast<uint64_t>(light.view_count) * light.tile_size * light.tile_size;
+        }
+
+        return static_cast<float>(static_cast<double>(texels) / (static_cast<double>(m_resolution) * m_resolution));
+    }
+
+    bool ShadowAtlas::AllocateTile(const uint32_t size, ShadowAtlasTile& tile)
+    {
+        const uint32_t level    = GetLevel(size);
+        const int32_t node      = FindFreeNode(level);
+        if (node < 0)
+            return false;
+
+        const uint32_t dimension    = 1 << level;
+        m_nodes[level][node]        = Node_Used;
+        tile.level                  = level;
+        tile.node                   = static_cast<uint32_t>(node);
+        tile.size                   = m_resolution >> level;
+        tile.x                      = (node % dimension) * tile.size;
+        tile.y                      = (node / dimension) * tile.size;
+
+        return true;
+    }
+
+    void ShadowAtlas::FreeTile(ShadowAtlasTile& tile)
+    {
+        if (!tile.IsValid())
+            return;
+
+        uint32_t level  = tile.level;
+        uint32_t node   = tile.node;
+        m_nodes[level][node] = Node_Free;
+        tile = ShadowAtlasTile();
+
+        // Merge with the siblings, for as long as they are free too
+        while (level > 0)
+        {
+            const uint32_t dimension    = 1 << level;
+            const uint32_t x            = (node % dimension) & ~1u;
+            const uint32_t y            = (node / dimension) & ~1u;
+            const uint32_t siblings[4]  = { y * dimension + x, y * dimension + x + 1, (y + 1) * dimension + x, (y + 1) * dimension + x + 1 };
+
+            for (uint32_t sibling : siblings)
+            {
+                if (m_nodes[level][sibling] != Node_Free)
+                    return;
+            }
+
+            for (uint32_t sibling : siblings)
+            {
+                m_nodes[level][sibling] = Node_Absent;
+            }
+
+            level--;
+            node                    = (y / 2) * (dimension / 2) + (x / 2);
+            m_nodes[level][node]    = Node_Free;
+        }
+    }
+
+    void ShadowAtlas::FreeLight(ShadowAtlasLight& light)
+    {
+        for (ShadowAtlasView& view : light.views)
+        {
+            FreeTile(view.tile);
+            view = ShadowAtlasView();
+        }
+
+        light.tile_size = 0;
+    }
+
+    int32_t ShadowAtlas::FindFreeNode(const uint32_t level)
+    {
+        // A free node of this size
+        vector<Node_State>& nodes = m_nodes[level];
+        for (uint32_t i = 0; i < static_cast<uint32_t>(nodes.size()); i++)
+        {
+            if (nodes[i] == Node_Free)
+                return static_cast<int32_t>(i);
+        }
+
+        if (level == 0)
+            return -1;
+
+        // Otherwise split a larger one
+        const int32_t parent = FindFreeNode(level - 1);
+        if (parent < 0)
+            return -1;
+
+        const uint32_t dimension_parent = 1 << (level - 1);
+        const uint32_t dimension        = 1 << level;
+        const uint32_t x                = (parent % dimension_parent) * 2;
+        const uint32_t y                = (parent / dimension_parent) * 2;
+
+        m_nodes[level - 1][parent]          = Node_Split;
+        nodes[y * dimension + x]            = Node_Free;
+        nodes[y * dimension + x + 1]        = Node_Free;
+        nodes[(y + 1) * dimension + x]      = Node_Free;
+        nodes[(y + 1) * dimension + x + 1]  = Node_Free;
+
+        return static_cast<int32_t>(y * dimension + x);
+    }
+
+    uint32_t ShadowAtlas::GetLevel(const uint32_t size) const
+    {
+        uint32_t level = 0;
+        while ((m_resolution >> level) > size && level < m_shadow_atlas_levels - 1)
+        {
+            level++;
+        }
+
+        return level;
+    }
+}
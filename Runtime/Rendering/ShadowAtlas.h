@@ -0,0 +1,147 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include "Renderer_Frame.h"
+#include "../Math/Vector4.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    // The atlas is split like a quadtree, level 0 is the whole atlas and every level halves the side of a tile
+    static const uint32_t m_shadow_atlas_levels         = 8;
+    static const uint32_t m_shadow_atlas_tile_size_min  = 128;
+    static const uint64_t m_shadow_caster_static_frames = 60; // a caster which hasn't moved for this many frames is static
+
+    struct ShadowAtlasTile
+    {
+        uint32_t x      = 0; // in texels
+        uint32_t y      = 0;
+        uint32_t size   = 0;
+        uint32_t level  = 0;
+        uint32_t node   = 0; // within the level
+
+        bool IsValid() const { return size != 0; }
+    };
+
+    // A shadow view (a cube face or a spot light) and the state of its tile
+    struct ShadowAtlasView
+    {
+        ShadowAtlasTile tile;
+
+        // What the static depth of the tile was rendered with
+        Math::Matrix view_projection    = Math::Matrix::Identity;
+        size_t static_signature         = 0;
+        bool static_valid               = false;
+
+        // Whether the tile was drawn on top of, last frame
+        bool dynamic_previous           = false;
+        bool transparent_previous       = false;
+
+        // This frame
+        bool render_static              = false; // the static casters have to be rendered into the static atlas
+        bool render_dynamic             = false; // the static depth has to be copied to the atlas (which clears the color), and the dynamic casters rendered on top
+    };
+
+    struct ShadowAtlasLight
+    {
+        std::array<ShadowAtlasView, m_max_shadow_views> views;
+        uint32_t view_count = 0;
+        uint32_t tile_size  = 0; // of every view, 0 if the light didn't fit
+        uint64_t frame_used = 0;
+    };
+
+    // How much of the atlas a light wants this frame
+    struct ShadowAtlasRequest
+    {
+        uint32_t light_id   = 0;
+        uint32_t view_count = 0;
+        float size          = 0.0f; // the tile size, in texels, which its screen space size calls for
+    };
+
+    // Shares one depth texture between the shadows of point and spot lights, every view gets a tile which is sized by how much
+    // of the screen the light covers. The tiles are cached: casters which haven't moved for a while are static, they are rendered
+    // into a second (static) atlas, only when the light or the set of static casters in the view changes. The dynamic casters
+    // are rendered every frame, on top of a copy of the static depth. It doesn't depend on the RHI, the renderer does the drawing.
+    class SPARTAN_CLASS ShadowAtlas
+    {
+    public:
+        ShadowAtlas() = default;
+        ~ShadowAtlas() = default;
+
+        // Frees all tiles, the resolution should be a power of two
+        void SetResolution(uint32_t resolution, uint32_t tile_size_max);
+        uint32_t GetResolution()    const { return m_resolution; }
+        uint32_t GetTileSizeMax()   const { return m_tile_size_max; }
+
+        // Tiles every requested light, lights which are not requested lose their tiles
+        void Allocate(std::vector<ShadowAtlasRequest>& requests, uint64_t frame);
+        ShadowAtlasLight* GetLight(uint32_t light_id);
+
+        // Sorts the casters into static and dynamic, by how long ago they last moved
+        void UpdateCasters(const std::vector<FrameRenderable>& renderables, uint64_t frame);
+        bool IsCasterDynamic(const FrameRenderable* renderable, const std::vector<FrameRenderable>& renderables) const;
+
+        // Decides what has to be rendered for a view this frame, transparent is whether it has transparent casters to draw
+        void UpdateView(ShadowAtlasView& view, const Math::Matrix& view_projection, const FrameDrawList& draw_list, const std::vector<FrameRenderable>& renderables, bool transparent) const;
+
+        // The tile in texture coordinates, offset (xy) and scale (zw)
+        Math::Vector4 GetTileRect(const ShadowAtlasTile& tile) const;
+
+        // Tiles which are in use, out of the ones of the smallest size that fit in the atlas
+        float GetOccupancy() const;
+
+    private:
+        enum Node_State : uint8_t
+        {
+            Node_Absent,    // a parent is free or used
+            Node_Free,
+            Node_Split,
+            Node_Used
+        };
+
+        bool AllocateTile(uint32_t size, ShadowAtlasTile& tile);
+        void FreeTile(ShadowAtlasTile& tile);
+        void FreeLight(ShadowAtlasLight& light);
+        int32_t FindFreeNode(uint32_t level);
+        uint32_t GetLevel(uint32_t size) const;
+
+        struct CasterState
+        {
+            Math::Matrix matrix = Math::Matrix::Identity;
+            uint64_t frame_moved = 0;
+            uint64_t frame_seen  = 0;
+        };
+
+        uint32_t m_resolution       = 0;
+        uint32_t m_tile_size_max    = 0;
+        std::array<std::vector<Node_State>, m_shadow_atlas_levels> m_nodes;
+        std::unordered_map<uint32_t, ShadowAtlasLight> m_lights;
+        std::unordered_map<uint32_t, CasterState> m_casters;
+        std::vector<bool> m_casters_dynamic; // indexed like the renderables
+    };
+}
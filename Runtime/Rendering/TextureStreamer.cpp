@@ -0,0 +1,308 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+//=============================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    void TextureStoreCpu::Add(const uint32_t texture_id, const vector<vector<std::byte>>& mips, const uint32_t mip_resident)
+    {
+        Texture& texture = m_textures[texture_id];
+        texture.mips = mips;
+        texture.mips_resident.clear();
+        SetMipResident(texture_id, mip_resident);
+    }
+
+    const vector<vector<std::byte>>* TextureStoreCpu::GetMipsResident(const uint32_t texture_id) const
+    {
+        auto it = m_textures.find(texture_id);
+        return it != m_textures.end() ? &it->second.mips_resident : nullptr;
+    }
+
+    uint64_t TextureStoreCpu::GetBytesResident() const
+    {
+        uint64_t byte_count = 0;
+        for (const auto& it : m_textures)
+        {
+            for (const vector<std::byte>& mip : it.second.mips_resident)
+            {
+                byte_count += mip.size();
+            }
+        }
+
+        return byte_count;
+    }
+
+    bool TextureStoreCpu::SetMipResident(const uint32_t texture_id, const uint32_t mip)
+    {
+        auto it = m_textures.find(texture_id);
+        if (it == m_textures.end() || mip >= it->second.mips.size())
+            return false;
+
+        Texture& texture = it->second;
+        texture.mips_resident.assign(texture.mips.begin() + mip, texture.mips.end());
+
+        return true;
+    }
+
+    void TextureStreamer::Add(const uint32_t texture_id, const uint32_t width, const uint32_t height, const vector<uint64_t>& byte_counts, const uint32_t mip_resident)
+    {
+        if (byte_counts.empty() || mip_resident >= byte_counts.size())
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return;
+        }
+
+        if (Contains(texture_id))
+            return;
+
+        TextureStreamerTexture& texture = m_textures[texture_id];
+        texture.width           = width;
+        texture.height          = height;
+        texture.mip_count       = static_cast<uint32_t>(byte_counts.size());
+        texture.mip_tail        = GetMipTail(width, height, texture.mip_count);
+        texture.mip_resident    = mip_resident;
+        texture.mip_wanted      = mip_resident;
+        texture.mip_target      = mip_resident;
+
+        // The byte count of every chain is a sum from the mip to the end
+        texture.byte_counts.resize(byte_counts.size() + 1);
+        texture.byte_counts.back() = 0;
+        for (int32_t mip = texture.mip_count - 1; mip >= 0; mip--)
+        {
+            texture.byte_counts[mip] = texture.byte_counts[mip + 1] + byte_counts[mip];
+        }
+
+        m_bytes_resident += texture.GetByteCount(mip_resident);
+    }
+
+    void TextureStreamer::Remove(const uint32_t texture_id)
+    {
+        auto it = m_textures.find(texture_id);
+        if (it == m_textures.end())
+            return;
+
+        m_bytes_resident -= it->second.GetByteCount(it->second.mip_resident);
+        m_textures.erase(it);
+    }
+
+    const TextureStreamerTexture* TextureStreamer::GetTexture(const uint32_t texture_id) const
+    {
+        auto it = m_textures.find(texture_id);
+        return it != m_textures.end() ? &it->second : nullptr;
+    }
+
+    void TextureStreamer::Request(const uint32_t texture_id, const float size, const uint64_t frame)
+    {
+        auto it = m_textures.find(texture_id);
+        if (it == m_textures.end())
+            return;
+
+        TextureStreamerTexture& texture = it->second;
+        const uint32_t mip              = GetMip(texture, size);
+
+        // The first request of a frame replaces the previous frame's
+        if (texture.frame_used != frame)
+        {
+            texture.frame_used  = frame;
+            texture.mip_wanted  = mip;
+            texture.size        = size;
+        }
+        else
+        {
+            texture.mip_wanted  = Math::Helper::Min(texture.mip_wanted, mip);
+            texture.size        = Math::Helper::Max(texture.size, size);
+        }
+    }
+
+    void TextureStreamer::Update(ITextureStore& store, const uint64_t frame)
+    {
+        m_bytes_streamed = 0;
+
+        // Forget the textures which are gone
+        for (auto it = m_textures.begin(); it != m_textures.end();)
+        {
+            if (store.IsValid(it->first))
+            {
+                it++;
+                continue;
+            }
+
+            m_bytes_resident -= it->second.GetByteCount(it->second.mip_resident);
+            it = m_textures.erase(it);
+        }
+
+        // The textures which were requested this frame want what they asked for, the rest keep what they have, unless the budget needs it
+        uint64_t byte_count = 0;
+        for (auto& it : m_textures)
+        {
+            TextureStreamerTexture& texture = it.second;
+            texture.mip_target  = texture.frame_used == frame ? texture.mip_wanted : texture.mip_resident;
+            byte_count          += texture.GetByteCount(texture.mip_target);
+        }
+
+        if (byte_count > m_budget)
+        {
+            // Drop the textures which are not in use to their tails, the least recently used first
+            m_textures_sorted.clear();
+            for (auto& it : m_textures)
+            {
+                if (it.second.frame_used != frame && it.second.mip_target < it.second.mip_tail)
+                {
+                    m_textures_sorted.emplace_back(it.first, &it.second);
+                }
+            }
+
+            sort(m_textures_sorted.begin(), m_textures_sorted.end(), [](const auto& a, const auto& b) { return a.second->frame_used < b.second->frame_used; });
+
+            for (auto& it : m_textures_sorted)
+            {
+                if (byte_count <= m_budget)
+                    break;
+
+                TextureStreamerTexture& texture = *it.second;
+                byte_count          -= texture.GetByteCount(texture.mip_target) - texture.GetByteCount(texture.mip_tail);
+                texture.mip_target  = texture.mip_tail;
+            }
+
+            // Then lower the resolution of the ones in use, a mip at a time, always of the texture which takes the most (it has the most to give)
+            m_textures_sorted.clear();
+            for (auto& it : m_textures)
+            {
+                if (it.second.frame_used == frame && it.second.mip_target < it.second.mip_tail)
+                {
+                    m_textures_sorted.emplace_back(it.first, &it.second);
+                }
+            }
+
+            const auto takes_less = [](const auto& a, const auto& b) { return a.second->GetByteCount(a.second->mip_target) < b.second->GetByteCount(b.second->mip_target); };
+            make_heap(m_textures_sorted.begin(), m_textures_sorted.end(), takes_less);
+            while (byte_count > m_budget && !m_textures_sorted.empty())
+            {
+                pop_heap(m_textures_sorted.begin(), m_textures_sorted.end(), takes_less);
+                TextureStreamerTexture& texture = *m_textures_sorted.back().second;
+                byte_count -= texture.GetByteCount(texture.mip_target) - texture.GetByteCount(texture.mip_target + 1);
+                texture.mip_target++;
+
+                if (texture.mip_target < texture.mip_tail)
+                {
+                    push_heap(m_textures_sorted.begin(), m_textures_sorted.end(), takes_less);
+                }
+                else
+                {
+                    m_textures_sorted.pop_back();
+                }
+            }
+        }
+
+        m_textures_failed.clear();
+
+        // Evict first, so that the resident mips don't go over the budget while streaming in
+        m_textures_sorted.clear();
+        for (auto& it : m_textures)
+        {
+            TextureStreamerTexture& texture = it.second;
+            if (texture.mip_target > texture.mip_resident)
+            {
+                SetMipResident(store, it.first, texture, texture.mip_target);
+            }
+            else if (texture.mip_target < texture.mip_resident)
+            {
+                m_textures_sorted.emplace_back(it.first, &texture);
+            }
+        }
+
+        // Stream in, the textures which are the furthest from their target (and then the largest on the screen) first
+        sort(m_textures_sorted.begin(), m_textures_sorted.end(), [](const auto& a, const auto& b)
+        {
+            const uint32_t distance_a = a.second->mip_resident - a.second->mip_target;
+            const uint32_t distance_b = b.second->mip_resident - b.second->mip_target;
+            return distance_a != distance_b ? distance_a > distance_b : a.second->size > b.second->size;
+        });
+
+        for (auto& it : m_textures_sorted)
+        {
+            // The whole chain is uploaded, and there is always room for one texture, so that a large one doesn't wait forever
+            TextureStreamerTexture& texture = *it.second;
+            const uint64_t byte_count_chain = texture.GetByteCount(texture.mip_target);
+            if (m_bytes_streamed != 0 && m_bytes_streamed + byte_count_chain > m_bytes_per_frame)
+                break;
+
+            if (SetMipResident(store, it.first, texture, texture.mip_target))
+            {
+                m_bytes_streamed += byte_count_chain;
+            }
+        }
+
+        for (const uint32_t texture_id : m_textures_failed)
+        {
+            Remove(texture_id);
+        }
+    }
+
+    uint32_t TextureStreamer::GetMip(const TextureStreamerTexture& texture, const float size)
+    {
+        if (size <= 0.0f)
+            return texture.mip_tail;
+
+        // Every mip halves the resolution, so the one which is at least as large as the size is log2(resolution / size), rounded down
+        const float ratio   = static_cast<float>(Math::Helper::Max(texture.width, texture.height)) / size;
+        const uint32_t mip  = ratio <= 1.0f ? 0 : static_cast<uint32_t>(log2(ratio));
+
+        return Math::Helper::Min(mip, texture.mip_tail);
+    }
+
+    uint32_t TextureStreamer::GetMipTail(const uint32_t width, const uint32_t height, const uint32_t mip_count)
+    {
+        uint32_t mip = 0;
+        while (mip + 1 < mip_count && Math::Helper::Max(width >> mip, height >> mip) > m_texture_streaming_tail_size)
+        {
+            mip++;
+        }
+
+        return mip;
+    }
+
+    bool TextureStreamer::SetMipResident(ITextureStore& store, const uint32_t texture_id, TextureStreamerTexture& texture, const uint32_t mip)
+    {
+        // The store couldn't do it, so the texture stops being streamed (it keeps whatever it has)
+        if (!store.SetMipResident(texture_id, mip))
+        {
+            m_textures_failed.emplace_back(texture_id);
+            return false;
+        }
+
+        m_bytes_resident        -= texture.GetByteCount(texture.mip_resident);
+        m_bytes_resident        += texture.GetByteCount(mip);
+        texture.mip_resident    = mip;
+
+        return true;
+    }
+}
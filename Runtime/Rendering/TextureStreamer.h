@@ -0,0 +1,137 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <unordered_map>
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    // Streamed textures always keep the mips which are this small (or smaller) resident, so that there is something to sample
+    static const uint32_t m_texture_streaming_tail_size         = 128;
+    static const uint64_t m_texture_streaming_bytes_per_frame   = 32 * 1024 * 1024;
+
+    // Where the mips of the streamed textures live. The renderer's store uploads them to the GPU, TextureStoreCpu keeps
+    // them in memory, which is enough to exercise the streamer's decisions without a GPU.
+    class SPARTAN_CLASS ITextureStore
+    {
+    public:
+        virtual ~ITextureStore() = default;
+
+        // Whether the texture is still around, the streamer forgets the ones that aren't
+        virtual bool IsValid(uint32_t texture_id) const = 0;
+
+        // Makes the mips from mip to the end of the chain resident, and only those. A store may do it asynchronously, in which case it
+        // returns once the work is queued and the mips become resident a few frames later (the budget counts them from the start)
+        virtual bool SetMipResident(uint32_t texture_id, uint32_t mip) = 0;
+    };
+
+    // A store which keeps every texture's whole chain in memory, and copies out the resident part of it
+    class SPARTAN_CLASS TextureStoreCpu : public ITextureStore
+    {
+    public:
+        void Add(uint32_t texture_id, const std::vector<std::vector<std::byte>>& mips, uint32_t mip_resident);
+        void Remove(uint32_t texture_id) { m_textures.erase(texture_id); }
+        const std::vector<std::vector<std::byte>>* GetMipsResident(uint32_t texture_id) const;
+        uint64_t GetBytesResident() const;
+
+        //= ITextureStore ==================================================
+        bool IsValid(uint32_t texture_id) const override { return m_textures.count(texture_id) != 0; }
+        bool SetMipResident(uint32_t texture_id, uint32_t mip) override;
+        //==================================================================
+
+    private:
+        struct Texture
+        {
+            std::vector<std::vector<std::byte>> mips;
+            std::vector<std::vector<std::byte>> mips_resident;
+        };
+
+        std::unordered_map<uint32_t, Texture> m_textures;
+    };
+
+    struct TextureStreamerTexture
+    {
+        uint32_t width          = 0;
+        uint32_t height         = 0;
+        uint32_t mip_count      = 0;
+        uint32_t mip_tail       = 0; // the first mip of the tail, which is never evicted
+        uint32_t mip_resident   = 0;
+        uint32_t mip_wanted     = 0; // by the requests of the frame it was last used in
+        uint32_t mip_target     = 0; // what the last update settled on, within the budget
+        uint64_t frame_used     = 0;
+        float size              = 0.0f; // the largest request of the frame it was last used in, in pixels
+        std::vector<uint64_t> byte_counts; // of the chain from every mip to the end, plus a zero
+
+        uint64_t GetByteCount(const uint32_t mip) const { return byte_counts[mip]; }
+    };
+
+    // Decides which mips of which textures are resident. The renderables ask for their textures to be as sharp as they appear
+    // on the screen, the streamer streams in what was asked for, the textures which are the furthest from it first and as much as
+    // a frame allows. When the resident mips don't fit in the budget, it evicts the least recently used textures down to their
+    // tails and then lowers the resolution of the ones in use, a mip at a time, the largest first. It doesn't depend on the RHI, it works through a store.
+    class SPARTAN_CLASS TextureStreamer
+    {
+    public:
+        TextureStreamer() = default;
+        ~TextureStreamer() = default;
+
+        // Starts tracking a texture, byte_counts has the byte count of every mip of the chain
+        void Add(uint32_t texture_id, uint32_t width, uint32_t height, const std::vector<uint64_t>& byte_counts, uint32_t mip_resident);
+        void Remove(uint32_t texture_id);
+        bool Contains(const uint32_t texture_id) const { return m_textures.count(texture_id) != 0; }
+        const TextureStreamerTexture* GetTexture(uint32_t texture_id) const;
+
+        // Asks for the texture to be sharp enough to cover size pixels of the screen, the largest request of a frame wins
+        void Request(uint32_t texture_id, float size, uint64_t frame);
+
+        // Evicts and streams in, through the store, to get as close to this frame's requests as the budget allows
+        void Update(ITextureStore& store, uint64_t frame);
+
+        // The mip which a texture needs to cover size pixels of the screen, assuming that its uvs span the renderable once
+        static uint32_t GetMip(const TextureStreamerTexture& texture, float size);
+        // The first mip which fits within the tail size
+        static uint32_t GetMipTail(uint32_t width, uint32_t height, uint32_t mip_count);
+
+        uint64_t GetBudget()        const { return m_budget; }
+        void SetBudget(const uint64_t budget) { m_budget = budget; }
+        uint64_t GetBytesPerFrame() const { return m_bytes_per_frame; }
+        void SetBytesPerFrame(const uint64_t bytes_per_frame) { m_bytes_per_frame = bytes_per_frame; }
+        uint64_t GetBytesResident() const { return m_bytes_resident; }
+        uint64_t GetBytesStreamed() const { return m_bytes_streamed; } // last update
+
+    private:
+        bool SetMipResident(ITextureStore& store, uint32_t texture_id, TextureStreamerTexture& texture, uint32_t mip);
+
+        std::unordered_map<uint32_t, TextureStreamerTexture> m_textures;
+        std::vector<std::pair<uint32_t, TextureStreamerTexture*>> m_textures_sorted;
+        std::vector<uint32_t> m_textures_failed;
+        uint64_t m_budget           = 1024ull * 1024 * 1024;
+        uint64_t m_bytes_per_frame  = m_texture_streaming_bytes_per_frame;
+        uint64_t m_bytes_resident   = 0;
+        uint64_t m_bytes_streamed   = 0;
+    };
+}
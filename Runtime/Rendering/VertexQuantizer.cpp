@@ -0,0 +1,227 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include "Spartan.h"
+#include "VertexQuantizer.h"
+#include "../RHI/RHI_Vertex.h"
+//=============================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Math;
+//=============================
+
+namespace Spartan
+{
+    static int16_t snorm16(const float value)
+    {
+        return static_cast<int16_t>(lrintf(Helper::Clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    static float snorm16_to_float(const int16_t value)
+    {
+        return Helper::Max(static_cast<float>(value) / 32767.0f, -1.0f);
+    }
+
+    // Rounds to the nearest half, ties to even, like the GPU does
+    static uint16_t float_to_half(const float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const uint32_t sign     = (bits >> 16) & 0x8000;
+        const uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+        // Infinity, or nan, or too large (65520 and up round to infinity)
+        if (abs_bits >= 0x477FF000)
+            return static_cast<uint16_t>(sign | (abs_bits > 0x7F800000 ? 0x7E00 : 0x7C00));
+
+        // Smaller than the smallest normal half (2^-14), the mantissa is the value in units of 2^-24
+        if (abs_bits < 0x38800000)
+            return static_cast<uint16_t>(sign | static_cast<uint32_t>(lrintf(fabsf(value) * 16777216.0f)));
+
+        // Normal, rebias the exponent and round the mantissa from 23 to 10 bits
+        uint32_t half           = (abs_bits - 0x38000000) >> 13;
+        const uint32_t rest     = abs_bits & 0x1FFF;
+        half                   += (rest > 0x1000 || (rest == 0x1000 && (half & 1))) ? 1 : 0;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    static float half_to_float(const uint16_t half)
+    {
+        const uint32_t sign     = static_cast<uint32_t>(half & 0x8000) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1F;
+        const uint32_t mantissa = half & 0x3FF;
+
+        if (exponent == 0)
+        {
+            const float value = static_cast<float>(mantissa) / 16777216.0f;
+            return sign ? -value : value;
+        }
+
+        const uint32_t bits = sign | (exponent == 31 ? (0x7F800000 | (mantissa << 13)) : (((exponent + 112) << 23) | (mantissa << 13)));
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Projects a direction onto the octahedron and unfolds the lower half over the upper one, a zero vector decodes to +z
+    static void octahedral_encode(const float* direction, int16_t* encoded)
+    {
+        const float length = fabsf(direction[0]) + fabsf(direction[1]) + fabsf(direction[2]);
+        float x = length > 0.0f ? direction[0] / length : 0.0f;
+        float y = length > 0.0f ? direction[1] / length : 0.0f;
+
+        if (direction[2] < 0.0f)
+        {
+            const float x_folded = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float y_folded = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = x_folded;
+            y = y_folded;
+        }
+
+        encoded[0] = snorm16(x);
+        encoded[1] = snorm16(y);
+    }
+
+    // Same as octahedral_decode() in Common_Vertex.hlsl
+    static void octahedral_decode(const int16_t* encoded, float* direction)
+    {
+        float x         = snorm16_to_float(encoded[0]);
+        float y         = snorm16_to_float(encoded[1]);
+        const float z   = 1.0f - fabsf(x) - fabsf(y);
+        const float t   = Helper::Saturate(-z);
+        x              += x >= 0.0f ? -t : t;
+        y              += y >= 0.0f ? -t : t;
+
+        const float length = sqrtf(x * x + y * y + z * z);
+        direction[0] = x / length;
+        direction[1] = y / length;
+        direction[2] = z / length;
+    }
+
+    bool VertexQuantizer::Fit(const vector<RHI_Vertex_PosTexNorTan>& vertices, const vector<uint32_t>& indices)
+    {
+        if (vertices.empty())
+            return false;
+
+        // Cube around the bounds
+        Vector3 min = Vector3::Infinity;
+        Vector3 max = Vector3::InfinityNeg;
+        for (const RHI_Vertex_PosTexNorTan& vertex : vertices)
+        {
+            min.x = Helper::Min(min.x, vertex.pos[0]);
+            min.y = Helper::Min(min.y, vertex.pos[1]);
+            min.z = Helper::Min(min.z, vertex.pos[2]);
+            max.x = Helper::Max(max.x, vertex.pos[0]);
+            max.y = Helper::Max(max.y, vertex.pos[1]);
+            max.z = Helper::Max(max.z, vertex.pos[2]);
+        }
+
+        const Vector3 extents   = (max - min) * 0.5f;
+        const float extent      = Helper::Max3(extents.x, extents.y, extents.z);
+        if (!(extent > 0.0f) || !isfinite(extent))
+            return false;
+
+        // Positions are off by up to half a step, which has to be small compared to the triangles
+        if (!indices.empty())
+        {
+            double edge_length_sum = 0.0;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                const RHI_Vertex_PosTexNorTan& a = vertices[indices[i + 0]];
+                const RHI_Vertex_PosTexNorTan& b = vertices[indices[i + 1]];
+                const RHI_Vertex_PosTexNorTan& c = vertices[indices[i + 2]];
+                const Vector3 pa = Vector3(a.pos[0], a.pos[1], a.pos[2]);
+                const Vector3 pb = Vector3(b.pos[0], b.pos[1], b.pos[2]);
+                const Vector3 pc = Vector3(c.pos[0], c.pos[1], c.pos[2]);
+                edge_length_sum += static_cast<double>((pb - pa).Length() + (pc - pb).Length() + (pa - pc).Length());
+            }
+
+            const double edge_length_average = edge_length_sum / static_cast<double>(indices.size() - indices.size() % 3);
+            const double error_position      = 0.5 * static_cast<double>(extent) / 32767.0;
+            if (error_position > m_vertex_quantization_position_error * edge_length_average)
+                return false;
+        }
+
+        // Uvs which are far from the 0-1 range lose too much precision as halfs
+        for (const RHI_Vertex_PosTexNorTan& vertex : vertices)
+        {
+            for (const float uv : vertex.tex)
+            {
+                if (!(fabsf(half_to_float(float_to_half(uv)) - uv) <= m_vertex_quantization_uv_error))
+                    return false;
+            }
+        }
+
+        m_center = (min + max) * 0.5f;
+        m_extent = extent;
+
+        return true;
+    }
+
+    void VertexQuantizer::Quantize(const RHI_Vertex_PosTexNorTan* vertices, const uint32_t vertex_count, RHI_Vertex_PosTexNorTanQuantized* vertices_quantized) const
+    {
+        const float extent_inverse = 1.0f / m_extent;
+
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            const RHI_Vertex_PosTexNorTan& vertex       = vertices[i];
+            RHI_Vertex_PosTexNorTanQuantized& quantized = vertices_quantized[i];
+
+            quantized.pos[0] = snorm16((vertex.pos[0] - m_center.x) * extent_inverse);
+            quantized.pos[1] = snorm16((vertex.pos[1] - m_center.y) * extent_inverse);
+            quantized.pos[2] = snorm16((vertex.pos[2] - m_center.z) * extent_inverse);
+            quantized.pos[3] = 32767;
+
+            quantized.tex[0] = float_to_half(vertex.tex[0]);
+            quantized.tex[1] = float_to_half(vertex.tex[1]);
+
+            octahedral_encode(vertex.nor, &quantized.nor_tan[0]);
+            octahedral_encode(vertex.tan, &quantized.nor_tan[2]);
+        }
+    }
+
+    void VertexQuantizer::Dequantize(const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized, const uint32_t vertex_count, RHI_Vertex_PosTexNorTan* vertices) const
+    {
+        for (uint32_t i = 0; i < vertex_count; i++)
+        {
+            const RHI_Vertex_PosTexNorTanQuantized& quantized   = vertices_quantized[i];
+            RHI_Vertex_PosTexNorTan& vertex                     = vertices[i];
+
+            vertex.pos[0] = m_center.x + snorm16_to_float(quantized.pos[0]) * m_extent;
+            vertex.pos[1] = m_center.y + snorm16_to_float(quantized.pos[1]) * m_extent;
+            vertex.pos[2] = m_center.z + snorm16_to_float(quantized.pos[2]) * m_extent;
+
+            vertex.tex[0] = half_to_float(quantized.tex[0]);
+            vertex.tex[1] = half_to_float(quantized.tex[1]);
+
+            octahedral_decode(&quantized.nor_tan[0], vertex.nor);
+            octahedral_decode(&quantized.nor_tan[2], vertex.tan);
+        }
+    }
+
+    Matrix VertexQuantizer::GetDequantization() const
+    {
+        return Matrix(m_center, Quaternion::Identity, Vector3(m_extent));
+    }
+}
@@ -0,0 +1,69 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../Math/Vector3.h"
+#include "../Math/Matrix.h"
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+    struct RHI_Vertex_PosTexNorTan;
+    struct RHI_Vertex_PosTexNorTanQuantized;
+
+    // How far the quantized geometry can be from the original before a model keeps the full precision vertices
+    static const float m_vertex_quantization_position_error = 0.01f;            // of the average edge length
+    static const float m_vertex_quantization_uv_error       = 1.0f / 4096.0f;   // half a texel of a 2048 texture
+
+    // Converts model geometry to and from RHI_Vertex_PosTexNorTanQuantized. Positions are stored relative to a cube around
+    // the geometry's bounds, the scale is uniform so that the dequantization can be part of the transform without distorting normals.
+    // Uvs are half precision, normals and tangents are octahedral, both with 16 bits per component. It doesn't depend on the RHI.
+    class SPARTAN_CLASS VertexQuantizer
+    {
+    public:
+        VertexQuantizer() = default;
+        VertexQuantizer(const Math::Vector3& center, float extent) : m_center(center), m_extent(extent) {}
+        ~VertexQuantizer() = default;
+
+        // Fits the cube to the geometry, returns false if the geometry can't be quantized within the error bounds
+        bool Fit(const std::vector<RHI_Vertex_PosTexNorTan>& vertices, const std::vector<uint32_t>& indices);
+
+        void Quantize(const RHI_Vertex_PosTexNorTan* vertices, uint32_t vertex_count, RHI_Vertex_PosTexNorTanQuantized* vertices_quantized) const;
+        void Dequantize(const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized, uint32_t vertex_count, RHI_Vertex_PosTexNorTan* vertices) const;
+
+        // Transforms quantized positions to the geometry's space, it goes in front of the world matrix
+        Math::Matrix GetDequantization() const;
+
+        // How far a dequantized position can be from the original, a full step along every axis so that it covers the rounding of the dequantization too
+        float GetPositionError()            const { return 1.7320508f * m_extent / 32767.0f; }
+        const Math::Vector3& GetCenter()    const { return m_center; }
+        float GetExtent()                   const { return m_extent; }
+
+    private:
+        Math::Vector3 m_center  = Math::Vector3::Zero;
+        float m_extent          = 1.0f; // half the size of the cube
+    };
+}
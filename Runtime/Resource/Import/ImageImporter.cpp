@@ -27,6 +27,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <Utilities.h>
 #include "../../Threading/Threading.h"
 #include "../../RHI/RHI_Texture2D.h"
+#include "TextureCompressor.h"
+#include "MipGenerator.h"
 //====================================
 
 //= NAMESPACES =====
@@ -37,23 +39,6 @@ namespace Spartan::freeimage_helper
 {
 	static FREE_IMAGE_FILTER rescale_filter = FILTER_LANCZOS3;
 
-	// A struct that rescaling threads will work with
-	struct RescaleJob
-	{
-		uint32_t width		    = 0;
-		uint32_t height		    = 0;
-		uint32_t channel_count	= 0;
-		vector<std::byte>* data	= nullptr;
-		bool done			    = false;
-
-		RescaleJob(const uint32_t width, const uint32_t height, const uint32_t channel_count)
-		{
-			this->width		    = width;
-			this->height	    = height;
-			this->channel_count	= channel_count;
-		}
-	};
-
     inline uint32_t get_bytes_per_channel(FIBITMAP* bitmap)
     {
         if (!bitmap)
@@ -121,6 +106,19 @@ namespace Spartan::freeimage_helper
         LOG_ERROR("Could not deduce format");
         return RHI_Format_Undefined;
     }
+
+    // A pixel is masked when all of its color channels are below the threshold (see GBuffer.hlsl), which is the same as testing
+    // their maximum. Writing it to every color channel keeps the test intact and lets the mask compress to a single channel.
+    inline void fold_mask(vector<std::byte>* data)
+    {
+        for (size_t i = 0; i + 3 < data->size(); i += 4)
+        {
+            const std::byte value = max((*data)[i], max((*data)[i + 1], (*data)[i + 2]));
+            (*data)[i]      = value;
+            (*data)[i + 1]  = value;
+            (*data)[i + 2]  = value;
+        }
+    }
 }
 
 namespace Spartan
@@ -164,6 +162,12 @@ namespace Spartan
 			return false;
 		}
 
+		// Color textures can ask for the high quality compression in place of the default one
+		if (m_color_compression_high && texture->GetCompression() == RHI_Texture_Compression_Color)
+		{
+			texture->SetCompression(RHI_Texture_Compression_Color_High);
+		}
+
 		// Acquire image format
 		auto format	= FreeImage_GetFileType(file_path.c_str(), 0);
 		format		= (format == FIF_UNKNOWN) ? FreeImage_GetFIFFromFilename(file_path.c_str()) : format;  // If the format is unknown, try to get it from the the filename	
@@ -212,22 +216,38 @@ namespace Spartan
 		const auto mip = texture->AddMipmap();
 		GetBitsFromFibitmap(mip, bitmap, image_width, image_height, image_channel_count);
 
+		if (texture->GetCompression() == RHI_Texture_Compression_Mask && image_format == RHI_Format_R8G8B8A8_Unorm)
+		{
+			freeimage_helper::fold_mask(mip);
+		}
+
 		// If the texture supports mipmaps, generate them
 		if (generate_mipmaps)
 		{
-			GenerateMipmaps(bitmap, texture, image_width, image_height, image_channel_count);
+			GenerateMipmaps(texture, image_width, image_height, image_channel_count, image_bytes_per_channel, image_is_grayscale);
 		}
 
 		// Free memory 
 		FreeImage_Unload(bitmap);
 
+		// Block compress, if the texture's usage asks for it (block compressed formats need the top mip's dimensions to be multiples of 4)
+		RHI_Format texture_format = image_format;
+		if (texture->GetCompression() != RHI_Texture_Compression_None && image_format == RHI_Format_R8G8B8A8_Unorm && image_width % 4 == 0 && image_height % 4 == 0)
+		{
+			const RHI_Format format_compressed = TextureCompressor::GetFormat(texture->GetCompression(), *texture->GetData(0), image_is_grayscale);
+			if (TextureCompressor::Compress(m_context->GetSubsystem<Threading>(), &texture->GetData(), image_width, image_height, format_compressed))
+			{
+				texture_format = format_compressed;
+			}
+		}
+
 		// Fill RHI_Texture with image properties
 		texture->SetBitsPerChannel(image_bytes_per_channel * 8);
 		texture->SetWidth(image_width);
 		texture->SetHeight(image_height);
 		texture->SetChannelCount(image_channel_count);
 		texture->SetTransparency(image_is_transparent);
-		texture->SetFormat(image_format);
+		texture->SetFormat(texture_format);
 		texture->SetGrayscale(image_is_grayscale);
 
 		return true;
@@ -257,64 +277,29 @@ namespace Spartan
 		return true;
 	}
 
-	void ImageImporter::GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels)
+	void ImageImporter::GenerateMipmaps(RHI_Texture* texture, const uint32_t width, const uint32_t height, const uint32_t channels, const uint32_t bytes_per_channel, const bool is_grayscale)
 	{
 		if (!texture)
 		{
 			LOG_ERROR_INVALID_PARAMETER();
 			return;
 		}
-	
-		// Create a RescaleJob for every mip that we need
-		vector<freeimage_helper::RescaleJob> jobs;
-		while (width > 1 && height > 1)
-		{
-			width	= Math::Helper::Max(width / 2, static_cast<uint32_t>(1));
-			height	= Math::Helper::Max(height / 2, static_cast<uint32_t>(1));
-			jobs.emplace_back(width, height, channels);
-			
-			// Resize the RHI_Texture vector accordingly
-			const auto size = width * height * channels;
-			auto mip		= texture->AddMipmap();
-			mip->reserve(size);
-			mip->resize(size);
-		}
 
-		// Pass data pointers (now that the RHI_Texture mip vector has been constructed)
-		for (uint32_t i = 0; i < jobs.size(); i++)
+		// Colors are averaged in linear space and normals are renormalized, based on how the texture will be used (data, like masks, is averaged as it is)
+		MipGenerator_Mode mode = MipGenerator_Linear;
+		if (texture->GetCompression() == RHI_Texture_Compression_Color || texture->GetCompression() == RHI_Texture_Compression_Color_High)
 		{
-			// reminder: i + 1 because the 0 mip is the default image size
-			jobs[i].data = texture->GetData(i + 1);
+			mode = MipGenerator_Srgb;
 		}
-
-		// Parallelize mipmap generation using multiple threads (because FreeImage_Rescale() using FILTER_LANCZOS3 is expensive)
-		auto threading = m_context->GetSubsystem<Threading>();
-		for (auto& job : jobs)
+		else if (texture->GetCompression() == RHI_Texture_Compression_Normal && !is_grayscale)
 		{
-			threading->AddTask([this, &job, &bitmap]()
-			{
-				const auto bitmap_scaled = FreeImage_Rescale(bitmap, job.width, job.height, freeimage_helper::rescale_filter);
-				if (!GetBitsFromFibitmap(job.data, bitmap_scaled, job.width, job.height, job.channel_count))
-				{
-					LOG_ERROR("Failed to create mip level %dx%d", job.width, job.height);
-				}
-				FreeImage_Unload(bitmap_scaled);
-				job.done = true;
-			});
+			mode = MipGenerator_Normal;
 		}
 
-		// Wait until all mipmaps have been generated
-		auto ready = false;
-		while (!ready)
+		// Every mip is downsampled from the previous one, with the rows of each mip split across threads
+		if (!MipGenerator::Generate(m_context->GetSubsystem<Threading>(), &texture->GetData(), width, height, channels, bytes_per_channel, mode))
 		{
-			ready = true;
-			for (const auto& job : jobs)
-			{
-				if (!job.done)
-				{
-					ready = false;
-				}
-			}
+			LOG_ERROR("Failed to generate mipmaps");
 		}
 	}
 
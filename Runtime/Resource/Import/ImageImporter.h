@@ -42,13 +42,18 @@ namespace Spartan
 
 		bool Load(const std::string& file_path, RHI_Texture* texture, bool generate_mipmaps = true);
 
+		// Color textures are compressed to BC7 instead of BC1/BC3, which takes twice the memory (without alpha) and keeps gradients smooth
+		void SetColorCompressionHigh(const bool color_compression_high) { m_color_compression_high = color_compression_high; }
+		bool GetColorCompressionHigh() const                            { return m_color_compression_high; }
+
 	private:	
 		bool GetBitsFromFibitmap(std::vector<std::byte>* data, FIBITMAP* bitmap, uint32_t width, uint32_t height, uint32_t channels) const;
-		void GenerateMipmaps(FIBITMAP* bitmap, RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels);
+		void GenerateMipmaps(RHI_Texture* texture, uint32_t width, uint32_t height, uint32_t channels, uint32_t bytes_per_channel, bool is_grayscale);
 		FIBITMAP* ApplyBitmapCorrections(FIBITMAP* bitmap) const;
 		FIBITMAP* _FreeImage_ConvertTo32Bits(FIBITMAP* bitmap) const;
 		FIBITMAP* _FreeImage_Rescale(FIBITMAP* bitmap, uint32_t width, uint32_t height) const;
 
-        Context* m_context = nullptr;
+        Context* m_context              = nullptr;
+        bool m_color_compression_high   = false;
 	};
 }
@@ -0,0 +1,311 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include "Spartan.h"
+#include "MipGenerator.h"
+#include "../../Threading/Threading.h"
+#include <emmintrin.h>
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::mip_generator
+{
+    // Fine enough for the steep start of the sRGB curve to map to the right 8 bit values
+    static const uint32_t linear_to_srgb_table_size = 16384;
+
+    struct srgb_tables
+    {
+        float to_linear[256];
+        uint8_t to_srgb[linear_to_srgb_table_size];
+    };
+
+    inline const srgb_tables& get_srgb_tables()
+    {
+        static const srgb_tables tables = []()
+        {
+            srgb_tables tables;
+
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                const float value   = i / 255.0f;
+                tables.to_linear[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < linear_to_srgb_table_size; i++)
+            {
+                const float value   = i / static_cast<float>(linear_to_srgb_table_size - 1);
+                const float srgb    = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+                tables.to_srgb[i]   = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+            }
+
+            return tables;
+        }();
+
+        return tables;
+    }
+
+    // An 8 bit RGBA pixel as floats in [0, 255]
+    inline __m128 unorm_load(const uint8_t* pixel)
+    {
+        int32_t value;
+        memcpy(&value, pixel, sizeof(value));
+        __m128i result = _mm_cvtsi32_si128(value);
+        result = _mm_unpacklo_epi8(result, _mm_setzero_si128());
+        result = _mm_unpacklo_epi16(result, _mm_setzero_si128());
+        return _mm_cvtepi32_ps(result);
+    }
+
+    // Floats in [0, 255] as an 8 bit RGBA pixel (rounded)
+    inline void unorm_store(const __m128 value, uint8_t* pixel)
+    {
+        __m128i result = _mm_cvtps_epi32(value);
+        result = _mm_packs_epi32(result, result);
+        result = _mm_packus_epi16(result, result);
+        const int32_t packed = _mm_cvtsi128_si32(result);
+        memcpy(pixel, &packed, sizeof(packed));
+    }
+
+    // Normalizes xyz, w is left as is
+    inline __m128 normalize_xyz(const __m128 value)
+    {
+        const __m128 xyz            = _mm_and_ps(value, _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)));
+        const __m128 squared        = _mm_mul_ps(xyz, xyz);
+        const __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(squared, squared, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(squared, squared, _MM_SHUFFLE(2, 2, 2, 2)));
+        if (_mm_cvtss_f32(length_squared) <= 0.0f)
+            return value;
+
+        const __m128 normalized = _mm_div_ps(xyz, _mm_sqrt_ps(length_squared));
+        return _mm_or_ps(normalized, _mm_and_ps(value, _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1))));
+    }
+
+    // Odd dimensions have one source pixel (or row) too many, the last pixel of the mip takes it in with a 3 tap footprint
+    inline uint32_t footprint_width(const uint32_t x, const uint32_t width, const uint32_t width_source)
+    {
+        return (x + 1 == width && width_source % 2 != 0) ? 3 : 2;
+    }
+
+    // Sums the RGBA footprint of a mip pixel, the 2x2 case is the one that has to be fast
+    template <typename T, typename Load>
+    inline __m128 footprint_sum(const T* const* rows, const uint32_t row_count, const uint32_t x, const uint32_t x_count, Load&& load)
+    {
+        const uint32_t x_0 = 2 * x * 4;
+        const uint32_t x_1 = x_0 + 4;
+        const uint32_t x_2 = x_1 + 4;
+
+        __m128 sum = _mm_add_ps(_mm_add_ps(load(rows[0] + x_0), load(rows[0] + x_1)), _mm_add_ps(load(rows[1] + x_0), load(rows[1] + x_1)));
+        if (x_count == 3)
+        {
+            sum = _mm_add_ps(sum, _mm_add_ps(load(rows[0] + x_2), load(rows[1] + x_2)));
+        }
+        if (row_count == 3)
+        {
+            sum = _mm_add_ps(sum, _mm_add_ps(load(rows[2] + x_0), load(rows[2] + x_1)));
+            if (x_count == 3)
+            {
+                sum = _mm_add_ps(sum, load(rows[2] + x_2));
+            }
+        }
+
+        return sum;
+    }
+
+    // Averages the 2x2 footprint (up to 3x3 on the last row and column of odd sizes) of every pixel of an 8 bit RGBA row
+    inline void downsample_row_unorm4(const uint8_t* const* rows, const uint32_t row_count, const uint32_t width_source, uint8_t* destination, const uint32_t width, const MipGenerator_Mode mode)
+    {
+        const __m128 weights[2] = { _mm_set1_ps(1.0f / (2 * row_count)), _mm_set1_ps(1.0f / (3 * row_count)) };
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint32_t x_count  = footprint_width(x, width, width_source);
+            const __m128 weight     = weights[x_count - 2];
+            uint8_t* pixel          = destination + x * 4;
+
+            if (mode == MipGenerator_Srgb)
+            {
+                const srgb_tables& tables = get_srgb_tables();
+                const auto load = [&tables](const uint8_t* p) { return _mm_setr_ps(tables.to_linear[p[0]], tables.to_linear[p[1]], tables.to_linear[p[2]], p[3] / 255.0f); };
+
+                const __m128 sum = footprint_sum(rows, row_count, x, x_count, load);
+                alignas(16) float average[4];
+                _mm_store_ps(average, _mm_mul_ps(sum, weight));
+
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    pixel[c] = tables.to_srgb[static_cast<uint32_t>(Math::Helper::Saturate(average[c]) * (linear_to_srgb_table_size - 1) + 0.5f)];
+                }
+                pixel[3] = static_cast<uint8_t>(Math::Helper::Saturate(average[3]) * 255.0f + 0.5f);
+            }
+            else
+            {
+                const __m128 sum = footprint_sum(rows, row_count, x, x_count, unorm_load);
+                __m128 average = _mm_mul_ps(sum, weight);
+
+                if (mode == MipGenerator_Normal)
+                {
+                    // [0, 255] to [-1, 1] and back
+                    const __m128 scale  = _mm_set1_ps(2.0f / 255.0f);
+                    const __m128 one    = _mm_set1_ps(1.0f);
+                    average = normalize_xyz(_mm_sub_ps(_mm_mul_ps(average, scale), one));
+                    average = _mm_mul_ps(_mm_add_ps(average, one), _mm_set1_ps(127.5f));
+                }
+
+                unorm_store(average, pixel);
+            }
+        }
+    }
+
+    // Averages the 2x2 footprint (up to 3x3 on the last row and column of odd sizes) of every pixel of a 32 bit float RGBA row (already linear)
+    inline void downsample_row_float4(const float* const* rows, const uint32_t row_count, const uint32_t width_source, float* destination, const uint32_t width, const MipGenerator_Mode mode)
+    {
+        const __m128 weights[2] = { _mm_set1_ps(1.0f / (2 * row_count)), _mm_set1_ps(1.0f / (3 * row_count)) };
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint32_t x_count  = footprint_width(x, width, width_source);
+            const __m128 sum        = footprint_sum(rows, row_count, x, x_count, [](const float* p) { return _mm_loadu_ps(p); });
+            __m128 average          = _mm_mul_ps(sum, weights[x_count - 2]);
+
+            if (mode == MipGenerator_Normal)
+            {
+                average = normalize_xyz(average);
+            }
+
+            _mm_storeu_ps(destination + x * 4, average);
+        }
+    }
+
+    // Any other layout, every channel is averaged as is
+    template <typename T>
+    inline void downsample_row_generic(const T* const* rows, const uint32_t row_count, const uint32_t width_source, T* destination, const uint32_t width, const uint32_t channel_count)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint32_t x_count  = footprint_width(x, width, width_source);
+            const float weight      = 1.0f / (x_count * row_count);
+
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                float sum = 0.0f;
+                for (uint32_t r = 0; r < row_count; r++)
+                {
+                    for (uint32_t i = 0; i < x_count; i++)
+                    {
+                        sum += static_cast<float>(rows[r][(2 * x + i) * channel_count + c]);
+                    }
+                }
+                destination[x * channel_count + c] = is_floating_point<T>::value ? static_cast<T>(sum * weight) : static_cast<T>(sum * weight + 0.5f);
+            }
+        }
+    }
+}
+
+namespace Spartan
+{
+    bool MipGenerator::Generate(Threading* threading, vector<vector<std::byte>>* mips, uint32_t width, uint32_t height, const uint32_t channel_count, const uint32_t bytes_per_channel, MipGenerator_Mode mode)
+    {
+        const uint32_t bytes_per_pixel = channel_count * bytes_per_channel;
+        if (!mips || mips->empty() || (bytes_per_channel != 1 && bytes_per_channel != 4) || (*mips)[0].size() != static_cast<size_t>(width) * height * bytes_per_pixel)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Only RGBA (or RGB) can be gamma corrected or renormalized, and float images are linear already
+        const bool is_rgba = channel_count == 4;
+        mode = !is_rgba || (mode == MipGenerator_Srgb && bytes_per_channel == 4) ? MipGenerator_Linear : mode;
+
+        // Build the tables before the threads need them
+        if (mode == MipGenerator_Srgb)
+        {
+            mip_generator::get_srgb_tables();
+        }
+
+        while (width > 1 && height > 1)
+        {
+            const uint32_t width_mip    = Math::Helper::Max(width / 2, 1u);
+            const uint32_t height_mip   = Math::Helper::Max(height / 2, 1u);
+
+            mips->emplace_back(static_cast<size_t>(width_mip) * height_mip * bytes_per_pixel);
+            const std::byte* source = (*mips)[mips->size() - 2].data();
+            std::byte* destination  = mips->back().data();
+
+            const auto downsample_rows = [=](const uint32_t row_start, const uint32_t row_end)
+            {
+                for (uint32_t y = row_start; y < row_end; y++)
+                {
+                    const uint32_t row_count    = mip_generator::footprint_width(y, height_mip, height);
+                    const size_t row_size       = static_cast<size_t>(width) * bytes_per_pixel;
+                    const std::byte* rows[3]    = { source + 2 * y * row_size, source + (2 * y + 1) * row_size, source + (2 * y + 2) * row_size };
+                    std::byte* row              = destination + static_cast<size_t>(y) * width_mip * bytes_per_pixel;
+
+                    if (bytes_per_channel == 1)
+                    {
+                        const uint8_t* rows_unorm[3]    = { reinterpret_cast<const uint8_t*>(rows[0]), reinterpret_cast<const uint8_t*>(rows[1]), reinterpret_cast<const uint8_t*>(rows[2]) };
+                        const auto row_unorm            = reinterpret_cast<uint8_t*>(row);
+
+                        if (is_rgba)
+                        {
+                            mip_generator::downsample_row_unorm4(rows_unorm, row_count, width, row_unorm, width_mip, mode);
+                        }
+                        else
+                        {
+                            mip_generator::downsample_row_generic(rows_unorm, row_count, width, row_unorm, width_mip, channel_count);
+                        }
+                    }
+                    else
+                    {
+                        const float* rows_float[3]  = { reinterpret_cast<const float*>(rows[0]), reinterpret_cast<const float*>(rows[1]), reinterpret_cast<const float*>(rows[2]) };
+                        const auto row_float        = reinterpret_cast<float*>(row);
+
+                        if (is_rgba)
+                        {
+                            mip_generator::downsample_row_float4(rows_float, row_count, width, row_float, width_mip, mode);
+                        }
+                        else
+                        {
+                            mip_generator::downsample_row_generic(rows_float, row_count, width, row_float, width_mip, channel_count);
+                        }
+                    }
+                }
+            };
+
+            // Each level depends on the previous one, so the rows of a level are split (a few thousand pixels per task at least)
+            if (threading)
+            {
+                threading->ParallelFor(height_mip, Math::Helper::Max(4096u / width_mip, 1u), downsample_rows);
+            }
+            else
+            {
+                downsample_rows(0, height_mip);
+            }
+
+            width   = width_mip;
+            height  = height_mip;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,50 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==============================
+#include <vector>
+#include "../../Core/Spartan_Definitions.h"
+//=========================================
+
+namespace Spartan
+{
+	class Threading;
+
+	enum MipGenerator_Mode
+	{
+		MipGenerator_Linear,	// channels are averaged as they are
+		MipGenerator_Srgb,		// color is averaged in linear space (alpha is linear already)
+		MipGenerator_Normal		// xyz is a unit vector, averaged and renormalized
+	};
+
+	// Builds mip chains, each level is box filtered (2x2) from the previous one. When a dimension is odd,
+	// the last pixel along it averages 3 source pixels instead, so the last row and column aren't dropped.
+	class SPARTAN_CLASS MipGenerator
+	{
+	public:
+		// Appends the chain to mips, which has to hold the top mip. Levels are generated until one of the dimensions reaches 1.
+		// Supports 8 bit (unorm) and 32 bit (float) channels, the rows of each level are split across threads.
+		static bool Generate(Threading* threading, std::vector<std::vector<std::byte>>* mips, uint32_t width, uint32_t height, uint32_t channel_count, uint32_t bytes_per_channel, MipGenerator_Mode mode);
+	};
+}
@@ -140,7 +140,8 @@ namespace Spartan
 			ParseNode(scene->mRootNode, params, nullptr, new_entity.get());
             // Parse animations
 			ParseAnimations(params);
-            // Update model geometry
+            // Update model geometry, quantized if it's within the error bounds
+            model->SetVertexQuantization(true);
 			model->UpdateGeometry();
 
 			FIRE_EVENT(EventType::WorldStart);
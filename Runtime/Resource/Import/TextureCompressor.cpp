@@ -0,0 +1,592 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include "Spartan.h"
+#include "TextureCompressor.h"
+#include "../../Threading/Threading.h"
+//================================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan::block_compression
+{
+    // Interpolation weights of the 16 BC7 palette entries (4 bit indices), out of 64
+    static const uint32_t bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // Position of each BC1 palette entry between the first (0) and the second (1) endpoint
+    static const float bc1_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    // Writes values of arbitrary bit counts into a block, least significant bit first
+    struct bit_writer
+    {
+        uint8_t* data       = nullptr;
+        uint32_t position   = 0;
+
+        void write(const uint32_t value, const uint32_t bit_count)
+        {
+            for (uint32_t i = 0; i < bit_count; i++, position++)
+            {
+                data[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+            }
+        }
+    };
+
+    inline float distance_squared(const float* a, const float* b, const uint32_t channel_count)
+    {
+        float distance = 0.0f;
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            distance += (a[c] - b[c]) * (a[c] - b[c]);
+        }
+        return distance;
+    }
+
+    // Fits a line through the pixels (their mean and principal axis) and returns the extremes of their projection on it
+    inline void fit_endpoints(const float pixels[16][4], const uint32_t channel_count, float* endpoint_0, float* endpoint_1)
+    {
+        float mean[4]   = {};
+        float min[4]    = { 255.0f, 255.0f, 255.0f, 255.0f };
+        float max[4]    = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                mean[c] += pixels[i][c] / 16.0f;
+                min[c]  = Math::Helper::Min(min[c], pixels[i][c]);
+                max[c]  = Math::Helper::Max(max[c], pixels[i][c]);
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t a = 0; a < channel_count; a++)
+            {
+                for (uint32_t b = 0; b < channel_count; b++)
+                {
+                    covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+                }
+            }
+        }
+
+        // Power iteration, starting from the diagonal of the bounding box
+        float axis[4] = {};
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            axis[c] = max[c] - min[c];
+        }
+
+        for (uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            float axis_new[4]   = {};
+            float length        = 0.0f;
+            for (uint32_t a = 0; a < channel_count; a++)
+            {
+                for (uint32_t b = 0; b < channel_count; b++)
+                {
+                    axis_new[a] += covariance[a][b] * axis[b];
+                }
+                length += axis_new[a] * axis_new[a];
+            }
+
+            if (length < Math::Helper::M_EPSILON)
+                break;
+
+            length = sqrtf(length);
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                axis[c] = axis_new[c] / length;
+            }
+        }
+
+        float t_min = 0.0f;
+        float t_max = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                t += (pixels[i][c] - mean[c]) * axis[c];
+            }
+            t_min = Math::Helper::Min(t_min, t);
+            t_max = Math::Helper::Max(t_max, t);
+        }
+
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            endpoint_0[c] = Math::Helper::Clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+            endpoint_1[c] = Math::Helper::Clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+        }
+    }
+
+    // Least squares endpoints for the pixels, given where each of them lies between the endpoints (0 is the first endpoint, 1 the second)
+    inline bool refine_endpoints(const float pixels[16][4], const float weights[16], const uint32_t channel_count, float* endpoint_0, float* endpoint_1)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[4] = {}, bp[4] = {};
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            const float b = weights[i];
+            const float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                ap[c] += a * pixels[i][c];
+                bp[c] += b * pixels[i][c];
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if (fabsf(determinant) < Math::Helper::M_EPSILON)
+            return false;
+
+        for (uint32_t c = 0; c < channel_count; c++)
+        {
+            endpoint_0[c] = Math::Helper::Clamp((ap[c] * bb - bp[c] * ab) / determinant, 0.0f, 255.0f);
+            endpoint_1[c] = Math::Helper::Clamp((bp[c] * aa - ap[c] * ab) / determinant, 0.0f, 255.0f);
+        }
+
+        return true;
+    }
+
+    inline uint16_t rgb_to_565(const float* rgb)
+    {
+        const uint32_t r = static_cast<uint32_t>(rgb[0] * 31.0f / 255.0f + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(rgb[1] * 63.0f / 255.0f + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(rgb[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    inline void rgb_from_565(const uint16_t color, float* rgb)
+    {
+        const uint32_t r = (color >> 11) & 31;
+        const uint32_t g = (color >> 5) & 63;
+        const uint32_t b = color & 31;
+        rgb[0] = static_cast<float>((r << 3) | (r >> 2));
+        rgb[1] = static_cast<float>((g << 2) | (g >> 4));
+        rgb[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    // Picks the closest entry of the 4 color BC1 palette for every pixel, returns the error
+    inline float bc1_indices(const float pixels[16][4], const uint16_t color_0, const uint16_t color_1, uint32_t* indices)
+    {
+        float palette[4][4] = {};
+        rgb_from_565(color_0, palette[0]);
+        rgb_from_565(color_1, palette[1]);
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+
+        float error = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float distance_min = numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 4; p++)
+            {
+                const float distance = distance_squared(pixels[i], palette[p], 3);
+                if (distance < distance_min)
+                {
+                    distance_min    = distance;
+                    indices[i]      = p;
+                }
+            }
+            error += distance_min;
+        }
+
+        return error;
+    }
+
+    // BC1 block (also the color half of BC3), always in 4 color mode
+    inline void encode_color(const float pixels[16][4], uint8_t* block)
+    {
+        float endpoint_0[4], endpoint_1[4];
+        fit_endpoints(pixels, 3, endpoint_0, endpoint_1);
+
+        // The first endpoint is the larger one, the projection's maximum
+        uint16_t color_0 = rgb_to_565(endpoint_1);
+        uint16_t color_1 = rgb_to_565(endpoint_0);
+        uint32_t indices[16] = {};
+        float error = bc1_indices(pixels, color_0, color_1, indices);
+
+        // Refine the endpoints for the chosen indices and keep them if they are better
+        float weights[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            weights[i] = bc1_weights[indices[i]];
+        }
+
+        if (refine_endpoints(pixels, weights, 3, endpoint_0, endpoint_1))
+        {
+            const uint16_t color_0_refined = rgb_to_565(endpoint_0);
+            const uint16_t color_1_refined = rgb_to_565(endpoint_1);
+            uint32_t indices_refined[16] = {};
+            const float error_refined = bc1_indices(pixels, color_0_refined, color_1_refined, indices_refined);
+            if (error_refined < error)
+            {
+                color_0 = color_0_refined;
+                color_1 = color_1_refined;
+                memcpy(indices, indices_refined, sizeof(indices));
+            }
+        }
+
+        // 4 color mode needs the first endpoint to be the larger one, swapping them swaps the indices too (0 <-> 1, 2 <-> 3)
+        if (color_0 < color_1)
+        {
+            swap(color_0, color_1);
+            for (uint32_t& index : indices)
+            {
+                index ^= 1;
+            }
+        }
+        else if (color_0 == color_1)
+        {
+            memset(indices, 0, sizeof(indices));
+        }
+
+        uint32_t index_bits = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            index_bits |= indices[i] << (2 * i);
+        }
+
+        memcpy(block + 0, &color_0, sizeof(uint16_t));
+        memcpy(block + 2, &color_1, sizeof(uint16_t));
+        memcpy(block + 4, &index_bits, sizeof(uint32_t));
+    }
+
+    // BC4 block (also the alpha half of BC3 and each half of BC5), always in 8 value mode
+    inline void encode_channel(const float pixels[16][4], const uint32_t channel, uint8_t* block)
+    {
+        float value_min = 255.0f;
+        float value_max = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            value_min = Math::Helper::Min(value_min, pixels[i][channel]);
+            value_max = Math::Helper::Max(value_max, pixels[i][channel]);
+        }
+
+        const uint32_t endpoint_0 = static_cast<uint32_t>(value_max + 0.5f);
+        const uint32_t endpoint_1 = static_cast<uint32_t>(value_min + 0.5f);
+        block[0] = static_cast<uint8_t>(endpoint_0);
+        block[1] = static_cast<uint8_t>(endpoint_1);
+
+        uint64_t index_bits = 0;
+        if (endpoint_0 > endpoint_1)
+        {
+            float palette[8];
+            palette[0] = static_cast<float>(endpoint_0);
+            palette[1] = static_cast<float>(endpoint_1);
+            for (uint32_t p = 2; p < 8; p++)
+            {
+                palette[p] = static_cast<float>((8 - p) * endpoint_0 + (p - 1) * endpoint_1) / 7.0f;
+            }
+
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                uint64_t index      = 0;
+                float distance_min  = numeric_limits<float>::max();
+                for (uint32_t p = 0; p < 8; p++)
+                {
+                    const float distance = fabsf(pixels[i][channel] - palette[p]);
+                    if (distance < distance_min)
+                    {
+                        distance_min    = distance;
+                        index           = p;
+                    }
+                }
+                index_bits |= index << (3 * i);
+            }
+        }
+
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            block[2 + i] = static_cast<uint8_t>(index_bits >> (8 * i));
+        }
+    }
+
+    // Quantizes an endpoint to 7 bits per channel plus a shared least significant bit (the p-bit), picking the p-bit with the lowest error
+    inline void bc7_quantize(const float* endpoint, uint32_t* quantized, uint32_t* p_bit)
+    {
+        float error_min = numeric_limits<float>::max();
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t candidate[4];
+            float error = 0.0f;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                candidate[c] = static_cast<uint32_t>(Math::Helper::Clamp((endpoint[c] - p) / 2.0f + 0.5f, 0.0f, 127.0f));
+                const float reconstructed = static_cast<float>((candidate[c] << 1) | p);
+                error += (reconstructed - endpoint[c]) * (reconstructed - endpoint[c]);
+            }
+
+            if (error < error_min)
+            {
+                error_min   = error;
+                *p_bit      = p;
+                memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    // Picks the closest entry of the 16 entry BC7 palette for every pixel, returns the error
+    inline float bc7_indices(const float pixels[16][4], const uint32_t* quantized_0, const uint32_t p_bit_0, const uint32_t* quantized_1, const uint32_t p_bit_1, uint32_t* indices)
+    {
+        float palette[16][4];
+        for (uint32_t p = 0; p < 16; p++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                const uint32_t endpoint_0 = (quantized_0[c] << 1) | p_bit_0;
+                const uint32_t endpoint_1 = (quantized_1[c] << 1) | p_bit_1;
+                palette[p][c] = static_cast<float>(((64 - bc7_weights[p]) * endpoint_0 + bc7_weights[p] * endpoint_1 + 32) >> 6);
+            }
+        }
+
+        float error = 0.0f;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            float distance_min = numeric_limits<float>::max();
+            for (uint32_t p = 0; p < 16; p++)
+            {
+                const float distance = distance_squared(pixels[i], palette[p], 4);
+                if (distance < distance_min)
+                {
+                    distance_min    = distance;
+                    indices[i]      = p;
+                }
+            }
+            error += distance_min;
+        }
+
+        return error;
+    }
+
+    // BC7 block in mode 6, a single RGBA line with 4 bit indices, which suits most color textures
+    inline void encode_bc7(const float pixels[16][4], uint8_t* block)
+    {
+        float endpoint_0[4], endpoint_1[4];
+        fit_endpoints(pixels, 4, endpoint_0, endpoint_1);
+
+        uint32_t quantized_0[4], quantized_1[4], p_bit_0 = 0, p_bit_1 = 0;
+        bc7_quantize(endpoint_0, quantized_0, &p_bit_0);
+        bc7_quantize(endpoint_1, quantized_1, &p_bit_1);
+        uint32_t indices[16] = {};
+        float error = bc7_indices(pixels, quantized_0, p_bit_0, quantized_1, p_bit_1, indices);
+
+        // Refine the endpoints for the chosen indices and keep them if they are better
+        float weights[16];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            weights[i] = bc7_weights[indices[i]] / 64.0f;
+        }
+
+        if (refine_endpoints(pixels, weights, 4, endpoint_0, endpoint_1))
+        {
+            uint32_t quantized_0_refined[4], quantized_1_refined[4], p_bit_0_refined = 0, p_bit_1_refined = 0;
+            bc7_quantize(endpoint_0, quantized_0_refined, &p_bit_0_refined);
+            bc7_quantize(endpoint_1, quantized_1_refined, &p_bit_1_refined);
+            uint32_t indices_refined[16] = {};
+            const float error_refined = bc7_indices(pixels, quantized_0_refined, p_bit_0_refined, quantized_1_refined, p_bit_1_refined, indices_refined);
+            if (error_refined < error)
+            {
+                memcpy(quantized_0, quantized_0_refined, sizeof(quantized_0));
+                memcpy(quantized_1, quantized_1_refined, sizeof(quantized_1));
+                memcpy(indices, indices_refined, sizeof(indices));
+                p_bit_0 = p_bit_0_refined;
+                p_bit_1 = p_bit_1_refined;
+            }
+        }
+
+        // The first index is stored without its most significant bit, so it has to be in the first half of the palette
+        if (indices[0] & 8)
+        {
+            swap(quantized_0, quantized_1);
+            swap(p_bit_0, p_bit_1);
+            for (uint32_t& index : indices)
+            {
+                index = 15 - index;
+            }
+        }
+
+        memset(block, 0, 16);
+        bit_writer writer = { block, 0 };
+        writer.write(1 << 6, 7); // mode 6
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            writer.write(quantized_0[c], 7);
+            writer.write(quantized_1[c], 7);
+        }
+        writer.write(p_bit_0, 1);
+        writer.write(p_bit_1, 1);
+        writer.write(indices[0], 3);
+        for (uint32_t i = 1; i < 16; i++)
+        {
+            writer.write(indices[i], 4);
+        }
+    }
+}
+
+namespace Spartan
+{
+    RHI_Format TextureCompressor::GetFormat(const RHI_Texture_Compression compression, const vector<std::byte>& mip, const bool is_grayscale)
+    {
+        switch (compression)
+        {
+            case RHI_Texture_Compression_Color:
+            {
+                for (size_t i = 3; i < mip.size(); i += 4)
+                {
+                    if (mip[i] != std::byte{ 255 })
+                        return RHI_Format_BC3_Unorm;
+                }
+
+                return RHI_Format_BC1_Unorm;
+            }
+            case RHI_Texture_Compression_Color_High:    return RHI_Format_BC7_Unorm;
+            case RHI_Texture_Compression_Normal:        return is_grayscale ? RHI_Format_BC4_Unorm : RHI_Format_BC5_Unorm;
+            case RHI_Texture_Compression_Grayscale:     return RHI_Format_BC4_Unorm;
+            case RHI_Texture_Compression_Mask:          return RHI_Format_BC4_Unorm;
+            default:                                    return RHI_Format_Undefined;
+        }
+    }
+
+    bool TextureCompressor::Compress(Threading* threading, vector<vector<std::byte>>* mips, const uint32_t width, const uint32_t height, const RHI_Format format)
+    {
+        if (!mips || mips->empty() || !rhi_format_is_block_compressed(format) || width % 4 != 0 || height % 4 != 0)
+        {
+            LOG_ERROR_INVALID_PARAMETER();
+            return false;
+        }
+
+        // Allocate the compressed mips and find where each mip's rows of blocks start
+        const uint32_t mip_count    = static_cast<uint32_t>(mips->size());
+        const uint32_t block_size   = rhi_format_block_byte_count(format);
+        vector<vector<std::byte>> mips_compressed(mip_count);
+        vector<uint32_t> mip_row_start(mip_count + 1, 0);
+        for (uint32_t mip_index = 0; mip_index < mip_count; mip_index++)
+        {
+            const uint32_t mip_width    = Math::Helper::Max(width >> mip_index, 1u);
+            const uint32_t mip_height   = Math::Helper::Max(height >> mip_index, 1u);
+
+            if ((*mips)[mip_index].size() != static_cast<size_t>(mip_width) * mip_height * 4)
+            {
+                LOG_ERROR("Mip %d is not an 8 bit RGBA %dx%d image", mip_index, mip_width, mip_height);
+                return false;
+            }
+
+            mips_compressed[mip_index].resize(GetByteCount(format, mip_width, mip_height));
+            mip_row_start[mip_index + 1] = mip_row_start[mip_index] + (mip_height + 3) / 4;
+        }
+
+        const auto compress_rows = [&](const uint32_t row_start, const uint32_t row_end)
+        {
+            for (uint32_t row = row_start; row < row_end; row++)
+            {
+                const uint32_t mip_index    = static_cast<uint32_t>(upper_bound(mip_row_start.begin(), mip_row_start.end(), row) - mip_row_start.begin()) - 1;
+                const uint32_t mip_width    = Math::Helper::Max(width >> mip_index, 1u);
+                const uint32_t mip_height   = Math::Helper::Max(height >> mip_index, 1u);
+                const uint32_t block_y      = row - mip_row_start[mip_index];
+                const uint32_t block_count  = (mip_width + 3) / 4;
+                const uint8_t* source       = reinterpret_cast<const uint8_t*>((*mips)[mip_index].data());
+                uint8_t* destination        = reinterpret_cast<uint8_t*>(mips_compressed[mip_index].data()) + static_cast<size_t>(block_y) * block_count * block_size;
+
+                for (uint32_t block_x = 0; block_x < block_count; block_x++)
+                {
+                    // Gather the block, mips smaller than a block repeat their edge pixels
+                    uint8_t pixels[16 * 4];
+                    for (uint32_t y = 0; y < 4; y++)
+                    {
+                        for (uint32_t x = 0; x < 4; x++)
+                        {
+                            const uint32_t source_x = Math::Helper::Min(block_x * 4 + x, mip_width - 1);
+                            const uint32_t source_y = Math::Helper::Min(block_y * 4 + y, mip_height - 1);
+                            memcpy(&pixels[(y * 4 + x) * 4], &source[(static_cast<size_t>(source_y) * mip_width + source_x) * 4], 4);
+                        }
+                    }
+
+                    CompressBlock(pixels, format, destination + block_x * block_size);
+                }
+            }
+        };
+
+        if (threading)
+        {
+            threading->ParallelFor(mip_row_start.back(), 0, compress_rows);
+        }
+        else
+        {
+            compress_rows(0, mip_row_start.back());
+        }
+
+        mips->swap(mips_compressed);
+        return true;
+    }
+
+    void TextureCompressor::CompressBlock(const uint8_t* pixels, const RHI_Format format, uint8_t* block)
+    {
+        float pixels_float[16][4];
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                pixels_float[i][c] = static_cast<float>(pixels[i * 4 + c]);
+            }
+        }
+
+        switch (format)
+        {
+            case RHI_Format_BC1_Unorm:
+                block_compression::encode_color(pixels_float, block);
+                break;
+            case RHI_Format_BC3_Unorm:
+                block_compression::encode_channel(pixels_float, 3, block);
+                block_compression::encode_color(pixels_float, block + 8);
+                break;
+            case RHI_Format_BC4_Unorm:
+                block_compression::encode_channel(pixels_float, 0, block);
+                break;
+            case RHI_Format_BC5_Unorm:
+                block_compression::encode_channel(pixels_float, 0, block);
+                block_compression::encode_channel(pixels_float, 1, block + 8);
+                break;
+            case RHI_Format_BC7_Unorm:
+                block_compression::encode_bc7(pixels_float, block);
+                break;
+            default:
+                LOG_ERROR("%s is not a block compressed format", rhi_format_to_string(format));
+                break;
+        }
+    }
+
+    uint32_t TextureCompressor::GetByteCount(const RHI_Format format, const uint32_t width, const uint32_t height)
+    {
+        return ((width + 3) / 4) * ((height + 3) / 4) * rhi_format_block_byte_count(format);
+    }
+}
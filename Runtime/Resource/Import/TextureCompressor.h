@@ -0,0 +1,52 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES ==============================
+#include <vector>
+#include "../../RHI/RHI_Definition.h"
+#include "../../Core/Spartan_Definitions.h"
+//=========================================
+
+namespace Spartan
+{
+	class Threading;
+
+	// CPU block compression of 8 bit RGBA images (BC1, BC3, BC4, BC5 and BC7)
+	class SPARTAN_CLASS TextureCompressor
+	{
+	public:
+		// Picks a format for what the texture is used for, based on the image (e.g. BC1, unless the top mip has alpha)
+		static RHI_Format GetFormat(RHI_Texture_Compression compression, const std::vector<std::byte>& mip, bool is_grayscale);
+
+		// Compresses every mip in place, the work is split in rows of blocks across all mips.
+		// The top mip's dimensions have to be multiples of 4, smaller mips are padded to a block.
+		static bool Compress(Threading* threading, std::vector<std::vector<std::byte>>* mips, uint32_t width, uint32_t height, RHI_Format format);
+
+		// Compresses 4x4 RGBA pixels (row major) into a block of the given format
+		static void CompressBlock(const uint8_t* pixels, RHI_Format format, uint8_t* block);
+
+		// The size of an image of the given format, in bytes
+		static uint32_t GetByteCount(RHI_Format format, uint32_t width, uint32_t height);
+	};
+}
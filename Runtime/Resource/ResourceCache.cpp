@@ -44,6 +44,9 @@ namespace Spartan
 {
 	ResourceCache::ResourceCache(Context* context) : ISubsystem(context)
 	{
+        // Doesn't tick
+        SetTickDependencies(Tick_Dependency_None, Tick_Dependency_None, false);
+
         const string data_dir = "Data\\";
 
 		// Add engine standard resource directories
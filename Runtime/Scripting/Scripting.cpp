@@ -41,6 +41,9 @@ namespace Spartan
 {
 	Scripting::Scripting(Context* context) : ISubsystem(context)
 	{
+        // Doesn't tick, scripts are ticked by their components
+        SetTickDependencies(Tick_Dependency_None, Tick_Dependency_None, false);
+
         ScriptingHelper::resource_cache = m_context->GetSubsystem<ResourceCache>();
 
         // Get file paths
@@ -0,0 +1,133 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =========
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+//====================
+
+namespace Spartan
+{
+    // A counter which tracks how many tasks (associated with it) are still pending.
+    // It's the handle that callers can wait on, see Threading::Wait().
+    class TaskCounter
+    {
+    public:
+        TaskCounter() = default;
+        TaskCounter(const TaskCounter&) = delete;
+        TaskCounter& operator=(const TaskCounter&) = delete;
+
+        void Increment(uint32_t count = 1)  { m_value.fetch_add(count, std::memory_order_relaxed); }
+        void Decrement()                    { m_value.fetch_sub(1, std::memory_order_acq_rel); }
+        uint32_t GetValue() const           { return m_value.load(std::memory_order_acquire); }
+        bool IsDone() const                 { return GetValue() == 0; }
+
+    private:
+        std::atomic<uint32_t> m_value = 0;
+    };
+
+    // A unit of work. Small callables (the vast majority of lambdas) are stored inline,
+    // larger ones fall back to the heap. Tasks themselves are pooled by the Threading subsystem.
+    class alignas(64) Task
+    {
+    public:
+        Task() = default;
+        ~Task() { Reset(); }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        template <typename Function>
+        void Set(Function&& function, TaskCounter* counter)
+        {
+            using function_type = std::decay_t<Function>;
+
+            if constexpr (sizeof(function_type) <= storage_size && alignof(function_type) <= alignof(std::max_align_t))
+            {
+                m_callable = new (m_storage) function_type(std::forward<Function>(function));
+                m_destroy  = [](void* callable) { static_cast<function_type*>(callable)->~function_type(); };
+            }
+            else
+            {
+                m_callable = new function_type(std::forward<Function>(function));
+                m_destroy  = [](void* callable) { delete static_cast<function_type*>(callable); };
+            }
+
+            m_invoke    = [](void* callable) { (*static_cast<function_type*>(callable))(); };
+            m_counter   = counter;
+        }
+
+        // Runs the callable and releases it, returns the counter that should be decremented (if any)
+        TaskCounter* Execute()
+        {
+            m_invoke(m_callable);
+            TaskCounter* counter = m_counter;
+            Reset();
+            return counter;
+        }
+
+        // Releases the callable without running it
+        TaskCounter* Discard()
+        {
+            TaskCounter* counter = m_counter;
+            Reset();
+            return counter;
+        }
+
+        TaskCounter* GetCounter() const     { return m_counter; }
+
+        // Pooling
+        bool TryAcquire()                   { return !m_in_use.exchange(true, std::memory_order_acquire); }
+        void Release()                      { m_in_use.store(false, std::memory_order_release); }
+        bool IsHeapAllocated() const        { return m_heap_allocated; }
+        void SetHeapAllocated(bool heap)    { m_heap_allocated = heap; }
+
+    private:
+        void Reset()
+        {
+            if (m_callable)
+            {
+                m_destroy(m_callable);
+            }
+
+            m_callable  = nullptr;
+            m_invoke    = nullptr;
+            m_destroy   = nullptr;
+            m_counter   = nullptr;
+        }
+
+        static constexpr size_t storage_size = 64;
+
+        alignas(std::max_align_t) std::byte m_storage[storage_size];
+        void* m_callable                = nullptr;
+        void (*m_invoke)(void*)         = nullptr;
+        void (*m_destroy)(void*)        = nullptr;
+        TaskCounter* m_counter          = nullptr;
+        std::atomic<bool> m_in_use      = false;
+        bool m_heap_allocated           = false;
+    };
+}
@@ -0,0 +1,150 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =========
+#include <atomic>
+#include <array>
+#include <cstdint>
+//====================
+
+namespace Spartan
+{
+    class Task;
+
+    class TaskCounter;
+
+    // A fixed capacity, lock-free Chase-Lev work-stealing deque.
+    // Only the owning thread may call Push() and Pop(), any thread may call Steal().
+    // Based on "Correct and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Nardelli 2013).
+    // Each slot also keeps the counter of its task, so that a thread which waits on a counter can take only the tasks associated with it.
+    class TaskQueue
+    {
+    public:
+        static constexpr int64_t capacity = 4096;
+
+        TaskQueue()
+        {
+            for (auto& slot : m_tasks)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+
+            for (auto& slot : m_counters)
+            {
+                slot.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // Owner only, returns false if the queue is full
+        bool Push(Task* task, const TaskCounter* counter)
+        {
+            const int64_t bottom    = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top       = m_top.load(std::memory_order_acquire);
+
+            if (bottom - top >= capacity)
+                return false;
+
+            m_tasks[bottom & mask].store(task, std::memory_order_relaxed);
+            m_counters[bottom & mask].store(counter, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+
+            return true;
+        }
+
+        // Owner only, takes from the bottom (LIFO, cache friendly). If a counter is given, the task is only taken if it's associated with it.
+        Task* Pop(const TaskCounter* counter = nullptr)
+        {
+            // Only the owner writes the slots, so the bottom one can be checked before committing to it
+            if (counter)
+            {
+                const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                if (bottom < m_top.load(std::memory_order_acquire) || m_counters[bottom & mask].load(std::memory_order_relaxed) != counter)
+                    return nullptr;
+            }
+
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+
+            // Empty
+            if (top > bottom)
+            {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            Task* task = m_tasks[bottom & mask].load(std::memory_order_relaxed);
+
+            // Last task, race against stealers
+            if (top == bottom)
+            {
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    task = nullptr;
+                }
+
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+
+            return task;
+        }
+
+        // Any thread, takes from the top (FIFO). If a counter is given, the task is only taken if it's associated with it.
+        Task* Steal(const TaskCounter* counter = nullptr)
+        {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+                return nullptr;
+
+            // The slot can only be reused after the top has moved past it, which the exchange below would catch
+            Task* task = m_tasks[top & mask].load(std::memory_order_relaxed);
+            if (counter && m_counters[top & mask].load(std::memory_order_relaxed) != counter)
+                return nullptr;
+
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+
+            return task;
+        }
+
+        bool IsEmpty() const
+        {
+            return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr int64_t mask = capacity - 1;
+        static_assert((capacity & mask) == 0, "Capacity must be a power of two");
+
+        alignas(64) std::atomic<int64_t> m_top      = 0;
+        alignas(64) std::atomic<int64_t> m_bottom   = 0;
+        std::array<std::atomic<Task*>, capacity> m_tasks;
+        std::array<std::atomic<const TaskCounter*>, capacity> m_counters;
+    };
+}
@@ -30,16 +30,29 @@ using namespace std;
 
 namespace Spartan
 {
+    // The index of the ThreadData owned by the calling thread (main thread is 0, workers follow)
+    static constexpr uint32_t thread_index_invalid = numeric_limits<uint32_t>::max();
+    static thread_local uint32_t thread_index = thread_index_invalid;
+
 	Threading::Threading(Context* context) : ISubsystem(context)
 	{
-		m_stopping	                            = false;
-        m_thread_count_support                  = thread::hardware_concurrency();
+        // Doesn't tick
+        SetTickDependencies(Tick_Dependency_None, Tick_Dependency_None, false);
+
+        m_thread_count_support                  = max(thread::hardware_concurrency(), 1u); // 0 if it can't be determined
 		m_thread_count                          = m_thread_count_support - 1; // exclude the main (this) thread
         m_thread_names[this_thread::get_id()]   = "main";
 
+        // Create a queue for every thread (plus one for the main thread)
+        for (uint32_t i = 0; i < m_thread_count + 1; i++)
+        {
+            m_thread_data.emplace_back(make_unique<ThreadData>());
+        }
+        thread_index = 0;
+
 		for (uint32_t i = 0; i < m_thread_count; i++)
 		{
-			m_threads.emplace_back(thread(&Threading::ThreadLoop, this));
+			m_threads.emplace_back(thread(&Threading::ThreadLoop, this, i + 1));
             m_thread_names[m_threads.back().get_id()] = "worker_" + to_string(i);
 		}
 
@@ -50,8 +63,8 @@ namespace Spartan
     {
         Flush(true);
 
-        // Put unique lock on task mutex.
-        unique_lock<mutex> lock(m_mutex_tasks);
+        // Put unique lock on the sleep mutex.
+        unique_lock<mutex> lock(m_mutex_sleep);
 
         // Set termination flag to true.
         m_stopping = true;
@@ -72,16 +85,26 @@ namespace Spartan
         m_threads.clear();
     }
 
-    uint32_t Threading::GetThreadsAvailable() const
+    void Threading::Wait(const TaskCounter& counter)
     {
-        uint32_t available_threads = m_thread_count;
-
-        for (const auto& task : m_tasks)
+        // Instead of spinning, help out
+        while (!counter.IsDone())
         {
-            available_threads -= task->IsExecuting() ? 1 : 0;
+            if (!TryExecuteTask(counter))
+            {
+                this_thread::yield();
+            }
         }
+    }
+
+    bool Threading::TryExecuteTask(const TaskCounter& counter)
+    {
+        Task* task = FindTask(&counter);
+        if (!task)
+            return false;
 
-        return available_threads;
+        Execute(task);
+        return true;
     }
 
     void Threading::Flush(bool removed_queued /*= false*/)
@@ -89,42 +112,180 @@ namespace Spartan
         // Clear any queued tasks
         if (removed_queued)
         {
-            m_tasks.clear();
+            for (const auto& thread_data : m_thread_data)
+            {
+                while (Task* task = thread_data->queue.Steal())
+                {
+                    Discard(task);
+                }
+            }
+
+            lock_guard<mutex> lock(m_mutex_tasks);
+            for (Task* task : m_tasks_overflow)
+            {
+                m_tasks_overflow_count--;
+                Discard(task);
+            }
+            m_tasks_overflow.clear();
         }
 
-        // If so, wait for them
+        // If so, wait for them (without helping, some of them may be waiting on the calling thread)
         while (AreTasksRunning())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            this_thread::yield();
         }
     }
 
-    void Threading::ThreadLoop()
+    void Threading::ThreadLoop(const uint32_t index)
     {
-        shared_ptr<Task> task;
+        thread_index = index;
+
         while (true)
         {
-            // Lock tasks mutex
-            unique_lock<mutex> lock(m_mutex_tasks);
+            if (Task* task = FindTask())
+            {
+                m_threads_working++;
+                Execute(task);
+                m_threads_working--;
+                continue;
+            }
 
-            // Check condition on notification
-            m_condition_var.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+            // Nothing to do, sleep until a task is submitted
+            unique_lock<mutex> lock(m_mutex_sleep);
+            m_threads_sleeping++;
+            m_condition_var.wait(lock, [this] { return m_tasks_queued > 0 || m_stopping; });
+            m_threads_sleeping--;
 
             // If m_stopping is true, it's time to shut everything down
-            if (m_stopping && m_tasks.empty())
+            if (m_stopping && m_tasks_queued <= 0)
                 return;
+        }
+    }
 
-            // Get next task in the queue.
-            task = m_tasks.front();
+    Task* Threading::AllocateTask()
+    {
+        // Threads which own a queue, also own a ring of tasks, so there is no allocation
+        if (thread_index < m_thread_data.size())
+        {
+            ThreadData& thread_data = *m_thread_data[thread_index];
+            Task& task = thread_data.task_pool[thread_data.task_pool_index++ & (task_pool_size - 1)];
+            if (task.TryAcquire())
+                return &task;
+        }
 
-            // Remove it from the queue.
-            m_tasks.pop_front();
+        // The ring wrapped around to a task that is still in flight (or this is a foreign thread)
+        Task* task = new Task();
+        task->SetHeapAllocated(true);
+        return task;
+    }
 
-            // Unlock the mutex
-            lock.unlock();
+    void Threading::ReleaseTask(Task* task)
+    {
+        if (task->IsHeapAllocated())
+        {
+            delete task;
+        }
+        else
+        {
+            task->Release();
+        }
+    }
 
-            // Execute the task.
-            task->Execute();
+    void Threading::Submit(Task* task)
+    {
+        m_tasks_pending++;
+
+        // Tasks without a counter are never waited on, so they don't belong in a queue that a waiting thread pops from
+        TaskCounter* counter    = task->GetCounter();
+        const bool queued       = counter && thread_index < m_thread_data.size() && m_thread_data[thread_index]->queue.Push(task, counter);
+        if (!queued)
+        {
+            lock_guard<mutex> lock(m_mutex_tasks);
+            m_tasks_overflow.push_back(task);
+            m_tasks_overflow_count++;
         }
+
+        m_tasks_queued++;
+
+        // Wake up a thread (the lock ensures it's not between checking the predicate and going to sleep)
+        if (m_threads_sleeping > 0)
+        {
+            { lock_guard<mutex> lock(m_mutex_sleep); }
+            m_condition_var.notify_one();
+        }
+    }
+
+    Task* Threading::FindTask(const TaskCounter* counter /*= nullptr*/)
+    {
+        const uint32_t thread_count = static_cast<uint32_t>(m_thread_data.size());
+        const bool owns_queue       = thread_index < thread_count;
+        Task* task                  = nullptr;
+
+        // Own queue first
+        if (owns_queue)
+        {
+            task = m_thread_data[thread_index]->queue.Pop(counter);
+        }
+
+        // Shared queue
+        if (!task && m_tasks_overflow_count > 0)
+        {
+            lock_guard<mutex> lock(m_mutex_tasks);
+            const auto it = !counter ? m_tasks_overflow.begin() : find_if(m_tasks_overflow.begin(), m_tasks_overflow.end(), [counter](const Task* task) { return task->GetCounter() == counter; });
+            if (it != m_tasks_overflow.end())
+            {
+                task = *it;
+                m_tasks_overflow.erase(it);
+                m_tasks_overflow_count--;
+            }
+        }
+
+        // Steal from the other threads
+        if (!task)
+        {
+            const uint32_t start = owns_queue ? thread_index + 1 : 0;
+            for (uint32_t i = 0; i < thread_count && !task; i++)
+            {
+                const uint32_t victim = (start + i) % thread_count;
+                if (owns_queue && victim == thread_index)
+                    continue;
+
+                task = m_thread_data[victim]->queue.Steal(counter);
+            }
+        }
+
+        if (task)
+        {
+            m_tasks_queued--;
+        }
+
+        return task;
+    }
+
+    void Threading::Execute(Task* task)
+    {
+        TaskCounter* counter = task->Execute();
+        ReleaseTask(task);
+
+        if (counter)
+        {
+            counter->Decrement();
+        }
+
+        m_tasks_pending--;
+    }
+
+    void Threading::Discard(Task* task)
+    {
+        TaskCounter* counter = task->Discard();
+        ReleaseTask(task);
+
+        if (counter)
+        {
+            counter->Decrement();
+        }
+
+        m_tasks_queued--;
+        m_tasks_pending--;
     }
 }
@@ -25,38 +25,29 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <deque>
+#include <array>
+#include <atomic>
 #include <unordered_map>
 #include <functional>
+#include "Task.h"
+#include "TaskQueue.h"
 #include "../Logging/Log.h"
 #include "../Core/ISubsystem.h"
 //=============================
 
 namespace Spartan
 {
-	class Task
-	{
-	public:
-		typedef std::function<void()> function_type;
-
-		Task(function_type&& function)  { m_function = std::forward<function_type>(function); }
-        void Execute()                  { m_is_executing = true; m_function(); m_is_executing = false; }
-        bool IsExecuting() const { return m_is_executing; }
-
-	private:
-        bool m_is_executing = false;
-		function_type m_function;
-	};
-
 	class Threading : public ISubsystem
 	{
 	public:
 		Threading(Context* context);
         ~Threading();
 
-		// Add a task
+		// Add a task, if a counter is provided it will be incremented now and decremented once the task completes
 		template <typename Function>
-		void AddTask(Function&& function)
+		void AddTask(Function&& function, TaskCounter* counter = nullptr)
 		{
 			if (m_threads.empty())
 			{
@@ -65,75 +56,147 @@ namespace Spartan
 				return;
 			}
 
-			// Lock tasks mutex
-			std::unique_lock<std::mutex> lock(m_mutex_tasks);
-
-			// Save the task
-			m_tasks.push_back(std::make_shared<Task>(std::bind(std::forward<Function>(function))));
+            if (counter)
+            {
+                counter->Increment();
+            }
 
-			// Unlock the mutex
-			lock.unlock();
+            // Acquire a pooled task and store the function in it
+            Task* task = AllocateTask();
+            task->Set(std::forward<Function>(function), counter);
 
-			// Wake up a thread
-			m_condition_var.notify_one();
+            // Push it to the calling thread's queue (idle threads will steal it from there), or to the shared queue
+            Submit(task);
 		}
 
-        // Adds a task which is a loop and executes chunks of it in parallel
+        // Executes function(start, end) over chunks of [0, range) in parallel, the counter is the handle to wait on.
+        // The function is copied into the tasks, so it doesn't have to outlive this call.
+        // A grain size of 0 picks one based on the thread count.
         template <typename Function>
-        void AddTaskLoop(Function&& function, uint32_t range)
+        void ParallelFor(uint32_t range, uint32_t grain_size, Function&& function, TaskCounter* counter)
         {
-            uint32_t available_threads  = GetThreadsAvailable();
-            vector<bool> tasks_done     = vector<bool>(available_threads, false);
-            const uint32_t task_count   = available_threads + 1; // plus one for the current thread
+            if (range == 0)
+                return;
+
+            grain_size = GetGrainSize(range, grain_size);
 
-            uint32_t start  = 0;
-            uint32_t end    = 0;
-            for (uint32_t i = 0; i < available_threads; i++)
+            AddTask([this, range, grain_size, function = std::forward<Function>(function), counter]()
             {
-                start   = (range / task_count) * i;
-                end     = start + (range / task_count);
+                ParallelForSplit(0, range, grain_size, function, counter);
+            }, counter);
+        }
 
-                // Kick off task
-                AddTask([&function, &tasks_done, i, start, end] { function(start, end); tasks_done[i] = true; });
-            }
+        // Executes function(start, end) over chunks of [0, range) in parallel and waits for them to finish.
+        // The calling thread participates, so it's safe to call from within a task (nested loops).
+        template <typename Function>
+        void ParallelFor(uint32_t range, uint32_t grain_size, Function&& function)
+        {
+            if (range == 0)
+                return;
 
-            // Do last task in the current thread
-            function(end, range);
+            grain_size = GetGrainSize(range, grain_size);
 
-            // Wait till the threads are done
-            uint32_t tasks = 0;
-            while (tasks != tasks_done.size())
-            {
-                tasks = 0;
-                for (const bool job_done : tasks_done)
-                {
-                    tasks += job_done ? 1 : 0;
-                }
-            }
+            TaskCounter counter;
+            auto function_ref = [&function](uint32_t start, uint32_t end) { function(start, end); };
+            ParallelForSplit(0, range, grain_size, function_ref, &counter);
+            Wait(counter);
         }
 
+        // Blocks until the counter reaches zero, the calling thread executes queued tasks associated with the counter while waiting
+        void Wait(const TaskCounter& counter);
+
+        // Executes a single queued task which is associated with the counter on the calling thread, returns false if there was none.
+        // Waiting threads only help with their own work, anything else (e.g. a long import) could stall them, or wait on them.
+        bool TryExecuteTask(const TaskCounter& counter);
+
         // Get the number of threads used
         uint32_t GetThreadCount()           const { return m_thread_count; }
         // Get the maximum number of threads the hardware supports
         uint32_t GetThreadCountSupport()    const { return m_thread_count_support; }
         // Get the number of threads which are not doing any work
-        uint32_t GetThreadsAvailable()      const;
-        // Returns true if at least one task is running
-        bool AreTasksRunning()              const { return GetThreadsAvailable() != GetThreadCount(); }
+        uint32_t GetThreadsAvailable()      const { return m_thread_count - m_threads_working.load(std::memory_order_relaxed); }
+        // Returns true if at least one task is queued or running
+        bool AreTasksRunning()              const { return m_tasks_pending.load(std::memory_order_acquire) != 0; }
         // Waits for all executing (and queued if requested) tasks to finish
         void Flush(bool removed_queued = false);
 
 	private:
+        static constexpr uint32_t task_pool_size = 1024;
+
+        // Each thread (including the main thread) owns a deque it pushes tasks with a counter to and pops from, other threads steal from it
+        struct ThreadData
+        {
+            TaskQueue queue;
+            std::array<Task, task_pool_size> task_pool;
+            uint32_t task_pool_index = 0;
+        };
+
         // This function is invoked by the threads
-        void ThreadLoop();
+        void ThreadLoop(uint32_t thread_index);
+
+        // Lazy binary splitting: half of the range is handed to other threads only while some of them are idle,
+        // otherwise the calling thread keeps consuming grain sized chunks (and checks again after each one).
+        template <typename Function>
+        void ParallelForSplit(uint32_t start, uint32_t end, const uint32_t grain_size, const Function& function, TaskCounter* counter)
+        {
+            while (end - start > grain_size)
+            {
+                if (!m_threads.empty() && GetThreadsAvailable() > 0)
+                {
+                    const uint32_t middle = start + (end - start) / 2;
+                    AddTask([this, middle, end, grain_size, function, counter]()
+                    {
+                        ParallelForSplit(middle, end, grain_size, function, counter);
+                    }, counter);
+                    end = middle;
+                }
+                else
+                {
+                    function(start, start + grain_size);
+                    start += grain_size;
+                }
+            }
+
+            function(start, end);
+        }
+
+        uint32_t GetGrainSize(uint32_t range, uint32_t grain_size) const
+        {
+            // Aim for a few chunks per thread so that stealing can balance uneven work
+            if (grain_size == 0)
+            {
+                grain_size = range / ((m_thread_count + 1) * 4);
+            }
+
+            return grain_size != 0 ? grain_size : 1;
+        }
+
+        Task* AllocateTask();
+        void ReleaseTask(Task* task);
+        void Submit(Task* task);
+        Task* FindTask(const TaskCounter* counter = nullptr); // any task, if no counter is given
+        void Execute(Task* task);
+        void Discard(Task* task);
 
 		uint32_t m_thread_count         = 0;
         uint32_t m_thread_count_support = 0;
 		std::vector<std::thread> m_threads;
-		std::deque<std::shared_ptr<Task>> m_tasks;
+        std::vector<std::unique_ptr<ThreadData>> m_thread_data;
+        std::unordered_map<std::thread::id, std::string> m_thread_names;
+
+        // Tasks without a counter, the ones submitted from threads that don't own a queue, and the ones which didn't fit in a queue.
+        // Only the workers take tasks from here without a counter to match.
+		std::deque<Task*> m_tasks_overflow;
 		std::mutex m_mutex_tasks;
+        std::atomic<uint32_t> m_tasks_overflow_count = 0;
+
+        // Sleeping
+        std::mutex m_mutex_sleep;
 		std::condition_variable m_condition_var;
-        std::unordered_map<std::thread::id, std::string> m_thread_names;
-		bool m_stopping;
+        std::atomic<int32_t> m_tasks_queued     = 0;
+        std::atomic<uint32_t> m_tasks_pending   = 0;
+        std::atomic<uint32_t> m_threads_sleeping = 0;
+        std::atomic<uint32_t> m_threads_working = 0;
+		std::atomic<bool> m_stopping            = false;
 	};
 }
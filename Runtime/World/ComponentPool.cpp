@@ -0,0 +1,86 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+//= INCLUDES ===========
+#include "Spartan.h"
+#include "ComponentPool.h"
+//======================
+
+//= NAMESPACES =====
+using namespace std;
+//==================
+
+namespace Spartan
+{
+    ComponentHandle ComponentPool::Add(IComponent* component)
+    {
+        ComponentHandle handle;
+
+        // Reuse a free slot, or make a new one
+        if (!m_slots_free.empty())
+        {
+            handle.index = m_slots_free.back();
+            m_slots_free.pop_back();
+        }
+        else
+        {
+            handle.index = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        }
+
+        Slot& slot          = m_slots[handle.index];
+        slot.component      = static_cast<uint32_t>(m_components.size());
+        handle.generation   = slot.generation;
+
+        m_components.emplace_back(component);
+        m_component_slots.emplace_back(handle.index);
+
+        return handle;
+    }
+
+    void ComponentPool::Remove(const ComponentHandle& handle)
+    {
+        if (!Get(handle))
+            return;
+
+        // Move the last component into the removed one's place
+        Slot& slot                          = m_slots[handle.index];
+        const uint32_t slot_last            = m_component_slots.back();
+        m_components[slot.component]        = m_components.back();
+        m_component_slots[slot.component]   = slot_last;
+        m_slots[slot_last].component        = slot.component;
+        m_components.pop_back();
+        m_component_slots.pop_back();
+
+        // Outdate any handles to the slot
+        slot.generation++;
+        m_slots_free.emplace_back(handle.index);
+    }
+
+    IComponent* ComponentPool::Get(const ComponentHandle& handle) const
+    {
+        if (handle.index >= static_cast<uint32_t>(m_slots.size()))
+            return nullptr;
+
+        const Slot& slot = m_slots[handle.index];
+        return slot.generation == handle.generation ? m_components[slot.component] : nullptr;
+    }
+}
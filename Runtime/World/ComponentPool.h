@@ -0,0 +1,72 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include "../Core/Spartan_Definitions.h"
+//================================
+
+namespace Spartan
+{
+	class IComponent;
+
+    static const uint32_t m_component_handle_invalid = 0xFFFFFFFF;
+
+    // Refers to a component in its pool. A slot's generation changes every time it's freed,
+    // so the handle of a removed component resolves to nothing, instead of to whatever took its slot.
+    struct ComponentHandle
+    {
+        bool IsValid() const { return index != m_component_handle_invalid; }
+
+        uint32_t index      = m_component_handle_invalid;
+        uint32_t generation = 0;
+    };
+
+    // The components of one type, so that systems can walk them without going through the entities. The array is dense,
+    // but it holds pointers, the components themselves are still allocated (and owned through shared_ptr) one by one.
+    // Removing a component moves the last one into its place, the slots keep the handles pointing at the right one.
+    class SPARTAN_CLASS ComponentPool
+    {
+    public:
+        ComponentPool() = default;
+        ~ComponentPool() = default;
+
+        ComponentHandle Add(IComponent* component);
+        void Remove(const ComponentHandle& handle);
+        IComponent* Get(const ComponentHandle& handle) const;
+        const auto& GetAll() const  { return m_components; }
+        auto GetCount() const       { return static_cast<uint32_t>(m_components.size()); }
+
+    private:
+        struct Slot
+        {
+            uint32_t component  = 0; // index in m_components
+            uint32_t generation = 0;
+        };
+
+        std::vector<IComponent*> m_components;
+        std::vector<uint32_t> m_component_slots; // the slot of each component
+        std::vector<Slot> m_slots;
+        std::vector<uint32_t> m_slots_free;
+    };
+}
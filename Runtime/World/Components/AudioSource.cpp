@@ -112,9 +112,18 @@ namespace Spartan
 		stream->Read(&m_pitch);
 		stream->Read(&m_pan);
 
+        m_audio_clip_name.clear();
         if (stream->ReadAs<bool>())
         {
-            m_audio_clip = m_context->GetSubsystem<ResourceCache>()->GetByName<AudioClip>(stream->ReadAs<string>());
+            stream->Read(&m_audio_clip_name);
+        }
+	}
+
+	void AudioSource::OnDeserialized()
+	{
+        if (!m_audio_clip_name.empty())
+        {
+            m_audio_clip = m_context->GetSubsystem<ResourceCache>()->GetByName<AudioClip>(m_audio_clip_name);
         }
 	}
 
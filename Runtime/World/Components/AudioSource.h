@@ -45,6 +45,7 @@ namespace Spartan
 		void OnTick(float delta_time) override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
+		void OnDeserialized() override;
 		//============================================
 
 		//= PROPERTIES ===================================================================
@@ -78,6 +79,7 @@ namespace Spartan
 
 	private:
 		std::shared_ptr<AudioClip> m_audio_clip;
+		std::string m_audio_clip_name; // read by Deserialize(), resolved by OnDeserialized()
 		bool m_mute;
 		bool m_play_on_start;
 		bool m_loop;
@@ -105,7 +105,10 @@ namespace Spartan
 		stream->Read(&m_fov_horizontal_rad);
 		stream->Read(&m_near_plane);
 		stream->Read(&m_far_plane);
+	}
 
+	void Camera::OnDeserialized()
+	{
         m_view              = ComputeViewMatrix();
         m_projection        = ComputeProjection(m_renderer->GetOption(Render_ReverseZ));
         m_view_projection   = m_view * m_projection;
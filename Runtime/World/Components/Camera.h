@@ -58,6 +58,7 @@ namespace Spartan
 		void OnTick(float delta_time) override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
+		void OnDeserialized() override;
 		//============================================
 
 		//= MATRICES ======================================================================
@@ -116,6 +117,7 @@ namespace Spartan
 		//= MISC ==============================================================================
 		bool IsInViewFrustrum(Renderable* renderable) const;
 		bool IsInViewFrustrum(const Math::Vector3& center, const Math::Vector3& extents) const;
+        const Math::Frustum& GetFrustum() const { return m_frustrum; }
 		const Math::Vector4& GetClearColor() const		{ return m_clear_color; }
 		void SetClearColor(const Math::Vector4& color)	{ m_clear_color = color; }
         bool GetFpsControl()                 const { return m_fps_control; }
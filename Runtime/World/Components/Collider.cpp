@@ -81,7 +81,10 @@ namespace Spartan
 		m_shapeType = ColliderShape(stream->ReadAs<uint32_t>());
 		stream->Read(&m_size);
 		stream->Read(&m_center);
+	}
 
+	void Collider::OnDeserialized()
+	{
 		Shape_Update();
 	}
 
@@ -54,6 +54,7 @@ namespace Spartan
 		void OnRemove() override;
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
+		void OnDeserialized() override;
 		//============================================
 
 		// Bounding box
@@ -112,8 +112,12 @@ namespace Spartan
 		stream->Read(&m_highLimit);
 		stream->Read(&m_lowLimit);
 
-		const auto body_other_id = stream->ReadAs<uint32_t>();
-		m_bodyOther = GetContext()->GetSubsystem<World>()->EntityGetById(body_other_id);
+		stream->Read(&m_bodyOther_id);
+	}
+
+	void Constraint::OnDeserialized()
+	{
+		m_bodyOther = GetContext()->GetSubsystem<World>()->EntityGetById(m_bodyOther_id);
 
 		Construct();
 	}
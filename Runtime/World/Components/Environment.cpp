@@ -84,7 +84,10 @@ namespace Spartan
     {
         m_environment_type = static_cast<Environment_Type>(stream->ReadAs<uint8_t>());
         stream->Read(&m_file_paths);
+    }
 
+    void Environment::OnDeserialized()
+    {
         m_context->GetSubsystem<Threading>()->AddTask([this]
         {
             if (m_environment_type == Enviroment_Cubemap)
@@ -44,6 +44,7 @@ namespace Spartan
         void OnTick(float delta_time) override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
+        void OnDeserialized() override;
         //============================================
 
         void LoadDefault();
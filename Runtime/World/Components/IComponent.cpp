@@ -48,7 +48,7 @@ namespace Spartan
     {
         m_context   = context;
         m_entity    = entity;
-        m_transform = transform ? transform : entity->GetTransform();
+        m_transform = transform ? transform : (entity ? entity->GetTransform() : nullptr);
         m_enabled   = true;
     }
 
@@ -27,6 +27,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <any>
 #include <vector>
 #include <functional>
+#include "../ComponentPool.h"
 #include "../../Core/Spartan_Object.h"
 //====================================
 
@@ -55,6 +56,8 @@ namespace Spartan
 		Unknown
 	};
 
+    static const uint32_t m_component_type_count = static_cast<uint32_t>(ComponentType::Unknown);
+
 	struct Attribute
 	{
 		std::function<std::any()> getter;
@@ -85,9 +88,13 @@ namespace Spartan
 		// Runs when the entity is being saved
 		virtual void Serialize(FileStream* stream) {}
 
-		// Runs when the entity is being loaded
+		// Runs when the entity is being loaded, it only reads into the component so that a world's components can be read in parallel
 		virtual void Deserialize(FileStream* stream) {}
 
+		// Runs after Deserialize(), once all of the entity's components have been read, anything which touches more than the
+		// component itself (resources, physics, other entities) happens here, one component at a time
+		virtual void OnDeserialized() {}
+
 		//= TYPE ===================================
 		template <typename T>
 		static constexpr ComponentType TypeToEnum();
@@ -99,6 +106,10 @@ namespace Spartan
 		ComponentType GetType() const	            { return m_type; }
         void SetType(ComponentType type)            { m_type = type; }
 
+        // Where the component is in the world's pool of its type
+        const ComponentHandle& GetHandle() const        { return m_handle; }
+        void SetHandle(const ComponentHandle& handle)   { m_handle = handle; }
+
         template <typename T>
         std::shared_ptr<T> GetPtrShared() { return dynamic_pointer_cast<T>(shared_from_this()); }
 
@@ -146,6 +157,8 @@ namespace Spartan
 		Entity* m_entity		= nullptr;
 		// The transform of the component (always exists)
 		Transform* m_transform	= nullptr;
+		// The slot of the component in the world's pool
+		ComponentHandle m_handle;
 
 	private:
 		// The attributes of the component
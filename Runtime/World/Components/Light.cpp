@@ -29,7 +29,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "../../IO/FileStream.h"
 #include "../../Rendering/Renderer.h"
 #include "../../RHI/RHI_Texture2D.h"
-#include "../../RHI/RHI_TextureCube.h"
 //====================================
 
 //= NAMESPACES ===============
@@ -117,12 +116,9 @@ namespace Spartan
 
             ComputeViewMatrix();
 
-            if (m_shadow_map.texture_depth)
+            for (uint32_t i = 0; i < GetShadowArraySize(); i++)
             {
-                for (uint32_t i = 0; i < m_shadow_map.texture_depth->GetArraySize(); i++)
-                {
-                    ComputeProjectionMatrix(i);
-                }
+                ComputeProjectionMatrix(i);
             }
         }
 
@@ -146,7 +142,9 @@ namespace Spartan
 
 	void Light::Deserialize(FileStream* stream)
 	{
-		SetLightType(static_cast<LightType>(stream->ReadAs<uint32_t>()));
+		// Not through SetLightType(), the shadow map is created on the first tick
+		m_light_type	= static_cast<LightType>(stream->ReadAs<uint32_t>());
+		m_is_dirty		= true;
 		stream->Read(&m_shadows_enabled);
         stream->Read(&m_shadows_screen_space_enabled);
         stream->Read(&m_shadows_transparent_enabled);
@@ -271,7 +269,7 @@ namespace Spartan
 
 	bool Light::ComputeProjectionMatrix(uint32_t index /*= 0*/)
 	{
-		if (index >= m_shadow_map.texture_depth->GetArraySize())
+		if (index >= GetShadowArraySize())
         {
             LOG_ERROR_INVALID_PARAMETER();
             return false;
@@ -290,9 +288,7 @@ namespace Spartan
 		}
 		else
 		{
-			const float width			= static_cast<float>(m_shadow_map.texture_depth->GetWidth());
-			const float height			= static_cast<float>(m_shadow_map.texture_depth->GetHeight());
-			const auto aspect_ratio		= width / height;
+			const auto aspect_ratio		= 1.0f; // the tiles of the shadow atlas are square
 			const float fov				= 1.57079633f; // 1.57079633 = 90 deg
 			const float near_plane		= reverse_z ? m_range : 0.1f;
 			const float far_plane		= reverse_z ? 0.1f : m_range;
@@ -429,6 +425,13 @@ namespace Spartan
 
     uint32_t Light::GetShadowArraySize() const
     {
+        if (!m_shadows_enabled)
+            return 0;
+
+        // Point and spot lights render into tiles of the renderer's shadow atlas, only directional lights have textures
+        if (m_light_type != LightType::Directional)
+            return static_cast<uint32_t>(m_shadow_map.slices.size());
+
         return m_shadow_map.texture_depth ? m_shadow_map.texture_depth->GetArraySize() : 0;
     }
 
@@ -469,24 +472,14 @@ namespace Spartan
 		}
 		else if (GetLightType() == LightType::Point)
 		{
-            m_shadow_map.texture_depth = make_unique<RHI_TextureCube>(m_context, resolution, resolution, RHI_Format_D32_Float);
-
-            if (m_shadows_transparent_enabled)
-            {
-                m_shadow_map.texture_color = make_unique<RHI_TextureCube>(m_context, resolution, resolution, RHI_Format_R8G8B8A8_Unorm);
-            }
-
+            m_shadow_map.texture_depth.reset();
+            m_shadow_map.texture_color.reset();
             m_shadow_map.slices = vector<ShadowSlice>(6);
 		}
 		else if (GetLightType() == LightType::Spot)
 		{
-            m_shadow_map.texture_depth  = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_D32_Float, 1);
-
-            if (m_shadows_transparent_enabled)
-            {
-                m_shadow_map.texture_color = make_unique<RHI_Texture2D>(m_context, resolution, resolution, RHI_Format_R8G8B8A8_Unorm, 1);
-            }
-
+            m_shadow_map.texture_depth.reset();
+            m_shadow_map.texture_color.reset();
             m_shadow_map.slices = vector<ShadowSlice>(1);
 		}
 	}
@@ -118,6 +118,7 @@ namespace Spartan
 
 		RHI_Texture* GetDepthTexture() const { return m_shadow_map.texture_depth.get(); }
         RHI_Texture* GetColorTexture() const { return m_shadow_map.texture_color.get(); }
+        const ShadowMap& GetShadowMap() const { return m_shadow_map; }
         uint32_t GetShadowArraySize() const;
         void CreateShadowMap();
 
@@ -145,9 +145,23 @@ namespace Spartan
 		m_geometryVertexOffset	= stream->ReadAs<uint32_t>();
 		m_geometryVertexCount	= stream->ReadAs<uint32_t>();
 		stream->Read(&m_bounding_box);
-		string model_name;
-		stream->Read(&model_name);
-		m_model = m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(model_name);
+		m_aabb_dirty = true;
+		stream->Read(&m_model_name);
+
+		// Material
+		stream->Read(&m_castShadows);
+		stream->Read(&m_receiveShadows);
+		stream->Read(&m_material_default);
+		m_material_name.clear();
+		if (!m_material_default)
+		{
+			stream->Read(&m_material_name);
+		}
+	}
+
+	void Renderable::OnDeserialized()
+	{
+		m_model = m_context->GetSubsystem<ResourceCache>()->GetByName<Model>(m_model_name);
 
 		// If it was a default mesh, we have to reconstruct it
 		if (m_geometry_type != Geometry_Custom) 
@@ -155,19 +169,13 @@ namespace Spartan
 			GeometrySet(m_geometry_type);
 		}
 
-		// Material
-		stream->Read(&m_castShadows);
-		stream->Read(&m_receiveShadows);
-		stream->Read(&m_material_default);
 		if (m_material_default)
 		{
 			UseDefaultMaterial();		
 		}
 		else
 		{
-			string material_name;
-			stream->Read(&material_name);
-			m_material = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(material_name);
+			m_material = m_context->GetSubsystem<ResourceCache>()->GetByName<Material>(m_material_name);
 		}
 	}
 
@@ -180,6 +188,10 @@ namespace Spartan
 		m_geometryVertexCount	= vertex_count;
 		m_bounding_box			= bounding_box;
 		m_model					= model ? model->GetSharedPtr() : nullptr;
+		m_aabb_dirty			= true;
+
+		// The world's spatial index (and the renderer) have to pick up the new bounds
+		FIRE_EVENT_DATA(EventType::WorldResolve, m_entity);
 	}
 
 	void Renderable::GeometrySet(const Geometry_Type type)
@@ -211,10 +223,11 @@ namespace Spartan
     const BoundingBox& Renderable::GetAabb()
 	{
         // Updated if dirty
-        if (m_last_transform != GetTransform()->GetMatrix())
+        if (m_aabb_dirty || m_last_transform != GetTransform()->GetMatrix())
         {
             m_aabb = m_bounding_box.Transform(GetTransform()->GetMatrix());
             m_last_transform = GetTransform()->GetMatrix();
+            m_aabb_dirty = false;
         }
 
 		return m_aabb;
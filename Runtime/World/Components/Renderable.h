@@ -58,6 +58,7 @@ namespace Spartan
 		//= ICOMPONENT ===============================
 		void Serialize(FileStream* stream) override;
 		void Deserialize(FileStream* stream) override;
+		void OnDeserialized() override;
 		//============================================
 
 		//= GEOMETRY ==========================================================================================
@@ -80,6 +81,7 @@ namespace Spartan
         Geometry_Type GeometryType()			    const { return m_geometry_type; }
 		const std::string& GeometryName()	        const { return m_geometryName; }
 		const Model* GeometryModel()                const { return m_model.get(); }
+		std::shared_ptr<const Model> GeometryModel_PtrShared() const { return m_model; }
         const Math::BoundingBox& GetBoundingBox()   const { return m_bounding_box; }
         const Math::BoundingBox& GetAabb();
 		//=====================================================================================================
@@ -111,10 +113,13 @@ namespace Spartan
 		uint32_t m_geometryVertexOffset;
 		uint32_t m_geometryVertexCount;
 		std::shared_ptr<Model> m_model;
+		std::string m_model_name; // read by Deserialize(), resolved by OnDeserialized()
+		std::string m_material_name;
 		Geometry_Type m_geometry_type;
 		Math::BoundingBox m_bounding_box;
 		Math::BoundingBox m_aabb;
         Math::Matrix m_last_transform   = Math::Matrix::Identity;
+        bool m_aabb_dirty               = true;
         bool m_castShadows              = true;
         bool m_receiveShadows           = true;
 		bool m_material_default;
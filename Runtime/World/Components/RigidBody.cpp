@@ -44,32 +44,54 @@ namespace Spartan
 	static const float DEFAULT_RESTITUTION          = 0.0f;	
 	static const float DEFAULT_DEACTIVATION_TIME    = 2000;
 
+	// Keeps the body's pose on the simulation's side, so that the physics can step while the world ticks.
+	// The rigid body exchanges it with the transform when it ticks, which the physics lock keeps apart from the step.
 	class MotionState : public btMotionState
 	{
 	public:
-		MotionState(RigidBody* rigidBody) { m_rigidBody = rigidBody; }
+		MotionState(RigidBody* rigidBody)
+		{
+			m_rigidBody	= rigidBody;
+			m_position	= rigidBody->GetTransform()->GetPosition();
+			m_rotation	= rigidBody->GetTransform()->GetRotation();
+		}
 
 		// Update from engine, ENGINE -> BULLET
 		void getWorldTransform(btTransform& worldTrans) const override
 		{
-            const Vector3 lastPos		= m_rigidBody->GetTransform()->GetPosition();
-            const Quaternion lastRot	= m_rigidBody->GetTransform()->GetRotation();
-
-			worldTrans.setOrigin(ToBtVector3(lastPos + lastRot * m_rigidBody->GetCenterOfMass()));
-			worldTrans.setRotation(ToBtQuaternion(lastRot));
+			worldTrans.setOrigin(ToBtVector3(m_position + m_rotation * m_rigidBody->GetCenterOfMass()));
+			worldTrans.setRotation(ToBtQuaternion(m_rotation));
 		}
 
 		// Update from bullet, BULLET -> ENGINE
 		void setWorldTransform(const btTransform& worldTrans) override
 		{
-            const Quaternion newWorldRot	= ToQuaternion(worldTrans.getRotation());
-            const Vector3 newWorldPos		= ToVector3(worldTrans.getOrigin()) - newWorldRot * m_rigidBody->GetCenterOfMass();
+			m_rotation	= ToQuaternion(worldTrans.getRotation());
+			m_position	= ToVector3(worldTrans.getOrigin()) - m_rotation * m_rigidBody->GetCenterOfMass();
+			m_simulated	= true;
+		}
+
+		// Hands what the simulation did over to the transform, and the transform over to the simulation (kinematic bodies follow it)
+		void Exchange()
+		{
+			Transform* transform = m_rigidBody->GetTransform();
+			if (m_simulated)
+			{
+				transform->SetPosition(m_position);
+				transform->SetRotation(m_rotation);
+				m_simulated = false;
+				return;
+			}
 
-			m_rigidBody->GetTransform()->SetPosition(newWorldPos);
-			m_rigidBody->GetTransform()->SetRotation(newWorldRot);
+			m_position = transform->GetPosition();
+			m_rotation = transform->GetRotation();
 		}
+
     private:
         RigidBody* m_rigidBody;
+		Vector3 m_position;
+		Quaternion m_rotation;
+		bool m_simulated = false;
 	};
 
 	RigidBody::RigidBody(Context* context, Entity* entity, uint32_t id /*= 0*/) : IComponent(context, entity, id)
@@ -124,6 +146,11 @@ namespace Spartan
 
 	void RigidBody::OnTick(float delta_time)
 	{
+		if (m_rigidBody)
+		{
+			static_cast<MotionState*>(m_rigidBody->getMotionState())->Exchange();
+		}
+
 		// When the rigid body is inactive or we are in editor mode, allow the user to move/rotate it
 		if (!IsActivated() || !m_context->m_engine->EngineMode_IsSet(Engine_Game))
 		{
@@ -169,7 +196,10 @@ namespace Spartan
 		stream->Read(&m_position_lock);
 		stream->Read(&m_rotation_lock);
 		stream->Read(&m_in_world);
+	}
 
+	void RigidBody::OnDeserialized()
+	{
 		Body_AcquireShape();
 		Body_AddToWorld();
 	}
@@ -66,6 +66,10 @@ namespace Spartan
 	void Script::Deserialize(FileStream* stream)
 	{
         stream->Read(&m_file_path);
+	}
+
+	void Script::OnDeserialized()
+	{
         SetScript(m_file_path);
 	}
 
@@ -62,11 +62,17 @@ namespace Spartan
 
     void Terrain::Deserialize(FileStream* stream)
     {
-        ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
-        m_height_map    = resource_cache->GetByPath<RHI_Texture2D>(stream->ReadAs<string>());
-        m_model         = resource_cache->GetByName<Model>(stream->ReadAs<string>());
+        stream->Read(&m_height_map_path);
+        stream->Read(&m_model_name);
         stream->Read(&m_min_y);
         stream->Read(&m_max_y);
+    }
+
+    void Terrain::OnDeserialized()
+    {
+        ResourceCache* resource_cache = m_context->GetSubsystem<ResourceCache>();
+        m_height_map    = resource_cache->GetByPath<RHI_Texture2D>(m_height_map_path);
+        m_model         = resource_cache->GetByName<Model>(m_model_name);
 
         UpdateFromModel(m_model);
     }
@@ -375,7 +381,7 @@ namespace Spartan
             }
         };
 
-        m_context->GetSubsystem<Threading>()->AddTaskLoop(compute_vertex_normals_tangents, vertex_count);
+        m_context->GetSubsystem<Threading>()->ParallelFor(vertex_count, 0, compute_vertex_normals_tangents);
 
         return true;
     }
@@ -45,6 +45,7 @@ namespace Spartan
         void OnInitialize() override;
         void Serialize(FileStream* stream) override;
         void Deserialize(FileStream* stream) override;
+        void OnDeserialized() override;
         //============================================
 
         const auto& GetHeightMap() const { return m_height_map; }
@@ -81,5 +82,7 @@ namespace Spartan
         std::string m_progress_desc;
         std::shared_ptr<RHI_Texture2D> m_height_map;
         std::shared_ptr<Model> m_model;
+        std::string m_height_map_path; // read by Deserialize(), resolved by OnDeserialized()
+        std::string m_model_name;
     };
 }
@@ -41,14 +41,12 @@ namespace Spartan
 		m_scaleLocal		= Vector3::One;
 		m_matrix			= Matrix::Identity;
 		m_matrixLocal		= Matrix::Identity;
-		m_wvp_previous		= Matrix::Identity;
 		m_parent			= nullptr;
 
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_positionLocal,	Vector3);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_rotationLocal,	Quaternion);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_scaleLocal, Vector3);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrix, Matrix);
-		REGISTER_ATTRIBUTE_VALUE_VALUE(m_matrixLocal, Matrix);
+		// The matrices are derived from these, the setters mark them dirty
+		REGISTER_ATTRIBUTE_VALUE_SET(m_positionLocal, SetPositionLocal, Vector3);
+		REGISTER_ATTRIBUTE_VALUE_SET(m_rotationLocal, SetRotationLocal, Quaternion);
+		REGISTER_ATTRIBUTE_VALUE_SET(m_scaleLocal, SetScaleLocal, Vector3);
 		REGISTER_ATTRIBUTE_VALUE_VALUE(m_lookAt, Vector3);
 	}
 
@@ -73,26 +71,23 @@ namespace Spartan
 		stream->Read(&m_rotationLocal);
 		stream->Read(&m_scaleLocal);
 		stream->Read(&m_lookAt);
-		uint32_t parententity_id = 0;
-		stream->Read(&parententity_id);
 
-		if (parententity_id != 0)
-		{
-			if (const auto parent = GetContext()->GetSubsystem<World>()->EntityGetById(parententity_id))
-			{
-				parent->GetTransform()->AddChild(this);
-			}
-		}
+		// The parent is linked by whoever loads the hierarchy (the entity or the world), once every transform exists,
+		// this keeps deserialization free of shared state so that transforms can be loaded in parallel.
+		stream->ReadAs<uint32_t>();
 
-		UpdateTransform();
+		MarkDirty();
 	}
 	//===============================================================================================
-	void Transform::UpdateTransform()
+	void Transform::UpdateTransform() const
 	{
+		if (!m_is_dirty)
+			return;
+
 		// Compute local transform
 		m_matrixLocal = Matrix(m_positionLocal, m_rotationLocal, m_scaleLocal);
 
-		// Compute world transform
+		// Compute world transform (resolving the parent first, if it's dirty too)
 		if (!HasParent())
 		{
 			m_matrix = m_matrixLocal;
@@ -101,20 +96,28 @@ namespace Spartan
 		{
 			m_matrix = m_matrixLocal * GetParentTransformMatrix();
 		}
-		
-		// Update children
-		for (const auto& child : m_children)
+
+		m_is_dirty = false;
+	}
+
+	void Transform::MarkDirty()
+	{
+		// If this transform is already dirty, so are its descendants
+		if (m_is_dirty)
+			return;
+
+		m_is_dirty = true;
+		m_moved = true;
+
+		for (Transform* child : m_children)
 		{
-			child->UpdateTransform();
+			child->MarkDirty();
 		}
 	}
 
 	//= TRANSLATION ==================================================================================
 	void Transform::SetPosition(const Vector3& position)
 	{
-		if (GetPosition() == position)
-			return;
-
 		SetPositionLocal(!HasParent() ? position : position * GetParent()->GetMatrix().Inverted());
 	}
 
@@ -124,16 +127,13 @@ namespace Spartan
 			return;
 
 		m_positionLocal = position;
-		UpdateTransform();
+		MarkDirty();
 	}
 	//================================================================================================
 
 	//= ROTATION =====================================================================================
 	void Transform::SetRotation(const Quaternion& rotation)
 	{
-		if (GetRotation() == rotation)
-			return;
-
 		SetRotationLocal(!HasParent() ? rotation : rotation * GetParent()->GetRotation().Inverse());
 	}
 
@@ -143,16 +143,13 @@ namespace Spartan
 			return;
 
 		m_rotationLocal = rotation;
-		UpdateTransform();
+		MarkDirty();
 	}
 	//================================================================================================
 
 	//= SCALE ========================================================================================
 	void Transform::SetScale(const Vector3& scale)
 	{
-		if (GetScale() == scale)
-			return;
-
 		SetScaleLocal(!HasParent() ? scale : scale / GetParent()->GetScale());
 	}
 
@@ -168,7 +165,7 @@ namespace Spartan
 		m_scaleLocal.y = (m_scaleLocal.y == 0.0f) ? Helper::M_EPSILON : m_scaleLocal.y;
 		m_scaleLocal.z = (m_scaleLocal.z == 0.0f) ? Helper::M_EPSILON : m_scaleLocal.z;
 
-		UpdateTransform();
+		MarkDirty();
 	}
 	//================================================================================================
 
@@ -287,7 +284,8 @@ namespace Spartan
 			m_parent->AcquireChildren();
 		}
 
-		UpdateTransform();
+		MarkDirty();
+		GetContext()->GetSubsystem<World>()->MakeHierarchyDirty();
 	}
 
 	void Transform::AddChild(Transform* child)
@@ -301,6 +299,16 @@ namespace Spartan
 		child->SetParent(this);
 	}
 
+	void Transform::AppendChild(Transform* child)
+	{
+		if (!child || child == this)
+			return;
+
+		child->m_parent = this;
+		m_children.emplace_back(child);
+		child->MarkDirty();
+	}
+
 	// Returns a child with the given index
 	Transform* Transform::GetChildByIndex(const uint32_t index)
 	{
@@ -338,18 +346,12 @@ namespace Spartan
 		m_children.clear();
 		m_children.shrink_to_fit();
 
-		auto entities = GetContext()->GetSubsystem<World>()->EntityGetAll();
-		for (const auto& entity : entities)
+		// every transform in the world is a possible child
+		GetContext()->GetSubsystem<World>()->ComponentForEach<Transform>([this](Transform* possible_child)
 		{
-			if (!entity)
-				continue;
-
-			// get the possible child
-			auto possible_child = entity->GetTransform();
-
 			// if it doesn't have a parent, forget about it.
 			if (!possible_child->HasParent())
-				continue;
+				return;
 
 			// if it's parent matches this transform
 			if (possible_child->GetParent()->GetId() == GetId())
@@ -360,7 +362,7 @@ namespace Spartan
 				// make the child do the same thing all over, essentially resolving the entire hierarchy.
 				possible_child->AcquireChildren();
 			}
-		}
+		});
 	}
 
 	bool Transform::IsDescendantOf(const Transform* transform) const
@@ -412,7 +414,7 @@ namespace Spartan
 		m_parent = nullptr;
 
 		// Update the transform without the parent now
-		UpdateTransform();
+		MarkDirty();
 
 		// make the parent search for children,
 		// that's indirect way of making the parent "forget"
@@ -421,5 +423,7 @@ namespace Spartan
 		{
 			temp_ref->AcquireChildren();
 		}
+
+		GetContext()->GetSubsystem<World>()->MakeHierarchyDirty();
 	}
 }
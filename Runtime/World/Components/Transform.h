@@ -46,24 +46,32 @@ namespace Spartan
 		void Deserialize(FileStream* stream) override;
 		//============================================
 
-		void UpdateTransform();
+		// Setters only mark the transform (and its descendants) as dirty, the matrices are recomputed
+		// when they are read, or by the World's batched update at the end of its tick, whichever comes first.
+		void UpdateTransform() const;
+		void MarkDirty();
+		bool IsDirty() const { return m_is_dirty; }
+
+		// Whether the transform has been marked dirty since this was last called, whoever caches anything derived
+		// from the matrix (the World's spatial index) uses this, as the matrix can be resolved before it gets to look.
+		bool ConsumeMoved() { const bool moved = m_moved; m_moved = false; return moved; }
 
 		//= POSITION ==============================================================
-		auto GetPosition()              const { return m_matrix.GetTranslation(); }
+		auto GetPosition()              const { return GetMatrix().GetTranslation(); }
 		const auto& GetPositionLocal()  const { return m_positionLocal; }
 		void SetPosition(const Math::Vector3& position);
 		void SetPositionLocal(const Math::Vector3& position);
 		//=========================================================================
 
 		//= ROTATION ===========================================================
-		Math::Quaternion GetRotation() const { return m_matrix.GetRotation(); }
+		Math::Quaternion GetRotation() const { return GetMatrix().GetRotation(); }
 		const auto& GetRotationLocal() const { return m_rotationLocal; }
 		void SetRotation(const Math::Quaternion& rotation);
 		void SetRotationLocal(const Math::Quaternion& rotation);
 		//======================================================================
 
 		//= SCALE =======================================================
-		auto GetScale()             const { return m_matrix.GetScale(); }
+		auto GetScale()             const { return GetMatrix().GetScale(); }
 		const auto& GetScaleLocal() const { return m_scaleLocal; }
 		void SetScale(const Math::Vector3& scale);
 		void SetScaleLocal(const Math::Vector3& scale);
@@ -91,6 +99,8 @@ namespace Spartan
 		bool HasChildren() const			{ return GetChildrenCount() > 0 ? true : false; }
 		uint32_t GetChildrenCount() const	{ return static_cast<uint32_t>(m_children.size()); }
 		void AddChild(Transform* child);
+		// Links an orphan child without re-acquiring the parent's children, for loaders which attach every child once, in order
+		void AppendChild(Transform* child);
 		Transform* GetRoot()			{ return HasParent() ? GetParent()->GetRoot() : this; }
 		Transform* GetParent() const	{ return m_parent; }
 		Transform* GetChildByIndex(uint32_t index);
@@ -103,10 +113,8 @@ namespace Spartan
 		//======================================================================================
 
 		void LookAt(const Math::Vector3& v)                       { m_lookAt = v; }
-		const Math::Matrix& GetMatrix()                     const { return m_matrix; }     
-		const Math::Matrix& GetLocalMatrix()                const { return m_matrixLocal; }
-        const Math::Matrix& GetWvpLastFrame()               const { return m_wvp_previous; }
-        void SetWvpLastFrame(const Math::Matrix& matrix)          { m_wvp_previous = matrix;}
+		const Math::Matrix& GetMatrix()                     const { if (m_is_dirty) UpdateTransform(); return m_matrix; }
+		const Math::Matrix& GetLocalMatrix()                const { if (m_is_dirty) UpdateTransform(); return m_matrixLocal; }
 
 	private:
 		Math::Matrix GetParentTransformMatrix() const;
@@ -116,13 +124,14 @@ namespace Spartan
 		Math::Quaternion m_rotationLocal;
 		Math::Vector3 m_scaleLocal;
 
-		Math::Matrix m_matrix;
-		Math::Matrix m_matrixLocal;
+		// Resolved lazily
+		mutable Math::Matrix m_matrix;
+		mutable Math::Matrix m_matrixLocal;
+		mutable bool m_is_dirty = true;
+		bool m_moved = true;
 		Math::Vector3 m_lookAt;
 
 		Transform* m_parent; // the parent of this transform
 		std::vector<Transform*> m_children; // the children of this transform
-
-		Math::Matrix m_wvp_previous;
 	};
 }
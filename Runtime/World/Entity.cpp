@@ -56,13 +56,22 @@ namespace Spartan
 
     Entity::~Entity()
 	{
+        // Entities leave the world's pools when they are removed from it, this catches any which weren't
+        for (const auto& component : m_components)
+        {
+            if (component->GetHandle().IsValid())
+            {
+                OnComponentRemoved(component.get());
+            }
+        }
+
         m_is_active             = false;
         m_hierarchy_visibility  = false;
         m_transform             = nullptr;
         m_renderable            = nullptr;
         m_context               = nullptr;
         m_name.clear();
-        m_component_mask = 0;
+        m_components_by_type.fill(nullptr);
 		for (auto it = m_components.begin(); it != m_components.end();)
 		{
 			(*it)->OnRemove();
@@ -72,6 +81,46 @@ namespace Spartan
 		m_components.clear();
 	}
 
+    void Entity::SetName(const string& name)
+    {
+        if (m_name == name)
+            return;
+
+        const string name_previous = m_name;
+        m_name = name;
+
+        if (World* world = m_context->GetSubsystem<World>())
+        {
+            world->EntityNameChanged(this, name_previous);
+        }
+    }
+
+    void Entity::SetId(const uint32_t id)
+    {
+        if (m_id == id)
+            return;
+
+        const uint32_t id_previous = m_id;
+        Spartan_Object::SetId(id);
+
+        World* world = m_context->GetSubsystem<World>();
+        if (world && !world->EntityIdChanged(this, id_previous))
+        {
+            m_id = id_previous;
+        }
+    }
+
+    void Entity::SetActive(const bool active)
+    {
+        if (m_is_active == active)
+            return;
+
+        m_is_active = active;
+
+        // Make the scene resolve
+        FIRE_EVENT_DATA(EventType::WorldResolve, this);
+    }
+
 	void Entity::Clone()
 	{
 		auto scene = m_context->GetSubsystem<World>();
@@ -139,18 +188,6 @@ namespace Spartan
 		}
 	}
 
-	void Entity::Tick(float delta_time)
-	{
-		if (!m_is_active)
-			return;
-
-		// call component Update()
-		for (const auto& component : m_components)
-		{
-			component->OnTick(delta_time);
-		}
-	}
-
 	void Entity::Serialize(FileStream* stream)
 	{
         // BASIC DATA
@@ -211,8 +248,8 @@ namespace Spartan
         {
             stream->Read(&m_is_active);
             stream->Read(&m_hierarchy_visibility);
-            stream->Read(&m_id);
-            stream->Read(&m_name);
+            SetId(stream->ReadAs<uint32_t>());
+            SetName(stream->ReadAs<string>());
         }
 
         // COMPONENTS
@@ -242,6 +279,11 @@ namespace Spartan
             {
                 m_transform->SetParent(parent);
             }
+
+            for (const auto& component : m_components)
+            {
+                component->OnDeserialized();
+            }
         }
 
         // CHILDREN
@@ -272,7 +314,7 @@ namespace Spartan
         }
 
 		// Make the scene resolve
-		FIRE_EVENT(EventType::WorldResolve);
+		FIRE_EVENT_DATA(EventType::WorldResolve, this);
 	}
 
     IComponent* Entity::AddComponent(const ComponentType type, uint32_t id /*= 0*/)
@@ -304,16 +346,14 @@ namespace Spartan
 
     void Entity::RemoveComponentById(const uint32_t id)
 	{
-        ComponentType component_type = ComponentType::Unknown;
-
 		for (auto it = m_components.begin(); it != m_components.end(); ) 
 		{
 			auto component = *it;
 			if (id == component->GetId())
 			{
-                component_type = component->GetType();
 				component->OnRemove();
-				it = m_components.erase(it);    
+				it = m_components.erase(it);
+                OnComponentRemoved(component.get());
                 break;
 			}
 			else
@@ -322,20 +362,43 @@ namespace Spartan
 			}
 		}
 
-        // The script component can have multiple instance, so only remove
-        // it's flag if there are no more components of that type left
-        bool others_of_same_type_exist = false;
-        for (auto it = m_components.begin(); it != m_components.end(); ++it)
+		// Make the scene resolve
+		FIRE_EVENT_DATA(EventType::WorldResolve, this);
+	}
+
+    void Entity::OnComponentAdded(IComponent* component)
+    {
+        if (World* world = m_context->GetSubsystem<World>())
+        {
+            world->ComponentAdd(component);
+        }
+    }
+
+    void Entity::OnComponentRemoved(IComponent* component)
+    {
+        if (World* world = m_context->GetSubsystem<World>())
         {
-            others_of_same_type_exist = ((*it)->GetType() == component_type) ? true : others_of_same_type_exist;
+            world->ComponentRemove(component);
         }
 
-        if (!others_of_same_type_exist)
+        // The script component can have multiple instances, so the next one (if any) takes its place
+        const ComponentType type = component->GetType();
+        IComponent*& component_by_type = m_components_by_type[static_cast<uint32_t>(type)];
+        if (component_by_type == component)
         {
-            m_component_mask &= ~GetComponentMask(component_type);
+            component_by_type = nullptr;
+            for (const auto& other : m_components)
+            {
+                if (other->GetType() == type)
+                {
+                    component_by_type = other.get();
+                    break;
+                }
+            }
         }
 
-		// Make the scene resolve
-		FIRE_EVENT(EventType::WorldResolve);
-	}
+        // Don't leave the cached components dangling
+        if (component == m_transform)  { m_transform   = nullptr; }
+        if (component == m_renderable) { m_renderable  = nullptr; }
+    }
 }
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES =====================
 #include <vector>
+#include <array>
 #include "../Core/EventSystem.h"
 #include "Components/IComponent.h"
 //================================
@@ -42,16 +43,18 @@ namespace Spartan
 		void Clone();
 		void Start();
 		void Stop();
-		void Tick(float delta_time);
 		void Serialize(FileStream* stream);
 		void Deserialize(FileStream* stream, Transform* parent);
 
 		//= PROPERTIES ===================================================================================================
 		const std::string& GetName() const								{ return m_name; }
-		void SetName(const std::string& name)							{ m_name = name; }
+		void SetName(const std::string& name);
+
+        // Keeps the world's index up to date, an id which another entity of the world has is rejected
+        void SetId(uint32_t id) override;
 
 		bool IsActive() const											{ return m_is_active; }
-		void SetActive(const bool active)								{ m_is_active = active; }
+		void SetActive(const bool active);
 
 		bool IsVisibleInHierarchy() const								{ return m_hierarchy_visibility; }
 		void SetHierarchyVisibility(const bool hierarchy_visibility)	{ m_hierarchy_visibility = hierarchy_visibility; }
@@ -70,9 +73,12 @@ namespace Spartan
             // Create a new component
             std::shared_ptr<T> component = std::make_shared<T>(m_context, this, id);
 
-            // Save new component
+            // Save new component (scripts can exist multiple times, the first one is what GetComponent returns)
             m_components.emplace_back(std::static_pointer_cast<IComponent>(component));
-            m_component_mask |= GetComponentMask(type);
+            if (!HasComponent(type))
+            {
+                m_components_by_type[static_cast<uint32_t>(type)] = component.get();
+            }
 
             // Caching of rendering performance critical components
             if constexpr (std::is_same<T, Transform>::value)    { m_transform   = static_cast<Transform*>(component.get()); }
@@ -82,8 +88,11 @@ namespace Spartan
             component->SetType(type);
             component->OnInitialize();
 
+            // Add it to the world's pool
+            OnComponentAdded(component.get());
+
 			// Make the scene resolve
-			FIRE_EVENT(EventType::WorldResolve);
+			FIRE_EVENT_DATA(EventType::WorldResolve, this);
 
             return component.get();
 		}
@@ -95,18 +104,7 @@ namespace Spartan
 		template <class T>
         T* GetComponent()
 		{
-            const ComponentType type = IComponent::TypeToEnum<T>();
-
-            if (!HasComponent(type))
-                return nullptr;
-
-			for (const auto& component : m_components)
-			{
-				if (component->GetType() == type)
-					return static_cast<T*>(component.get());
-			}
-
-			return nullptr;
+            return static_cast<T*>(m_components_by_type[static_cast<uint32_t>(IComponent::TypeToEnum<T>())]);
 		}
 
 		// Returns any components of type T (if they exist)
@@ -131,7 +129,7 @@ namespace Spartan
 		}
 		
 		// Checks if a component exists
-        constexpr bool HasComponent(const ComponentType type) { return m_component_mask & GetComponentMask(type); }
+        bool HasComponent(const ComponentType type) const { return type != ComponentType::Unknown && m_components_by_type[static_cast<uint32_t>(type)] != nullptr; }
 
 		// Checks if a component exists
 		template <class T>
@@ -150,7 +148,7 @@ namespace Spartan
 				{
 					component->OnRemove();
 					it = m_components.erase(it);
-                    m_component_mask &= ~GetComponentMask(type);
+                    OnComponentRemoved(component.get());
 				}
 				else
 				{
@@ -159,7 +157,7 @@ namespace Spartan
 			}
 
 			// Make the scene resolve
-			FIRE_EVENT(Event_World_Resolve_Pending);
+			FIRE_EVENT_DATA(EventType::WorldResolve, this);
 		}
 
 		void RemoveComponentById(uint32_t id);
@@ -174,7 +172,8 @@ namespace Spartan
 		std::shared_ptr<Entity> GetPtrShared()  { return shared_from_this(); }
 
 	private:
-        constexpr uint32_t GetComponentMask(ComponentType type) { return static_cast<uint32_t>(1) << static_cast<uint32_t>(type); }
+        void OnComponentAdded(IComponent* component);
+        void OnComponentRemoved(IComponent* component);
 
 		std::string m_name			= "Entity";
 		bool m_is_active			= true;
@@ -185,6 +184,6 @@ namespace Spartan
 		
         // Components
         std::vector<std::shared_ptr<IComponent>> m_components;
-        uint32_t m_component_mask = 0;
+        std::array<IComponent*, m_component_type_count> m_components_by_type = {}; // what GetComponent returns, per type
 	};
 }
@@ -28,12 +28,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Components/Light.h"
 #include "Components/Environment.h"
 #include "Components/AudioListener.h"
+#include "Components/AudioSource.h"
+#include "Components/Renderable.h"
+#include "Components/RigidBody.h"
+#include "Components/SoftBody.h"
+#include "Components/Constraint.h"
+#include "Components/Script.h"
 #include "../Resource/ResourceCache.h"
 #include "../Resource/ProgressReport.h"
 #include "../IO/FileStream.h"
 #include "../Profiling/Profiler.h"
 #include "../Rendering/Renderer.h"
 #include "../Input/Input.h"
+#include "../Threading/Threading.h"
+#include "../Physics/Physics.h"
 #include "../RHI/RHI_Device.h"
 //=====================================
 
@@ -44,12 +52,134 @@ using namespace Spartan::Math;
 
 namespace Spartan
 {
+    // World files are a header (magic, version, chunk count), a chunk table and the chunks it points to.
+    // Chunks are aligned and the entity and component tables are fixed size little endian records,
+    // so a mapped file can be read in place and any component type can be located without parsing the rest.
+    static const uint32_t world_file_magic                  = 0x44575053; // "SPWD"
+    static const uint32_t world_file_version                = 1;
+    static const uint32_t world_file_alignment              = 16;
+    static const uint32_t world_file_index_none             = 0xFFFFFFFF;
+    static const uint32_t world_file_parallel_grain_size    = 512;
+
+    enum World_File_Chunk_Type : uint32_t
+    {
+        World_Chunk_Names,          // entity names, each stored once
+        World_Chunk_Entities,       // a World_File_Entity per entity, parents before children
+        World_Chunk_Components,     // a World_File_Component per component, in the order of the entities which own them
+        World_Chunk_Component_Data  // + ComponentType, the offsets of the serialized components followed by the components
+    };
+
+    struct World_File_Chunk
+    {
+        uint32_t type   = 0;
+        uint32_t count  = 0;
+        uint64_t offset = 0; // from the start of the file
+        uint64_t size   = 0;
+    };
+
+    struct World_File_Entity
+    {
+        uint32_t id                         = 0;
+        uint32_t name_index                 = 0;
+        uint32_t parent_index               = world_file_index_none; // index in the entity chunk
+        uint32_t component_count            = 0;
+        uint8_t is_active                   = 0;
+        uint8_t is_visible_in_hierarchy     = 0;
+        uint16_t padding                    = 0;
+    };
+
+    struct World_File_Component
+    {
+        uint32_t type   = 0;
+        uint32_t id     = 0;
+    };
+
+    // Components are applied (see IComponent::OnDeserialized) one type at a time, in an order which respects their dependencies (e.g. colliders need rigid bodies)
+    static const array<ComponentType, m_component_type_count> world_file_component_load_order =
+    {
+        ComponentType::Transform,
+        ComponentType::AudioListener,
+        ComponentType::AudioSource,
+        ComponentType::Camera,
+        ComponentType::Environment,
+        ComponentType::Light,
+        ComponentType::Renderable,
+        ComponentType::Terrain,
+        ComponentType::Script,
+        ComponentType::RigidBody,
+        ComponentType::Collider,
+        ComponentType::SoftBody,
+        ComponentType::Constraint
+    };
+
+    static void world_file_write(FileStream* file, const World_File_Chunk& chunk)
+    {
+        file->Write(chunk.type);
+        file->Write(chunk.count);
+        file->Write(chunk.offset);
+        file->Write(chunk.size);
+    }
+
+    static void world_file_write(FileStream* file, const World_File_Entity& entity)
+    {
+        file->Write(entity.id);
+        file->Write(entity.name_index);
+        file->Write(entity.parent_index);
+        file->Write(entity.component_count);
+        file->Write(entity.is_active);
+        file->Write(entity.is_visible_in_hierarchy);
+        file->Write(entity.padding);
+    }
+
+    static void world_file_write(FileStream* file, const World_File_Component& component)
+    {
+        file->Write(component.type);
+        file->Write(component.id);
+    }
+
+    static void world_file_read(FileStream* file, World_File_Chunk* chunk)
+    {
+        file->Read(&chunk->type);
+        file->Read(&chunk->count);
+        file->Read(&chunk->offset);
+        file->Read(&chunk->size);
+    }
+
+    static void world_file_read(FileStream* file, World_File_Entity* entity)
+    {
+        file->Read(&entity->id);
+        file->Read(&entity->name_index);
+        file->Read(&entity->parent_index);
+        file->Read(&entity->component_count);
+        file->Read(&entity->is_active);
+        file->Read(&entity->is_visible_in_hierarchy);
+        file->Read(&entity->padding);
+    }
+
+    static void world_file_read(FileStream* file, World_File_Component* component)
+    {
+        file->Read(&component->type);
+        file->Read(&component->id);
+    }
+
 	World::World(Context* context) : ISubsystem(context)
 	{
+        // Ticks components (scripts, rigid bodies, audio sources etc.) and resolves the entities for the renderer.
+        // What it shares with the other subsystems doesn't make them wait: the rigid bodies touch the physics under the physics lock, the audio
+        // gets a copy of the listener's pose (FMOD is thread safe) and the renderer guards the entities it acquires. It reads the renderer's camera and options.
+        SetTickDependencies(
+            Tick_Dependency_Time | Tick_Dependency_Input | Tick_Dependency_Profiling | Tick_Dependency_Rendering,
+            Tick_Dependency_Entities | Tick_Dependency_Scripts,
+            true
+        );
+
 		// Subscribe to events
-		SUBSCRIBE_TO_EVENT(EventType::WorldResolve, [this](Variant) { m_is_dirty = true; });
-		SUBSCRIBE_TO_EVENT(EventType::WorldStop,    [this](Variant)	{ m_state = WorldState::Idle; });
-		SUBSCRIBE_TO_EVENT(EventType::WorldStart,   [this](Variant)	{ m_state = WorldState::Ticking; });
+		SUBSCRIBE_TO_EVENT(EventType::WorldResolve, EVENT_HANDLER_VARIANT(EntityChanged));
+		SUBSCRIBE_TO_EVENT(EventType::WorldStop,    [this](Variant)	{ lock_guard<mutex> lock(m_state_mutex); m_state = WorldState::Idle; });
+		SUBSCRIBE_TO_EVENT(EventType::WorldStart,   [this](Variant)	{ lock_guard<mutex> lock(m_state_mutex); m_state = WorldState::Ticking; });
+
+        // Registered before the world, loading reads the components on it (which doesn't need the world to be initialized)
+        m_threading = m_context->GetSubsystem<Threading>();
 	}
 
 	World::~World()
@@ -57,12 +187,15 @@ namespace Spartan
 		Unload();
         m_input     = nullptr;
         m_profiler  = nullptr;
+        m_threading = nullptr;
+        m_physics   = nullptr;
 	}
 
 	bool World::Initialize()
 	{
 		m_input		= m_context->GetSubsystem<Input>();
 		m_profiler	= m_context->GetSubsystem<Profiler>();
+		m_physics	= m_context->GetSubsystem<Physics>();
 
 		CreateCamera();
 		CreateEnvironment();
@@ -73,17 +206,23 @@ namespace Spartan
 
 	void World::Tick(float delta_time)
 	{	
-		if (m_state == WorldState::RequestLoading)
 		{
-			m_state = WorldState::Loading;
-			return;
-		}
+			lock_guard<mutex> lock(m_state_mutex);
+			if (m_state != WorldState::Ticking)
+				return;
 
-		if (m_state != WorldState::Ticking)
-			return;
+			m_is_ticking = true;
+		}
 
         SCOPED_TIME_BLOCK(m_profiler);
 
+        // The components touch the physics bodies when they tick or go away, the rest of the tick runs alongside the simulation
+        unique_lock<mutex> lock_physics;
+        if (m_physics)
+        {
+            lock_physics = unique_lock<mutex>(m_physics->GetMutex());
+        }
+
         // Tick entities
 		{
             // Detect game toggling
@@ -109,11 +248,24 @@ namespace Spartan
                 }
             }
 
-            // Tick
-            for (const auto& entity : m_entities)
+            // Tick, a type at a time, walking the type's pool instead of every entity's components. Scripts go first so that
+            // the bodies pick up what they moved, then the physics, and the audio once everything has moved.
+            const auto tick = [delta_time](IComponent* component)
             {
-                entity->Tick(delta_time);
-            }
+                if (component->GetEntity()->IsActive())
+                {
+                    component->OnTick(delta_time);
+                }
+            };
+            ComponentForEach<Script>(tick);
+            ComponentForEach<RigidBody>(tick);
+            ComponentForEach<SoftBody>(tick);
+            ComponentForEach<Constraint>(tick);
+            ComponentForEach<Camera>(tick);
+            ComponentForEach<Light>(tick);
+            ComponentForEach<Environment>(tick);
+            ComponentForEach<AudioListener>(tick);
+            ComponentForEach<AudioSource>(tick);
 		}
 
         if (m_is_dirty)
@@ -131,11 +283,29 @@ namespace Spartan
                     }
                 }
             }
+        }
+
+        if (lock_physics)
+        {
+            lock_physics.unlock();
+        }
 
+        TransformsUpdate();
+        SpatialIndexUpdate();
+
+        if (m_is_dirty)
+        {
             // Notify Renderer
-            FIRE_EVENT_DATA(EventType::WorldResolved, m_entities);
+            FIRE_EVENT_DATA(EventType::WorldResolved, m_entities_changed);
+            m_entities_changed.clear();
             m_is_dirty = false;
         }
+
+        {
+            lock_guard<mutex> lock(m_state_mutex);
+            m_is_ticking = false;
+        }
+        m_state_condition.notify_all();
 	}
 
 	void World::Unload()
@@ -143,8 +313,27 @@ namespace Spartan
         // Notify any systems that the entities are about to be cleared
 		FIRE_EVENT(EventType::WorldUnload);
 
+        m_spatial_index.Clear();
+        m_spatial_proxies.clear();
+        m_transforms.clear();
+        m_transform_roots.clear();
+        m_transforms_moved.clear();
+        m_is_hierarchy_dirty = true;
+
+        // Other systems can keep the entities alive for a bit, but their components are no longer part of the world
+        for (const auto& entity : m_entities)
+        {
+            for (const auto& component : entity->GetAllComponents())
+            {
+                ComponentRemove(component.get());
+            }
+        }
+
         m_entities.clear();
         m_entities.shrink_to_fit();
+        m_entities_by_id.clear();
+        m_entities_by_name.clear();
+        m_entities_changed.clear();
 
 		m_is_dirty = true;
 	}
@@ -176,28 +365,167 @@ namespace Spartan
 			return false;
 		}
 
-		// Only save root entities as they will also save their descendants
-		auto root_actors = EntityGetRoots();
-		const auto root_entity_count = static_cast<uint32_t>(root_actors.size());
+		// Flatten the hierarchy so that every root is followed by its descendants (parents before children)
+		vector<Entity*> entities;
+		unordered_map<const Entity*, uint32_t> entity_indices;
+		{
+			vector<Transform*> descendants;
+			for (const auto& root : EntityGetRoots())
+			{
+				entities.emplace_back(root.get());
+
+				descendants.clear();
+				root->GetTransform()->GetDescendants(&descendants);
+				for (Transform* descendant : descendants)
+				{
+					entities.emplace_back(descendant->GetEntity());
+				}
+			}
+
+			entity_indices.reserve(entities.size());
+			for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
+			{
+				entity_indices[entities[i]] = i;
+			}
+		}
+
+		ProgressReport::Get().SetJobCount(g_progress_world, static_cast<uint32_t>(entities.size()));
 
-		ProgressReport::Get().SetJobCount(g_progress_world, root_entity_count);
+		// Names (they don't have to be unique, so they are stored once)
+		vector<string> names;
+		unordered_map<string, uint32_t> name_indices;
+		vector<World_File_Entity> entity_records(entities.size());
 
-		// Save root entity count
-		file->Write(root_entity_count);
+		// Components, grouped by type but in the same order as the entities which own them
+		vector<World_File_Component> component_records;
+		array<vector<IComponent*>, m_component_type_count> components;
 
-		// Save root entity IDs
-		for (const auto& root : root_actors)
+		for (uint32_t i = 0; i < static_cast<uint32_t>(entities.size()); i++)
 		{
-			file->Write(root->GetId());
+			Entity* entity = entities[i];
+			World_File_Entity& record = entity_records[i];
+
+			auto name_it = name_indices.find(entity->GetName());
+			if (name_it == name_indices.end())
+			{
+				name_it = name_indices.emplace(entity->GetName(), static_cast<uint32_t>(names.size())).first;
+				names.emplace_back(entity->GetName());
+			}
+
+			Transform* parent                   = entity->GetTransform()->GetParent();
+			record.id                           = entity->GetId();
+			record.name_index                   = name_it->second;
+			record.parent_index                 = parent ? entity_indices[parent->GetEntity()] : world_file_index_none;
+			record.component_count              = static_cast<uint32_t>(entity->GetAllComponents().size());
+			record.is_active                    = entity->IsActive() ? 1 : 0;
+			record.is_visible_in_hierarchy      = entity->IsVisibleInHierarchy() ? 1 : 0;
+
+			for (const auto& component : entity->GetAllComponents())
+			{
+				component_records.push_back({ static_cast<uint32_t>(component->GetType()), component->GetId() });
+				components[static_cast<uint32_t>(component->GetType())].emplace_back(component.get());
+			}
 		}
 
-		// Save root entities
-		for (const auto& root : root_actors)
+		// Header, the chunk table is written once the chunk offsets and sizes are known
+		vector<World_File_Chunk> chunks;
+		uint32_t chunk_count = 3;
+		for (const auto& components_type : components)
 		{
-			root->Serialize(file.get());
-			ProgressReport::Get().IncrementJobsDone(g_progress_world);
+			chunk_count += components_type.empty() ? 0 : 1;
 		}
 
+		file->Write(world_file_magic);
+		file->Write(world_file_version);
+		file->Write(chunk_count);
+		file->Write(uint32_t(0)); // padding
+		const uint64_t chunk_table_offset = file->GetPosition();
+		for (uint32_t i = 0; i < chunk_count; i++)
+		{
+			world_file_write(file.get(), World_File_Chunk());
+		}
+
+		const auto chunk_begin = [&file, &chunks](const uint32_t type, const uint32_t count)
+		{
+			while (file->GetPosition() % world_file_alignment != 0)
+			{
+				file->Write(uint8_t(0));
+			}
+
+			chunks.push_back({ type, count, file->GetPosition(), 0 });
+		};
+
+		const auto chunk_end = [&file, &chunks]()
+		{
+			chunks.back().size = file->GetPosition() - chunks.back().offset;
+		};
+
+		// Names
+		chunk_begin(World_Chunk_Names, static_cast<uint32_t>(names.size()));
+		for (const string& name : names)
+		{
+			file->Write(name);
+		}
+		chunk_end();
+
+		// Entities
+		chunk_begin(World_Chunk_Entities, static_cast<uint32_t>(entity_records.size()));
+		for (const World_File_Entity& record : entity_records)
+		{
+			world_file_write(file.get(), record);
+		}
+		chunk_end();
+
+		// Component types and ids, per entity
+		chunk_begin(World_Chunk_Components, static_cast<uint32_t>(component_records.size()));
+		for (const World_File_Component& record : component_records)
+		{
+			world_file_write(file.get(), record);
+		}
+		chunk_end();
+
+		// Component data, per type, a table with the offset of each component (from the start of the chunk) followed by the components
+		for (uint32_t type = 0; type < m_component_type_count; type++)
+		{
+			const vector<IComponent*>& components_type = components[type];
+			if (components_type.empty())
+				continue;
+
+			chunk_begin(World_Chunk_Component_Data + type, static_cast<uint32_t>(components_type.size()));
+			const uint64_t chunk_offset = chunks.back().offset;
+
+			vector<uint64_t> offsets(components_type.size(), 0);
+			for (const uint64_t offset : offsets)
+			{
+				file->Write(offset);
+			}
+
+			for (uint32_t i = 0; i < static_cast<uint32_t>(components_type.size()); i++)
+			{
+				offsets[i] = file->GetPosition() - chunk_offset;
+				components_type[i]->Serialize(file.get());
+			}
+
+			chunk_end();
+
+			const uint64_t position = file->GetPosition();
+			file->Seek(chunk_offset);
+			for (const uint64_t offset : offsets)
+			{
+				file->Write(offset);
+			}
+			file->Seek(position);
+		}
+
+		// Chunk table
+		file->Seek(chunk_table_offset);
+		for (const World_File_Chunk& chunk : chunks)
+		{
+			world_file_write(file.get(), chunk);
+		}
+
+		ProgressReport::Get().SetJobsDone(g_progress_world, static_cast<uint32_t>(entities.size()));
+
 		// Finish with progress report and timer
 		ProgressReport::Get().SetIsLoading(g_progress_world, false);
 		LOG_INFO("Saving took %.2f ms", timer.GetElapsedTimeMs());
@@ -216,12 +544,13 @@ namespace Spartan
 			return false;
 		}
 
-		// Thread safety: Wait for the world and the renderer to stop using entities
-		while (m_state != WorldState::Loading || m_context->GetSubsystem<Renderer>()->IsRendering())
-        {
-            m_state = WorldState::RequestLoading;
-            this_thread::sleep_for(chrono::milliseconds(16));
-        }
+		// Thread safety: Stop the world from ticking and wait for the tick in progress, if any, to stop using entities
+		// (the renderer's frame snapshot keeps the ones it records alive)
+		{
+			unique_lock<mutex> lock(m_state_mutex);
+			m_state = WorldState::Loading;
+			m_state_condition.wait(lock, [this] { return !m_is_ticking; });
+		}
 
 		// Start progress report and timing
 		ProgressReport::Get().Reset(g_progress_world);
@@ -235,13 +564,195 @@ namespace Spartan
 		// Read all the resource file paths
 		auto file = make_unique<FileStream>(file_path, FileStream_Read);
 		if (!file->IsOpen())
+		{
+			lock_guard<mutex> lock(m_state_mutex);
+			m_state = WorldState::Ticking;
+			ProgressReport::Get().SetIsLoading(g_progress_world, false);
 			return false;
+		}
 
 		m_name = FileSystem::GetFileNameNoExtensionFromFilePath(file_path);
 
 		// Notify subsystems that need to load data
 		FIRE_EVENT(EventType::WorldLoad);
 
+		// Every entity is created during loading (so it's already queued for the renderer), the events
+		// fired by each component and entity along the way would only queue it again, so they are ignored.
+		m_is_loading = true;
+
+		bool result = false;
+		if (file->ReadAs<uint32_t>() == world_file_magic)
+		{
+			result = LoadFromFileChunks(file.get(), file_path);
+		}
+		else
+		{
+			// Worlds saved before the chunked format, they start with the root entity count
+			file->Seek(0);
+			result = LoadFromFileHierarchy(file.get());
+		}
+
+		m_is_loading            = false;
+		m_is_dirty              = true;
+		m_is_hierarchy_dirty    = true;
+		{
+			lock_guard<mutex> lock(m_state_mutex);
+			m_state = WorldState::Ticking;
+		}
+		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
+		LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
+
+		FIRE_EVENT(EventType::WorldLoaded);
+		return result;
+	}
+
+	bool World::LoadFromFileChunks(FileStream* file, const string& file_path)
+	{
+		const auto version = file->ReadAs<uint32_t>();
+		if (version > world_file_version)
+		{
+			LOG_ERROR("%s has version %d, only versions up to %d are supported.", file_path.c_str(), version, world_file_version);
+			return false;
+		}
+
+		const auto chunk_count = file->ReadAs<uint32_t>();
+		file->Skip(sizeof(uint32_t)); // padding
+
+		vector<World_File_Chunk> chunks(chunk_count);
+		for (World_File_Chunk& chunk : chunks)
+		{
+			world_file_read(file, &chunk);
+		}
+
+		const auto chunk_get = [&chunks](const uint32_t type) -> const World_File_Chunk*
+		{
+			for (const World_File_Chunk& chunk : chunks)
+			{
+				if (chunk.type == type)
+					return &chunk;
+			}
+
+			return nullptr;
+		};
+
+		const World_File_Chunk* chunk_names         = chunk_get(World_Chunk_Names);
+		const World_File_Chunk* chunk_entities      = chunk_get(World_Chunk_Entities);
+		const World_File_Chunk* chunk_components    = chunk_get(World_Chunk_Components);
+		if (!chunk_names || !chunk_entities || !chunk_components)
+		{
+			LOG_ERROR("%s is missing required chunks.", file_path.c_str());
+			return false;
+		}
+
+		ProgressReport::Get().SetJobCount(g_progress_world, chunk_entities->count);
+
+		// Names
+		vector<string> names(chunk_names->count);
+		file->Seek(chunk_names->offset);
+		for (string& name : names)
+		{
+			file->Read(&name);
+		}
+
+		// Entities
+		vector<World_File_Entity> entity_records(chunk_entities->count);
+		file->Seek(chunk_entities->offset);
+		for (World_File_Entity& record : entity_records)
+		{
+			world_file_read(file, &record);
+		}
+
+		// The component data is read last, have it paged in while the entities and components are created
+		for (const World_File_Chunk& chunk : chunks)
+		{
+			if (chunk.type >= World_Chunk_Component_Data)
+			{
+				file->Prefetch(chunk.offset, chunk.size);
+			}
+		}
+
+		// Create the entities and their components, all components exist before any of them is deserialized, as some depend on others
+		array<vector<IComponent*>, m_component_type_count> components;
+		file->Seek(chunk_components->offset);
+		for (const World_File_Entity& record : entity_records)
+		{
+			auto& entity = EntityCreate(record.is_active != 0);
+			entity->SetId(record.id);
+			entity->SetName(record.name_index < names.size() ? names[record.name_index] : string());
+			entity->SetHierarchyVisibility(record.is_visible_in_hierarchy != 0);
+
+			for (uint32_t i = 0; i < record.component_count; i++)
+			{
+				World_File_Component component_record;
+				world_file_read(file, &component_record);
+
+				if (component_record.type >= m_component_type_count)
+					continue;
+
+				if (IComponent* component = entity->AddComponent(static_cast<ComponentType>(component_record.type), component_record.id))
+				{
+					// The transform is created with the entity, so it doesn't get the saved id
+					component->SetId(component_record.id);
+					components[component_record.type].emplace_back(component);
+				}
+			}
+
+			ProgressReport::Get().IncrementJobsDone(g_progress_world);
+		}
+
+		// Read the components, reading only touches the component itself so every type's chunk is read in parallel.
+		// Each range reads the same mapping at its own offset, the ranges of all the types are in flight together.
+		TaskCounter counter;
+		for (const ComponentType type : world_file_component_load_order)
+		{
+			const vector<IComponent*>& components_type = components[static_cast<uint32_t>(type)];
+			const World_File_Chunk* chunk = chunk_get(World_Chunk_Component_Data + static_cast<uint32_t>(type));
+
+			if (chunk && chunk->count == components_type.size())
+			{
+				m_threading->ParallelFor(chunk->count, world_file_parallel_grain_size, [file, &components_type, chunk](uint32_t start, uint32_t end)
+				{
+					FileStream stream(*file, chunk->offset + sizeof(uint64_t) * start);
+					stream.Seek(chunk->offset + stream.ReadAs<uint64_t>());
+
+					for (uint32_t i = start; i < end; i++)
+					{
+						components_type[i]->Deserialize(&stream);
+					}
+				}, &counter);
+			}
+			else if (!components_type.empty())
+			{
+				LOG_ERROR("%s has no data for %d components of type %d.", file_path.c_str(), static_cast<uint32_t>(components_type.size()), static_cast<uint32_t>(type));
+			}
+		}
+		m_threading->Wait(counter);
+
+		// Link the hierarchy, the rest of the components (e.g. rigid bodies) can then rely on world transforms.
+		// Parents come before their children, so each child is appended once and in the order it was saved.
+		for (uint32_t i = 0; i < static_cast<uint32_t>(entity_records.size()); i++)
+		{
+			const uint32_t parent_index = entity_records[i].parent_index;
+			if (parent_index < i)
+			{
+				m_entities[parent_index]->GetTransform()->AppendChild(m_entities[i]->GetTransform());
+			}
+		}
+
+		// Then apply them, one type at a time as some depend on others (e.g. colliders on rigid bodies)
+		for (const ComponentType type : world_file_component_load_order)
+		{
+			for (IComponent* component : components[static_cast<uint32_t>(type)])
+			{
+				component->OnDeserialized();
+			}
+		}
+
+		return true;
+	}
+
+	bool World::LoadFromFileHierarchy(FileStream* file)
+	{
 		// Load root entity count
         const auto root_entity_count = file->ReadAs<uint32_t>();
 
@@ -257,23 +768,21 @@ namespace Spartan
 		// Serialize root entities
 		for (uint32_t i = 0; i < root_entity_count; i++)
 		{
-			m_entities[i]->Deserialize(file.get(), nullptr);
+			m_entities[i]->Deserialize(file, nullptr);
 			ProgressReport::Get().IncrementJobsDone(g_progress_world);
 		}
 
-		m_is_dirty	= true;
-		m_state		= WorldState::Ticking;
-		ProgressReport::Get().SetIsLoading(g_progress_world, false);	
-		LOG_INFO("Loading took %.2f ms", timer.GetElapsedTimeMs());
-
-		FIRE_EVENT(EventType::WorldLoaded);
 		return true;
 	}
 
     shared_ptr<Entity>& World::EntityCreate(bool is_active /*= true*/)
     {
         auto& entity = m_entities.emplace_back(make_shared<Entity>(m_context));
+        EntityIndex(entity);
         entity->SetActive(is_active);
+        m_entities_changed.emplace_back(entity);
+        m_is_hierarchy_dirty = true;
+        m_is_dirty = true;
         return entity;
     }
 
@@ -284,6 +793,10 @@ namespace Spartan
 		if (!entity)
 			return empty;
 
+		EntityIndex(entity);
+		m_entities_changed.emplace_back(entity);
+		m_is_hierarchy_dirty = true;
+		m_is_dirty = true;
 		return m_entities.emplace_back(entity);
 	}
 
@@ -320,13 +833,12 @@ namespace Spartan
 		return root_entities;
 	}
 
+	// Names don't have to be unique, this returns any one of the entities with the name
 	const shared_ptr<Entity>& World::EntityGetByName(const string& name)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetName() == name)
-				return entity;
-		}
+		const auto it = m_entities_by_name.find(name);
+		if (it != m_entities_by_name.end() && !it->second.empty())
+			return it->second.front();
 
         static shared_ptr<Entity> empty;
 		return empty;
@@ -334,16 +846,119 @@ namespace Spartan
 
 	const shared_ptr<Entity>& World::EntityGetById(const uint32_t id)
 	{
-		for (const auto& entity : m_entities)
-		{
-			if (entity->GetId() == id)
-				return entity;
-		}
+		const auto it = m_entities_by_id.find(id);
+		if (it != m_entities_by_id.end())
+			return it->second;
 
         static shared_ptr<Entity> empty;
 		return empty;
 	}
 
+    bool World::EntityIdChanged(Entity* entity, const uint32_t id_previous)
+    {
+        // Only entities in the world are indexed
+        auto it = m_entities_by_id.find(id_previous);
+        if (it == m_entities_by_id.end() || it->second.get() != entity)
+            return true;
+
+        // Ids are unique, the entity which already has it keeps it
+        const auto it_taken = m_entities_by_id.find(entity->GetId());
+        if (it_taken != m_entities_by_id.end())
+        {
+            LOG_ERROR("Entity \"%s\" can't take the id %d, \"%s\" already has it", entity->GetName().c_str(), entity->GetId(), it_taken->second->GetName().c_str());
+            return false;
+        }
+
+        shared_ptr<Entity> entity_shared = move(it->second);
+        m_entities_by_id.erase(it);
+        m_entities_by_id[entity->GetId()] = move(entity_shared);
+        return true;
+    }
+
+    void World::EntityNameChanged(Entity* entity, const string& name_previous)
+    {
+        // Only entities in the world are indexed
+        auto it = m_entities_by_name.find(name_previous);
+        if (it == m_entities_by_name.end())
+            return;
+
+        vector<shared_ptr<Entity>>& entities = it->second;
+        for (auto it_entity = entities.begin(); it_entity != entities.end(); it_entity++)
+        {
+            if (it_entity->get() == entity)
+            {
+                m_entities_by_name[entity->GetName()].emplace_back(move(*it_entity));
+                entities.erase(it_entity);
+                break;
+            }
+        }
+
+        if (entities.empty())
+        {
+            m_entities_by_name.erase(name_previous);
+        }
+    }
+
+    void World::EntityIndex(const shared_ptr<Entity>& entity)
+    {
+        // An entity which comes with an id that's taken (e.g. a copy of one which is in the world) gets a new one
+        const auto it = m_entities_by_id.find(entity->GetId());
+        if (it != m_entities_by_id.end() && it->second != entity)
+        {
+            LOG_WARNING("Entity \"%s\" has the id %d of another entity, it's given a new one", entity->GetName().c_str(), entity->GetId());
+            entity->Spartan_Object::SetId(Spartan_Object::GenerateId());
+        }
+
+        m_entities_by_id[entity->GetId()] = entity;
+        m_entities_by_name[entity->GetName()].emplace_back(entity);
+    }
+
+    void World::ComponentAdd(IComponent* component)
+    {
+        if (!component || component->GetType() == ComponentType::Unknown || component->GetHandle().IsValid())
+            return;
+
+        component->SetHandle(m_component_pools[static_cast<uint32_t>(component->GetType())].Add(component));
+    }
+
+    void World::ComponentRemove(IComponent* component)
+    {
+        if (!component || !component->GetHandle().IsValid())
+            return;
+
+        m_component_pools[static_cast<uint32_t>(component->GetType())].Remove(component->GetHandle());
+        component->SetHandle(ComponentHandle());
+
+        // Renderables are in the spatial index
+        if (component->GetType() == ComponentType::Renderable)
+        {
+            const auto it_proxy = m_spatial_proxies.find(component->GetEntity());
+            if (it_proxy != m_spatial_proxies.end())
+            {
+                m_spatial_index.Remove(it_proxy->second);
+                m_spatial_proxies.erase(it_proxy);
+            }
+        }
+    }
+
+    // Entities pass themselves along with the event when their components change, so only they are resolved again
+    void World::EntityChanged(const Variant& entity_variant)
+    {
+        m_is_dirty = true;
+
+        if (m_is_loading)
+            return;
+
+        if (Entity* const* entity = get_if<Entity*>(&entity_variant.GetVariantRaw()))
+        {
+            // Entities which the world doesn't own (yet) are resolved when they are added
+            if (shared_ptr<Entity> entity_shared = (*entity)->weak_from_this().lock())
+            {
+                m_entities_changed.emplace_back(move(entity_shared));
+            }
+        }
+    }
+
     // Removes an entity and all of it's children
     void World::_EntityRemove(const std::shared_ptr<Entity>& entity)
     {
@@ -357,6 +972,35 @@ namespace Spartan
         // Keep a reference to it's parent (in case it has one)
         auto parent = entity->GetTransform()->GetParent();
 
+        m_is_hierarchy_dirty = true;
+
+        // It's pending destruction, so the renderer will let go of it
+        m_entities_changed.emplace_back(entity);
+
+        // Remove its components from the pools (and the spatial index)
+        for (const auto& component : entity->GetAllComponents())
+        {
+            ComponentRemove(component.get());
+        }
+
+        // Remove it from the indices
+        const auto it_id = m_entities_by_id.find(entity->GetId());
+        if (it_id != m_entities_by_id.end() && it_id->second == entity)
+        {
+            m_entities_by_id.erase(it_id);
+        }
+
+        const auto it_name = m_entities_by_name.find(entity->GetName());
+        if (it_name != m_entities_by_name.end())
+        {
+            vector<shared_ptr<Entity>>& entities = it_name->second;
+            entities.erase(remove(entities.begin(), entities.end(), entity), entities.end());
+            if (entities.empty())
+            {
+                m_entities_by_name.erase(it_name);
+            }
+        }
+
         // Remove this entity
         for (auto it = m_entities.begin(); it < m_entities.end();)
         {
@@ -376,6 +1020,104 @@ namespace Spartan
         }
     }
 
+    // Resolves the world matrices of all the dirty transforms in one pass. The transforms are sorted so that a parent is
+    // always resolved before its children (so nothing recurses), and every root's hierarchy is an independent range of work.
+    void World::TransformsUpdate()
+    {
+        if (m_is_hierarchy_dirty)
+        {
+            m_transforms.clear();
+            m_transform_roots.clear();
+
+            for (const auto& entity : m_entities)
+            {
+                Transform* transform = entity->GetTransform();
+                if (!transform->IsRoot())
+                    continue;
+
+                m_transform_roots.emplace_back(static_cast<uint32_t>(m_transforms.size()));
+                m_transforms.emplace_back(transform);
+                transform->GetDescendants(&m_transforms);
+            }
+            m_transform_roots.emplace_back(static_cast<uint32_t>(m_transforms.size()));
+
+            m_is_hierarchy_dirty = false;
+        }
+
+        // The ones which moved are collected along the way, for whatever depends on them
+        m_transforms_moved.clear();
+        const uint32_t root_count = static_cast<uint32_t>(m_transform_roots.size()) - 1;
+        m_threading->ParallelFor(root_count, 0, [this](const uint32_t start, const uint32_t end)
+        {
+            vector<Transform*> moved;
+            for (uint32_t i = m_transform_roots[start]; i < m_transform_roots[end]; i++)
+            {
+                Transform* transform = m_transforms[i];
+                transform->UpdateTransform();
+                if (transform->ConsumeMoved())
+                {
+                    moved.emplace_back(transform);
+                }
+            }
+
+            if (!moved.empty())
+            {
+                lock_guard<mutex> lock(m_transforms_moved_mutex);
+                m_transforms_moved.insert(m_transforms_moved.end(), moved.begin(), moved.end());
+            }
+        });
+    }
+
+    // Keeps the spatial index in sync with the renderables, without looking at the ones which didn't change. Entities which
+    // were added, (de)activated, or had their components or geometry changed since the last tick are re-evaluated, and the
+    // proxies of the entities which moved are updated. Moving within the margin of a proxy only stores the new box.
+    // Removed renderables leave the index when they leave their pool, see ComponentRemove().
+    void World::SpatialIndexUpdate()
+    {
+        for (const shared_ptr<Entity>& entity : m_entities_changed)
+        {
+            SpatialProxyUpdate(entity.get());
+        }
+
+        for (Transform* transform : m_transforms_moved)
+        {
+            const auto it_proxy = m_spatial_proxies.find(transform->GetEntity());
+            if (it_proxy != m_spatial_proxies.end())
+            {
+                m_spatial_index.Update(it_proxy->second, transform->GetEntity()->GetRenderable()->GetAabb());
+            }
+        }
+    }
+
+    void World::SpatialProxyUpdate(Entity* entity)
+    {
+        Renderable* renderable  = entity->GetRenderable();
+        const auto it_entity    = m_entities_by_id.find(entity->GetId());
+        const auto it_proxy     = m_spatial_proxies.find(entity);
+
+        // Not (or no longer) drawn
+        const bool in_world = it_entity != m_entities_by_id.end() && it_entity->second.get() == entity;
+        if (!in_world || !renderable || !entity->IsActive() || !renderable->GetBoundingBox().Defined())
+        {
+            if (it_proxy != m_spatial_proxies.end())
+            {
+                m_spatial_index.Remove(it_proxy->second);
+                m_spatial_proxies.erase(it_proxy);
+            }
+            return;
+        }
+
+        const BoundingBox& aabb = renderable->GetAabb();
+        if (it_proxy == m_spatial_proxies.end())
+        {
+            m_spatial_proxies[entity] = m_spatial_index.Insert(aabb, entity);
+        }
+        else
+        {
+            m_spatial_index.Update(it_proxy->second, aabb);
+        }
+    }
+
 	shared_ptr<Entity>& World::CreateEnvironment()
 	{
 		auto& environment = EntityCreate();
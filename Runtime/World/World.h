@@ -23,24 +23,34 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 //= INCLUDES ===========================
 #include <vector>
+#include <array>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
 #include "../Core/ISubsystem.h"
+#include "../Math/AabbTree.h"
+#include "Components/IComponent.h"
 #include "../Core/Spartan_Definitions.h"
 //======================================
 
 namespace Spartan
 {
 	class Entity;
+	class Transform;
 	class Light;
 	class Input;
 	class Profiler;
+	class Threading;
+	class Physics;
+	class Variant;
+	class FileStream;
 
 	enum class WorldState
 	{
 		Ticking,
 		Idle,
-		RequestLoading,
 		Loading
 	};
 
@@ -60,6 +70,7 @@ namespace Spartan
 		bool LoadFromFile(const std::string& file_path);
 		const auto& GetName() const { return m_name; }
         void MakeDirty() { m_is_dirty = true; }
+        void MakeHierarchyDirty() { m_is_hierarchy_dirty = true; }
 
 		//= Entities ===========================================================================
 		std::shared_ptr<Entity>& EntityCreate(bool is_active = true);
@@ -69,12 +80,56 @@ namespace Spartan
 		std::vector<std::shared_ptr<Entity>> EntityGetRoots();
 		const std::shared_ptr<Entity>& EntityGetByName(const std::string& name);
 		const std::shared_ptr<Entity>& EntityGetById(uint32_t id);
+        bool EntityIdChanged(Entity* entity, uint32_t id_previous);
+        void EntityNameChanged(Entity* entity, const std::string& name_previous);
 		const auto& EntityGetAll() const    { return m_entities; }
 		auto EntityGetCount() const         { return static_cast<uint32_t>(m_entities.size()); }
 		//======================================================================================
 
+		//= Components =========================================================================
+        void ComponentAdd(IComponent* component);
+        void ComponentRemove(IComponent* component);
+        const ComponentPool& ComponentGetPool(const ComponentType type) const { return m_component_pools[static_cast<uint32_t>(type)]; }
+
+        // Calls the function with every component of type T in the world, including the ones it adds along the way
+        template <class T, class Function>
+        void ComponentForEach(Function&& function) const
+        {
+            const std::vector<IComponent*>& components = ComponentGetPool(IComponent::TypeToEnum<T>()).GetAll();
+            for (size_t i = 0; i < components.size(); i++)
+            {
+                function(static_cast<T*>(components[i]));
+            }
+        }
+
+        // Calls the function with every component of type T whose entity also has a component of type U, e.g. every light with a transform
+        template <class T, class U, class Function>
+        void ComponentForEach(Function&& function) const
+        {
+            const std::vector<IComponent*>& components = ComponentGetPool(IComponent::TypeToEnum<T>()).GetAll();
+            for (size_t i = 0; i < components.size(); i++)
+            {
+                T* component_t = static_cast<T*>(components[i]);
+                if (U* component_u = component_t->GetEntity()->template GetComponent<U>())
+                {
+                    function(component_t, component_u);
+                }
+            }
+        }
+		//======================================================================================
+
+        // Bounding volume hierarchy of all active renderables, the user data is the Entity*
+        const Math::AabbTree& GetSpatialIndex() const { return m_spatial_index; }
+
 	private:
+        bool LoadFromFileChunks(FileStream* file, const std::string& file_path);
+        bool LoadFromFileHierarchy(FileStream* file);
         void _EntityRemove(const std::shared_ptr<Entity>& entity);
+        void EntityIndex(const std::shared_ptr<Entity>& entity);
+        void EntityChanged(const Variant& entity_variant);
+        void SpatialIndexUpdate();
+        void SpatialProxyUpdate(Entity* entity);
+        void TransformsUpdate();
 
 		//= COMMON ENTITY CREATION ========================
 		std::shared_ptr<Entity>& CreateEnvironment();
@@ -85,10 +140,29 @@ namespace Spartan
         std::string m_name;
         bool m_was_in_editor_mode   = false;
         bool m_is_dirty             = true;
+        bool m_is_loading           = false; // entity events are ignored while loading, every loaded entity is queued once when it's created
         WorldState m_state          = WorldState::Ticking;
+        bool m_is_ticking           = false; // loading waits for the tick in progress, through the condition
+        std::mutex m_state_mutex;
+        std::condition_variable m_state_condition;
         Input* m_input              = nullptr;
         Profiler* m_profiler        = nullptr;
+        Threading* m_threading      = nullptr;
+        Physics* m_physics          = nullptr;
 
         std::vector<std::shared_ptr<Entity>> m_entities;
+        std::unordered_map<uint32_t, std::shared_ptr<Entity>> m_entities_by_id;
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Entity>>> m_entities_by_name; // names don't have to be unique
+        std::vector<std::shared_ptr<Entity>> m_entities_changed; // added, removed or changed since the world last resolved, the renderer only gets these
+        Math::AabbTree m_spatial_index;
+        std::unordered_map<const Entity*, int32_t> m_spatial_proxies;
+        std::array<ComponentPool, m_component_type_count> m_component_pools; // indexed by ComponentType
+
+        // All the transforms, sorted so that every root is followed by its descendants (parents before children)
+        std::vector<Transform*> m_transforms;
+        std::vector<uint32_t> m_transform_roots; // where each root's range starts in m_transforms, followed by the end
+        std::vector<Transform*> m_transforms_moved; // by the last update, in no particular order
+        std::mutex m_transforms_moved_mutex;
+        bool m_is_hierarchy_dirty = true;
 	};
 }
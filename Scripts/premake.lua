@@ -20,10 +20,12 @@
 SOLUTION_NAME		= "Spartan"
 EDITOR_NAME			= "Editor"
 RUNTIME_NAME		= "Runtime"
+TESTS_NAME			= "Tests"
 TARGET_NAME			= "Spartan" -- Name of executable
 DEBUG_FORMAT		= "c7"
 EDITOR_DIR			= "../" .. EDITOR_NAME
 RUNTIME_DIR			= "../" .. RUNTIME_NAME
+TESTS_DIR			= "../" .. TESTS_NAME
 IGNORE_FILES		= {}
 LIBRARY_DIR			= "../ThirdParty/libraries"
 INTERMEDIATE_DIR	= "../Binaries/Intermediate"
@@ -186,4 +188,39 @@ project (EDITOR_NAME)
 	-- "Release"
 	filter "configurations:Release"
 		targetdir (TARGET_DIR_RELEASE)
-		debugdir (TARGET_DIR_RELEASE)
\ No newline at end of file
+		debugdir (TARGET_DIR_RELEASE)
+
+-- Tests ---------------------------------------------------------------------------------------------------
+project (TESTS_NAME)
+	location (TESTS_DIR)
+	links { RUNTIME_NAME }
+	dependson { RUNTIME_NAME }
+	targetname ( TESTS_NAME )
+	objdir (INTERMEDIATE_DIR)
+	kind "ConsoleApp"
+	staticruntime "On"
+	defines{ "SPARTAN_TESTS", API_GRAPHICS }
+	
+	-- Files
+	files 
+	{ 
+		TESTS_DIR .. "/**.h",
+		TESTS_DIR .. "/**.cpp"
+	}
+	
+	-- Includes
+	includedirs { "../" .. RUNTIME_NAME }
+	
+	-- Libraries
+	libdirs (LIBRARY_DIR)
+
+	-- "Debug"
+	filter "configurations:Debug"
+		targetdir (TARGET_DIR_DEBUG)	
+		debugdir (TARGET_DIR_DEBUG)
+		debugformat (DEBUG_FORMAT)		
+				
+	-- "Release"
+	filter "configurations:Release"
+		targetdir (TARGET_DIR_RELEASE)
+		debugdir (TARGET_DIR_RELEASE)
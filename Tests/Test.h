@@ -0,0 +1,115 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+//= INCLUDES =====================
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include "Core/Context.h"
+#include "Core/Stopwatch.h"
+#include "Threading/Threading.h"
+//=================================
+
+namespace Spartan::Tests
+{
+    // A test (or a benchmark), registered by the macros below before main() runs
+    struct Test
+    {
+        const char* name    = nullptr;
+        void (*function)()  = nullptr;
+        bool benchmark      = false;
+    };
+
+    inline std::vector<Test>& GetTests()
+    {
+        static std::vector<Test> tests;
+        return tests;
+    }
+
+    inline uint32_t& GetFailureCount()
+    {
+        static uint32_t failure_count = 0;
+        return failure_count;
+    }
+
+    struct TestRegistrar
+    {
+        TestRegistrar(const char* name, void (*function)(), const bool benchmark) { GetTests().push_back({ name, function, benchmark }); }
+    };
+
+    inline void Fail(const char* file, const int line, const char* expression)
+    {
+        printf("    failed: %s (%s:%d)\n", expression, file, line);
+        GetFailureCount()++;
+    }
+
+    // A context with only the threading subsystem, for the tests of the code which runs on the job system
+    inline Threading* GetThreading()
+    {
+        static Context context;
+        static Threading* threading = []()
+        {
+            context.RegisterSubsystem<Threading>();
+            return context.GetSubsystem<Threading>();
+        }();
+
+        return threading;
+    }
+
+    // Runs a function the given number of times (after one warm up run) and prints the average duration
+    template <typename Function>
+    double Measure(const char* name, const uint32_t iterations, Function&& function)
+    {
+        function();
+
+        Stopwatch timer;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            function();
+        }
+        const double ms = static_cast<double>(timer.GetElapsedTimeMs()) / iterations;
+
+        printf("    %-48s %10.4f ms\n", name, ms);
+        return ms;
+    }
+
+    // Prints a value which a benchmark measured, other than time
+    inline void Report(const char* name, const double value, const char* unit)
+    {
+        printf("    %-48s %10.2f %s\n", name, value, unit);
+    }
+}
+
+#define TEST(name)                                                                                          \
+    static void test_##name();                                                                              \
+    static const Spartan::Tests::TestRegistrar test_registrar_##name(#name, test_##name, false);          \
+    static void test_##name()
+
+#define BENCHMARK(name)                                                                                     \
+    static void benchmark_##name();                                                                         \
+    static const Spartan::Tests::TestRegistrar benchmark_registrar_##name(#name, benchmark_##name, true); \
+    static void benchmark_##name()
+
+// Records a failure and carries on with the test
+#define CHECK(expression) do { if (!(expression)) Spartan::Tests::Fail(__FILE__, __LINE__, #expression); } while (false)
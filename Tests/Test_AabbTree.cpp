@@ -0,0 +1,254 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ============
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include "Test.h"
+#include "Math/AabbTree.h"
+//=======================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+// Boxes of up to two units, scattered across a cube of the given size
+static vector<BoundingBox> random_boxes(const uint32_t count, const float extent, mt19937& random)
+{
+    uniform_real_distribution<float> position(-extent, extent);
+    uniform_real_distribution<float> size(0.1f, 2.0f);
+
+    vector<BoundingBox> boxes(count);
+    for (BoundingBox& box : boxes)
+    {
+        const Vector3 min = Vector3(position(random), position(random), position(random));
+        box = BoundingBox(min, min + Vector3(size(random), size(random), size(random)));
+    }
+
+    return boxes;
+}
+
+static vector<uintptr_t> query_brute_force(const vector<BoundingBox>& boxes, const BoundingBox& query)
+{
+    vector<uintptr_t> hits;
+    for (uintptr_t i = 0; i < boxes.size(); i++)
+    {
+        if (query.IsInside(boxes[i]) != Outside)
+        {
+            hits.emplace_back(i);
+        }
+    }
+
+    return hits;
+}
+
+static vector<uintptr_t> query_tree(const AabbTree& tree, const BoundingBox& query)
+{
+    vector<uintptr_t> hits;
+    tree.QueryBox(query, [&hits](void* user_data) { hits.emplace_back(reinterpret_cast<uintptr_t>(user_data)); });
+    sort(hits.begin(), hits.end());
+    return hits;
+}
+
+TEST(aabb_tree_query_matches_brute_force)
+{
+    mt19937 random(7);
+    vector<BoundingBox> boxes = random_boxes(2000, 100.0f, random);
+
+    AabbTree tree;
+    vector<int32_t> proxies(boxes.size());
+    for (uintptr_t i = 0; i < boxes.size(); i++)
+    {
+        proxies[i] = tree.Insert(boxes[i], reinterpret_cast<void*>(i));
+    }
+    CHECK(tree.GetProxyCount() == boxes.size());
+
+    // Move half of them, some a little (within the fat box) and some far away
+    uniform_real_distribution<float> offset(-0.05f, 0.05f);
+    uniform_real_distribution<float> jump(-100.0f, 100.0f);
+    for (uint32_t i = 0; i < boxes.size(); i += 2)
+    {
+        const Vector3 delta = (i % 4 == 0) ? Vector3(offset(random), offset(random), offset(random)) : Vector3(jump(random), jump(random), jump(random));
+        boxes[i] = BoundingBox(boxes[i].GetMin() + delta, boxes[i].GetMax() + delta);
+        tree.Update(proxies[i], boxes[i]);
+    }
+
+    // And remove a few, which brute force skips by replacing them with a box nothing can reach
+    for (uint32_t i = 1; i < boxes.size(); i += 10)
+    {
+        tree.Remove(proxies[i]);
+        boxes[i] = BoundingBox(Vector3(1e6f), Vector3(1e6f + 1.0f));
+    }
+
+    for (const BoundingBox& query : random_boxes(200, 100.0f, random))
+    {
+        const BoundingBox query_large(query.GetMin(), query.GetMin() + Vector3(20.0f));
+        CHECK(query_tree(tree, query_large) == query_brute_force(boxes, query_large));
+    }
+
+    // A tree which is built by insertions stays roughly logarithmic in height
+    CHECK(tree.GetHeight() < 32);
+}
+
+TEST(aabb_tree_ray_query_matches_brute_force)
+{
+    mt19937 random(11);
+    const vector<BoundingBox> boxes = random_boxes(2000, 20.0f, random);
+
+    AabbTree tree;
+    for (uintptr_t i = 0; i < boxes.size(); i++)
+    {
+        tree.Insert(boxes[i], reinterpret_cast<void*>(i));
+    }
+
+    // Rays from anywhere around the boxes to anywhere else, some of them start inside of boxes
+    uniform_real_distribution<float> position(-30.0f, 30.0f);
+    uint32_t hit_count = 0;
+    for (uint32_t i = 0; i < 200; i++)
+    {
+        const Ray ray(Vector3(position(random), position(random), position(random)), Vector3(position(random), position(random), position(random)));
+
+        vector<pair<uintptr_t, float>> hits_tree;
+        tree.QueryRay(ray, [&hits_tree](void* user_data, const float distance) { hits_tree.emplace_back(reinterpret_cast<uintptr_t>(user_data), distance); });
+        sort(hits_tree.begin(), hits_tree.end());
+
+        vector<pair<uintptr_t, float>> hits_brute_force;
+        for (uintptr_t j = 0; j < boxes.size(); j++)
+        {
+            const float distance = ray.HitDistance(boxes[j]);
+            if (distance != INFINITY)
+            {
+                hits_brute_force.emplace_back(j, distance);
+            }
+        }
+
+        CHECK(hits_tree == hits_brute_force);
+        hit_count += static_cast<uint32_t>(hits_tree.size());
+    }
+
+    // The rays are long enough to cross a few boxes each
+    CHECK(hit_count > 200);
+}
+
+BENCHMARK(aabb_tree_query_and_update)
+{
+    mt19937 random(7);
+
+    // The density stays the same as the world grows, so a query returns about as many boxes at every size
+    for (const uint32_t count : { 1000u, 10000u, 100000u, 1000000u })
+    {
+        const float extent = 500.0f * cbrt(count / 20000.0f);
+        vector<BoundingBox> boxes = random_boxes(count, extent, random);
+        printf("  %u boxes\n", count);
+
+        char name[64];
+        AabbTree tree;
+        vector<int32_t> proxies(count);
+        snprintf(name, sizeof(name), "insert %uk", count / 1000);
+        Measure(name, 1, [&tree, &boxes, &proxies]()
+        {
+            tree.Clear();
+            for (uintptr_t i = 0; i < boxes.size(); i++)
+            {
+                proxies[i] = tree.Insert(boxes[i], reinterpret_cast<void*>(i));
+            }
+        });
+        Report("height", tree.GetHeight(), "");
+
+        // Queries the size of a light's range, against the tree and against every box
+        const vector<BoundingBox> queries = random_boxes(100, extent, random);
+        uint32_t hits_tree = 0;
+        const double ms_tree = Measure("100 box queries, tree", 10, [&tree, &queries, &hits_tree]()
+        {
+            hits_tree = 0;
+            for (const BoundingBox& query : queries)
+            {
+                tree.QueryBox(BoundingBox(query.GetMin(), query.GetMin() + Vector3(25.0f)), [&hits_tree](void*) { hits_tree++; });
+            }
+        });
+
+        uint32_t hits_brute_force = 0;
+        const double ms_brute_force = Measure("100 box queries, brute force", 3, [&boxes, &queries, &hits_brute_force]()
+        {
+            hits_brute_force = 0;
+            for (const BoundingBox& query : queries)
+            {
+                const BoundingBox query_large(query.GetMin(), query.GetMin() + Vector3(25.0f));
+                for (const BoundingBox& box : boxes)
+                {
+                    hits_brute_force += query_large.IsInside(box) != Outside ? 1 : 0;
+                }
+            }
+        });
+        Report("us per box query, tree", ms_tree * 10.0, "us");
+        Report("speedup", ms_brute_force / ms_tree, "x");
+        CHECK(hits_tree == hits_brute_force);
+
+        // Picking rays, which cross the whole world
+        uniform_real_distribution<float> position(-extent, extent);
+        vector<Ray> rays;
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            rays.emplace_back(Vector3(position(random), position(random), position(random)), Vector3(position(random), position(random), position(random)));
+        }
+        uint32_t hits_ray = 0;
+        const double ms_ray = Measure("100 ray queries, tree", 10, [&tree, &rays, &hits_ray]()
+        {
+            hits_ray = 0;
+            for (const Ray& ray : rays)
+            {
+                tree.QueryRay(ray, [&hits_ray](void*, float) { hits_ray++; });
+            }
+        });
+        Report("us per ray query, tree", ms_ray * 10.0, "us");
+
+        // Updates, most entities move a little every frame and stay in their fat box, a few move far
+        uniform_real_distribution<float> offset(-0.02f, 0.02f);
+        uniform_real_distribution<float> jump(-50.0f, 50.0f);
+        vector<Vector3> deltas(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            deltas[i] = (i % 20 == 0) ? Vector3(jump(random), jump(random), jump(random)) : Vector3(offset(random), offset(random), offset(random));
+        }
+
+        uint32_t reinserted = 0;
+        snprintf(name, sizeof(name), "update %uk", count / 1000);
+        Measure(name, 10, [&tree, &boxes, &proxies, &deltas, &reinserted]()
+        {
+            reinserted = 0;
+            for (uint32_t i = 0; i < static_cast<uint32_t>(boxes.size()); i++)
+            {
+                boxes[i] = BoundingBox(boxes[i].GetMin() + deltas[i], boxes[i].GetMax() + deltas[i]);
+                reinserted += tree.Update(proxies[i], boxes[i]) ? 1 : 0;
+            }
+            for (Vector3& delta : deltas)
+            {
+                delta = -delta; // back and forth, so the boxes stay where they are
+            }
+        });
+        Report("re-inserted per update", reinserted, "");
+    }
+}
@@ -0,0 +1,150 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==========================
+#include <memory>
+#include <random>
+#include <algorithm>
+#include "Test.h"
+#include "World/ComponentPool.h"
+#include "World/Components/IComponent.h"
+#include "Math/Vector3.h"
+//=====================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+// A component without an entity, which moves a position every tick
+class TestComponent : public IComponent
+{
+public:
+    TestComponent(const ComponentType type) : IComponent(nullptr, nullptr) { SetType(type); }
+
+    void OnTick(const float delta_time) override { position += velocity * delta_time; }
+
+    Vector3 position = Vector3::Zero;
+    Vector3 velocity = Vector3::One;
+};
+
+TEST(component_pool_handles_survive_removals)
+{
+    vector<unique_ptr<TestComponent>> components;
+    vector<ComponentHandle> handles;
+    ComponentPool pool;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        components.emplace_back(make_unique<TestComponent>(ComponentType::Script));
+        handles.emplace_back(pool.Add(components.back().get()));
+    }
+
+    // Remove every third, the rest must still resolve to their own component
+    for (uint32_t i = 0; i < 100; i += 3)
+    {
+        pool.Remove(handles[i]);
+    }
+    CHECK(pool.GetCount() == 66);
+
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        CHECK(pool.Get(handles[i]) == (i % 3 == 0 ? nullptr : components[i].get()));
+    }
+
+    // Re-used slots don't bring removed handles back to life
+    unique_ptr<TestComponent> component = make_unique<TestComponent>(ComponentType::Script);
+    const ComponentHandle handle = pool.Add(component.get());
+    CHECK(pool.Get(handle) == component.get());
+    CHECK(pool.Get(handles[0]) == nullptr && pool.Get(handles[99]) == nullptr);
+}
+
+BENCHMARK(component_pool_iteration)
+{
+    // Entities with a few components each, allocated in a shuffled order as they would be after a while of
+    // adding and removing, compared to walking the pool of the one type a system is interested in
+    const uint32_t entity_count = 50000;
+    const ComponentType types[] = { ComponentType::Transform, ComponentType::Renderable, ComponentType::Script };
+
+    vector<vector<shared_ptr<IComponent>>> entities(entity_count);
+    vector<pair<uint32_t, ComponentType>> order;
+    for (uint32_t i = 0; i < entity_count; i++)
+    {
+        for (const ComponentType type : types)
+        {
+            order.emplace_back(i, type);
+        }
+    }
+    shuffle(order.begin(), order.end(), mt19937(7));
+
+    ComponentPool pool;
+    for (const auto& [entity, type] : order)
+    {
+        entities[entity].emplace_back(make_shared<TestComponent>(type));
+        if (type == ComponentType::Script)
+        {
+            IComponent* component = entities[entity].back().get();
+            component->SetHandle(pool.Add(component));
+        }
+    }
+
+    const float delta_time = 0.016f;
+    const double ms_entities = Measure("50k entities, find the component", 20, [&entities, delta_time]()
+    {
+        for (const vector<shared_ptr<IComponent>>& components : entities)
+        {
+            for (const shared_ptr<IComponent>& component : components)
+            {
+                if (component->GetType() == ComponentType::Script)
+                {
+                    component->OnTick(delta_time);
+                }
+            }
+        }
+    });
+
+    const double ms_pool = Measure("50k components, pool", 20, [&pool, delta_time]()
+    {
+        for (IComponent* component : pool.GetAll())
+        {
+            component->OnTick(delta_time);
+        }
+    });
+    Report("speedup", ms_entities / ms_pool, "x");
+
+    // Churn, half of them removed and added back
+    vector<ComponentHandle> handles;
+    Measure("remove and add 25k", 20, [&pool, &handles]()
+    {
+        handles.clear();
+        const vector<IComponent*> components = pool.GetAll();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(components.size()); i += 2)
+        {
+            pool.Remove(components[i]->GetHandle());
+        }
+        for (uint32_t i = 0; i < static_cast<uint32_t>(components.size()); i += 2)
+        {
+            components[i]->SetHandle(pool.Add(components[i]));
+        }
+    });
+}
@@ -0,0 +1,310 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Test.h"
+#include "IO/FileStream.h"
+#include "RHI/RHI_Vertex.h"
+//=============================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+static const char* file_path = "test_file_stream.bin";
+
+// Laid out like the transform chunk of a world file, the offset of each record followed by the records
+static const uint32_t transform_count = 200000;
+
+static void transforms_write()
+{
+    // Position, rotation, scale, look at and the parent index
+    const uint64_t record_size = sizeof(Vector3) + sizeof(Quaternion) + sizeof(Vector3) + sizeof(Vector3) + sizeof(uint32_t);
+
+    FileStream file(file_path, FileStream_Write);
+    for (uint32_t i = 0; i < transform_count; i++)
+    {
+        file.Write(static_cast<uint64_t>(sizeof(uint64_t) * transform_count + record_size * i));
+    }
+
+    for (uint32_t i = 0; i < transform_count; i++)
+    {
+        const float f = static_cast<float>(i);
+        file.Write(Vector3(f, f + 1.0f, f + 2.0f));
+        file.Write(Quaternion::Identity);
+        file.Write(Vector3::One);
+        file.Write(Vector3::Zero);
+        file.Write(i);
+    }
+}
+
+// Reads the records [start, end) the way Transform::Deserialize does, returns the sum of the positions
+static float transforms_read(FileStream& stream, const uint32_t start, const uint32_t end)
+{
+    stream.Seek(sizeof(uint64_t) * start);
+    stream.Seek(stream.ReadAs<uint64_t>());
+
+    float sum = 0.0f;
+    Vector3 position, scale, look_at;
+    Quaternion rotation;
+    for (uint32_t i = start; i < end; i++)
+    {
+        stream.Read(&position);
+        stream.Read(&rotation);
+        stream.Read(&scale);
+        stream.Read(&look_at);
+        stream.ReadAs<uint32_t>();
+        sum += position.x;
+    }
+
+    return sum;
+}
+
+TEST(file_stream_shares_a_mapping)
+{
+    transforms_write();
+
+    FileStream file(file_path, FileStream_Read);
+    CHECK(file.IsOpen());
+
+    // Streams over the same mapping keep their own position
+    FileStream a(file, 0);
+    FileStream b(file, sizeof(uint64_t) * 10);
+    CHECK(a.IsOpen() && b.IsOpen());
+    CHECK(a.GetSize() == file.GetSize());
+    CHECK(a.ReadAs<uint64_t>() == sizeof(uint64_t) * transform_count);
+    CHECK(transforms_read(b, 10, 11) == 10.0f);
+    CHECK(transforms_read(a, 5, 7) == 11.0f);
+
+    // Positions past the end are clamped, like Seek()
+    FileStream c(file, file.GetSize() + 100);
+    CHECK(c.GetPosition() == file.GetSize());
+
+    file.Close();
+    remove(file_path);
+}
+
+// How the transforms of a world load, one range per task
+BENCHMARK(file_stream_world_transform_load)
+{
+    transforms_write();
+    Threading* threading = GetThreading();
+    const uint32_t grain_size = 512;
+    float sum = 0.0f;
+
+    Measure("read 200k transforms, serial", 10, [&sum]()
+    {
+        FileStream file(file_path, FileStream_Read);
+        sum += transforms_read(file, 0, transform_count);
+    });
+
+    Measure("read 200k transforms, parallel, a stream opened per range", 10, [threading]()
+    {
+        threading->ParallelFor(transform_count, grain_size, [](uint32_t start, uint32_t end)
+        {
+            FileStream stream(file_path, FileStream_Read);
+            transforms_read(stream, start, end);
+        });
+    });
+
+    Measure("read 200k transforms, parallel, one mapping", 10, [threading]()
+    {
+        FileStream file(file_path, FileStream_Read);
+        threading->ParallelFor(transform_count, grain_size, [&file](uint32_t start, uint32_t end)
+        {
+            FileStream stream(file, 0);
+            transforms_read(stream, start, end);
+        });
+    });
+
+    CHECK(sum != 0.0f);
+    remove(file_path);
+}
+
+TEST(file_stream_round_trip)
+{
+    const vector<uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+    {
+        FileStream file(file_path, FileStream_Write);
+        file.Write(true);
+        file.Write(7.5f);
+        file.Write(Vector3(1.0f, 2.0f, 3.0f));
+        file.Write(string("mesh"));
+        file.Write(indices);
+        // Bigger than the write buffer, so it's written directly after what's buffered
+        file.Write(vector<std::byte>(200 * 1024, std::byte(9)));
+        file.Write(42u);
+    }
+
+    FileStream file(file_path, FileStream_Read);
+    CHECK(file.ReadAs<bool>());
+    CHECK(file.ReadAs<float>() == 7.5f);
+    Vector3 v;
+    file.Read(&v);
+    CHECK(v == Vector3(1.0f, 2.0f, 3.0f));
+    CHECK(file.ReadAs<string>() == "mesh");
+
+    uint32_t count = 0;
+    const uint32_t* view = file.ReadView<uint32_t>(&count);
+    CHECK(count == indices.size() && view && view[5] == 3);
+
+    vector<std::byte> bytes;
+    file.Read(&bytes);
+    CHECK(bytes.size() == 200 * 1024 && bytes.back() == std::byte(9));
+    CHECK(file.ReadAs<uint32_t>() == 42);
+
+    // Reading past the end returns nothing
+    CHECK(file.ReadView(1) == nullptr);
+    CHECK(file.GetPosition() == file.GetSize());
+
+    file.Close();
+    remove(file_path);
+}
+
+TEST(file_stream_corrupt_counts_are_clamped)
+{
+    // Counts which claim far more than the file holds, like a truncated or corrupt file would
+    {
+        FileStream file(file_path, FileStream_Write);
+        file.Write(0xFFFFFFFFu);
+        file.Write(1u);
+        file.Write(2u);
+    }
+
+    {
+        FileStream file(file_path, FileStream_Read);
+        vector<uint32_t> values;
+        file.Read(&values);
+        CHECK(values.size() == 2 && values[0] == 1 && values[1] == 2);
+        CHECK(file.GetPosition() == file.GetSize());
+    }
+
+    const auto read_whole = [](auto value)
+    {
+        FileStream file(file_path, FileStream_Read);
+        file.Read(&value);
+        return value.size();
+    };
+    CHECK(read_whole(string()) == 8);
+    CHECK(read_whole(vector<string>()) == 2);
+    CHECK(read_whole(vector<std::byte>()) == 8);
+    CHECK(read_whole(vector<unsigned char>()) == 8);
+    CHECK(read_whole(vector<RHI_Vertex_PosTexNorTan>()) == 0);
+
+    remove(file_path);
+}
+
+// Small fields, like components and materials are saved, and bulk arrays, like vertices and indices.
+// The fstream numbers are what FileStream did before it buffered writes and mapped reads.
+BENCHMARK(file_stream_throughput)
+{
+    const uint32_t field_count = 1000000;
+    const vector<uint32_t> array(16 * 1024 * 1024, 1);
+    uint64_t sum = 0;
+
+    Measure("write 1M small fields, fstream", 5, [&]()
+    {
+        ofstream out(file_path, ios::binary);
+        for (uint32_t i = 0; i < field_count; i++)
+        {
+            const Vector3 v(static_cast<float>(i));
+            out.write(reinterpret_cast<const char*>(&i), sizeof(i));
+            out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+        }
+    });
+
+    Measure("write 1M small fields, FileStream", 5, [&]()
+    {
+        FileStream file(file_path, FileStream_Write);
+        for (uint32_t i = 0; i < field_count; i++)
+        {
+            file.Write(i);
+            file.Write(Vector3(static_cast<float>(i)));
+        }
+    });
+
+    Measure("read 1M small fields, fstream", 5, [&]()
+    {
+        ifstream in(file_path, ios::binary);
+        uint32_t value = 0;
+        Vector3 v;
+        for (uint32_t i = 0; i < field_count; i++)
+        {
+            in.read(reinterpret_cast<char*>(&value), sizeof(value));
+            in.read(reinterpret_cast<char*>(&v), sizeof(v));
+            sum += value;
+        }
+    });
+
+    Measure("read 1M small fields, FileStream", 5, [&]()
+    {
+        FileStream file(file_path, FileStream_Read);
+        Vector3 v;
+        for (uint32_t i = 0; i < field_count; i++)
+        {
+            sum += file.ReadAs<uint32_t>();
+            file.Read(&v);
+        }
+    });
+
+    Measure("write a 64 MB array, FileStream", 5, [&]()
+    {
+        FileStream file(file_path, FileStream_Write);
+        file.Write(array);
+    });
+
+    Measure("read a 64 MB array, fstream", 5, [&]()
+    {
+        ifstream in(file_path, ios::binary);
+        uint32_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        vector<uint32_t> values(count);
+        in.read(reinterpret_cast<char*>(values.data()), sizeof(uint32_t) * count);
+        sum += values.back();
+    });
+
+    Measure("read a 64 MB array, FileStream copy", 5, [&]()
+    {
+        FileStream file(file_path, FileStream_Read);
+        vector<uint32_t> values;
+        file.Read(&values);
+        sum += values.back();
+    });
+
+    Measure("read a 64 MB array, FileStream view", 5, [&]()
+    {
+        FileStream file(file_path, FileStream_Read);
+        uint32_t count = 0;
+        const uint32_t* values = file.ReadView<uint32_t>(&count);
+        sum += values[count - 1];
+    });
+
+    CHECK(sum != 0);
+    remove(file_path);
+}
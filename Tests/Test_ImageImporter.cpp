@@ -0,0 +1,103 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ====================================
+#include <cstdio>
+#include <vector>
+#include "Test.h"
+#include "Core/Settings.h"
+#include "RHI/RHI_Texture2D.h"
+#include "Resource/Import/ImageImporter.h"
+//===============================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+// An uncompressed 24 bit TGA with a smooth gradient, which is what BC1 struggles with
+static void save_tga(const string& file_path, const uint32_t width, const uint32_t height)
+{
+    vector<uint8_t> file =
+    {
+        0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        static_cast<uint8_t>(width), static_cast<uint8_t>(width >> 8), static_cast<uint8_t>(height), static_cast<uint8_t>(height >> 8),
+        24, 0x20 // top left origin
+    };
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            file.emplace_back(static_cast<uint8_t>(x * 255 / (width - 1)));         // b
+            file.emplace_back(static_cast<uint8_t>(y * 255 / (height - 1)));        // g
+            file.emplace_back(static_cast<uint8_t>((x + y) * 255 / (width + height - 2))); // r
+        }
+    }
+
+    FILE* stream = fopen(file_path.c_str(), "wb");
+    fwrite(file.data(), 1, file.size(), stream);
+    fclose(stream);
+}
+
+TEST(image_importer_color_compression_high)
+{
+    Context context;
+    context.RegisterSubsystem<Settings>();
+    context.RegisterSubsystem<Threading>();
+    ImageImporter importer(&context);
+
+    const string file_path  = "test_image_importer.tga";
+    const uint32_t size     = 64;
+    const size_t blocks     = (size / 4) * (size / 4);
+    save_tga(file_path, size, size);
+
+    const auto load = [&context, &importer, &file_path](const RHI_Texture_Compression compression)
+    {
+        auto texture = make_shared<RHI_Texture2D>(&context);
+        texture->SetCompression(compression);
+        CHECK(importer.Load(file_path, texture.get()));
+        return texture;
+    };
+
+    // Opaque color is BC1 by default
+    shared_ptr<RHI_Texture2D> texture = load(RHI_Texture_Compression_Color);
+    CHECK(texture->GetFormat() == RHI_Format_BC1_Unorm);
+    CHECK(texture->GetData(0)->size() == blocks * 8);
+
+    // The import setting asks for BC7, with every mip compressed
+    importer.SetColorCompressionHigh(true);
+    texture = load(RHI_Texture_Compression_Color);
+    CHECK(texture->GetCompression() == RHI_Texture_Compression_Color_High);
+    CHECK(texture->GetFormat() == RHI_Format_BC7_Unorm);
+    CHECK(texture->GetData(0)->size() == blocks * 16);
+    CHECK(texture->GetData().size() == 7);
+
+    // Only color is affected, data textures keep their formats
+    texture = load(RHI_Texture_Compression_Normal);
+    CHECK(texture->GetFormat() == RHI_Format_BC5_Unorm);
+    texture = load(RHI_Texture_Compression_Grayscale);
+    CHECK(texture->GetFormat() == RHI_Format_BC4_Unorm);
+
+    remove(file_path.c_str());
+}
@@ -0,0 +1,173 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include <random>
+#include <algorithm>
+#include "Test.h"
+#include "Rendering/LightClusters.h"
+//================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+// A camera at the origin looking down +z, with point and spot lights scattered in front of it
+struct ClusterScene
+{
+    ClusterScene(const uint32_t light_count)
+    {
+        view        = Matrix::CreateLookAtLH(Vector3::Zero, Vector3::Forward, Vector3::Up);
+        projection  = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, near_plane, far_plane);
+
+        mt19937 random(7);
+        uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        uniform_real_distribution<float> depth(5.0f, 80.0f);
+        uniform_real_distribution<float> range(0.5f, 4.0f);
+        uniform_real_distribution<float> angle(0.1f, 1.2f);
+
+        lights.resize(light_count);
+        for (uint32_t i = 0; i < light_count; i++)
+        {
+            ClusteredLight& light   = lights[i];
+            const float z           = depth(random);
+            light.position          = Vector3(unit(random) * z, unit(random) * z * 0.6f, z);
+            light.range             = range(random);
+            if (i % 2 == 0)
+            {
+                light.direction = Vector3(unit(random), unit(random), unit(random)).Normalized();
+                light.angle     = angle(random);
+            }
+        }
+    }
+
+    // Whether a light can reach a point, what the clusters have to be conservative about
+    static bool Reaches(const ClusteredLight& light, const Vector3& point)
+    {
+        const Vector3 to_point  = point - light.position;
+        const float distance    = to_point.Length();
+        if (distance > light.range)
+            return false;
+
+        if (light.angle <= 0.0f || distance == 0.0f)
+            return true;
+
+        return Vector3::Dot(to_point / distance, light.direction) >= cos(light.angle);
+    }
+
+    Matrix view;
+    Matrix projection;
+    vector<ClusteredLight> lights;
+    const float near_plane  = 0.3f;
+    const float far_plane   = 100.0f;
+};
+
+TEST(light_clusters_contain_every_light_which_reaches_them)
+{
+    const ClusterScene scene(256);
+    LightClusters clusters;
+    clusters.Build(scene.lights, scene.view, scene.projection, scene.near_plane, scene.far_plane);
+    CHECK(clusters.GetOverflowCount() == 0);
+
+    // Points inside of the view, they must find every light which reaches them in their cluster
+    mt19937 random(11);
+    uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    uniform_real_distribution<float> depth(scene.near_plane, 90.0f);
+    uint32_t missing        = 0;
+    uint32_t lit_points     = 0;
+    uint32_t light_checks   = 0;
+    for (uint32_t sample = 0; sample < 20000; sample++)
+    {
+        const float z               = depth(random);
+        const Vector3 point_view    = Vector3(unit(random) * z * 0.9f, unit(random) * z * 0.5f, z);
+        const Vector3 ndc           = scene.projection * point_view;
+        if (Helper::Abs(ndc.x) > 1.0f || Helper::Abs(ndc.y) > 1.0f)
+            continue;
+
+        const uint32_t x        = Helper::Min(static_cast<uint32_t>((ndc.x * 0.5f + 0.5f) * m_cluster_count_x), m_cluster_count_x - 1);
+        const uint32_t y        = Helper::Min(static_cast<uint32_t>((0.5f - ndc.y * 0.5f) * m_cluster_count_y), m_cluster_count_y - 1);
+        const uint32_t cluster  = clusters.GetClusters()[clusters.GetClusterIndex(x, y, clusters.GetSlice(z))];
+        const uint16_t* begin   = clusters.GetIndices().data() + (cluster >> 8);
+        const uint16_t* end     = begin + (cluster & 0xFF);
+
+        bool lit = false;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(scene.lights.size()); i++)
+        {
+            if (!ClusterScene::Reaches(scene.lights[i], point_view))
+                continue;
+
+            lit = true;
+            light_checks++;
+            missing += find(begin, end, static_cast<uint16_t>(i)) == end ? 1 : 0;
+        }
+        lit_points += lit ? 1 : 0;
+    }
+
+    CHECK(missing == 0);
+    CHECK(lit_points > 100 && light_checks > 100); // the scene actually exercises the clusters
+}
+
+TEST(light_clusters_threaded_build_matches_serial)
+{
+    const ClusterScene scene(1024);
+
+    LightClusters serial;
+    serial.Build(scene.lights, scene.view, scene.projection, scene.near_plane, scene.far_plane);
+
+    LightClusters threaded;
+    threaded.Build(scene.lights, scene.view, scene.projection, scene.near_plane, scene.far_plane, GetThreading());
+
+    CHECK(serial.GetClusters() == threaded.GetClusters());
+    CHECK(serial.GetIndices() == threaded.GetIndices());
+    CHECK(serial.GetOverflowCount() == threaded.GetOverflowCount());
+}
+
+BENCHMARK(light_clusters_build)
+{
+    for (uint32_t light_count = 1; light_count <= 4096; light_count *= 4)
+    {
+        const ClusterScene scene(light_count);
+        LightClusters clusters;
+        char name[64];
+
+        snprintf(name, sizeof(name), "%u lights, serial", light_count);
+        Measure(name, 20, [&scene, &clusters]()
+        {
+            clusters.Build(scene.lights, scene.view, scene.projection, scene.near_plane, scene.far_plane);
+        });
+
+        snprintf(name, sizeof(name), "%u lights, job system", light_count);
+        Measure(name, 20, [&scene, &clusters]()
+        {
+            clusters.Build(scene.lights, scene.view, scene.projection, scene.near_plane, scene.far_plane, GetThreading());
+        });
+
+        snprintf(name, sizeof(name), "%u lights, light indices", light_count);
+        Report(name, static_cast<double>(clusters.GetIndices().size()), "");
+
+        snprintf(name, sizeof(name), "%u lights, overflowing clusters", light_count);
+        Report(name, static_cast<double>(clusters.GetOverflowCount()), "");
+    }
+}
@@ -0,0 +1,383 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include <random>
+#include "Test.h"
+#include "Math/Matrix.h"
+#include "Math/Quaternion.h"
+#include "Math/BoundingBox.h"
+//================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+// The SSE paths claim to be bit-exact with the scalar ones, which are reproduced below as the reference.
+// On targets without SSE the math classes run the scalar code, and these tests compare it against itself.
+
+static Matrix multiply_scalar(const Matrix& a, const Matrix& b)
+{
+    return Matrix(
+        a.m00 * b.m00 + a.m01 * b.m10 + a.m02 * b.m20 + a.m03 * b.m30,
+        a.m00 * b.m01 + a.m01 * b.m11 + a.m02 * b.m21 + a.m03 * b.m31,
+        a.m00 * b.m02 + a.m01 * b.m12 + a.m02 * b.m22 + a.m03 * b.m32,
+        a.m00 * b.m03 + a.m01 * b.m13 + a.m02 * b.m23 + a.m03 * b.m33,
+        a.m10 * b.m00 + a.m11 * b.m10 + a.m12 * b.m20 + a.m13 * b.m30,
+        a.m10 * b.m01 + a.m11 * b.m11 + a.m12 * b.m21 + a.m13 * b.m31,
+        a.m10 * b.m02 + a.m11 * b.m12 + a.m12 * b.m22 + a.m13 * b.m32,
+        a.m10 * b.m03 + a.m11 * b.m13 + a.m12 * b.m23 + a.m13 * b.m33,
+        a.m20 * b.m00 + a.m21 * b.m10 + a.m22 * b.m20 + a.m23 * b.m30,
+        a.m20 * b.m01 + a.m21 * b.m11 + a.m22 * b.m21 + a.m23 * b.m31,
+        a.m20 * b.m02 + a.m21 * b.m12 + a.m22 * b.m22 + a.m23 * b.m32,
+        a.m20 * b.m03 + a.m21 * b.m13 + a.m22 * b.m23 + a.m23 * b.m33,
+        a.m30 * b.m00 + a.m31 * b.m10 + a.m32 * b.m20 + a.m33 * b.m30,
+        a.m30 * b.m01 + a.m31 * b.m11 + a.m32 * b.m21 + a.m33 * b.m31,
+        a.m30 * b.m02 + a.m31 * b.m12 + a.m32 * b.m22 + a.m33 * b.m32,
+        a.m30 * b.m03 + a.m31 * b.m13 + a.m32 * b.m23 + a.m33 * b.m33
+    );
+}
+
+static Vector3 transform_scalar(const Matrix& m, const Vector3& v)
+{
+    const float w = 1 / ((v.x * m.m03) + (v.y * m.m13) + (v.z * m.m23) + m.m33);
+    return Vector3
+    (
+        ((v.x * m.m00) + (v.y * m.m10) + (v.z * m.m20) + m.m30) * w,
+        ((v.x * m.m01) + (v.y * m.m11) + (v.z * m.m21) + m.m31) * w,
+        ((v.x * m.m02) + (v.y * m.m12) + (v.z * m.m22) + m.m32) * w
+    );
+}
+
+static Vector4 transform_scalar(const Matrix& m, const Vector4& v)
+{
+    return Vector4
+    (
+        (v.x * m.m00) + (v.y * m.m10) + (v.z * m.m20) + (v.w * m.m30),
+        (v.x * m.m01) + (v.y * m.m11) + (v.z * m.m21) + (v.w * m.m31),
+        (v.x * m.m02) + (v.y * m.m12) + (v.z * m.m22) + (v.w * m.m32),
+        (v.x * m.m03) + (v.y * m.m13) + (v.z * m.m23) + (v.w * m.m33)
+    );
+}
+
+static Matrix invert_scalar(const Matrix& m)
+{
+    float v0 = m.m20 * m.m31 - m.m21 * m.m30;
+    float v1 = m.m20 * m.m32 - m.m22 * m.m30;
+    float v2 = m.m20 * m.m33 - m.m23 * m.m30;
+    float v3 = m.m21 * m.m32 - m.m22 * m.m31;
+    float v4 = m.m21 * m.m33 - m.m23 * m.m31;
+    float v5 = m.m22 * m.m33 - m.m23 * m.m32;
+
+    float i00 = (v5 * m.m11 - v4 * m.m12 + v3 * m.m13);
+    float i10 = -(v5 * m.m10 - v2 * m.m12 + v1 * m.m13);
+    float i20 = (v4 * m.m10 - v2 * m.m11 + v0 * m.m13);
+    float i30 = -(v3 * m.m10 - v1 * m.m11 + v0 * m.m12);
+
+    const float inverse_determinant = 1.0f / (i00 * m.m00 + i10 * m.m01 + i20 * m.m02 + i30 * m.m03);
+    i00 *= inverse_determinant;
+    i10 *= inverse_determinant;
+    i20 *= inverse_determinant;
+    i30 *= inverse_determinant;
+
+    const float i01 = -(v5 * m.m01 - v4 * m.m02 + v3 * m.m03) * inverse_determinant;
+    const float i11 = (v5 * m.m00 - v2 * m.m02 + v1 * m.m03) * inverse_determinant;
+    const float i21 = -(v4 * m.m00 - v2 * m.m01 + v0 * m.m03) * inverse_determinant;
+    const float i31 = (v3 * m.m00 - v1 * m.m01 + v0 * m.m02) * inverse_determinant;
+
+    v0 = m.m10 * m.m31 - m.m11 * m.m30;
+    v1 = m.m10 * m.m32 - m.m12 * m.m30;
+    v2 = m.m10 * m.m33 - m.m13 * m.m30;
+    v3 = m.m11 * m.m32 - m.m12 * m.m31;
+    v4 = m.m11 * m.m33 - m.m13 * m.m31;
+    v5 = m.m12 * m.m33 - m.m13 * m.m32;
+
+    const float i02 = (v5 * m.m01 - v4 * m.m02 + v3 * m.m03) * inverse_determinant;
+    const float i12 = -(v5 * m.m00 - v2 * m.m02 + v1 * m.m03) * inverse_determinant;
+    const float i22 = (v4 * m.m00 - v2 * m.m01 + v0 * m.m03) * inverse_determinant;
+    const float i32 = -(v3 * m.m00 - v1 * m.m01 + v0 * m.m02) * inverse_determinant;
+
+    v0 = m.m21 * m.m10 - m.m20 * m.m11;
+    v1 = m.m22 * m.m10 - m.m20 * m.m12;
+    v2 = m.m23 * m.m10 - m.m20 * m.m13;
+    v3 = m.m22 * m.m11 - m.m21 * m.m12;
+    v4 = m.m23 * m.m11 - m.m21 * m.m13;
+    v5 = m.m23 * m.m12 - m.m22 * m.m13;
+
+    const float i03 = -(v5 * m.m01 - v4 * m.m02 + v3 * m.m03) * inverse_determinant;
+    const float i13 = (v5 * m.m00 - v2 * m.m02 + v1 * m.m03) * inverse_determinant;
+    const float i23 = -(v4 * m.m00 - v2 * m.m01 + v0 * m.m03) * inverse_determinant;
+    const float i33 = (v3 * m.m00 - v1 * m.m01 + v0 * m.m02) * inverse_determinant;
+
+    return Matrix(
+        i00, i01, i02, i03,
+        i10, i11, i12, i13,
+        i20, i21, i22, i23,
+        i30, i31, i32, i33);
+}
+
+static Vector3 scale_scalar(const Matrix& m)
+{
+    const float xs = (Helper::Sign(m.m00 * m.m01 * m.m02 * m.m03) < 0) ? -1.0f : 1.0f;
+    const float ys = (Helper::Sign(m.m10 * m.m11 * m.m12 * m.m13) < 0) ? -1.0f : 1.0f;
+    const float zs = (Helper::Sign(m.m20 * m.m21 * m.m22 * m.m23) < 0) ? -1.0f : 1.0f;
+
+    return Vector3(
+        xs * Helper::Sqrt(m.m00 * m.m00 + m.m01 * m.m01 + m.m02 * m.m02),
+        ys * Helper::Sqrt(m.m10 * m.m10 + m.m11 * m.m11 + m.m12 * m.m12),
+        zs * Helper::Sqrt(m.m20 * m.m20 + m.m21 * m.m21 + m.m22 * m.m22)
+    );
+}
+
+static Quaternion multiply_scalar(const Quaternion& a, const Quaternion& b)
+{
+    const float cross_x = (a.y * b.z) - (a.z * b.y);
+    const float cross_y = (a.z * b.x) - (a.x * b.z);
+    const float cross_z = (a.x * b.y) - (a.y * b.x);
+    const float dot     = ((a.x * b.x) + (a.y * b.y)) + (a.z * b.z);
+
+    return Quaternion(
+        ((a.x * b.w) + (b.x * a.w)) + cross_x,
+        ((a.y * b.w) + (b.y * a.w)) + cross_y,
+        ((a.z * b.w) + (b.z * a.w)) + cross_z,
+        (a.w * b.w) - dot
+    );
+}
+
+static Vector3 rotate_scalar(const Quaternion& q, const Vector3& v)
+{
+    const Vector3 q_xyz(q.x, q.y, q.z);
+    const Vector3 cross1(q_xyz.Cross(v));
+    const Vector3 cross2(q_xyz.Cross(cross1));
+
+    return v + 2.0f * (cross1 * q.w + cross2);
+}
+
+static BoundingBox transform_scalar(const BoundingBox& box, const Matrix& m)
+{
+    const Vector3 center    = transform_scalar(m, box.GetCenter());
+    const Vector3 extent    = box.GetExtents();
+    const Vector3 extent_new = Vector3
+    (
+        Helper::Abs(m.m00) * extent.x + Helper::Abs(m.m10) * extent.y + Helper::Abs(m.m20) * extent.z,
+        Helper::Abs(m.m01) * extent.x + Helper::Abs(m.m11) * extent.y + Helper::Abs(m.m21) * extent.z,
+        Helper::Abs(m.m02) * extent.x + Helper::Abs(m.m12) * extent.y + Helper::Abs(m.m22) * extent.z
+    );
+
+    return BoundingBox(center - extent_new, center + extent_new);
+}
+
+static bool equal(const Vector3& a, const Vector3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+static bool equal(const Vector4& a, const Vector4& b) { return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w; }
+static bool equal(const Quaternion& a, const Quaternion& b) { return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w; }
+static bool equal(const Matrix& a, const Matrix& b)
+{
+    return
+        a.m00 == b.m00 && a.m01 == b.m01 && a.m02 == b.m02 && a.m03 == b.m03 &&
+        a.m10 == b.m10 && a.m11 == b.m11 && a.m12 == b.m12 && a.m13 == b.m13 &&
+        a.m20 == b.m20 && a.m21 == b.m21 && a.m22 == b.m22 && a.m23 == b.m23 &&
+        a.m30 == b.m30 && a.m31 == b.m31 && a.m32 == b.m32 && a.m33 == b.m33;
+}
+
+// Transforms the way entities have them, translation, rotation and a (sometimes negative) scale
+struct RandomMath
+{
+    RandomMath() : random(7) {}
+
+    float Value(const float range) { return uniform_real_distribution<float>(-range, range)(random); }
+    Vector3 Position()      { return Vector3(Value(100.0f), Value(100.0f), Value(100.0f)); }
+    Quaternion Rotation()   { return Quaternion::FromEulerAngles(Value(180.0f), Value(180.0f), Value(180.0f)); }
+    Vector3 Scale()         { return Vector3(Value(4.0f), Value(4.0f), Value(4.0f)); }
+    Matrix Transform()      { return Matrix(Position(), Rotation(), Scale()); }
+
+    mt19937 random;
+};
+
+TEST(math_matrix_sse_matches_scalar)
+{
+    RandomMath random;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const Matrix a = random.Transform();
+        const Matrix b = random.Transform();
+        const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.0f + random.Value(0.5f), 1.777f, 0.3f, 1000.0f);
+
+        CHECK(equal(a * b, multiply_scalar(a, b)));
+        CHECK(equal(a * projection, multiply_scalar(a, projection)));
+        CHECK(equal(a.Inverted(), invert_scalar(a)));
+        CHECK(equal((a * projection).Inverted(), invert_scalar(a * projection)));
+        CHECK(equal(a.GetScale(), scale_scalar(a)));
+
+        const Matrix t = a.Transposed();
+        CHECK(t.m01 == a.m10 && t.m02 == a.m20 && t.m03 == a.m30 && t.m12 == a.m21 && t.m13 == a.m31 && t.m23 == a.m32);
+
+        const Vector3 v = random.Position();
+        CHECK(equal(a * v, transform_scalar(a, v)));
+        CHECK(equal(projection * v, transform_scalar(projection, v)));
+
+        const Vector4 v4 = Vector4(v.x, v.y, v.z, random.Value(1.0f));
+        CHECK(equal(a * v4, transform_scalar(a, v4)));
+    }
+}
+
+TEST(math_quaternion_sse_matches_scalar)
+{
+    RandomMath random;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const Quaternion a = random.Rotation();
+        const Quaternion b = random.Rotation();
+        CHECK(equal(a * b, multiply_scalar(a, b)));
+
+        const Vector3 v = random.Position();
+        CHECK(equal(a * v, rotate_scalar(a, v)));
+    }
+}
+
+TEST(math_bounding_box_sse_matches_scalar)
+{
+    RandomMath random;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const Vector3 min       = random.Position();
+        const BoundingBox box   = BoundingBox(min, min + Vector3(Helper::Abs(random.Value(10.0f)), Helper::Abs(random.Value(10.0f)), Helper::Abs(random.Value(10.0f))));
+        const Matrix transform  = random.Transform();
+
+        const BoundingBox result    = box.Transform(transform);
+        const BoundingBox reference = transform_scalar(box, transform);
+        CHECK(equal(result.GetMin(), reference.GetMin()) && equal(result.GetMax(), reference.GetMax()));
+    }
+}
+
+// Runs a kernel through the math classes and through the scalar reference over the same inputs, and reports the speedup
+template <typename Sse, typename Scalar>
+static void math_benchmark(const char* name, Sse&& sse, Scalar&& scalar)
+{
+    char label[64];
+    snprintf(label, sizeof(label), "%s, sse", name);
+    const double ms_sse = Measure(label, 20, sse);
+    snprintf(label, sizeof(label), "%s, scalar", name);
+    const double ms_scalar = Measure(label, 20, scalar);
+    snprintf(label, sizeof(label), "%s, speedup", name);
+    Report(label, ms_scalar / ms_sse, "x");
+}
+
+BENCHMARK(math_kernels)
+{
+    const uint32_t count = 100000;
+    RandomMath random;
+    vector<Matrix> matrices(count);
+    vector<Quaternion> rotations(count);
+    vector<Vector3> positions(count);
+    vector<BoundingBox> boxes(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        matrices[i]     = random.Transform();
+        rotations[i]    = random.Rotation();
+        positions[i]    = random.Position();
+        boxes[i]        = BoundingBox(positions[i], positions[i] + Vector3(1.0f, 2.0f, 3.0f));
+    }
+
+    // The results are written out, so that nothing gets optimized away
+    vector<Matrix> matrices_out(count);
+    vector<Vector3> positions_out(count);
+    vector<BoundingBox> boxes_out(count);
+    const Matrix view_projection = Matrix::CreateLookAtLH(Vector3(0.0f, 10.0f, -50.0f), Vector3::Zero, Vector3::Up) * Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 1.777f, 0.3f, 1000.0f);
+
+    math_benchmark("100k matrix multiply", [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            matrices_out[i] = matrices[i] * view_projection;
+        }
+    },
+    [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            matrices_out[i] = multiply_scalar(matrices[i], view_projection);
+        }
+    });
+
+    math_benchmark("100k matrix inverse", [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            matrices_out[i] = matrices[i].Inverted();
+        }
+    },
+    [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            matrices_out[i] = invert_scalar(matrices[i]);
+        }
+    });
+
+    math_benchmark("100k vector transform", [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions_out[i] = matrices[i] * positions[i];
+        }
+    },
+    [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions_out[i] = transform_scalar(matrices[i], positions[i]);
+        }
+    });
+
+    math_benchmark("100k quaternion rotate", [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions_out[i] = rotations[i] * positions[i];
+        }
+    },
+    [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            positions_out[i] = rotate_scalar(rotations[i], positions[i]);
+        }
+    });
+
+    math_benchmark("100k bounding box transform", [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            boxes_out[i] = boxes[i].Transform(matrices[i]);
+        }
+    },
+    [&]()
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            boxes_out[i] = transform_scalar(boxes[i], matrices[i]);
+        }
+    });
+}
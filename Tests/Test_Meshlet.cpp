@@ -0,0 +1,201 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include <vector>
+#include "Test.h"
+#include "Math/Frustum.h"
+#include "RHI/RHI_Vertex.h"
+#include "Rendering/Meshlet.h"
+#include "Rendering/VertexQuantizer.h"
+//================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+static Vector3 position(const RHI_Vertex_PosTexNorTan& vertex)
+{
+    return Vector3(vertex.pos[0], vertex.pos[1], vertex.pos[2]);
+}
+
+// A sphere at the origin, its triangles face outwards
+static void create_sphere(const float radius, const uint32_t rings, const uint32_t segments, vector<RHI_Vertex_PosTexNorTan>* vertices, vector<uint32_t>* indices)
+{
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        const float phi = Helper::PI * ring / rings;
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            const float theta       = 2.0f * Helper::PI * segment / segments;
+            const Vector3 normal    = Vector3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta));
+            vertices->emplace_back(normal * radius, Vector2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings), normal, Vector3(-sinf(theta), 0.0f, cosf(theta)));
+        }
+    }
+
+    const auto add_triangle = [&vertices, &indices](const uint32_t a, const uint32_t b, const uint32_t c)
+    {
+        const Vector3 pa = position((*vertices)[a]), pb = position((*vertices)[b]), pc = position((*vertices)[c]);
+        const Vector3 normal = Vector3::Cross(pb - pa, pc - pa);
+        if (normal.LengthSquared() == 0.0f)
+            return;
+
+        if (Vector3::Dot(normal, pa + pb + pc) > 0.0f)
+        {
+            indices->insert(indices->end(), { a, b, c });
+        }
+        else
+        {
+            indices->insert(indices->end(), { a, c, b });
+        }
+    };
+
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            const uint32_t i = ring * (segments + 1) + segment;
+            add_triangle(i, i + segments + 1, i + 1);
+            add_triangle(i + 1, i + segments + 1, i + segments + 2);
+        }
+    }
+}
+
+// Same as the renderer's cluster culling of a renderable, returns how many indices survive
+static uint32_t cluster_cull(const vector<Meshlet>& meshlets, const Frustum& frustum, const Vector3& view_position)
+{
+    uint32_t index_count = 0;
+    for (const Meshlet& meshlet : meshlets)
+    {
+        if (meshlet.IsBackFacing(view_position) || !frustum.IsVisible(meshlet.center, meshlet.radius))
+            continue;
+
+        index_count += meshlet.index_count;
+    }
+
+    return index_count;
+}
+
+TEST(meshlet_bounds_are_conservative)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+    create_sphere(10.0f, 64, 128, &vertices, &indices);
+
+    VertexQuantizer quantizer;
+    CHECK(quantizer.Fit(vertices, indices));
+    vector<RHI_Vertex_PosTexNorTanQuantized> vertices_quantized(vertices.size());
+    vector<RHI_Vertex_PosTexNorTan> vertices_dequantized(vertices.size());
+    quantizer.Quantize(vertices.data(), static_cast<uint32_t>(vertices.size()), vertices_quantized.data());
+    quantizer.Dequantize(vertices_quantized.data(), static_cast<uint32_t>(vertices.size()), vertices_dequantized.data());
+
+    vector<Meshlet> meshlets;
+    MeshletBuilder::Build(indices.data(), static_cast<uint32_t>(indices.size()), 0, vertices.data(), quantizer.GetPositionError(), &meshlets);
+    CHECK(meshlets.size() > 1);
+
+    // They cover the indices in order and hold what mesh shader hardware can
+    uint32_t index_offset = 0;
+    for (const Meshlet& meshlet : meshlets)
+    {
+        CHECK(meshlet.index_offset == index_offset);
+        CHECK(meshlet.index_count % 3 == 0 && meshlet.index_count / 3 <= m_meshlet_triangles_max);
+        index_offset += meshlet.index_count;
+
+        vector<uint32_t> meshlet_vertices(indices.begin() + meshlet.index_offset, indices.begin() + meshlet.index_offset + meshlet.index_count);
+        sort(meshlet_vertices.begin(), meshlet_vertices.end());
+        CHECK(unique(meshlet_vertices.begin(), meshlet_vertices.end()) - meshlet_vertices.begin() <= m_meshlet_vertices_max);
+
+        // The spheres contain the quantized positions the GPU draws, not just the original ones
+        for (uint32_t i = meshlet.index_offset; i < meshlet.index_offset + meshlet.index_count; i++)
+        {
+            CHECK(Vector3::Distance(meshlet.center, position(vertices[indices[i]])) <= meshlet.radius);
+            CHECK(Vector3::Distance(meshlet.center, position(vertices_dequantized[indices[i]])) <= meshlet.radius);
+        }
+    }
+    CHECK(index_offset == indices.size());
+
+    // A back facing meshlet has no triangle that faces the viewer, from outside and from inside of the sphere
+    const Vector3 view_positions[] = { Vector3(0.0f, 0.0f, -30.0f), Vector3(25.0f, 8.0f, 3.0f), Vector3(0.0f, 10.5f, 0.0f), Vector3(0.0f, 2.0f, 1.0f) };
+    for (const Vector3& view_position : view_positions)
+    {
+        uint32_t back_facing = 0;
+        for (const Meshlet& meshlet : meshlets)
+        {
+            if (!meshlet.IsBackFacing(view_position))
+                continue;
+
+            back_facing++;
+            for (uint32_t i = meshlet.index_offset; i < meshlet.index_offset + meshlet.index_count; i += 3)
+            {
+                const Vector3 a = position(vertices[indices[i]]), b = position(vertices[indices[i + 1]]), c = position(vertices[indices[i + 2]]);
+                CHECK(Vector3::Dot(Vector3::Cross(b - a, c - a), a - view_position) >= 0.0f);
+            }
+        }
+
+        // Outside, a good part of the far side is rejected
+        if (view_position.Length() > 10.0f)
+        {
+            CHECK(back_facing > meshlets.size() / 4);
+        }
+    }
+}
+
+BENCHMARK(meshlet_cluster_culling)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+    create_sphere(10.0f, 512, 1024, &vertices, &indices);
+
+    vector<Meshlet> meshlets;
+    Measure("build, 1M triangles", 5, [&]()
+    {
+        meshlets.clear();
+        MeshletBuilder::Build(indices.data(), static_cast<uint32_t>(indices.size()), 0, vertices.data(), 0.0f, &meshlets);
+    });
+    Report("meshlets", static_cast<double>(meshlets.size()), "");
+
+    // Looking at the sphere from far away, where only the far side is rejected, and from up close, where most of it is outside the view
+    const float near_plane  = 0.3f;
+    const float far_plane   = 1000.0f;
+    const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.0f, 16.0f / 9.0f, near_plane, far_plane);
+    const struct { const char* name; Vector3 position; } views[] =
+    {
+        { "far",    Vector3(0.0f, 0.0f, -40.0f) },
+        { "close",  Vector3(0.0f, 0.0f, -11.0f) }
+    };
+
+    for (const auto& view : views)
+    {
+        const Frustum frustum = Frustum(Matrix::CreateLookAtLH(view.position, Vector3::Zero, Vector3::Up), projection, far_plane);
+
+        uint32_t index_count = 0;
+        const string name = string("cull, ") + view.name;
+        Measure(name.c_str(), 100, [&]()
+        {
+            index_count = cluster_cull(meshlets, frustum, view.position);
+        });
+        Report((string("triangles culled, ") + view.name).c_str(), 100.0 * (indices.size() - index_count) / indices.size(), "%");
+    }
+}
@@ -0,0 +1,390 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===========================
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "Test.h"
+#include "Resource/Import/MipGenerator.h"
+//======================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+static vector<std::byte> create_image(const uint32_t width, const uint32_t height)
+{
+    vector<std::byte> image(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 1;
+    for (std::byte& value : image)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        value = std::byte(static_cast<uint8_t>(seed >> 24));
+    }
+    return image;
+}
+
+static uint8_t channel(const vector<vector<std::byte>>& mips, const uint32_t mip, const uint32_t c)
+{
+    return static_cast<uint8_t>(mips[mip][c]);
+}
+
+// What the importer did before MipGenerator, FreeImage_Rescale() with FILTER_LANCZOS3 from the full image, once per mip.
+// Separable, horizontally into floats and then vertically, with the weights of every output column and row computed up front.
+namespace lanczos
+{
+    struct Weights
+    {
+        vector<uint32_t> first; // the first source pixel of every output pixel
+        vector<uint32_t> count;
+        vector<float> values;   // count weights per output pixel, at first * max_count
+        uint32_t max_count = 0;
+    };
+
+    static float lanczos3(const float x)
+    {
+        const float pi = 3.14159265f;
+        if (x == 0.0f)
+            return 1.0f;
+        if (fabsf(x) >= 3.0f)
+            return 0.0f;
+        return 3.0f * sinf(pi * x) * sinf(pi * x / 3.0f) / (pi * pi * x * x);
+    }
+
+    static Weights weights_compute(const uint32_t size_source, const uint32_t size)
+    {
+        // Downscaling stretches the filter over the source, so every output pixel covers the same source area
+        const float scale   = static_cast<float>(size_source) / size;
+        const float support = 3.0f * scale;
+
+        Weights weights;
+        weights.max_count = static_cast<uint32_t>(ceilf(2.0f * support)) + 1;
+        weights.first.resize(size);
+        weights.count.resize(size);
+        weights.values.resize(static_cast<size_t>(size) * weights.max_count);
+
+        for (uint32_t i = 0; i < size; i++)
+        {
+            const float center      = (i + 0.5f) * scale;
+            const int32_t first     = max(static_cast<int32_t>(floorf(center - support)), 0);
+            const int32_t last      = min(static_cast<int32_t>(ceilf(center + support)), static_cast<int32_t>(size_source) - 1);
+            const uint32_t count    = min(static_cast<uint32_t>(last - first + 1), weights.max_count);
+            float* values           = &weights.values[static_cast<size_t>(i) * weights.max_count];
+
+            float sum = 0.0f;
+            for (uint32_t j = 0; j < count; j++)
+            {
+                values[j]   = lanczos3((first + j + 0.5f - center) / scale);
+                sum         += values[j];
+            }
+            for (uint32_t j = 0; j < count; j++)
+            {
+                values[j] /= sum;
+            }
+
+            weights.first[i] = static_cast<uint32_t>(first);
+            weights.count[i] = count;
+        }
+
+        return weights;
+    }
+
+    static void rescale(const vector<std::byte>& source, const uint32_t width_source, const uint32_t height_source, vector<std::byte>* destination, const uint32_t width, const uint32_t height)
+    {
+        const Weights weights_x = weights_compute(width_source, width);
+        const Weights weights_y = weights_compute(height_source, height);
+
+        vector<float> rows(static_cast<size_t>(height_source) * width * 4);
+        for (uint32_t y = 0; y < height_source; y++)
+        {
+            const std::byte* row_source = &source[static_cast<size_t>(y) * width_source * 4];
+            float* row                  = &rows[static_cast<size_t>(y) * width * 4];
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const float* values = &weights_x.values[static_cast<size_t>(x) * weights_x.max_count];
+                float sum[4]        = {};
+                for (uint32_t j = 0; j < weights_x.count[x]; j++)
+                {
+                    const std::byte* pixel = row_source + (weights_x.first[x] + j) * 4;
+                    for (uint32_t c = 0; c < 4; c++)
+                    {
+                        sum[c] += values[j] * static_cast<float>(pixel[c]);
+                    }
+                }
+                memcpy(row + x * 4, sum, sizeof(sum));
+            }
+        }
+
+        destination->resize(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const float* values = &weights_y.values[static_cast<size_t>(y) * weights_y.max_count];
+            for (uint32_t x = 0; x < width * 4; x++)
+            {
+                float sum = 0.0f;
+                for (uint32_t j = 0; j < weights_y.count[y]; j++)
+                {
+                    sum += values[j] * rows[static_cast<size_t>(weights_y.first[y] + j) * width * 4 + x];
+                }
+                (*destination)[static_cast<size_t>(y) * width * 4 + x] = std::byte(static_cast<uint8_t>(min(max(sum + 0.5f, 0.0f), 255.0f)));
+            }
+        }
+    }
+
+    // One task per mip, like the importer, the largest mip bounds how fast the chain can be
+    static void generate(const vector<std::byte>& image, uint32_t width, uint32_t height, vector<vector<std::byte>>* mips)
+    {
+        const uint32_t width_source     = width;
+        const uint32_t height_source    = height;
+        while (width > 1 && height > 1)
+        {
+            width   = max(width / 2, 1u);
+            height  = max(height / 2, 1u);
+            mips->emplace_back();
+        }
+
+        TaskCounter counter;
+        for (uint32_t i = 1; i < static_cast<uint32_t>(mips->size()); i++)
+        {
+            GetThreading()->AddTask([&image, width_source, height_source, mips, i]()
+            {
+                rescale(image, width_source, height_source, &(*mips)[i], max(width_source >> i, 1u), max(height_source >> i, 1u));
+            }, &counter);
+        }
+        GetThreading()->Wait(counter);
+    }
+}
+
+TEST(mip_generator_modes)
+{
+    // Black and white pixels, with a black and white alpha
+    const vector<std::byte> checker =
+    {
+        std::byte(0),   std::byte(0),   std::byte(0),   std::byte(0),   std::byte(255), std::byte(255), std::byte(255), std::byte(255),
+        std::byte(255), std::byte(255), std::byte(255), std::byte(255), std::byte(0),   std::byte(0),   std::byte(0),   std::byte(0)
+    };
+
+    // Data (e.g. masks) averages to the middle
+    vector<vector<std::byte>> mips = { checker };
+    CHECK(MipGenerator::Generate(nullptr, &mips, 2, 2, 4, 1, MipGenerator_Linear));
+    CHECK(mips.size() == 2 && mips[1].size() == 4);
+    CHECK(channel(mips, 1, 0) >= 127 && channel(mips, 1, 0) <= 128);
+
+    // Color averages to the middle in linear space, which is brighter in sRGB, alpha is linear in both
+    mips = { checker };
+    CHECK(MipGenerator::Generate(nullptr, &mips, 2, 2, 4, 1, MipGenerator_Srgb));
+    CHECK(channel(mips, 1, 0) >= 186 && channel(mips, 1, 0) <= 189);
+    CHECK(channel(mips, 1, 3) >= 127 && channel(mips, 1, 3) <= 128);
+
+    // Normals stay unit length
+    const vector<std::byte> normals =
+    {
+        std::byte(255), std::byte(128), std::byte(128), std::byte(255), std::byte(128), std::byte(255), std::byte(128), std::byte(255),
+        std::byte(255), std::byte(128), std::byte(128), std::byte(255), std::byte(128), std::byte(255), std::byte(128), std::byte(255)
+    };
+    mips = { normals };
+    CHECK(MipGenerator::Generate(nullptr, &mips, 2, 2, 4, 1, MipGenerator_Normal));
+    float length_squared = 0.0f;
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        const float value = channel(mips, 1, c) / 255.0f * 2.0f - 1.0f;
+        length_squared += value * value;
+    }
+    CHECK(fabsf(sqrtf(length_squared) - 1.0f) < 0.02f);
+}
+
+TEST(mip_generator_threaded_matches_serial)
+{
+    const MipGenerator_Mode modes[] = { MipGenerator_Linear, MipGenerator_Srgb, MipGenerator_Normal };
+    for (const MipGenerator_Mode mode : modes)
+    {
+        vector<vector<std::byte>> mips          = { create_image(256, 128) };
+        vector<vector<std::byte>> mips_threaded = mips;
+        CHECK(MipGenerator::Generate(nullptr, &mips, 256, 128, 4, 1, mode));
+        CHECK(MipGenerator::Generate(GetThreading(), &mips_threaded, 256, 128, 4, 1, mode));
+        CHECK(mips.size() == 8);
+        CHECK(mips == mips_threaded);
+    }
+}
+
+// The footprint of every mip pixel in the level above, 2x2 or 3 wide (or tall) on the last column (or row) of odd sizes
+static vector<float> downsample_reference(const vector<float>& source, const uint32_t width, const uint32_t height, const uint32_t channel_count)
+{
+    const uint32_t width_mip    = width / 2;
+    const uint32_t height_mip   = height / 2;
+    vector<float> mip(static_cast<size_t>(width_mip) * height_mip * channel_count);
+    for (uint32_t y = 0; y < height_mip; y++)
+    {
+        const uint32_t y_count = (y + 1 == height_mip && height % 2 != 0) ? 3 : 2;
+        for (uint32_t x = 0; x < width_mip; x++)
+        {
+            const uint32_t x_count = (x + 1 == width_mip && width % 2 != 0) ? 3 : 2;
+            for (uint32_t c = 0; c < channel_count; c++)
+            {
+                float sum = 0.0f;
+                for (uint32_t j = 0; j < y_count; j++)
+                {
+                    for (uint32_t i = 0; i < x_count; i++)
+                    {
+                        sum += source[((2 * y + j) * width + 2 * x + i) * channel_count + c];
+                    }
+                }
+                mip[(y * width_mip + x) * channel_count + c] = sum / (x_count * y_count);
+            }
+        }
+    }
+    return mip;
+}
+
+TEST(mip_generator_odd_sizes)
+{
+    const auto to_floats = [](const vector<std::byte>& mip, const uint32_t bytes_per_channel)
+    {
+        vector<float> values(mip.size() / bytes_per_channel);
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            if (bytes_per_channel == 1)
+            {
+                values[i] = static_cast<float>(mip[i]);
+            }
+            else
+            {
+                memcpy(&values[i], mip.data() + i * sizeof(float), sizeof(float));
+            }
+        }
+        return values;
+    };
+
+    // Odd at every level until the chain ends, so the last row and column always have to be taken in
+    for (const uint32_t channel_count : { 4u, 1u })
+    {
+        for (const uint32_t bytes_per_channel : { 1u, 4u })
+        {
+            uint32_t width  = 23;
+            uint32_t height = 11;
+
+            vector<std::byte> image = create_image(width, height);
+            image.resize(static_cast<size_t>(width) * height * channel_count);
+            vector<vector<std::byte>> mips = { image };
+            if (bytes_per_channel == 4)
+            {
+                mips[0].resize(image.size() * sizeof(float));
+                for (size_t i = 0; i < image.size(); i++)
+                {
+                    const float value = static_cast<float>(image[i]);
+                    memcpy(mips[0].data() + i * sizeof(float), &value, sizeof(float));
+                }
+            }
+
+            CHECK(MipGenerator::Generate(GetThreading(), &mips, width, height, channel_count, bytes_per_channel, MipGenerator_Linear));
+            CHECK(mips.size() == 4); // 23x11, 11x5, 5x2, 2x1
+
+            // Every level against the footprint of the level it was made from, 8 bit rounds and float is exact up to the order of the additions
+            for (uint32_t mip = 1; mip < static_cast<uint32_t>(mips.size()); mip++)
+            {
+                const vector<float> expected    = downsample_reference(to_floats(mips[mip - 1], bytes_per_channel), width, height, channel_count);
+                const vector<float> actual      = to_floats(mips[mip], bytes_per_channel);
+                const float tolerance           = bytes_per_channel == 1 ? 0.51f : 0.001f;
+
+                CHECK(actual.size() == expected.size());
+                bool matches = actual.size() == expected.size();
+                for (size_t i = 0; matches && i < expected.size(); i++)
+                {
+                    matches = fabsf(actual[i] - expected[i]) <= tolerance;
+                }
+                CHECK(matches);
+
+                width   /= 2;
+                height  /= 2;
+            }
+        }
+    }
+}
+
+BENCHMARK(mip_generator_chain)
+{
+    const uint32_t size                 = 2048;
+    const vector<std::byte> image       = create_image(size, size);
+    const vector<std::byte> image_float(image.size() * 4);
+
+    Measure("2048x2048 rgba8 linear, serial", 5, [&image]()
+    {
+        vector<vector<std::byte>> mips = { image };
+        MipGenerator::Generate(nullptr, &mips, size, size, 4, 1, MipGenerator_Linear);
+    });
+
+    Measure("2048x2048 rgba8 linear", 5, [&image]()
+    {
+        vector<vector<std::byte>> mips = { image };
+        MipGenerator::Generate(GetThreading(), &mips, size, size, 4, 1, MipGenerator_Linear);
+    });
+
+    Measure("2048x2048 rgba8 srgb", 5, [&image]()
+    {
+        vector<vector<std::byte>> mips = { image };
+        MipGenerator::Generate(GetThreading(), &mips, size, size, 4, 1, MipGenerator_Srgb);
+    });
+
+    Measure("2048x2048 rgba8 normal", 5, [&image]()
+    {
+        vector<vector<std::byte>> mips = { image };
+        MipGenerator::Generate(GetThreading(), &mips, size, size, 4, 1, MipGenerator_Normal);
+    });
+
+    Measure("2048x2048 rgba32 float", 5, [&image_float]()
+    {
+        vector<vector<std::byte>> mips = { image_float };
+        MipGenerator::Generate(GetThreading(), &mips, size, size, 4, 4, MipGenerator_Linear);
+    });
+}
+
+BENCHMARK(mip_generator_lanczos)
+{
+    // The box filter from the previous mip against the Lanczos filter from the full image, which is what the importer used to do
+    for (const uint32_t size : { 1024u, 2048u, 4096u, 8192u })
+    {
+        const vector<std::byte> image   = create_image(size, size);
+        const uint32_t iterations       = size >= 4096 ? 1 : 3;
+        char name[64];
+
+        snprintf(name, sizeof(name), "%ux%u rgba8, box", size, size);
+        const double ms_box = Measure(name, iterations, [&image, size]()
+        {
+            vector<vector<std::byte>> mips = { image };
+            MipGenerator::Generate(GetThreading(), &mips, size, size, 4, 1, MipGenerator_Linear);
+        });
+
+        snprintf(name, sizeof(name), "%ux%u rgba8, lanczos from the full image", size, size);
+        const double ms_lanczos = Measure(name, iterations, [&image, size]()
+        {
+            vector<vector<std::byte>> mips = { image };
+            lanczos::generate(image, size, size, &mips);
+        });
+
+        Report("speedup", ms_lanczos / ms_box, "x");
+    }
+}
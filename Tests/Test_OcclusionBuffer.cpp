@@ -0,0 +1,91 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ======================
+#include "Test.h"
+#include "Rendering/OcclusionBuffer.h"
+#include "RHI/RHI_Vertex.h"
+//=================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+// A camera at the origin looking down +z, in front of a wall at z = 10 which covers the center of the view
+static void occlusion_buffer_check(const bool reverse_z)
+{
+    const float near_plane  = 0.3f;
+    const float far_plane   = 1000.0f;
+    const Matrix view       = Matrix::CreateLookAtLH(Vector3::Zero, Vector3::Forward, Vector3::Up);
+    const Matrix projection = Matrix::CreatePerspectiveFieldOfViewLH(1.5f, 2.0f, reverse_z ? far_plane : near_plane, reverse_z ? near_plane : far_plane);
+    const Matrix view_projection = view * projection;
+
+    const RHI_Vertex_PosTexNorTan wall[4] =
+    {
+        RHI_Vertex_PosTexNorTan(Vector3(-4.0f, -4.0f, 10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3( 4.0f, -4.0f, 10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3( 4.0f,  4.0f, 10.0f), Vector2::Zero),
+        RHI_Vertex_PosTexNorTan(Vector3(-4.0f,  4.0f, 10.0f), Vector2::Zero)
+    };
+    const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    OcclusionBuffer buffer;
+    buffer.Clear(256, 128, reverse_z);
+
+    // Nothing is hidden by an empty buffer
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(-0.5f, -0.5f, 20.0f), Vector3(0.5f, 0.5f, 21.0f)), view_projection));
+
+    buffer.RasterizeOccluder(wall, 4, indices, 6, view_projection);
+
+    // Behind the wall
+    CHECK(!buffer.IsVisible(BoundingBox(Vector3(-0.5f, -0.5f, 20.0f), Vector3(0.5f, 0.5f, 21.0f)), view_projection));
+    CHECK(!buffer.IsVisible(BoundingBox(Vector3(-2.0f, -2.0f, 12.0f), Vector3(2.0f, 2.0f, 14.0f)), view_projection));
+
+    // In front of the wall, poking through it, or behind it but outside of its silhouette
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(-0.5f, -0.5f, 5.0f), Vector3(0.5f, 0.5f, 6.0f)), view_projection));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(-0.5f, -0.5f, 9.0f), Vector3(0.5f, 0.5f, 11.0f)), view_projection));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(10.0f, -0.5f, 20.0f), Vector3(11.0f, 0.5f, 21.0f)), view_projection));
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(3.0f, -0.5f, 20.0f), Vector3(9.0f, 0.5f, 21.0f)), view_projection));
+
+    // Boxes around the camera are always visible
+    CHECK(buffer.IsVisible(BoundingBox(Vector3(-1.0f), Vector3(1.0f)), view_projection));
+    CHECK(buffer.GetScreenCoverage(BoundingBox(Vector3(-1.0f), Vector3(1.0f)), view_projection) == 1.0f);
+
+    // The wall covers a good part of the view, a box far away barely any
+    const float coverage_wall = buffer.GetScreenCoverage(BoundingBox(Vector3(-4.0f, -4.0f, 10.0f), Vector3(4.0f, 4.0f, 10.1f)), view_projection);
+    const float coverage_far  = buffer.GetScreenCoverage(BoundingBox(Vector3(-0.5f, -0.5f, 500.0f), Vector3(0.5f, 0.5f, 501.0f)), view_projection);
+    CHECK(coverage_wall > 0.05f && coverage_wall < 0.2f);
+    CHECK(coverage_far < 0.001f);
+}
+
+TEST(occlusion_buffer_hides_boxes_behind_occluders)
+{
+    occlusion_buffer_check(false);
+}
+
+TEST(occlusion_buffer_hides_boxes_behind_occluders_reverse_z)
+{
+    occlusion_buffer_check(true);
+}
@@ -0,0 +1,249 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========================
+#include <vector>
+#include "Test.h"
+#include "Rendering/ShadowAtlas.h"
+#include "World/World.h"
+#include "World/Entity.h"
+//====================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+static ShadowAtlasRequest request(const uint32_t light_id, const uint32_t view_count, const float size)
+{
+    ShadowAtlasRequest request;
+    request.light_id    = light_id;
+    request.view_count  = view_count;
+    request.size        = size;
+    return request;
+}
+
+// Whether the tiles of the given lights are inside of the atlas and don't overlap, returns how many there are
+static uint32_t check_tiles(ShadowAtlas& atlas, const uint32_t light_count)
+{
+    vector<ShadowAtlasTile> tiles;
+    for (uint32_t light_id = 0; light_id < light_count; light_id++)
+    {
+        const ShadowAtlasLight* light = atlas.GetLight(light_id);
+        if (!light)
+            continue;
+
+        for (uint32_t i = 0; i < light->view_count; i++)
+        {
+            const ShadowAtlasTile& tile = light->views[i].tile;
+            CHECK(tile.IsValid() == (light->tile_size != 0));
+            if (!tile.IsValid())
+                continue;
+
+            CHECK(tile.size == light->tile_size);
+            CHECK(tile.x + tile.size <= atlas.GetResolution() && tile.y + tile.size <= atlas.GetResolution());
+            for (const ShadowAtlasTile& other : tiles)
+            {
+                const bool apart = tile.x + tile.size <= other.x || other.x + other.size <= tile.x || tile.y + tile.size <= other.y || other.y + other.size <= tile.y;
+                CHECK(apart);
+            }
+            tiles.emplace_back(tile);
+        }
+    }
+
+    return static_cast<uint32_t>(tiles.size());
+}
+
+TEST(shadow_atlas_allocates_frees_and_merges)
+{
+    ShadowAtlas atlas;
+    atlas.SetResolution(4096, 1024);
+    CHECK(atlas.GetTileSizeMax() == 1024);
+
+    // Spot lights fill the atlas with the largest tiles
+    vector<ShadowAtlasRequest> requests;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        requests.emplace_back(request(i, 1, 1024.0f));
+    }
+    atlas.Allocate(requests, 1);
+    CHECK(check_tiles(atlas, 16) == 16);
+    CHECK(atlas.GetOccupancy() == 1.0f);
+
+    // Lights which are no longer requested free their tiles
+    requests.resize(8);
+    atlas.Allocate(requests, 2);
+    CHECK(atlas.GetLight(12) == nullptr);
+    CHECK(check_tiles(atlas, 16) == 8);
+    CHECK(atlas.GetOccupancy() == 0.5f);
+
+    // The smallest tiles split the free ones down to their size, once they are freed the quadrants merge back,
+    // so that the largest tiles fit again
+    requests.clear();
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        requests.emplace_back(request(100 + i, 4, 256.0f));
+    }
+    atlas.Allocate(requests, 3);
+    CHECK(check_tiles(atlas, 200) == 256);
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        CHECK(atlas.GetLight(100 + i)->tile_size == 256);
+    }
+
+    requests.clear();
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        requests.emplace_back(request(200 + i, 1, 1024.0f));
+    }
+    atlas.Allocate(requests, 4);
+    CHECK(check_tiles(atlas, 216) == 16);
+    CHECK(atlas.GetOccupancy() == 1.0f);
+
+    // Lights keep their tiles (and what's cached in them) while their size changes a little
+    const ShadowAtlasTile tile = atlas.GetLight(200)->views[0].tile;
+    requests[0].size = 900.0f;
+    atlas.Allocate(requests, 5);
+    CHECK(atlas.GetLight(200)->views[0].tile.x == tile.x && atlas.GetLight(200)->views[0].tile.y == tile.y);
+}
+
+TEST(shadow_atlas_full)
+{
+    ShadowAtlas atlas;
+    atlas.SetResolution(1024, 256);
+
+    // The largest lights get the tiles, the rest go without shadows
+    vector<ShadowAtlasRequest> requests;
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        requests.emplace_back(request(i, 1, 200.0f + i * 10.0f));
+    }
+    atlas.Allocate(requests, 1);
+    CHECK(check_tiles(atlas, 20) == 16);
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        CHECK(atlas.GetLight(i)->tile_size == (i >= 4 ? 256u : 0u));
+        CHECK(!atlas.GetLight(i)->views[0].tile.IsValid() == (i < 4));
+    }
+
+    // A light which doesn't fit with the tiles it asks for falls back to smaller ones
+    requests.clear();
+    for (uint32_t i = 0; i < 15; i++)
+    {
+        requests.emplace_back(request(i, 1, 256.0f));
+    }
+    requests.emplace_back(request(100, 4, 250.0f));
+    atlas.Allocate(requests, 2);
+    CHECK(atlas.GetLight(100)->tile_size == 128);
+    CHECK(check_tiles(atlas, 101) == 19);
+    CHECK(atlas.GetOccupancy() == 1.0f);
+
+    // A point light which needs more than what's left gets nothing, and doesn't keep any partial tiles
+    requests.emplace_back(request(101, 6, 128.0f));
+    atlas.Allocate(requests, 3);
+    CHECK(atlas.GetLight(101)->tile_size == 0);
+    CHECK(check_tiles(atlas, 102) == 19);
+}
+
+TEST(shadow_atlas_static_signature)
+{
+    Context context;
+    context.RegisterSubsystem<World>();
+    World* world = context.GetSubsystem<World>();
+
+    vector<FrameRenderable> renderables(3);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        renderables[i].entity = world->EntityCreate().get();
+        renderables[i].matrix = Matrix::CreateTranslation(Vector3(static_cast<float>(i), 0.0f, 10.0f));
+    }
+
+    FrameDrawList draw_list;
+    for (const FrameRenderable& renderable : renderables)
+    {
+        draw_list.draw_calls.emplace_back().renderable = &renderable;
+    }
+
+    ShadowAtlas atlas;
+    ShadowAtlasView view;
+    const Matrix view_projection = Matrix::CreatePerspectiveFieldOfViewLH(1.5f, 1.0f, 0.3f, 100.0f);
+
+    // Casters which were just added are dynamic, the static depth is rendered once (empty) and the dynamic casters every frame
+    uint64_t frame = 1;
+    atlas.UpdateCasters(renderables, frame);
+    CHECK(atlas.IsCasterDynamic(&renderables[0], renderables));
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(view.render_static && view.render_dynamic);
+
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(!view.render_static && view.render_dynamic);
+
+    // Once they stop moving they become static, which changes the signature
+    for (; frame <= m_shadow_caster_static_frames + 1; frame++)
+    {
+        atlas.UpdateCasters(renderables, frame);
+    }
+    CHECK(!atlas.IsCasterDynamic(&renderables[0], renderables));
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(view.render_static);
+
+    // Nothing changed, nothing is rendered
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(!view.render_static && !view.render_dynamic);
+
+    // Transparent casters are drawn on top, so they have to be cleared the frame after too
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, true);
+    CHECK(!view.render_static && view.render_dynamic);
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(!view.render_static && view.render_dynamic);
+
+    // A static caster which moves becomes dynamic, and takes itself out of the static depth
+    renderables[1].matrix = Matrix::CreateTranslation(Vector3(1.0f, 1.0f, 10.0f));
+    atlas.UpdateCasters(renderables, ++frame);
+    CHECK(atlas.IsCasterDynamic(&renderables[1], renderables));
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(view.render_static && view.render_dynamic);
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(!view.render_static && view.render_dynamic);
+
+    // So does a static caster which leaves the view, the order of the draw calls doesn't matter
+    swap(draw_list.draw_calls[0], draw_list.draw_calls[2]);
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(!view.render_static);
+    draw_list.draw_calls.pop_back();
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection, draw_list, renderables, false);
+    CHECK(view.render_static);
+
+    // And the light moving
+    atlas.UpdateCasters(renderables, ++frame);
+    atlas.UpdateView(view, view_projection * Matrix::CreateTranslation(Vector3(0.0f, 0.0f, 1.0f)), draw_list, renderables, false);
+    CHECK(view.render_static);
+}
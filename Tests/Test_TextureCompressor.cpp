@@ -0,0 +1,315 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ==================================
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Test.h"
+#include "Resource/Import/TextureCompressor.h"
+//=============================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+// Reference decoders, written from the format specifications rather than from the encoder
+
+static void decode_565(const uint16_t color, uint32_t* rgb)
+{
+    const uint32_t r = (color >> 11) & 31;
+    const uint32_t g = (color >> 5) & 63;
+    const uint32_t b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Writes the rgb of 16 RGBA pixels
+static void decode_bc1(const uint8_t* block, uint8_t* pixels)
+{
+    uint16_t color_0, color_1;
+    uint32_t index_bits;
+    memcpy(&color_0, block + 0, 2);
+    memcpy(&color_1, block + 2, 2);
+    memcpy(&index_bits, block + 4, 4);
+
+    uint32_t palette[4][3];
+    decode_565(color_0, palette[0]);
+    decode_565(color_1, palette[1]);
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        if (color_0 > color_1)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        const uint32_t index = (index_bits >> (2 * i)) & 3;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            pixels[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+        }
+    }
+}
+
+// Writes one channel of 16 RGBA pixels
+static void decode_bc4(const uint8_t* block, uint8_t* pixels, const uint32_t channel)
+{
+    const uint32_t value_0 = block[0];
+    const uint32_t value_1 = block[1];
+
+    uint32_t palette[8] = { value_0, value_1 };
+    for (uint32_t p = 2; p < 8; p++)
+    {
+        if (value_0 > value_1)
+        {
+            palette[p] = ((8 - p) * value_0 + (p - 1) * value_1 + 3) / 7;
+        }
+        else
+        {
+            palette[p] = p < 6 ? ((6 - p) * value_0 + (p - 1) * value_1 + 2) / 5 : (p == 6 ? 0 : 255);
+        }
+    }
+
+    uint64_t index_bits = 0;
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        index_bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        pixels[i * 4 + channel] = static_cast<uint8_t>(palette[(index_bits >> (3 * i)) & 7]);
+    }
+}
+
+static uint32_t read_bits(const uint8_t* block, uint32_t* position, const uint32_t bit_count)
+{
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < bit_count; i++, (*position)++)
+    {
+        value |= ((block[*position >> 3] >> (*position & 7)) & 1) << i;
+    }
+    return value;
+}
+
+// Only mode 6 is decoded, returns false for any other mode
+static bool decode_bc7(const uint8_t* block, uint8_t* pixels)
+{
+    static const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    uint32_t position = 0;
+    if (read_bits(block, &position, 7) != (1 << 6))
+        return false;
+
+    uint32_t endpoints[2][4];
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = read_bits(block, &position, 7);
+        endpoints[1][c] = read_bits(block, &position, 7);
+    }
+
+    const uint32_t p_bit_0 = read_bits(block, &position, 1);
+    const uint32_t p_bit_1 = read_bits(block, &position, 1);
+    for (uint32_t c = 0; c < 4; c++)
+    {
+        endpoints[0][c] = (endpoints[0][c] << 1) | p_bit_0;
+        endpoints[1][c] = (endpoints[1][c] << 1) | p_bit_1;
+    }
+
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        const uint32_t weight = weights[read_bits(block, &position, i == 0 ? 3 : 4)];
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            pixels[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+        }
+    }
+
+    return true;
+}
+
+static bool decode_block(const uint8_t* block, const RHI_Format format, uint8_t* pixels)
+{
+    switch (format)
+    {
+        case RHI_Format_BC1_Unorm: decode_bc1(block, pixels); return true;
+        case RHI_Format_BC3_Unorm: decode_bc4(block, pixels, 3); decode_bc1(block + 8, pixels); return true;
+        case RHI_Format_BC4_Unorm: decode_bc4(block, pixels, 0); return true;
+        case RHI_Format_BC5_Unorm: decode_bc4(block, pixels, 0); decode_bc4(block + 8, pixels, 1); return true;
+        case RHI_Format_BC7_Unorm: return decode_bc7(block, pixels);
+        default: return false;
+    }
+}
+
+// An image with smooth gradients, noise and hard edges, like the textures of a material
+static vector<std::byte> create_image(const uint32_t width, const uint32_t height)
+{
+    vector<std::byte> image(static_cast<size_t>(width) * height * 4);
+    uint32_t seed = 1;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const float noise   = static_cast<float>(seed >> 28) - 8.0f;
+            const bool edge     = ((x / 24) + (y / 24)) % 2 == 0;
+            const float bumps   = sinf(x * 0.05f) * cosf(y * 0.07f);
+
+            const float value[4] =
+            {
+                x * 255.0f / width + noise,
+                edge ? 200.0f + noise : 60.0f + noise,
+                127.5f + 127.5f * bumps,
+                y * 255.0f / height
+            };
+
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                image[(static_cast<size_t>(y) * width + x) * 4 + c] = std::byte(static_cast<uint8_t>(value[c] < 0.0f ? 0.0f : (value[c] > 255.0f ? 255.0f : value[c])));
+            }
+        }
+    }
+
+    return image;
+}
+
+// The channels each format stores
+static uint32_t channel_count(const RHI_Format format)
+{
+    switch (format)
+    {
+        case RHI_Format_BC1_Unorm: return 3;
+        case RHI_Format_BC4_Unorm: return 1;
+        case RHI_Format_BC5_Unorm: return 2;
+        default:                   return 4;
+    }
+}
+
+// Compresses and decodes an image, returns the peak signal to noise ratio over the stored channels in dB
+static double compress_psnr(const RHI_Format format, const uint32_t width, const uint32_t height)
+{
+    const vector<std::byte> image = create_image(width, height);
+    vector<vector<std::byte>> mips = { image };
+    if (!TextureCompressor::Compress(nullptr, &mips, width, height, format))
+        return 0.0;
+
+    const uint32_t block_size   = TextureCompressor::GetByteCount(format, 4, 4);
+    const uint32_t channels     = channel_count(format);
+    double error                = 0.0;
+    for (uint32_t block_y = 0; block_y < height / 4; block_y++)
+    {
+        for (uint32_t block_x = 0; block_x < width / 4; block_x++)
+        {
+            uint8_t pixels[16 * 4] = {};
+            if (!decode_block(reinterpret_cast<const uint8_t*>(mips[0].data()) + (block_y * (width / 4) + block_x) * block_size, format, pixels))
+                return 0.0;
+
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                const size_t pixel = (static_cast<size_t>(block_y * 4 + i / 4) * width + block_x * 4 + i % 4) * 4;
+                for (uint32_t c = 0; c < channels; c++)
+                {
+                    const double difference = static_cast<double>(pixels[i * 4 + c]) - static_cast<double>(image[pixel + c]);
+                    error += difference * difference;
+                }
+            }
+        }
+    }
+
+    const double mse = error / (static_cast<double>(width) * height * channels);
+    return mse == 0.0 ? 100.0 : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+TEST(texture_compressor_psnr)
+{
+    const double bc1 = compress_psnr(RHI_Format_BC1_Unorm, 256, 256);
+    const double bc3 = compress_psnr(RHI_Format_BC3_Unorm, 256, 256);
+    const double bc4 = compress_psnr(RHI_Format_BC4_Unorm, 256, 256);
+    const double bc5 = compress_psnr(RHI_Format_BC5_Unorm, 256, 256);
+    const double bc7 = compress_psnr(RHI_Format_BC7_Unorm, 256, 256);
+    Report("BC1 psnr", bc1, "dB");
+    Report("BC3 psnr", bc3, "dB");
+    Report("BC4 psnr", bc4, "dB");
+    Report("BC5 psnr", bc5, "dB");
+    Report("BC7 psnr", bc7, "dB");
+
+    // Below these the encoder (or the block layout) is broken, rather than just lossy
+    CHECK(bc1 > 34.0);
+    CHECK(bc3 > 35.0);
+    CHECK(bc4 > 48.0);
+    CHECK(bc5 > 48.0);
+    CHECK(bc7 > 37.0);
+
+    // BC7 is the high quality option
+    CHECK(bc7 > bc1);
+}
+
+TEST(texture_compressor_threaded_matches_serial)
+{
+    // A full mip chain, the smallest mips are padded to a block
+    const uint32_t size = 64;
+    vector<vector<std::byte>> mips;
+    for (uint32_t mip_size = size; mip_size != 0; mip_size /= 2)
+    {
+        mips.emplace_back(create_image(mip_size, mip_size));
+    }
+
+    vector<vector<std::byte>> mips_threaded = mips;
+    CHECK(TextureCompressor::Compress(nullptr, &mips, size, size, RHI_Format_BC7_Unorm));
+    CHECK(TextureCompressor::Compress(GetThreading(), &mips_threaded, size, size, RHI_Format_BC7_Unorm));
+    CHECK(mips == mips_threaded);
+    CHECK(mips.back().size() == 16);
+
+    // Top mips which aren't made of whole blocks are rejected
+    vector<vector<std::byte>> odd = { create_image(6, 6) };
+    CHECK(!TextureCompressor::Compress(nullptr, &odd, 6, 6, RHI_Format_BC1_Unorm));
+}
+
+BENCHMARK(texture_compressor_throughput)
+{
+    const uint32_t size = 1024;
+    const vector<std::byte> image = create_image(size, size);
+    const double megapixels = size * size / 1000000.0;
+
+    const RHI_Format formats[] = { RHI_Format_BC1_Unorm, RHI_Format_BC3_Unorm, RHI_Format_BC4_Unorm, RHI_Format_BC5_Unorm, RHI_Format_BC7_Unorm };
+    for (const RHI_Format format : formats)
+    {
+        const double ms = Measure(rhi_format_to_string(format), 3, [&image, format]()
+        {
+            vector<vector<std::byte>> mips = { image };
+            TextureCompressor::Compress(GetThreading(), &mips, size, size, format);
+        });
+        Report("megapixels per second", megapixels * 1000.0 / ms, "MP/s");
+    }
+}
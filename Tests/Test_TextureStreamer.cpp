@@ -0,0 +1,179 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ===========================
+#include <vector>
+#include "Test.h"
+#include "Rendering/TextureStreamer.h"
+//======================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+// An RGBA8 chain down to 1x1, every byte of a mip is its index so that the resident mips can be told apart
+static vector<vector<std::byte>> create_mips(const uint32_t size)
+{
+    vector<vector<std::byte>> mips;
+    for (uint32_t mip_size = size; mip_size != 0; mip_size /= 2)
+    {
+        mips.emplace_back(static_cast<size_t>(mip_size) * mip_size * 4, std::byte(static_cast<uint8_t>(mips.size())));
+    }
+    return mips;
+}
+
+// Tracks a texture in both the store and the streamer, starting with its tail resident, the way the renderer does
+static void add_texture(TextureStoreCpu& store, TextureStreamer& streamer, const uint32_t id, const uint32_t size)
+{
+    const vector<vector<std::byte>> mips = create_mips(size);
+    vector<uint64_t> byte_counts;
+    for (const vector<std::byte>& mip : mips)
+    {
+        byte_counts.emplace_back(mip.size());
+    }
+
+    const uint32_t mip_tail = TextureStreamer::GetMipTail(size, size, static_cast<uint32_t>(mips.size()));
+    store.Add(id, mips, mip_tail);
+    streamer.Add(id, size, size, byte_counts, mip_tail);
+}
+
+// The first resident mip, according to the store
+static uint32_t mip_resident(const TextureStoreCpu& store, const uint32_t id)
+{
+    const vector<vector<std::byte>>* mips = store.GetMipsResident(id);
+    return mips && !mips->empty() ? static_cast<uint32_t>(mips->front().front()) : ~0u;
+}
+
+TEST(texture_streamer_streams_in_what_is_requested)
+{
+    TextureStoreCpu store;
+    TextureStreamer streamer;
+    add_texture(store, streamer, 1, 1024);
+
+    // Only the tail (128x128 and smaller) is resident to begin with
+    CHECK(mip_resident(store, 1) == 3);
+    CHECK(streamer.GetBytesResident() == store.GetBytesResident());
+
+    // Covering 300 pixels of the screen needs the 512x512 mip
+    streamer.Request(1, 300.0f, 1);
+    streamer.Update(store, 1);
+    CHECK(mip_resident(store, 1) == 1);
+    CHECK(streamer.GetTexture(1)->mip_resident == 1);
+    CHECK(streamer.GetBytesResident() == store.GetBytesResident());
+
+    // The largest request of a frame wins
+    streamer.Request(1, 100.0f, 2);
+    streamer.Request(1, 2000.0f, 2);
+    streamer.Update(store, 2);
+    CHECK(mip_resident(store, 1) == 0);
+
+    // Textures which are no longer requested keep what they have while there is room
+    streamer.Update(store, 3);
+    CHECK(mip_resident(store, 1) == 0);
+
+    // Textures which are gone from the store are forgotten
+    store.Remove(1);
+    streamer.Update(store, 4);
+    CHECK(!streamer.Contains(1));
+    CHECK(streamer.GetBytesResident() == 0);
+}
+
+TEST(texture_streamer_stays_within_the_budget)
+{
+    TextureStoreCpu store;
+    TextureStreamer streamer;
+    streamer.SetBytesPerFrame(~0ull);
+    for (uint32_t id = 1; id <= 3; id++)
+    {
+        add_texture(store, streamer, id, 1024);
+    }
+
+    // Two whole chains fit, three don't
+    uint64_t chain = 0;
+    for (const vector<std::byte>& mip : create_mips(1024))
+    {
+        chain += mip.size();
+    }
+    streamer.SetBudget(2 * chain);
+
+    // Everything is requested at full resolution, the resolution of the largest is lowered until it fits
+    for (uint32_t id = 1; id <= 3; id++)
+    {
+        streamer.Request(id, 1024.0f, 1);
+    }
+    streamer.Update(store, 1);
+    CHECK(streamer.GetBytesResident() <= streamer.GetBudget());
+    CHECK(streamer.GetBytesResident() == store.GetBytesResident());
+    uint32_t full_resolution_count = 0;
+    for (uint32_t id = 1; id <= 3; id++)
+    {
+        full_resolution_count += mip_resident(store, id) == 0 ? 1 : 0;
+        CHECK(mip_resident(store, id) <= 1);
+    }
+    CHECK(full_resolution_count >= 1);
+
+    // Only the third is used now, the others are evicted (to their tails) before it loses any resolution
+    streamer.Request(3, 1024.0f, 2);
+    streamer.Update(store, 2);
+    CHECK(mip_resident(store, 3) == 0);
+    CHECK(streamer.GetBytesResident() <= streamer.GetBudget());
+    CHECK(streamer.GetBytesResident() == store.GetBytesResident());
+
+    // Tails are never evicted, even when the budget is smaller than them
+    streamer.SetBudget(0);
+    streamer.Update(store, 3);
+    for (uint32_t id = 1; id <= 3; id++)
+    {
+        CHECK(mip_resident(store, id) == 3);
+    }
+}
+
+TEST(texture_streamer_limits_the_bytes_per_frame)
+{
+    TextureStoreCpu store;
+    TextureStreamer streamer;
+    for (uint32_t id = 1; id <= 4; id++)
+    {
+        add_texture(store, streamer, id, 1024);
+    }
+
+    // Room for one whole chain per frame (a 1024x1024 chain is a bit over 5 MB), the textures arrive one frame at a time
+    streamer.SetBytesPerFrame(8ull * 1024 * 1024);
+    for (uint64_t frame = 1; frame <= 4; frame++)
+    {
+        for (uint32_t id = 1; id <= 4; id++)
+        {
+            streamer.Request(id, 1024.0f, frame);
+        }
+        streamer.Update(store, frame);
+
+        uint32_t streamed_count = 0;
+        for (uint32_t id = 1; id <= 4; id++)
+        {
+            streamed_count += mip_resident(store, id) == 0 ? 1 : 0;
+        }
+        CHECK(streamed_count == frame);
+        CHECK(streamer.GetBytesStreamed() <= streamer.GetBytesPerFrame());
+    }
+}
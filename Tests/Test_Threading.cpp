@@ -0,0 +1,240 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES ============
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <deque>
+#include <condition_variable>
+#include "Test.h"
+//=======================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+TEST(threading_parallel_for_covers_range)
+{
+    Threading* threading = GetThreading();
+
+    vector<uint32_t> visits(100000, 0);
+    threading->ParallelFor(static_cast<uint32_t>(visits.size()), 0, [&visits](const uint32_t start, const uint32_t end)
+    {
+        for (uint32_t i = start; i < end; i++)
+        {
+            visits[i]++;
+        }
+    });
+
+    CHECK(all_of(visits.begin(), visits.end(), [](const uint32_t count) { return count == 1; }));
+}
+
+TEST(threading_parallel_for_nested)
+{
+    Threading* threading = GetThreading();
+
+    atomic<uint32_t> sum = 0;
+    threading->ParallelFor(64, 1, [threading, &sum](const uint32_t start, const uint32_t end)
+    {
+        for (uint32_t i = start; i < end; i++)
+        {
+            threading->ParallelFor(1000, 0, [&sum](const uint32_t start, const uint32_t end) { sum += end - start; });
+        }
+    });
+
+    CHECK(sum == 64 * 1000);
+}
+
+TEST(threading_counter_wait_skips_other_tasks)
+{
+    Threading* threading = GetThreading();
+    if (threading->GetThreadCount() == 0)
+        return;
+
+    // A task without a counter which can't finish until the calling thread is done waiting, it must never run inline
+    atomic<bool> waited     = false;
+    atomic<bool> done       = false;
+    atomic<bool> inline_run = false;
+    const thread::id caller = this_thread::get_id();
+    threading->AddTask([&waited, &done, &inline_run, caller]()
+    {
+        if (this_thread::get_id() == caller)
+        {
+            inline_run = true;
+        }
+        else
+        {
+            while (!waited)
+            {
+                this_thread::yield();
+            }
+        }
+
+        done = true;
+    });
+
+    threading->ParallelFor(100000, 0, [](uint32_t, uint32_t) {});
+    waited = true;
+
+    while (!done)
+    {
+        this_thread::yield();
+    }
+
+    CHECK(!inline_run);
+}
+
+namespace
+{
+    // The scheduler which the job system replaced, kept as a baseline: a single deque of
+    // heap allocated std::function tasks behind one mutex, which every thread contends on.
+    class LegacyScheduler
+    {
+    public:
+        LegacyScheduler(const uint32_t thread_count)
+        {
+            for (uint32_t i = 0; i < thread_count; i++)
+            {
+                m_threads.emplace_back(&LegacyScheduler::ThreadLoop, this);
+            }
+        }
+
+        ~LegacyScheduler()
+        {
+            {
+                lock_guard<mutex> lock(m_mutex);
+                m_stopping = true;
+            }
+            m_condition.notify_all();
+
+            for (thread& thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        template <typename Function>
+        void AddTask(Function&& task)
+        {
+            m_pending.fetch_add(1, memory_order_relaxed);
+
+            unique_lock<mutex> lock(m_mutex);
+            m_tasks.push_back(make_shared<function<void()>>(forward<Function>(task)));
+            lock.unlock();
+
+            m_condition.notify_one();
+        }
+
+        void Wait()
+        {
+            while (m_pending.load(memory_order_acquire) != 0)
+            {
+                this_thread::yield();
+            }
+        }
+
+    private:
+        void ThreadLoop()
+        {
+            while (true)
+            {
+                unique_lock<mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] { return !m_tasks.empty() || m_stopping; });
+                if (m_stopping && m_tasks.empty())
+                    return;
+
+                shared_ptr<function<void()>> task = m_tasks.front();
+                m_tasks.pop_front();
+                lock.unlock();
+
+                (*task)();
+                m_pending.fetch_sub(1, memory_order_release);
+            }
+        }
+
+        vector<thread> m_threads;
+        deque<shared_ptr<function<void()>>> m_tasks;
+        mutex m_mutex;
+        condition_variable m_condition;
+        atomic<uint32_t> m_pending = 0;
+        bool m_stopping = false;
+    };
+}
+
+BENCHMARK(threading_throughput)
+{
+    Threading* threading = GetThreading();
+    Report("threads", threading->GetThreadCount(), "");
+    if (threading->GetThreadCount() == 0)
+        return;
+
+    // Scheduling overhead, empty tasks, against the mutex and deque scheduler with as many threads
+    LegacyScheduler legacy(threading->GetThreadCount());
+    for (const uint32_t task_count : { 10000u, 100000u, 1000000u })
+    {
+        const uint32_t iterations = task_count >= 1000000 ? 3 : 10;
+        char name[64];
+
+        snprintf(name, sizeof(name), "%uk empty tasks, job system", task_count / 1000);
+        const double ms_tasks = Measure(name, iterations, [threading, task_count]()
+        {
+            TaskCounter counter;
+            for (uint32_t i = 0; i < task_count; i++)
+            {
+                threading->AddTask([]() {}, &counter);
+            }
+            threading->Wait(counter);
+        });
+
+        snprintf(name, sizeof(name), "%uk empty tasks, mutex and deque", task_count / 1000);
+        const double ms_legacy = Measure(name, iterations, [&legacy, task_count]()
+        {
+            for (uint32_t i = 0; i < task_count; i++)
+            {
+                legacy.AddTask([]() {});
+            }
+            legacy.Wait();
+        });
+
+        Report("tasks per ms, job system", task_count / ms_tasks, "");
+        Report("tasks per ms, mutex and deque", task_count / ms_legacy, "");
+        Report("speedup", ms_legacy / ms_tasks, "x");
+    }
+
+    // Scaling, a loop with some work per element
+    vector<float> values(1 << 22, 2.0f);
+    const auto work = [&values](const uint32_t start, const uint32_t end)
+    {
+        for (uint32_t i = start; i < end; i++)
+        {
+            values[i] = sqrtf(values[i] * values[i] + 1.0f);
+        }
+    };
+
+    const double ms_serial      = Measure("4M elements, serial", 10, [&work, &values]() { work(0, static_cast<uint32_t>(values.size())); });
+    const double ms_parallel    = Measure("4M elements, ParallelFor", 10, [threading, &work, &values]() { threading->ParallelFor(static_cast<uint32_t>(values.size()), 0, work); });
+    Report("speedup", ms_serial / ms_parallel, "x");
+}
@@ -0,0 +1,296 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====================
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "Test.h"
+#include "IO/FileStream.h"
+#include "RHI/RHI_Vertex.h"
+#include "Rendering/VertexQuantizer.h"
+//================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Math;
+using namespace Spartan::Tests;
+//=============================
+
+static float random_float(uint32_t& seed, const float from, const float to)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return from + (to - from) * static_cast<float>(seed >> 8) / 16777216.0f;
+}
+
+static void random_direction(uint32_t& seed, float* direction)
+{
+    float length = 0.0f;
+    do
+    {
+        direction[0] = random_float(seed, -1.0f, 1.0f);
+        direction[1] = random_float(seed, -1.0f, 1.0f);
+        direction[2] = random_float(seed, -1.0f, 1.0f);
+        length       = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+    } while (length < 0.01f || length > 1.0f);
+
+    direction[0] /= length;
+    direction[1] /= length;
+    direction[2] /= length;
+}
+
+// A grid of triangles inside the given bounds, with random uvs, normals and tangents
+static void create_geometry(const Vector3& min, const Vector3& max, const uint32_t size, vector<RHI_Vertex_PosTexNorTan>* vertices, vector<uint32_t>* indices)
+{
+    uint32_t seed = 1;
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            RHI_Vertex_PosTexNorTan vertex;
+            vertex.pos[0] = min.x + (max.x - min.x) * x / (size - 1);
+            vertex.pos[1] = random_float(seed, min.y, max.y);
+            vertex.pos[2] = min.z + (max.z - min.z) * y / (size - 1);
+            vertex.tex[0] = random_float(seed, 0.0f, 1.0f);
+            vertex.tex[1] = random_float(seed, 0.0f, 1.0f);
+            random_direction(seed, vertex.nor);
+            random_direction(seed, vertex.tan);
+            vertices->emplace_back(vertex);
+        }
+    }
+
+    for (uint32_t y = 0; y + 1 < size; y++)
+    {
+        for (uint32_t x = 0; x + 1 < size; x++)
+        {
+            const uint32_t i = y * size + x;
+            indices->insert(indices->end(), { i, i + size, i + 1, i + 1, i + size, i + size + 1 });
+        }
+    }
+}
+
+// Angle between two unit directions, from the cross product since acos() of a float dot product can't resolve small angles
+static float angle(const float* a, const float* b)
+{
+    const double x      = static_cast<double>(a[1]) * b[2] - static_cast<double>(a[2]) * b[1];
+    const double y      = static_cast<double>(a[2]) * b[0] - static_cast<double>(a[0]) * b[2];
+    const double z      = static_cast<double>(a[0]) * b[1] - static_cast<double>(a[1]) * b[0];
+    const double dot    = static_cast<double>(a[0]) * b[0] + static_cast<double>(a[1]) * b[1] + static_cast<double>(a[2]) * b[2];
+    return static_cast<float>(atan2(sqrt(x * x + y * y + z * z), dot));
+}
+
+TEST(vertex_quantizer_round_trip_error)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+    create_geometry(Vector3(-30.0f, 2.0f, 10.0f), Vector3(50.0f, 6.0f, 90.0f), 64, &vertices, &indices);
+
+    VertexQuantizer quantizer;
+    CHECK(quantizer.Fit(vertices, indices));
+    CHECK(quantizer.GetCenter().x == 10.0f && quantizer.GetCenter().z == 50.0f);
+    CHECK(quantizer.GetExtent() == 40.0f);
+
+    const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+    vector<RHI_Vertex_PosTexNorTanQuantized> vertices_quantized(vertex_count);
+    vector<RHI_Vertex_PosTexNorTan> vertices_dequantized(vertex_count);
+    quantizer.Quantize(vertices.data(), vertex_count, vertices_quantized.data());
+    quantizer.Dequantize(vertices_quantized.data(), vertex_count, vertices_dequantized.data());
+
+    // Positions are within half a step of the cube, plus the float rounding of the center and the extent
+    const float error_position_bound    = 0.5f * quantizer.GetExtent() / 32767.0f + 50.0f * 1e-6f;
+    const Matrix dequantization         = quantizer.GetDequantization();
+    float error_position                = 0.0f;
+    float error_position_matrix         = 0.0f;
+    float error_uv                      = 0.0f;
+    float error_normal                  = 0.0f;
+    float error_tangent                 = 0.0f;
+    for (uint32_t i = 0; i < vertex_count; i++)
+    {
+        const RHI_Vertex_PosTexNorTan& vertex               = vertices[i];
+        const RHI_Vertex_PosTexNorTan& vertex_dequantized   = vertices_dequantized[i];
+        const RHI_Vertex_PosTexNorTanQuantized& quantized   = vertices_quantized[i];
+
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            error_position = Helper::Max(error_position, fabsf(vertex_dequantized.pos[c] - vertex.pos[c]));
+        }
+
+        // The vertex shader path, snorm positions through the dequantization matrix
+        const Vector3 position_snorm    = Vector3(quantized.pos[0], quantized.pos[1], quantized.pos[2]) / 32767.0f;
+        const Vector3 position          = position_snorm * dequantization;
+        error_position_matrix = Helper::Max(error_position_matrix, fabsf(position.x - vertex.pos[0]));
+        error_position_matrix = Helper::Max(error_position_matrix, fabsf(position.y - vertex.pos[1]));
+        error_position_matrix = Helper::Max(error_position_matrix, fabsf(position.z - vertex.pos[2]));
+
+        error_uv        = Helper::Max(error_uv, Helper::Max(fabsf(vertex_dequantized.tex[0] - vertex.tex[0]), fabsf(vertex_dequantized.tex[1] - vertex.tex[1])));
+        error_normal    = Helper::Max(error_normal, angle(vertex.nor, vertex_dequantized.nor));
+        error_tangent   = Helper::Max(error_tangent, angle(vertex.tan, vertex_dequantized.tan));
+    }
+
+    Report("position error", error_position / error_position_bound * 100.0f, "% of the bound");
+    Report("uv error", error_uv * 65536.0f, "1/65536");
+    Report("normal error", error_normal * Helper::RAD_TO_DEG * 3600.0f, "arcseconds");
+    Report("tangent error", error_tangent * Helper::RAD_TO_DEG * 3600.0f, "arcseconds");
+
+    CHECK(error_position <= error_position_bound);
+    CHECK(error_position_matrix <= error_position_bound);
+
+    // Half precision has 11 significant bits, in [0.5, 1) a step is 2^-11
+    CHECK(error_uv <= 1.0f / 4096.0f);
+
+    // 16 bit octahedral directions are well under a hundredth of a degree off
+    CHECK(error_normal <= 0.01f * Helper::DEG_TO_RAD);
+    CHECK(error_tangent <= 0.01f * Helper::DEG_TO_RAD);
+
+    // The axes, including the folded -z hemisphere, and a zero vector which decodes to +z
+    const float directions[][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 0, 0 } };
+    const float decoded_expected[][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 0, 1 } };
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        RHI_Vertex_PosTexNorTan vertex = vertices[0];
+        memcpy(vertex.nor, directions[i], sizeof(vertex.nor));
+        RHI_Vertex_PosTexNorTanQuantized quantized;
+        RHI_Vertex_PosTexNorTan vertex_dequantized;
+        quantizer.Quantize(&vertex, 1, &quantized);
+        quantizer.Dequantize(&quantized, 1, &vertex_dequantized);
+        CHECK(angle(vertex_dequantized.nor, decoded_expected[i]) <= 0.01f * Helper::DEG_TO_RAD);
+    }
+}
+
+TEST(vertex_quantizer_rejects_what_it_cant_represent)
+{
+    vector<RHI_Vertex_PosTexNorTan> vertices;
+    vector<uint32_t> indices;
+
+    // A small triangle far from the rest of the geometry, half a step is more than a percent of its edges
+    vertices.resize(4);
+    vertices[1].pos[0] = 0.01f;
+    vertices[2].pos[2] = 0.01f;
+    vertices[3].pos[0] = 10000.0f;
+    indices = { 0, 1, 2 };
+    VertexQuantizer quantizer;
+    CHECK(!quantizer.Fit(vertices, indices));
+
+    // Tiling uvs far from the 0-1 range
+    vertices.clear();
+    indices.clear();
+    create_geometry(Vector3(0.0f), Vector3(1.0f), 8, &vertices, &indices);
+    CHECK(quantizer.Fit(vertices, indices));
+    vertices[5].tex[0] = 3000.3f;
+    CHECK(!quantizer.Fit(vertices, indices));
+
+    // Degenerate geometry
+    vertices.clear();
+    CHECK(!quantizer.Fit(vertices, indices));
+    vertices.resize(3);
+    CHECK(!quantizer.Fit(vertices, { 0, 1, 2 }));
+}
+
+// The geometry part of a model file, written and read the way Model::SaveToFile() and Model::LoadFromFile() do
+static void save_geometry(const string& file_path, const vector<uint32_t>& indices, const vector<RHI_Vertex_PosTexNorTan>& vertices, const VertexQuantizer* quantizer)
+{
+    FileStream file(file_path, FileStream_Write);
+    file.Write(indices);
+    if (quantizer)
+    {
+        vector<RHI_Vertex_PosTexNorTanQuantized> vertices_quantized(vertices.size());
+        quantizer->Quantize(vertices.data(), static_cast<uint32_t>(vertices.size()), vertices_quantized.data());
+
+        file.Write(vector<RHI_Vertex_PosTexNorTan>());
+        file.Write(true);
+        file.Write(quantizer->GetCenter());
+        file.Write(quantizer->GetExtent());
+        file.Write(vertices_quantized);
+    }
+    else
+    {
+        file.Write(vertices);
+        file.Write(false);
+    }
+    file.Close();
+}
+
+// The CPU copy of the vertices is what both paths end up with, the quantized one also hands the GPU a view into the file
+static uint64_t load_geometry(const string& file_path, vector<uint32_t>* indices, vector<RHI_Vertex_PosTexNorTan>* vertices)
+{
+    FileStream file(file_path, FileStream_Read);
+    file.Read(indices);
+    file.Read(vertices);
+    if (file.ReadAs<bool>())
+    {
+        Vector3 center  = Vector3::Zero;
+        float extent    = 1.0f;
+        file.Read(&center);
+        file.Read(&extent);
+
+        uint32_t vertex_count = 0;
+        const RHI_Vertex_PosTexNorTanQuantized* vertices_quantized = file.ReadView<RHI_Vertex_PosTexNorTanQuantized>(&vertex_count);
+        vertices->resize(vertex_count);
+        VertexQuantizer(center, extent).Dequantize(vertices_quantized, vertex_count, vertices->data());
+    }
+
+    return file.GetSize();
+}
+
+BENCHMARK(vertex_quantizer_model_file)
+{
+    for (const uint32_t size : { 317u, 1000u }) // 100k and 1M vertices
+    {
+        vector<RHI_Vertex_PosTexNorTan> vertices;
+        vector<uint32_t> indices;
+        create_geometry(Vector3(-30.0f, 2.0f, 10.0f), Vector3(50.0f, 6.0f, 90.0f), size, &vertices, &indices);
+
+        VertexQuantizer quantizer;
+        CHECK(quantizer.Fit(vertices, indices));
+
+        const string file_path_float        = "test_vertex_quantizer_float.model";
+        const string file_path_quantized    = "test_vertex_quantizer_quantized.model";
+        save_geometry(file_path_float, indices, vertices, nullptr);
+        save_geometry(file_path_quantized, indices, vertices, &quantizer);
+
+        const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+        char name[64];
+
+        vector<uint32_t> indices_loaded;
+        vector<RHI_Vertex_PosTexNorTan> vertices_loaded;
+        uint64_t size_float = 0;
+        snprintf(name, sizeof(name), "load %uk vertices, float", vertex_count / 1000);
+        const double ms_float = Measure(name, 5, [&]() { size_float = load_geometry(file_path_float, &indices_loaded, &vertices_loaded); });
+        CHECK(vertices_loaded.size() == vertex_count);
+
+        uint64_t size_quantized = 0;
+        snprintf(name, sizeof(name), "load %uk vertices, quantized", vertex_count / 1000);
+        const double ms_quantized = Measure(name, 5, [&]() { size_quantized = load_geometry(file_path_quantized, &indices_loaded, &vertices_loaded); });
+        CHECK(vertices_loaded.size() == vertex_count);
+
+        Report("file size, float", size_float / (1024.0 * 1024.0), "MB");
+        Report("file size, quantized", size_quantized / (1024.0 * 1024.0), "MB");
+        Report("vertex buffer, float", vertex_count * sizeof(RHI_Vertex_PosTexNorTan) / (1024.0 * 1024.0), "MB");
+        Report("vertex buffer, quantized", vertex_count * sizeof(RHI_Vertex_PosTexNorTanQuantized) / (1024.0 * 1024.0), "MB");
+        Report("load throughput, float", vertex_count / ms_float / 1000.0, "M vertices/s");
+        Report("load throughput, quantized", vertex_count / ms_quantized / 1000.0, "M vertices/s");
+
+        remove(file_path_float.c_str());
+        remove(file_path_quantized.c_str());
+    }
+}
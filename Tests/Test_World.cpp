@@ -0,0 +1,294 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =========================
+#include <string>
+#include <random>
+#include <filesystem>
+#include "Test.h"
+#include "IO/FileStream.h"
+#include "World/World.h"
+#include "World/Entity.h"
+#include "World/Components/Transform.h"
+#include "World/Components/Light.h"
+//====================================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan;
+using namespace Spartan::Tests;
+//=============================
+
+// A world which isn't initialized, so it starts without the default camera, environment and light
+static World* create_world(Context& context)
+{
+    context.RegisterSubsystem<World>();
+    return context.GetSubsystem<World>();
+}
+
+TEST(world_entity_id_collisions_are_rejected)
+{
+    Context context;
+    World* world = create_world(context);
+
+    const shared_ptr<Entity> a = world->EntityCreate();
+    const shared_ptr<Entity> b = world->EntityCreate();
+    const uint32_t id_a = a->GetId();
+    const uint32_t id_b = b->GetId();
+    CHECK(id_a != id_b);
+
+    // Taking another entity's id leaves both as they were
+    b->SetId(id_a);
+    CHECK(b->GetId() == id_b);
+    CHECK(world->EntityGetById(id_a) == a);
+    CHECK(world->EntityGetById(id_b) == b);
+
+    // Also through the base class
+    static_cast<Spartan_Object*>(b.get())->SetId(id_a);
+    CHECK(b->GetId() == id_b);
+
+    // A free id is taken, and isn't generated for anything afterwards
+    const uint32_t id_free = id_b + 1000;
+    b->SetId(id_free);
+    CHECK(b->GetId() == id_free);
+    CHECK(world->EntityGetById(id_free) == b);
+    CHECK(world->EntityGetById(id_b) == nullptr);
+    CHECK(world->EntityCreate()->GetId() > id_free);
+}
+
+BENCHMARK(world_entity_lookup)
+{
+    Context context;
+    World* world = create_world(context);
+
+    // Names repeat, like the meshes of an imported model
+    const uint32_t entity_count = 20000;
+    vector<uint32_t> ids;
+    Measure("create 20k entities", 1, [world, &ids]()
+    {
+        for (uint32_t i = 0; i < entity_count; i++)
+        {
+            const shared_ptr<Entity>& entity = world->EntityCreate();
+            entity->SetName("Mesh_" + to_string(i % 2000));
+            ids.emplace_back(entity->GetId());
+        }
+    });
+
+    mt19937 random(7);
+    vector<uint32_t> lookups_id(100000);
+    vector<string> lookups_name(lookups_id.size());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(lookups_id.size()); i++)
+    {
+        lookups_id[i]   = ids[random() % ids.size()];
+        lookups_name[i] = "Mesh_" + to_string(random() % 2000);
+    }
+
+    uint32_t found = 0;
+    Measure("100k lookups by id", 10, [world, &lookups_id, &found]()
+    {
+        for (const uint32_t id : lookups_id)
+        {
+            found += world->EntityGetById(id) ? 1 : 0;
+        }
+    });
+
+    Measure("100k lookups by name", 10, [world, &lookups_name, &found]()
+    {
+        for (const string& name : lookups_name)
+        {
+            found += world->EntityGetByName(name) ? 1 : 0;
+        }
+    });
+
+    // What the index costs when entities are renamed, e.g. by the editor or a script
+    Measure("rename 20k entities", 10, [world, &found]()
+    {
+        for (const shared_ptr<Entity>& entity : world->EntityGetAll())
+        {
+            entity->SetName(entity->GetName() == "Renamed" ? "Mesh" : "Renamed");
+        }
+    });
+    CHECK(found != 0);
+}
+
+BENCHMARK(world_components)
+{
+    Context context;
+    World* world = create_world(context);
+
+    // Every entity has a transform, one in ten is a light
+    const uint32_t entity_count = 100000;
+    for (uint32_t i = 0; i < entity_count; i++)
+    {
+        const shared_ptr<Entity>& entity = world->EntityCreate();
+        entity->GetTransform()->SetPositionLocal(Math::Vector3(static_cast<float>(i), 0.0f, 0.0f));
+        if (i % 10 == 0)
+        {
+            entity->AddComponent<Light>()->SetRange(static_cast<float>(i % 100));
+        }
+    }
+
+    // What the systems used to do, ask every entity for the component they are after
+    float sum_entities = 0.0f;
+    Measure("100k entities, GetComponent<Light>", 10, [world, &sum_entities]()
+    {
+        for (const shared_ptr<Entity>& entity : world->EntityGetAll())
+        {
+            if (const Light* light = entity->GetComponent<Light>())
+            {
+                sum_entities += light->GetRange();
+            }
+        }
+    });
+
+    float sum_pool = 0.0f;
+    Measure("100k entities, ComponentForEach<Light>", 10, [world, &sum_pool]()
+    {
+        world->ComponentForEach<Light>([&sum_pool](const Light* light) { sum_pool += light->GetRange(); });
+    });
+    CHECK(sum_entities == sum_pool);
+
+    sum_entities = 0.0f;
+    Measure("100k entities, GetTransform", 10, [world, &sum_entities]()
+    {
+        for (const shared_ptr<Entity>& entity : world->EntityGetAll())
+        {
+            sum_entities += entity->GetTransform()->GetPositionLocal().x;
+        }
+    });
+
+    sum_pool = 0.0f;
+    Measure("100k entities, ComponentForEach<Transform>", 10, [world, &sum_pool]()
+    {
+        world->ComponentForEach<Transform>([&sum_pool](const Transform* transform) { sum_pool += transform->GetPositionLocal().x; });
+    });
+    CHECK(sum_entities == sum_pool);
+
+    // Lights with their transforms, what the renderer captures every frame
+    uint32_t lights = 0;
+    Measure("100k entities, ComponentForEach<Light, Transform>", 10, [world, &lights]()
+    {
+        world->ComponentForEach<Light, Transform>([&lights](const Light*, const Transform*) { lights++; });
+    });
+    CHECK(lights == entity_count / 10 * 10);
+}
+
+BENCHMARK(world_load)
+{
+    // Every loaded entity is indexed by id and name as it's created
+    for (const uint32_t entity_count : { 10000u, 50000u, 200000u })
+    {
+        Context context;
+        context.RegisterSubsystem<Threading>();
+        World* world = create_world(context);
+
+        vector<uint32_t> ids;
+        for (uint32_t i = 0; i < entity_count; i++)
+        {
+            const shared_ptr<Entity>& entity = world->EntityCreate();
+            entity->SetName("Mesh_" + to_string(i % 2000));
+            ids.emplace_back(entity->GetId());
+        }
+
+        const string file_path = "test_world_load.world";
+        world->SaveToFile(file_path);
+
+        char name[64];
+        snprintf(name, sizeof(name), "load %uk entities", entity_count / 1000);
+        const double ms = Measure(name, 3, [world, &file_path]() { world->LoadFromFile(file_path); });
+        Report("entities per ms", entity_count / ms, "");
+
+        // The indices are complete once loading returns
+        CHECK(world->EntityGetAll().size() == entity_count);
+        CHECK(world->EntityGetById(ids.front()) != nullptr);
+        CHECK(world->EntityGetById(ids.back()) != nullptr);
+        CHECK(world->EntityGetByName("Mesh_1999") != nullptr);
+
+        remove(file_path.c_str());
+    }
+}
+
+// Writes the world the way it was saved before the chunked format, every root followed by its descendants, depth first
+static void save_hierarchy(World* world, const string& file_path)
+{
+    FileStream file(file_path, FileStream_Write);
+
+    const vector<shared_ptr<Entity>> roots = world->EntityGetRoots();
+    file.Write(static_cast<uint32_t>(roots.size()));
+    for (const shared_ptr<Entity>& root : roots)
+    {
+        file.Write(root->GetId());
+    }
+    for (const shared_ptr<Entity>& root : roots)
+    {
+        root->Serialize(&file);
+    }
+}
+
+BENCHMARK(world_save_load)
+{
+    Context context;
+    context.RegisterSubsystem<Threading>();
+    World* world = create_world(context);
+
+    // Roots with a few children each, like imported models, some of them lights
+    const uint32_t entity_count = 50000;
+    mt19937 random(7);
+    uniform_real_distribution<float> position(-500.0f, 500.0f);
+    for (uint32_t i = 0; i < entity_count; i += 10)
+    {
+        Entity* root = world->EntityCreate().get();
+        root->SetName("Model_" + to_string(i / 10));
+        root->GetTransform()->SetPositionLocal(Math::Vector3(position(random), position(random), position(random)));
+
+        for (uint32_t j = 1; j < 10; j++)
+        {
+            Entity* child = world->EntityCreate().get();
+            child->SetName("Mesh_" + to_string(j));
+            child->GetTransform()->SetParent(root->GetTransform());
+            child->GetTransform()->SetPositionLocal(Math::Vector3(position(random), position(random), position(random)) * 0.01f);
+            if (j == 9)
+            {
+                child->AddComponent<Light>()->SetRange(10.0f);
+            }
+        }
+    }
+
+    const string file_path_chunks       = "test_world_chunks.world";
+    const string file_path_hierarchy    = "test_world_hierarchy.world";
+    const double ms_save_chunks         = Measure("save 50k entities, chunks", 3, [world, &file_path_chunks]() { world->SaveToFile(file_path_chunks); });
+    const double ms_save_hierarchy      = Measure("save 50k entities, hierarchy", 3, [world, &file_path_hierarchy]() { save_hierarchy(world, file_path_hierarchy); });
+    Report("save speedup", ms_save_hierarchy / ms_save_chunks, "x");
+    Report("file size, chunks", filesystem::file_size(file_path_chunks) / 1024.0, "KB");
+    Report("file size, hierarchy", filesystem::file_size(file_path_hierarchy) / 1024.0, "KB");
+
+    const double ms_load_chunks     = Measure("load 50k entities, chunks", 3, [world, &file_path_chunks]() { world->LoadFromFile(file_path_chunks); });
+    CHECK(world->EntityGetAll().size() == entity_count);
+    const double ms_load_hierarchy  = Measure("load 50k entities, hierarchy", 3, [world, &file_path_hierarchy]() { world->LoadFromFile(file_path_hierarchy); });
+    CHECK(world->EntityGetAll().size() == entity_count);
+    Report("entities per ms, chunks", entity_count / ms_load_chunks, "");
+    Report("entities per ms, hierarchy", entity_count / ms_load_hierarchy, "");
+    Report("load speedup", ms_load_hierarchy / ms_load_chunks, "x");
+
+    remove(file_path_chunks.c_str());
+    remove(file_path_hierarchy.c_str());
+}
@@ -0,0 +1,66 @@
+/*
+Copyright(c) 2016-2020 Panos Karabelas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+copies of the Software, and to permit persons to whom the Software is furnished
+to do so, subject to the following conditions :
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//= INCLUDES =====
+#include <cstring>
+#include "Test.h"
+//================
+
+//= NAMESPACES ================
+using namespace std;
+using namespace Spartan::Tests;
+//=============================
+
+// Usage: Tests [--benchmarks] [name]
+// Runs the tests (and the benchmarks, if asked to) whose name contains the given one. Returns the number of failed checks.
+int main(int argc, char** argv)
+{
+    bool benchmarks     = false;
+    const char* filter  = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--benchmarks") == 0)
+        {
+            benchmarks = true;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    uint32_t test_count = 0;
+    for (const Test& test : GetTests())
+    {
+        if ((test.benchmark && !benchmarks) || (filter && !strstr(test.name, filter)))
+            continue;
+
+        const uint32_t failure_count = GetFailureCount();
+        printf("%s %s\n", test.benchmark ? "[benchmark]" : "[test]", test.name);
+        test.function();
+        printf("    %s\n", GetFailureCount() == failure_count ? "ok" : "FAILED");
+        test_count++;
+    }
+
+    printf("%u ran, %u failed checks\n", test_count, GetFailureCount());
+    return static_cast<int>(GetFailureCount());
+}